@@ -1,4 +1,5 @@
 #pragma once
+#include "BuildingMesh.h"
 
 // Draws an academic block at the given position with the given parameters
 void drawAcademicBlock(
@@ -7,4 +8,10 @@ void drawAcademicBlock(
     float r, float g, float b,
     int windowsX, int windowsZ_front, int windowsZ_side, int floors,
     const char* label
-);
\ No newline at end of file
+);
+
+// Just the label, for when the building itself is drawn some other way
+void drawAcademicBlockLabel(float x, float y, float z, float height, const char* label);
+
+// Its boxes, for requesting meshes ahead of drawing (WorldPartition.h)
+extern const BuildingGeometry ACADEMIC_BLOCK_GEOMETRY;
@@ -1,42 +1,35 @@
 #include "AdminBlock.h"
+#include "BuildingMesh.h"
+#include "CubeBatch.h"
 #include <GL/glut.h>
 #include <string>
 
-// Helper to draw a rectangular prism
-static void drawRectPrism(float w, float h, float d) {
-    glPushMatrix();
-    glScalef(w, h, d);
-    glutSolidCube(1.0);
-    glPopMatrix();
-}
-
 // Helper to draw 3D text above the building
 static void renderText3D(float x, float y, float z, void* font, const std::string& text, float r, float g, float b) {
-    glColor3f(r, g, b);
-    glRasterPos3f(x, y, z);
+    rcColor3f(r, g, b);
+    rcRasterPos3f(x, y, z);
     for (char c : text) {
         glutBitmapCharacter(font, c);
     }
 }
 
-void drawAdminBlock(
-    float x, float y, float z,
-    float w, float h, float d,
-    float r, float g, float b,
-    int windowsX, int windowsZ_front, int windowsZ_side, int floors,
-    const char* label
-) {
-    glColor3f(r, g, b);
-    glPushMatrix();
-    glTranslatef(x, y + h/2.0f, z);
+// Walls, roof, windows and door, standing on the origin
+static void adminBlockGeometry(const BuildingShape& shape) {
+    float w = shape.width, h = shape.height, d = shape.depth;
+    float r = shape.r, g = shape.g, b = shape.b;
+    int windowsX = shape.windowsX, windowsZ_front = shape.windowsZ_front, floors = shape.floors;
+
+    rcColor3f(r, g, b);
+    rcPushMatrix();
+    rcTranslatef(0, h/2.0f, 0);
     drawRectPrism(w, h, d);
 
     // Roof
-    glColor3f(r * 0.6f, g * 0.6f, b * 0.6f);
-    glPushMatrix();
-    glTranslatef(0, h/2.0f + 0.15f, 0);
+    rcColor3f(r * 0.6f, g * 0.6f, b * 0.6f);
+    rcPushMatrix();
+    rcTranslatef(0, h/2.0f + 0.15f, 0);
     drawRectPrism(w + 0.5f, 0.3f, d + 0.5f);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Windows & Doors
     float floorHeight = h / floors;
@@ -56,21 +49,21 @@ void drawAdminBlock(
             for (int i = 0; i < windowsZ_front; ++i) {
                 float winZ = -d/2.0f + (i+1)*winSpacingZ_front - winSpacingZ_front/2.0f;
                 // Front face
-                glPushMatrix();
-                glTranslatef(w/2.0f + windowDepth/2.0f, currentFloorY + windowHeight/2.0f, winZ);
-                glColor3f(0.5f, 0.7f, 0.8f);
+                rcPushMatrix();
+                rcTranslatef(w/2.0f + windowDepth/2.0f, currentFloorY + windowHeight/2.0f, winZ);
+                rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowDepth, windowHeight, windowWidth*0.8f);
-                glColor3f(r*0.5f, g*0.5f, b*0.5f);
+                rcColor3f(r*0.5f, g*0.5f, b*0.5f);
                 drawRectPrism(windowDepth*1.2f, windowHeight+0.2f, windowWidth*0.8f+0.2f);
-                glPopMatrix();
+                rcPopMatrix();
                 // Back face
-                glPushMatrix();
-                glTranslatef(-w/2.0f - windowDepth/2.0f, currentFloorY + windowHeight/2.0f, winZ);
-                glColor3f(0.5f, 0.7f, 0.8f);
+                rcPushMatrix();
+                rcTranslatef(-w/2.0f - windowDepth/2.0f, currentFloorY + windowHeight/2.0f, winZ);
+                rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowDepth, windowHeight, windowWidth*0.8f);
-                glColor3f(r*0.5f, g*0.5f, b*0.5f);
+                rcColor3f(r*0.5f, g*0.5f, b*0.5f);
                 drawRectPrism(windowDepth*1.2f, windowHeight+0.2f, windowWidth*0.8f+0.2f);
-                glPopMatrix();
+                rcPopMatrix();
             }
         }
 
@@ -80,34 +73,54 @@ void drawAdminBlock(
             for (int i = 0; i < windowsX; ++i) {
                 float winX = -w/2.0f + (i+1)*winSpacingX - winSpacingX/2.0f;
                 // Left face
-                glPushMatrix();
-                glTranslatef(winX, currentFloorY + windowHeight/2.0f, d/2.0f + windowDepth/2.0f);
-                glColor3f(0.5f, 0.7f, 0.8f);
+                rcPushMatrix();
+                rcTranslatef(winX, currentFloorY + windowHeight/2.0f, d/2.0f + windowDepth/2.0f);
+                rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowWidth, windowHeight, windowDepth);
-                glColor3f(r*0.5f, g*0.5f, b*0.5f);
+                rcColor3f(r*0.5f, g*0.5f, b*0.5f);
                 drawRectPrism(windowWidth+0.2f, windowHeight+0.2f, windowDepth*1.2f);
-                glPopMatrix();
+                rcPopMatrix();
                 // Right face
-                glPushMatrix();
-                glTranslatef(winX, currentFloorY + windowHeight/2.0f, -d/2.0f - windowDepth/2.0f);
-                glColor3f(0.5f, 0.7f, 0.8f);
+                rcPushMatrix();
+                rcTranslatef(winX, currentFloorY + windowHeight/2.0f, -d/2.0f - windowDepth/2.0f);
+                rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowWidth, windowHeight, windowDepth);
-                glColor3f(r*0.5f, g*0.5f, b*0.5f);
+                rcColor3f(r*0.5f, g*0.5f, b*0.5f);
                 drawRectPrism(windowWidth+0.2f, windowHeight+0.2f, windowDepth*1.2f);
-                glPopMatrix();
+                rcPopMatrix();
             }
         }
         // Door (only on ground floor, front face, center)
         if (f == 0) {
-            glColor3f(r * 0.4f, g * 0.4f, b * 0.35f);
-            glPushMatrix();
-            glTranslatef(w/2.0f + windowDepth/2.0f, -h/2.0f + doorHeight/2.0f, 0);
+            rcColor3f(r * 0.4f, g * 0.4f, b * 0.35f);
+            rcPushMatrix();
+            rcTranslatef(w/2.0f + windowDepth/2.0f, -h/2.0f + doorHeight/2.0f, 0);
             drawRectPrism(windowDepth*1.5f, doorHeight, doorWidth);
-            glPopMatrix();
+            rcPopMatrix();
         }
     }
-    glPopMatrix();
+    rcPopMatrix();
+}
+
+const BuildingGeometry ADMIN_BLOCK_GEOMETRY = {"admin", adminBlockGeometry};
+
+// Label above building
+void drawAdminBlockLabel(float x, float y, float z, float height, const char* label) {
+    renderText3D(x, y + height + 2, z, GLUT_BITMAP_HELVETICA_12, label, 0.1f, 0.1f, 0.1f);
+}
+
+void drawAdminBlock(
+    float x, float y, float z,
+    float w, float h, float d,
+    float r, float g, float b,
+    int windowsX, int windowsZ_front, int windowsZ_side, int floors,
+    const char* label
+) {
+    BuildingShape shape = {w, h, d, r, g, b, windowsX, windowsZ_front, windowsZ_side, floors};
+    rcPushMatrix();
+    rcTranslatef(x, y, z);
+    drawBuildingMesh(shape, ADMIN_BLOCK_GEOMETRY);
+    rcPopMatrix();
 
-    // Label above building
-    renderText3D(x, y + h + 2, z, GLUT_BITMAP_HELVETICA_12, label, 0.1f, 0.1f, 0.1f);
+    drawAdminBlockLabel(x, y, z, h, label);
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#pragma once
+#include <GL/glut.h>
+
+// Face rules of the mesh baker, shared by the runtime baker (MeshBaker.cpp)
+// and the compile-time one (StaticMesh.h), so both produce the same surfaces.
+// Everything here is constexpr and works on plain arrays.
+
+constexpr float BAKE_EPSILON = 1e-4f; // Positions closer than this count as the same
+
+constexpr float bakeAbs(float v) { return v < 0.0f ? -v : v; }
+constexpr float bakeMin(float a, float b) { return a < b ? a : b; }
+constexpr float bakeMax(float a, float b) { return a > b ? a : b; }
+
+// Axis-aligned box in bake space
+struct BakeBox
+{
+    float lo[3], hi[3];
+};
+
+// Axis-aligned rectangle on a box face. The in-plane axes are (axis + 1) % 3
+// and (axis + 2) % 3, so that their cross product points along +axis.
+struct BakeFace
+{
+    int axis;
+    int sign; // Outward normal along +axis or -axis
+    float plane;
+    float lo[2], hi[2];
+    GLubyte color[4];
+    bool trimmed;
+};
+
+constexpr BakeFace bakeBoxFace(const BakeBox &box, int axis, int sign, const GLubyte color[4])
+{
+    BakeFace f{};
+    f.axis = axis;
+    f.sign = sign;
+    f.plane = sign > 0 ? box.hi[axis] : box.lo[axis];
+    for (int k = 0; k < 2; ++k)
+    {
+        f.lo[k] = box.lo[(axis + 1 + k) % 3];
+        f.hi[k] = box.hi[(axis + 1 + k) % 3];
+    }
+    for (int i = 0; i < 4; ++i)
+        f.color[i] = color[i];
+    return f;
+}
+
+enum BakeCover
+{
+    BAKE_COVER_NONE,
+    BAKE_COVER_TRIMMED,
+    BAKE_COVER_ENCLOSED
+};
+
+// A face is hidden where the space just outside it is inside another box: it
+// is then interior to the union of the boxes. Only removals that leave a
+// single rectangle are made, so no face is split.
+constexpr BakeCover bakeCoverFace(BakeFace &f, const BakeBox &box)
+{
+    int a = f.axis;
+    if (f.plane < box.lo[a] - BAKE_EPSILON || f.plane > box.hi[a] + BAKE_EPSILON)
+        return BAKE_COVER_NONE;
+    if (f.sign > 0 ? box.hi[a] <= f.plane + BAKE_EPSILON : box.lo[a] >= f.plane - BAKE_EPSILON)
+        return BAKE_COVER_NONE; // Flush with the box's own face on this side
+    bool full[2] = {false, false};
+    for (int k = 0; k < 2; ++k)
+    {
+        int axis = (a + 1 + k) % 3;
+        if (box.lo[axis] >= f.hi[k] - BAKE_EPSILON || box.hi[axis] <= f.lo[k] + BAKE_EPSILON)
+            return BAKE_COVER_NONE;
+        full[k] = box.lo[axis] <= f.lo[k] + BAKE_EPSILON && box.hi[axis] >= f.hi[k] - BAKE_EPSILON;
+    }
+    if (full[0] && full[1])
+        return BAKE_COVER_ENCLOSED;
+    for (int k = 0; k < 2; ++k)
+    {
+        if (!full[1 - k])
+            continue;
+        int axis = (a + 1 + k) % 3;
+        if (box.lo[axis] <= f.lo[k] + BAKE_EPSILON)
+        {
+            f.lo[k] = box.hi[axis];
+            return BAKE_COVER_TRIMMED;
+        }
+        if (box.hi[axis] >= f.hi[k] - BAKE_EPSILON)
+        {
+            f.hi[k] = box.lo[axis];
+            return BAKE_COVER_TRIMMED;
+        }
+    }
+    return BAKE_COVER_NONE;
+}
+
+// Trims f against every box until nothing changes; true if it is enclosed
+constexpr bool bakeHideFace(BakeFace &f, const BakeBox *boxes, int boxCount)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = 0; i < boxCount; ++i)
+        {
+            BakeCover cover = bakeCoverFace(f, boxes[i]);
+            if (cover == BAKE_COVER_ENCLOSED)
+                return true;
+            if (cover == BAKE_COVER_TRIMMED)
+            {
+                f.trimmed = true;
+                changed = true;
+            }
+        }
+    }
+    return false;
+}
+
+constexpr bool bakeSameSurface(const BakeFace &a, const BakeFace &b)
+{
+    return a.axis == b.axis && a.sign == b.sign && bakeAbs(a.plane - b.plane) <= BAKE_EPSILON &&
+           a.color[0] == b.color[0] && a.color[1] == b.color[1] && a.color[2] == b.color[2] &&
+           a.color[3] == b.color[3];
+}
+
+constexpr bool bakeRectWithin(const BakeFace &inner, const BakeFace &outer)
+{
+    return inner.lo[0] >= outer.lo[0] - BAKE_EPSILON && inner.hi[0] <= outer.hi[0] + BAKE_EPSILON &&
+           inner.lo[1] >= outer.lo[1] - BAKE_EPSILON && inner.hi[1] <= outer.hi[1] + BAKE_EPSILON;
+}
+
+// Grows a to cover b if together they form one rectangle
+constexpr bool bakeMergeFace(BakeFace &a, const BakeFace &b)
+{
+    if (bakeRectWithin(b, a))
+        return true;
+    if (bakeRectWithin(a, b))
+    {
+        a = b;
+        return true;
+    }
+    for (int k = 0; k < 2; ++k)
+    {
+        int o = 1 - k;
+        if (bakeAbs(a.lo[o] - b.lo[o]) > BAKE_EPSILON || bakeAbs(a.hi[o] - b.hi[o]) > BAKE_EPSILON)
+            continue;
+        // Touching or overlapping along k
+        if (b.lo[k] <= a.hi[k] + BAKE_EPSILON && b.hi[k] >= a.lo[k] - BAKE_EPSILON)
+        {
+            a.lo[k] = bakeMin(a.lo[k], b.lo[k]);
+            a.hi[k] = bakeMax(a.hi[k], b.hi[k]);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Merges coplanar faces of one colour in place; returns the new count
+constexpr int bakeMergeFaces(BakeFace *faces, int count, int &merges)
+{
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (int i = 0; i < count; ++i)
+        {
+            for (int j = i + 1; j < count;)
+            {
+                if (bakeSameSurface(faces[i], faces[j]) && bakeMergeFace(faces[i], faces[j]))
+                {
+                    faces[j] = faces[--count];
+                    ++merges;
+                    merged = true;
+                }
+                else
+                {
+                    ++j;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// Corners counter-clockwise seen from outside, and the normal
+constexpr void bakeFaceCorners(const BakeFace &f, float corners[4][3], float normal[3])
+{
+    int u = (f.axis + 1) % 3, v = (f.axis + 2) % 3;
+    const int sides[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    for (int i = 0; i < 4; ++i)
+    {
+        const int *side = sides[f.sign > 0 ? i : 3 - i];
+        corners[i][f.axis] = f.plane;
+        corners[i][u] = side[0] ? f.hi[0] : f.lo[0];
+        corners[i][v] = side[1] ? f.hi[1] : f.lo[1];
+    }
+    normal[0] = normal[1] = normal[2] = 0.0f;
+    normal[f.axis] = static_cast<float>(f.sign);
+}
+
+// Degenerate once trimmed away to nothing
+constexpr bool bakeFaceEmpty(const BakeFace &f)
+{
+    return f.hi[0] - f.lo[0] <= BAKE_EPSILON || f.hi[1] - f.lo[1] <= BAKE_EPSILON;
+}
@@ -0,0 +1,149 @@
+#include "Benchmark.h"
+#include "Profiler.h"
+#include "RenderBackend.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+// Orbit around the campus: wide views, a low pass between the buildings and
+// a close look at the courts
+static const CameraPose keyPoses[] = {
+    {20.0f, -45.0f, 150.0f, {0.0f, 10.0f, 0.0f}},
+    {35.0f, 10.0f, 210.0f, {0.0f, 10.0f, 0.0f}},
+    {12.0f, 70.0f, 80.0f, {40.0f, 5.0f, -20.0f}},
+    {55.0f, 150.0f, 260.0f, {0.0f, 0.0f, 0.0f}},
+    {8.0f, 230.0f, 60.0f, {-30.0f, 8.0f, 30.0f}},
+    {25.0f, 315.0f, 150.0f, {0.0f, 10.0f, 0.0f}},
+};
+static const int KEY_POSE_COUNT = sizeof(keyPoses) / sizeof(keyPoses[0]);
+static const int FRAMES_PER_SEGMENT = 30;
+static const int POSE_COUNT = (KEY_POSE_COUNT - 1) * FRAMES_PER_SEGMENT + 1;
+static const int WARMUP_FRAMES = 8; // Untimed; first uses of each path pay one-off costs
+static const int DRAIN_FRAMES = 8;  // Lets the last timer queries complete
+
+static bool running = false;
+static int backends[2];
+static int frame = 0;       // Warm-up, two per pose, then the drain frames
+static int frameTag = -1;   // 0 = A, 1 = B, -1 while draining
+static double cpuSumMs[PROFILE_PASS_COUNT][2];
+static int cpuCount[2];
+
+static CameraPose poseAt(int index)
+{
+    int segment = index / FRAMES_PER_SEGMENT;
+    if (segment >= KEY_POSE_COUNT - 1)
+        return keyPoses[KEY_POSE_COUNT - 1];
+    float t = static_cast<float>(index % FRAMES_PER_SEGMENT) / FRAMES_PER_SEGMENT;
+    const CameraPose &a = keyPoses[segment];
+    const CameraPose &b = keyPoses[segment + 1];
+    CameraPose p;
+    p.angleX = a.angleX + (b.angleX - a.angleX) * t;
+    p.angleY = a.angleY + (b.angleY - a.angleY) * t;
+    p.distance = a.distance + (b.distance - a.distance) * t;
+    for (int i = 0; i < 3; ++i)
+        p.lookAt[i] = a.lookAt[i] + (b.lookAt[i] - a.lookAt[i]) * t;
+    return p;
+}
+
+void benchmarkStart(int backendA, int backendB)
+{
+    backends[0] = backendA;
+    backends[1] = backendB;
+    frame = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        cpuCount[i] = 0;
+        for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+            cpuSumMs[p][i] = 0.0;
+    }
+    profilerResetTagged();
+    running = true;
+    std::cout << "Benchmark: " << renderBackendInfo(backendA).name << " vs " << renderBackendInfo(backendB).name
+              << ", " << POSE_COUNT << " poses" << std::endl;
+}
+
+bool benchmarkActive()
+{
+    return running;
+}
+
+bool benchmarkBeginFrame(CameraPose &pose, int &backend)
+{
+    if (!running)
+        return false;
+    int pathFrame = frame - WARMUP_FRAMES;
+    if (pathFrame < 0)
+    {
+        frameTag = -1;
+        pose = poseAt(0);
+        backend = backends[frame % 2];
+    }
+    else if (pathFrame < POSE_COUNT * 2)
+    {
+        // Alternate A, B on each pose; swap the order every other pose so
+        // neither backend always runs on a freshly switched state
+        int poseIndex = pathFrame / 2;
+        frameTag = (pathFrame + poseIndex) % 2;
+        pose = poseAt(poseIndex);
+        backend = backends[frameTag];
+    }
+    else
+    {
+        frameTag = -1;
+        pose = poseAt(POSE_COUNT - 1);
+        backend = backends[0];
+    }
+    profilerSetTag(frameTag);
+    return true;
+}
+
+static void printTimes(const char *label, double a, double b)
+{
+    double delta = b - a;
+    std::cout << "  " << std::left << std::setw(10) << label << std::right << std::setw(9) << a << " ms"
+              << std::setw(10) << b << " ms" << std::setw(10) << std::showpos << delta << " ms";
+    if (a > 0.0)
+        std::cout << std::setw(9) << delta / a * 100.0 << "%";
+    std::cout << std::noshowpos << std::endl;
+}
+
+static void printReport()
+{
+    std::ios_base::fmtflags flags = std::cout.flags(); // Restored after, for everyone else's logs
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Benchmark results (A = " << renderBackendInfo(backends[0]).name
+              << ", B = " << renderBackendInfo(backends[1]).name << ", delta = B - A)" << std::endl;
+    std::cout << " GPU" << std::endl;
+    for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+    {
+        double a = 0.0, b = 0.0;
+        if (profilerTaggedMs(static_cast<ProfilePass>(p), 0, a) && profilerTaggedMs(static_cast<ProfilePass>(p), 1, b))
+            printTimes(profilerPassName(static_cast<ProfilePass>(p)), a, b);
+        else
+            std::cout << "  " << std::left << std::setw(10) << profilerPassName(static_cast<ProfilePass>(p)) << std::right << "       -" << std::endl;
+    }
+    std::cout << " CPU submission" << std::endl;
+    for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+        printTimes(profilerPassName(static_cast<ProfilePass>(p)), cpuSumMs[p][0] / std::max(cpuCount[0], 1), cpuSumMs[p][1] / std::max(cpuCount[1], 1));
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+bool benchmarkEndFrame()
+{
+    if (!running)
+        return false;
+    if (frameTag >= 0)
+    {
+        for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+            cpuSumMs[p][frameTag] += profilerCpuMs(static_cast<ProfilePass>(p));
+        ++cpuCount[frameTag];
+    }
+    if (++frame < WARMUP_FRAMES + POSE_COUNT * 2 + DRAIN_FRAMES)
+        return false;
+    running = false;
+    profilerSetTag(-1);
+    printReport();
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// A/B comparison of two render backends. A fixed camera path is rendered with
+// the animation frozen, each pose twice in a row, once per backend, so both
+// see identical frames under the same clock and thermal conditions. GPU pass
+// times come from the profiler's tagged samples, CPU submission times from
+// profilerCpuMs; the report gives both per pass with the B - A delta.
+
+struct CameraPose
+{
+    float angleX, angleY; // Elevation and azimuth, degrees
+    float distance;
+    float lookAt[3];
+};
+
+// Starts a run comparing backends a and b (RenderBackend.h indices)
+void benchmarkStart(int backendA, int backendB);
+bool benchmarkActive();
+
+// Pose and backend for the next frame; false when no run is in progress
+bool benchmarkBeginFrame(CameraPose &pose, int &backend);
+// Collects the frame's CPU pass times. Returns true once, when the run has
+// finished and the report has been printed.
+bool benchmarkEndFrame();
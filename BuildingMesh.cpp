@@ -0,0 +1,345 @@
+#include "BuildingMesh.h"
+#include "MatrixStack.h"
+#include "MeshBaker.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "RenderQueue.h"
+#include "StaticBuildings.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+
+enum BuildingMeshState
+{
+    MESH_RECORDED, // Waiting for a bake thread
+    MESH_BAKING,   // A worker owns the mesh until the bake is collected
+    MESH_BAKED,
+    MESH_READY // Uploaded
+};
+
+struct CachedBuilding
+{
+    BuildingShape shape;
+    const BuildingGeometry *geometry;
+    BakedMesh mesh;
+    bool precompiled; // Not worth a place in the mesh cache file
+    int refs;         // Stream handles
+    BuildingMeshState state;
+    MeshBakeRecording recording;
+    std::future<void> baking;
+    MeshBakeStats stats;
+    MeshOptimizeStats optimized;
+    std::list<CachedBuilding>::iterator self;
+};
+
+const int BAKE_THREADS = 2;
+
+// A list keeps meshes in place while the render queue and stream handles
+// point at them, whatever else is freed
+static std::list<CachedBuilding> cache;
+static std::unordered_multimap<uint64_t, CachedBuilding *> shapeIndex; // By buildingShapeHash
+static std::deque<CachedBuilding *> bakeQueue;
+static std::vector<CachedBuilding *> bakesRunning;
+static std::deque<CachedBuilding *> uploadQueue;
+static bool cacheFileDirty = false; // Meshes were baked that the cache file lacks
+
+bool sameBuildingShape(const BuildingShape &a, const BuildingShape &b)
+{
+    return a.width == b.width && a.height == b.height && a.depth == b.depth && a.r == b.r && a.g == b.g &&
+           a.b == b.b && a.windowsX == b.windowsX && a.windowsZ_front == b.windowsZ_front &&
+           a.windowsZ_side == b.windowsZ_side && a.floors == b.floors;
+}
+
+uint64_t buildingShapeHash(const BuildingShape &shape, const char *geometry)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const float floats[6] = {shape.width, shape.height, shape.depth, shape.r, shape.g, shape.b};
+    const int ints[4] = {shape.windowsX, shape.windowsZ_front, shape.windowsZ_side, shape.floors};
+    const unsigned char *parts[3] = {reinterpret_cast<const unsigned char *>(floats),
+                                     reinterpret_cast<const unsigned char *>(ints),
+                                     reinterpret_cast<const unsigned char *>(geometry)};
+    const size_t sizes[3] = {sizeof(floats), sizeof(ints), std::strlen(geometry)};
+    for (int p = 0; p < 3; ++p)
+    {
+        for (size_t i = 0; i < sizes[p]; ++i)
+        {
+            hash ^= parts[p][i];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static CachedBuilding *findEntry(const BuildingShape &shape, const BuildingGeometry &geometry)
+{
+    auto range = shapeIndex.equal_range(buildingShapeHash(shape, geometry.name));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second->geometry == &geometry && sameBuildingShape(it->second->shape, shape))
+            return it->second;
+    }
+    return nullptr;
+}
+
+static void logBake(const CachedBuilding &entry)
+{
+    const BuildingShape &shape = entry.shape;
+    const MeshBakeStats &stats = entry.stats;
+    const MeshOptimizeStats &optimized = entry.optimized;
+    std::cout << "Baked building " << shape.width << "x" << shape.height << "x" << shape.depth << ": "
+              << stats.boxes << " boxes, " << stats.trianglesBefore << " -> " << stats.trianglesAfter
+              << " triangles, " << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices ("
+              << stats.facesRemoved << " faces enclosed, " << stats.facesTrimmed << " trimmed, "
+              << stats.facesMerged << " merged)" << std::endl;
+    // Formatted apart so std::cout keeps its float format for everyone else
+    std::ostringstream line;
+    line << "  ACMR " << std::fixed << std::setprecision(2) << optimized.acmrBefore << " -> "
+         << optimized.acmrAfter << ", " << optimized.bytesPerVertexBefore << " -> "
+         << optimized.bytesPerVertexAfter << " bytes/vertex, " << optimized.bytesPerIndexBefore << " -> "
+         << optimized.bytesPerIndexAfter << " bytes/index, " << optimized.paletteSize << " palette colours";
+    std::cout << line.str() << std::endl;
+}
+
+static void bakeEntry(CachedBuilding &entry)
+{
+    meshBakeBuild(entry.recording, entry.mesh, entry.stats);
+    meshOptimize(entry.mesh, entry.optimized);
+}
+
+static void bakeDone(CachedBuilding &entry)
+{
+    logBake(entry);
+    entry.state = MESH_BAKED;
+    cacheFileDirty = true;
+    if (entry.refs > 0)
+        uploadQueue.push_back(&entry);
+}
+
+// Precompiled and cached meshes come ready to upload; the rest are recorded
+// here, as recording goes through the render queue, and baked now or, for
+// streaming, on a bake thread
+static CachedBuilding &addEntry(const BuildingShape &shape, const BuildingGeometry &geometry, bool inBackground)
+{
+    cache.emplace_back();
+    CachedBuilding &entry = cache.back();
+    entry.self = std::prev(cache.end());
+    entry.shape = shape;
+    entry.geometry = &geometry;
+    entry.refs = 0;
+    entry.state = MESH_BAKED;
+    shapeIndex.emplace(buildingShapeHash(shape, geometry.name), &entry);
+
+    entry.precompiled = staticBuildingMesh(shape, geometry.name, entry.mesh);
+    if (entry.precompiled)
+    {
+        std::cout << "Building " << shape.width << "x" << shape.height
+                  << "x" << shape.depth << ": precompiled, " << entry.mesh.indexCount / 3 << " triangles, "
+                  << bakedMeshPackedCount(entry.mesh) << " vertices, " << entry.mesh.palette.size() / 4
+                  << " palette colours" << std::endl;
+        return entry;
+    }
+    if (meshCacheFind(shape, geometry.name, entry.mesh))
+    {
+        std::cout << "Building " << shape.width << "x" << shape.height
+                  << "x" << shape.depth << ": from the mesh cache, " << entry.mesh.indexCount / 3 << " triangles"
+                  << std::endl;
+        return entry;
+    }
+
+    // Record in the building's own space, leaving the current colour as it was
+    const GLfloat *current = rcCurrentColor();
+    GLfloat color[4] = {current[0], current[1], current[2], current[3]};
+    rcPushMatrix();
+    rcLoadMatrix(Mat4());
+    meshBakeBegin();
+    geometry.build(shape);
+    meshBakeTake(entry.recording);
+    rcPopMatrix();
+    rcColor4f(color[0], color[1], color[2], color[3]);
+    if (inBackground)
+    {
+        entry.state = MESH_RECORDED;
+        bakeQueue.push_back(&entry);
+        return entry;
+    }
+    bakeEntry(entry);
+    bakeDone(entry);
+    return entry;
+}
+
+// Brings an entry to MESH_BAKED or beyond, waiting for its bake thread if it has one
+static void finishBake(CachedBuilding &entry)
+{
+    if (entry.state == MESH_RECORDED)
+    {
+        bakeQueue.erase(std::find(bakeQueue.begin(), bakeQueue.end(), &entry));
+        bakeEntry(entry);
+        bakeDone(entry);
+    }
+    else if (entry.state == MESH_BAKING)
+    {
+        entry.baking.get();
+        bakesRunning.erase(std::find(bakesRunning.begin(), bakesRunning.end(), &entry));
+        bakeDone(entry);
+    }
+}
+
+static void freeEntry(CachedBuilding &entry)
+{
+    auto range = shapeIndex.equal_range(buildingShapeHash(entry.shape, entry.geometry->name));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == &entry)
+        {
+            shapeIndex.erase(it);
+            break;
+        }
+    }
+    if (entry.state == MESH_RECORDED)
+        bakeQueue.erase(std::find(bakeQueue.begin(), bakeQueue.end(), &entry));
+    uploadQueue.erase(std::remove(uploadQueue.begin(), uploadQueue.end(), &entry), uploadQueue.end());
+    bakedMeshRelease(entry.mesh);
+    cache.erase(entry.self);
+}
+
+void drawBuildingMesh(const BuildingShape &shape, const BuildingGeometry &geometry)
+{
+    CachedBuilding *entry = findEntry(shape, geometry);
+    if (!entry)
+        entry = &addEntry(shape, geometry, false);
+    else if (entry->state < MESH_BAKED)
+        finishBake(*entry);
+    renderQueueMesh(entry->mesh);
+}
+
+BuildingMeshHandle buildingMeshAcquire(const BuildingShape &shape, const BuildingGeometry &geometry)
+{
+    CachedBuilding *entry = findEntry(shape, geometry);
+    if (!entry)
+        entry = &addEntry(shape, geometry, true);
+    // Meshes drawn before they were streamed still need their upload here
+    if (entry->state == MESH_BAKED && std::find(uploadQueue.begin(), uploadQueue.end(), entry) == uploadQueue.end())
+        uploadQueue.push_back(entry);
+    ++entry->refs;
+    return entry;
+}
+
+void buildingMeshRelease(BuildingMeshHandle handle)
+{
+    if (--handle->refs > 0)
+        return;
+    if (handle->state == MESH_BAKING)
+        return; // Freed when the bake is collected
+    freeEntry(*handle);
+}
+
+bool buildingMeshReady(BuildingMeshHandle handle)
+{
+    return handle->state == MESH_READY;
+}
+
+void buildingMeshStream(size_t uploadBytes, bool wait)
+{
+    for (;;)
+    {
+        for (size_t i = 0; i < bakesRunning.size();)
+        {
+            CachedBuilding &entry = *bakesRunning[i];
+            if (!wait && entry.baking.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++i;
+                continue;
+            }
+            entry.baking.get();
+            bakesRunning.erase(bakesRunning.begin() + i);
+            bakeDone(entry);
+            if (entry.refs == 0)
+                freeEntry(entry); // Released while baking
+        }
+        while (bakesRunning.size() < BAKE_THREADS && !bakeQueue.empty())
+        {
+            CachedBuilding *entry = bakeQueue.front();
+            bakeQueue.pop_front();
+            entry->state = MESH_BAKING;
+            entry->baking = std::async(std::launch::async, bakeEntry, std::ref(*entry));
+            bakesRunning.push_back(entry);
+        }
+        if (!wait || bakesRunning.empty())
+            break;
+    }
+
+    // At least one upload a frame, however large
+    size_t uploaded = 0;
+    while (!uploadQueue.empty() && (wait || uploaded < uploadBytes))
+    {
+        CachedBuilding *entry = uploadQueue.front();
+        uploadQueue.pop_front();
+        uploaded += bakedMeshUpload(entry->mesh);
+        entry->state = MESH_READY;
+    }
+}
+
+bool buildingMeshStreaming()
+{
+    return !bakeQueue.empty() || !bakesRunning.empty() || !uploadQueue.empty();
+}
+
+size_t buildingMeshBytes()
+{
+    size_t bytes = 0;
+    for (const CachedBuilding &entry : cache)
+    {
+        if (entry.state >= MESH_BAKED)
+            bytes += bakedMeshBytes(entry.mesh);
+    }
+    return bytes;
+}
+
+int buildingMeshCount()
+{
+    return static_cast<int>(cache.size());
+}
+
+void buildingMeshCacheOpen(const char *path, uint64_t layoutKey)
+{
+    cacheFileDirty = !meshCacheOpen(path, layoutKey);
+}
+
+void buildingMeshCacheRekey(uint64_t layoutKey)
+{
+    meshCacheRekey(layoutKey);
+    cacheFileDirty = true;
+}
+
+void buildingMeshCacheUpdate()
+{
+    bool writing = meshCachePoll();
+    if (meshCacheReplacePending())
+    {
+        // Called after the frame's draws, so nothing still uses the old file
+        for (CachedBuilding &entry : cache)
+        {
+            if (entry.state >= MESH_BAKED)
+                meshCacheDetach(entry.mesh);
+        }
+        meshCacheReplace();
+    }
+    // Streamed bakes are written together once they settle
+    if (writing || !cacheFileDirty || !meshCacheEnabled() || !bakeQueue.empty() || !bakesRunning.empty())
+        return;
+    std::vector<MeshCacheItem> items;
+    for (const CachedBuilding &entry : cache)
+    {
+        if (!entry.precompiled && entry.state >= MESH_BAKED)
+            items.push_back({entry.shape, entry.geometry->name, &entry.mesh});
+    }
+    meshCacheWrite(items);
+    cacheFileDirty = false;
+}
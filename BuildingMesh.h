@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Buildings are static, so each distinct shape is baked once into an
+// optimised mesh (MeshBaker.h) and drawn from it afterwards. Position and the
+// hover lift stay outside the mesh and come from the modelview.
+
+struct BuildingShape
+{
+    float width, height, depth;
+    float r, g, b;
+    int windowsX, windowsZ_front, windowsZ_side, floors;
+};
+
+bool sameBuildingShape(const BuildingShape &a, const BuildingShape &b);
+// 64-bit FNV-1a of a shape and its generator name, for hashing meshes by shape
+uint64_t buildingShapeHash(const BuildingShape &shape, const char *geometry);
+
+// Issues a building's boxes with drawRectPrism, standing on the origin. The
+// name stands for the generator in the mesh cache file.
+struct BuildingGeometry
+{
+    const char *name;
+    void (*build)(const BuildingShape &shape);
+};
+
+// Draws the building at the current modelview origin. The campus's own shapes
+// come precompiled (StaticBuildings.h), others from the mesh cache file if
+// one is open, the rest are baked from geometry on first use.
+void drawBuildingMesh(const BuildingShape &shape, const BuildingGeometry &geometry);
+
+// Streaming (WorldPartition.h). A handle holds one reference to a shape's
+// mesh, which is freed when the last reference goes. Precompiled and cached
+// meshes are ready at once; others are recorded now and baked on a worker
+// thread, and buildingMeshStream uploads them once they are done. Drawing a
+// shape whose bake is still running waits for it.
+typedef struct CachedBuilding *BuildingMeshHandle;
+BuildingMeshHandle buildingMeshAcquire(const BuildingShape &shape, const BuildingGeometry &geometry);
+void buildingMeshRelease(BuildingMeshHandle handle);
+bool buildingMeshReady(BuildingMeshHandle handle); // Baked and uploaded
+
+// Call once per frame: starts queued bakes, collects finished ones and
+// uploads about uploadBytes of them. With wait set it returns once every
+// requested mesh is baked and uploaded.
+void buildingMeshStream(size_t uploadBytes, bool wait);
+bool buildingMeshStreaming(); // Bakes or uploads outstanding
+// Memory held by the building meshes (bakedMeshBytes), and how many there are
+size_t buildingMeshBytes();
+int buildingMeshCount();
+
+// Opens the mesh cache file (MeshCache.h) for a layout. If it is missing or
+// stale, buildingMeshCacheUpdate rewrites it from the meshes baked this run.
+void buildingMeshCacheOpen(const char *path, uint64_t layoutKey);
+// After a layout reload: keys the cache file to the new layout, to be
+// rewritten by buildingMeshCacheUpdate
+void buildingMeshCacheRekey(uint64_t layoutKey);
+// Call once per frame, after its draws: starts a background write when meshes
+// were baked that the file lacks, and puts finished writes in place of the file
+void buildingMeshCacheUpdate();
@@ -1,4 +1,5 @@
 #pragma once
+#include "BuildingMesh.h"
 
 // Draws a cafe building at the given position with all parameters and label
 void drawCafe(
@@ -7,4 +8,10 @@ void drawCafe(
     float r, float g, float b,
     int windowsX, int windowsZ_front, int windowsZ_side, int floors,
     const char* label
-);
\ No newline at end of file
+);
+
+// Just the label, for when the building itself is drawn some other way
+void drawCafeLabel(float x, float y, float z, float height, const char* label);
+
+// Its boxes, for requesting meshes ahead of drawing (WorldPartition.h)
+extern const BuildingGeometry CAFE_GEOMETRY;
@@ -4,6 +4,33 @@
 #include "Dormitory.h"
 #include "Cafe.h"
 #include "Library.h"
+#include "Simulation.h"
+#include "GLExt.h"
+#include "SceneTarget.h"
+#include "Profiler.h"
+#include "DynamicResolution.h"
+#include "Options.h"
+#include "Quality.h"
+#include "SphereMesh.h"
+#include "CubeBatch.h"
+#include "GLState.h"
+#include "ShaderPipeline.h"
+#include "ImmediateMode.h"
+#include "RenderBackend.h"
+#include "Benchmark.h"
+#include "Validation.h"
+#include "CampusLayout.h"
+#include "BuildingMesh.h"
+#include "MeshCache.h"
+#include "LayoutDiff.h"
+#include "LayoutBvh.h"
+#include "FileWatch.h"
+#include "WorldPartition.h"
+#include "CampusImpostor.h"
+#include "LayoutPvs.h"
+#include "OcclusionCulling.h"
+#include "Overdraw.h"
+#include "ShadowMap.h"
 #include <GL/glut.h>
 #include <cmath>
 #include <vector>
@@ -12,6 +39,9 @@
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
 
 // --- Configuration & Global Variables ---
 
@@ -30,6 +60,8 @@ float camAngleY = -45.0f;   // Azimuth angle
 float camDistance = 150.0f; // Distance from origin
 float camLookAtX = 0.0f, camLookAtY = 10.0f, camLookAtZ = 0.0f;
 float camPosX, camPosY, camPosZ;
+Mat4 viewMatrix;       // Set by updateCameraPosition
+Mat4 projectionMatrix; // Set by campusReshape
 
 // Mouse interaction for camera
 int lastMouseX, lastMouseY;
@@ -52,6 +84,13 @@ bool hoveredMensDorm1 = false;
 bool hoveredMensDorm2 = false;
 bool hoveredAvailability = false;
 
+// Hover flag of each info box slot (LayoutBuilding::slot)
+const int BUILDING_SLOT_COUNT = 11;
+bool *const hoveredSlot[BUILDING_SLOT_COUNT] = {
+    &hoveredAdminBlock, &hoveredAcademic1, &hoveredAcademic2, &hoveredAcademic3,
+    &hoveredAcademic4, &hoveredLibrary, &hoveredWomensDorm1, &hoveredWomensDorm2,
+    &hoveredMensDorm1, &hoveredMensDorm2, &hoveredCafe};
+
 bool isSelecedAdminBlock = false;
 bool isSelecedAcademic1 = false;
 bool isSelecedAcademic2 = false;
@@ -82,11 +121,75 @@ void setSelectedFalse()
     isSelecedMensDorm2 = false;
 }
 
-// Animation
+// Animation (render-side copies of the interpolated simulation state, see Simulation.h)
 bool isNightMode = false;
+bool overdrawView = false; // Fragments per pixel as a heatmap instead of the scene (Overdraw.h)
 float sunAngle = 0.0f; // For sun/moon movement
 float cloudOffset = 0.0f;
-const int NUM_CLOUDS = 10;
+int renderRateHz = 60; // Redisplay timer rate, 0 = redraw only on input
+int renderTimerGeneration = 0; // Invalidates timers armed at an older rate
+bool sceneFrameDue = true; // Set by the redisplay timer; other redraws reuse the last animation state
+int viewportWidth = WINDOW_WIDTH, viewportHeight = WINDOW_HEIGHT;
+const float CAMERA_FOV_Y = 50.0f;
+
+// Everything the 3D pass depends on. While it is unchanged the offscreen
+// scene render is reused and only the HUD is redrawn.
+struct SceneKey
+{
+    float camPos[3];
+    float camLookAt[3];
+    float sunAngle, cloudOffset;
+    bool nightMode;
+    bool hovered[BUILDING_SLOT_COUNT]; // Hovered buildings are drawn lifted
+    int qualityLevel;
+    bool overdrawView;
+    int viewportW, viewportH;
+    unsigned layoutGeneration;
+    unsigned streamGeneration; // Chunks switching between detail and proxies
+    unsigned impostorGeneration; // Impostor cells captured
+    unsigned occlusionGeneration; // Hidden buildings found visible
+};
+SceneKey lastSceneKey;
+unsigned layoutGeneration = 0; // Bumped by each layout reload
+
+// Far overviews draw the campus as its impostor (CampusImpostor.h). The key
+// holds what the impostor's cells were captured under.
+struct ImpostorKey
+{
+    unsigned layoutGeneration, streamGeneration;
+    bool nightMode;
+    float sunAngle;
+    bool hovered[BUILDING_SLOT_COUNT];
+    int qualityLevel;
+};
+ImpostorKey impostorKey;
+bool impostorActive = false;           // This frame draws the impostor
+const float IMPOSTOR_SUN_STEP = 4.0f; // Degrees the sun moves before the cells are captured again
+
+// Sun shadows (ShadowMap.h). The maps follow the sun themselves; the key holds
+// the rest of what the static map was rendered with.
+struct ShadowKey
+{
+    unsigned layoutGeneration, streamGeneration;
+    bool hovered[BUILDING_SLOT_COUNT];
+    int qualityLevel;
+};
+ShadowKey shadowKey;
+bool shadowsActive = false;   // This frame is shadowed
+unsigned cloudGeneration = 0; // Bumped whenever the clouds are placed anew
+float shadowCloudOffset = 0.0f;
+unsigned shadowCloudGeneration = 0;
+const float SHADOW_MIN_ELEVATION = 5.0f;   // Degrees; a lower sun casts no shadows
+const float SHADOW_FADE = 10.0f;           // Degrees above that over which they fade in
+const float SHADOW_STRENGTH = 0.45f;       // Share of the colour lost in full shadow
+const float CLOUD_SHADOW_STRENGTH = 0.25f; // The same under a cloud
+
+// Restored when a benchmark started from the keyboard finishes
+CameraPose poseBeforeBenchmark;
+int backendBeforeBenchmark = 0;
+bool exitAfterBenchmark = false; // Runs started from the command line
+bool startupTaskPending = true;  // Command-line capture/validate/benchmark, run on the first frame
+const int NUM_CLOUDS = 10; // Generated; the quality level decides how many are drawn
 struct Cloud
 {
     float x, y, z;
@@ -106,9 +209,17 @@ struct Car
     bool movingForward; // Direction along path segment
 };
 std::vector<Car> cars;
-std::vector<std::pair<float, float>> carPath = {
-    {-80, 40}, {-30, 40}, {-30, -50}, {30, -50}, {30, 40}, {80, 40}, {80, -50}, {-80, -50}, {-80, 40} // Loop back
-};
+std::vector<std::pair<float, float>> carPath; // The layout's route, loops back to its start
+
+// Layout objects the layout BVH finds in view this pass, per section in table
+// order: in full detail, and as proxies where their chunk is not streamed in
+std::vector<uint32_t> visibleObjects[LAYOUT_ROUTE];
+std::vector<uint32_t> proxyObjects[LAYOUT_ROUTE];
+std::vector<uint32_t> layoutQuery;
+
+// Per layout building kind, for streaming building meshes in ahead of drawing
+const BuildingGeometry *const buildingGeometries[LAYOUT_BUILDING_KIND_COUNT] = {
+    &ACADEMIC_BLOCK_GEOMETRY, &LIBRARY_GEOMETRY, &DORMITORY_GEOMETRY, &ADMIN_BLOCK_GEOMETRY, &CAFE_GEOMETRY};
 
 // --- Utility Functions ---
 
@@ -119,46 +230,40 @@ void drawInfoBox(int topY, int rightX, int rectWidth, int rectHeight, const std:
     int x = WINDOW_WIDTH - rectWidth - rightX; // 10px from right edge
     int y = WINDOW_HEIGHT - topY;  
 
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+    rcPushProjection(mat4Ortho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT));
+    rcPushMatrix();
+    rcLoadMatrix(Mat4());
 
-    glDisable(GL_LIGHTING);
-    glDisable(GL_DEPTH_TEST); // <--- Disable depth test for overlay
+    glsDisable(GL_LIGHTING);
+    glsDisable(GL_DEPTH_TEST); // <--- Disable depth test for overlay
     if (isHoveredUserBox)
     {
-        glColor3f(0.5f, 0.5f, 0.5f); // light gray background
+        rcColor3f(0.5f, 0.5f, 0.5f); // light gray background
     }
     else
     {
-        glColor3f(0.95f, 0.95f, 0.95f);
+        rcColor3f(0.95f, 0.95f, 0.95f);
     }
 
-    glBegin(GL_QUADS);
-    glVertex2i(x, y);
-    glVertex2i(x + rectWidth, y);
-    glVertex2i(x + rectWidth, y - rectHeight);
-    glVertex2i(x, y - rectHeight);
-    glEnd();
+    imBegin(GL_QUADS);
+    imVertex2f(x, y);
+    imVertex2f(x + rectWidth, y);
+    imVertex2f(x + rectWidth, y - rectHeight);
+    imVertex2f(x, y - rectHeight);
+    imEnd();
 
-    glColor3f(0.0f, 0.0f, 0.0f);
-    glRasterPos2i(x + 15, y - 15);
+    rcColor3f(0.0f, 0.0f, 0.0f);
+    rcRasterPos3f(x + 15, y - 15, 0);
 
 for (char c : text)
     glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
 
-    glEnable(GL_DEPTH_TEST); // <--- Re-enable depth test for 3D scene
-    glEnable(GL_LIGHTING);
+    glsEnable(GL_DEPTH_TEST); // <--- Re-enable depth test for 3D scene
+    glsEnable(GL_LIGHTING);
 
     // Restore matrices
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
+    rcPopMatrix();
+    rcPopProjection();
 }
 
 
@@ -167,28 +272,19 @@ void updateCameraPosition()
     float radX = camAngleX * M_PI / 180.0f;
     float radY = camAngleY * M_PI / 180.0f;
 
-    camPosX = camLookAtX + camDistance * cos(radX) * sin(radY);
-    camPosY = camLookAtY + camDistance * sin(radX);
-    camPosZ = camLookAtZ + camDistance * cos(radX) * cos(radY);
-}
-
-void drawCube(float size)
-{
-    glutSolidCube(size);
-}
-
-void drawRectPrism(float w, float h, float d)
-{
-    glPushMatrix();
-    glScalef(w, h, d);
-    glutSolidCube(1.0);
-    glPopMatrix();
+    Vec3 lookAt(camLookAtX, camLookAtY, camLookAtZ);
+    Vec3 offset(cos(radX) * sin(radY), sin(radX), cos(radX) * cos(radY));
+    Vec3 eye = lookAt + offset * camDistance;
+    camPosX = eye.x;
+    camPosY = eye.y;
+    camPosZ = eye.z;
+    viewMatrix = mat4LookAt(eye, lookAt, Vec3(0.0f, 1.0f, 0.0f));
 }
 
 void renderText3D(float x, float y, float z, void *font, const std::string &text, float r, float g, float b)
 {
-    glColor3f(r, g, b);
-    glRasterPos3f(x, y, z);
+    rcColor3f(r, g, b);
+    rcRasterPos3f(x, y, z);
     for (char c : text)
     {
         glutBitmapCharacter(font, c);
@@ -197,13 +293,14 @@ void renderText3D(float x, float y, float z, void *font, const std::string &text
 
 void initLighting()
 {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
+    glsEnable(GL_LIGHTING);
+    glsEnable(GL_LIGHT0);
+    glsEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
-    glEnable(GL_NORMALIZE);
+    glsEnable(GL_NORMALIZE);
     float globalAmbient[] = {0.3f, 0.3f, 0.3f, 1.0f};
     glLightModelfv(GL_LIGHT_MODEL_AMBIENT, globalAmbient);
+    shaderPipelineSetGlobalAmbient(Vec4(globalAmbient[0], globalAmbient[1], globalAmbient[2], globalAmbient[3]));
     glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
 }
 
@@ -220,18 +317,309 @@ void initClouds()
         c.speed = 0.05f + (rand() % 100) / 2000.0f;
         clouds.push_back(c);
     }
+    ++cloudGeneration;
+}
+
+CameraPose currentCameraPose()
+{
+    CameraPose pose = {camAngleX, camAngleY, camDistance, {camLookAtX, camLookAtY, camLookAtZ}};
+    return pose;
+}
+
+void applyCameraPose(const CameraPose &pose)
+{
+    camAngleX = pose.angleX;
+    camAngleY = pose.angleY;
+    camDistance = pose.distance;
+    camLookAtX = pose.lookAt[0];
+    camLookAtY = pose.lookAt[1];
+    camLookAtZ = pose.lookAt[2];
+    updateCameraPosition();
+}
+
+void drawScene3D();
+void updateCampusShadows();
+
+size_t streamBudgetBytes()
+{
+    return static_cast<size_t>(campusOptions.streamBudgetMb * 1048576.0f);
+}
+
+// Streams chunks around the look-at; waiting makes everything in range detailed now
+void streamCampus(bool wait)
+{
+    worldPartitionUpdate(camLookAtX, camLookAtZ, campusOptions.streamRadius, streamBudgetBytes(), wait);
+}
+
+// Renders a validation shot into the scene target (or the back buffer) at
+// full resolution and ultra quality, then restores everything it pinned
+void renderValidationShot(const ValidationShot &shot, Image &out)
+{
+    CameraPose savedPose = currentCameraPose();
+    float savedSunAngle = sunAngle, savedCloudOffset = cloudOffset;
+    bool savedNightMode = isNightMode, savedOverdrawView = overdrawView;
+    std::vector<Cloud> savedClouds = clouds;
+    int savedQuality = qualityLevel();
+    bool savedQualityFixed = qualityIsFixed();
+
+    applyCameraPose(shot.pose);
+    streamCampus(true);
+    layoutPvsPoll(true);
+    occlusionCullingForget(); // Results from other views would lag behind the shot
+    sunAngle = shot.sunAngle;
+    cloudOffset = shot.cloudOffset;
+    isNightMode = shot.night;
+    overdrawView = false;
+    qualitySetFixed(QUALITY_LEVEL_COUNT - 1);
+    srand(shot.seed); // Clouds, lit windows and star twinkle all come from rand()
+    initClouds();
+    sceneTargetSetScale(1.0f);
+    updateCampusShadows();
+
+    int width = viewportWidth, height = viewportHeight;
+    if (sceneTargetAvailable())
+    {
+        sceneTargetBegin();
+        sceneTargetSize(width, height);
+    }
+    drawScene3D();
+    out.width = width;
+    out.height = height;
+    out.rgb.resize(static_cast<size_t>(width) * height * 3);
+    std::vector<unsigned char> rows(out.rgb.size());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+    for (int y = 0; y < height; ++y) // GL rows run bottom-up
+        std::copy_n(&rows[static_cast<size_t>(height - 1 - y) * width * 3], width * 3, &out.rgb[static_cast<size_t>(y) * width * 3]);
+    if (sceneTargetAvailable())
+        sceneTargetEnd();
+
+    applyCameraPose(savedPose);
+    sunAngle = savedSunAngle;
+    cloudOffset = savedCloudOffset;
+    isNightMode = savedNightMode;
+    overdrawView = savedOverdrawView;
+    clouds = savedClouds;
+    ++cloudGeneration;
+    qualitySetFixed(savedQuality);
+    if (!savedQualityFixed)
+        qualitySetFixed(-1);
+    sceneTargetSetScale(dynamicResolutionScale());
+    sceneTargetInvalidate();
+}
+
+DiffTolerance diffTolerance()
+{
+    DiffTolerance tolerance = {campusOptions.diffDeltaE, campusOptions.diffMaxFailPercent / 100.0};
+    return tolerance;
+}
+
+void startBenchmark(int backendA, int backendB, bool exitWhenDone)
+{
+    for (int backend : {backendA, backendB})
+    {
+        if (!renderBackendInfo(backend).available())
+        {
+            std::cout << "Backend " << renderBackendInfo(backend).name << " unavailable, no benchmark" << std::endl;
+            return;
+        }
+    }
+    // Speedups only count if the frames still match
+    if (!validationCompareBackends(backendA, backendB, renderValidationShot, diffTolerance()))
+    {
+        std::cout << "Benchmark refused: " << renderBackendInfo(backendB).name << " does not render like "
+                  << renderBackendInfo(backendA).name << std::endl;
+        if (exitWhenDone)
+        {
+            simShutdown();
+            exit(1);
+        }
+        return;
+    }
+    poseBeforeBenchmark = currentCameraPose();
+    backendBeforeBenchmark = renderBackendCurrent();
+    exitAfterBenchmark = exitWhenDone;
+    benchmarkStart(backendA, backendB);
+    glutPostRedisplay();
+}
+
+void finishBenchmark()
+{
+    if (exitAfterBenchmark)
+    {
+        simShutdown();
+        exit(0);
+    }
+    applyCameraPose(poseBeforeBenchmark);
+    renderBackendSelect(backendBeforeBenchmark);
+    sceneTargetInvalidate();
+    glutPostRedisplay();
+}
+
+// Capture, validate and benchmark runs requested on the command line
+void runStartupTask()
+{
+    bool ok = true;
+    if (campusOptions.captureDir)
+        ok = validationCapture(campusOptions.captureDir, renderValidationShot);
+    else if (campusOptions.validateDir)
+        ok = validationCompareReference(campusOptions.validateDir, renderValidationShot, diffTolerance());
+    else if (campusOptions.benchmarkBackends[0] >= 0)
+        startBenchmark(campusOptions.benchmarkBackends[0], campusOptions.benchmarkBackends[1], true);
+    else
+        return;
+
+    if (campusOptions.captureDir || campusOptions.validateDir)
+    {
+        simShutdown();
+        exit(ok ? 0 : 1);
+    }
+}
+
+void loadCarPath()
+{
+    const CampusLayout &layout = campusLayout();
+    carPath.clear();
+    for (uint32_t i = 0; i < layout.routeCount; ++i)
+        carPath.push_back({layout.route[i].x, layout.route[i].z});
+}
+
+// Everything the scene draws and the picker tests is placed by the layout
+// The impostor and the shadow maps cover the ground plane and every layout
+// object but the route
+void setCampusBounds(const CampusLayout &layout)
+{
+    float lo[3] = {-125.0f, -1.0f, -125.0f}, hi[3] = {125.0f, 8.5f, 125.0f};
+    for (uint32_t i = 0; i < layout.aabbCount; ++i)
+    {
+        const LayoutAabb &box = layout.aabbs[i];
+        if (box.section >= LAYOUT_ROUTE)
+            continue;
+        for (int k = 0; k < 3; ++k)
+        {
+            lo[k] = std::min(lo[k], box.min[k]);
+            hi[k] = std::max(hi[k], box.max[k]);
+        }
+    }
+    Vec3 center(0.5f * (lo[0] + hi[0]), 0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2]));
+    float radius = length(Vec3(hi[0], hi[1], hi[2]) - center);
+    impostorSetBounds(center, radius);
+    shadowMapSetBounds(center, radius);
+}
+
+void loadCampusLayout()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (!campusOptions.layoutPath)
+        campusLayoutLoadDefault();
+    else if (!campusLayoutLoad(campusOptions.layoutPath, error))
+    {
+        std::cout << "Layout " << campusOptions.layoutPath << ": " << error << ", using the built-in campus"
+                  << std::endl;
+        campusLayoutLoadDefault();
+    }
+    const CampusLayout &layout = campusLayout();
+    layoutBvhBuild(layout);
+    worldPartitionBuild(layout, buildingGeometries);
+    setCampusBounds(layout);
+    layoutPvsBuild(layout);
+    occlusionCullingReset(layout.aabbCount);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    LayoutBvhStats bvh = layoutBvhStats();
+    std::cout << "Layout: " << layout.aabbCount << " objects (" << layout.buildingCount << " buildings), BVH "
+              << bvh.nodes << " nodes " << bvh.depth << " deep, in " << ms << " ms" << std::endl;
+    loadCarPath();
+
+    std::string meshCache = campusOptions.meshCachePath ? campusOptions.meshCachePath : "";
+    if (meshCache.empty() && campusOptions.layoutPath)
+        meshCache = std::string(campusOptions.layoutPath) + ".meshes";
+    if (!meshCache.empty())
+        buildingMeshCacheOpen(meshCache.c_str(), meshCacheLayoutKey(layout.image, layout.imageSize));
+}
+
+// Applies an edited layout file. Only what changed is redone: the BVH is
+// refit around changed objects, only the chunks holding them load again, and
+// occlusion results carry over for the rest. Building meshes are per shape, so
+// those chunks only bake new shapes and only free shapes no longer used.
+void reloadCampusLayout()
+{
+    auto start = std::chrono::steady_clock::now();
+    LayoutDiff diff;
+    std::string error;
+    if (!campusLayoutReload(campusOptions.layoutPath, diff, error))
+    {
+        std::cout << "Layout " << campusOptions.layoutPath << ": " << error << ", keeping the current one"
+                  << std::endl;
+        return;
+    }
+    const CampusLayout &layout = campusLayout();
+    uint32_t changes = layoutDiffChanges(diff);
+    if (changes == 0 && !diff.routeChanged && layoutDiffKeepsIndices(diff, layout.aabbCount))
+        return; // Saved without edits; reordered records still renumber everything below
+    layoutBvhUpdate(layout, diff);
+    if (diff.routeChanged)
+        loadCarPath();
+
+    int meshesBefore = buildingMeshCount();
+    worldPartitionApply(layout, diff);
+    setCampusBounds(layout);
+    layoutPvsBuild(layout);
+    occlusionCullingRemap(diff.aabbs, layout.aabbCount);
+    if (meshCacheEnabled())
+        buildingMeshCacheRekey(meshCacheLayoutKey(layout.image, layout.imageSize));
+    for (int slot = 0; slot < BUILDING_SLOT_COUNT; ++slot)
+        *hoveredSlot[slot] = false; // Picked again at the next mouse move
+    ++layoutGeneration;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    LayoutBvhStats bvh = layoutBvhStats();
+    std::cout << "Layout reloaded: " << changes << " of " << layout.aabbCount << " objects changed (+"
+              << diff.aabbs.added.size() << " -" << diff.aabbs.removed.size() << " ~" << diff.aabbs.modified.size()
+              << "), building meshes " << meshesBefore << " -> " << buildingMeshCount() << ", BVH " << (bvh.rebuilt ? "rebuilt" : "refit") << " ("
+              << bvh.refitNodes << " of " << bvh.nodes << " nodes) in " << ms << " ms" << std::endl;
+    glutPostRedisplay();
+}
+
+const int LAYOUT_WATCH_MS = 50;
+
+void layoutWatchTimer(int value)
+{
+    if (fileWatchChanged())
+        reloadCampusLayout();
+    glutTimerFunc(LAYOUT_WATCH_MS, layoutWatchTimer, value);
 }
 
 void campusInit()
 {
+    loadCampusLayout();
+    if (campusOptions.layoutPath && campusOptions.watchLayout && fileWatchStart(campusOptions.layoutPath))
+        glutTimerFunc(LAYOUT_WATCH_MS, layoutWatchTimer, 0);
+    glExtInit();
+    shaderPipelineInit();
+    if (!renderBackendSelect(campusOptions.backend))
+        std::cout << "Backend " << renderBackendInfo(campusOptions.backend).name << " unavailable, using "
+                  << renderBackendInfo(renderBackendCurrent()).name << std::endl;
+    profilerInit();
+    occlusionCullingInit();
+    qualityInit();
+    dynamicResolutionReset();
+    sceneTargetSetScale(dynamicResolutionScale());
+    sceneTargetInit(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+    impostorInit();
+    shadowMapInit();
+    sphereMeshInit();
     glClearColor(0.5f, 0.7f, 1.0f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
+    glsEnable(GL_DEPTH_TEST);
     glShadeModel(GL_SMOOTH);
     initLighting();
     updateCameraPosition();
     srand(static_cast<unsigned int>(time(nullptr)));
     initClouds();
-    glEnable(GL_BLEND);
+    SimState initialState = {sunAngle, cloudOffset, isNightMode};
+    simInit(initialState);
+    glsEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
@@ -246,116 +634,179 @@ void campusInit()
 void drawGroundPlane()
 {
     // --- Main grassy ground ---
-    glColor3f(0.3f, 0.6f, 0.25f); // Green grass
-    glPushMatrix();
-    glTranslatef(0, -0.5f, 0);
-    glScalef(250.0f, 1.0f, 250.0f);
+    rcColor3f(0.3f, 0.6f, 0.25f); // Green grass
+    rcPushMatrix();
+    rcTranslatef(0, -0.5f, 0);
+    rcScalef(250.0f, 1.0f, 250.0f);
     drawCube(1.0); // Main ground
-    glPopMatrix();
+    rcPopMatrix();
 
     float halfSize = 125.0f;
     float fenceHeight = 8.5f;
     float fenceThickness = 0.3f;
 
     // --- Fence on all four sides ---
-    glColor3f(0.4f, 0.4f, 0.4f);
+    rcColor3f(0.4f, 0.4f, 0.4f);
 
     // Front
-    glPushMatrix();
-    glTranslatef(0, fenceHeight / 2, halfSize);
+    rcPushMatrix();
+    rcTranslatef(0, fenceHeight / 2, halfSize);
     drawRectPrism(250.0f, fenceHeight, fenceThickness);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Back
-    glPushMatrix();
-    glTranslatef(0, fenceHeight / 2, -halfSize);
+    rcPushMatrix();
+    rcTranslatef(0, fenceHeight / 2, -halfSize);
     drawRectPrism(250.0f, fenceHeight, fenceThickness);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Left
-    glPushMatrix();
-    glTranslatef(-halfSize, fenceHeight / 2, 0);
+    rcPushMatrix();
+    rcTranslatef(-halfSize, fenceHeight / 2, 0);
     drawRectPrism(fenceThickness, fenceHeight, 250.0f);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Right
-    glPushMatrix();
-    glTranslatef(halfSize, fenceHeight / 2, 0);
+    rcPushMatrix();
+    rcTranslatef(halfSize, fenceHeight / 2, 0);
     drawRectPrism(fenceThickness, fenceHeight, 250.0f);
-    glPopMatrix();
+    rcPopMatrix();
 
     // --- Road patches near gates (gray) ---
-    glColor3f(0.18f, 0.18f, 0.20f); // Asphalt road color
+    rcColor3f(0.18f, 0.18f, 0.20f); // Asphalt road color
     float roadW = 10.0f;
     float roadL = 80.0f;
     float roadY = 0.01f;
 
     // NW gate road (top-left)
-    glPushMatrix();
-    glTranslatef(-halfSize + 5.0f, roadY, -halfSize + roadL / 2);
+    rcPushMatrix();
+    rcTranslatef(-halfSize + 5.0f, roadY, -halfSize + roadL / 2);
     drawRectPrism(roadW, 0.05f, roadL);
-    glPopMatrix();
+    rcPopMatrix();
 
     // SE gate road (bottom-right)
-    glPushMatrix();
-    glTranslatef(halfSize - 5.0f, roadY, halfSize - roadL / 2);
+    rcPushMatrix();
+    rcTranslatef(halfSize - 5.0f, roadY, halfSize - roadL / 2);
     drawRectPrism(roadW, 0.05f, roadL);
-    glPopMatrix();
+    rcPopMatrix();
 
     // --- Realistic steel blue gates ---
     float gateW = 4.0f, gateH = 5.5f, gateD = 0.2f, post = 0.4f;
 
     // Gate color
-    glColor3f(0.3f, 0.4f, 0.5f); // Metal gray-blue
+    rcColor3f(0.3f, 0.4f, 0.5f); // Metal gray-blue
 
     // NW Gate
     float gateX_NW = -halfSize + 5.0f;
     float gateZ_NW = -halfSize + gateD / 2;
 
-    glPushMatrix();
-    glTranslatef(gateX_NW - gateW / 2, gateH / 2, gateZ_NW);
+    rcPushMatrix();
+    rcTranslatef(gateX_NW - gateW / 2, gateH / 2, gateZ_NW);
     drawRectPrism(gateW, gateH, gateD);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(gateX_NW + gateW / 2, gateH / 2, gateZ_NW);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(gateX_NW + gateW / 2, gateH / 2, gateZ_NW);
     drawRectPrism(gateW, gateH, gateD);
-    glPopMatrix();
+    rcPopMatrix();
 
-    glColor3f(0.4f, 0.4f, 0.4f); // Pillars
-    glPushMatrix();
-    glTranslatef(gateX_NW - gateW - post / 2, gateH / 2, gateZ_NW);
+    rcColor3f(0.4f, 0.4f, 0.4f); // Pillars
+    rcPushMatrix();
+    rcTranslatef(gateX_NW - gateW - post / 2, gateH / 2, gateZ_NW);
     drawRectPrism(post, gateH, post);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(gateX_NW + gateW + post / 2, gateH / 2, gateZ_NW);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(gateX_NW + gateW + post / 2, gateH / 2, gateZ_NW);
     drawRectPrism(post, gateH, post);
-    glPopMatrix();
+    rcPopMatrix();
 
     // SE Gate
     float gateX_SE = halfSize - 5.0f;
     float gateZ_SE = halfSize - gateD / 2;
 
-    glColor3f(0.3f, 0.4f, 0.5f);
-    glPushMatrix();
-    glTranslatef(gateX_SE - gateW / 2, gateH / 2, gateZ_SE);
+    rcColor3f(0.3f, 0.4f, 0.5f);
+    rcPushMatrix();
+    rcTranslatef(gateX_SE - gateW / 2, gateH / 2, gateZ_SE);
     drawRectPrism(gateW, gateH, gateD);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(gateX_SE + gateW / 2, gateH / 2, gateZ_SE);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(gateX_SE + gateW / 2, gateH / 2, gateZ_SE);
     drawRectPrism(gateW, gateH, gateD);
-    glPopMatrix();
+    rcPopMatrix();
 
-    glColor3f(0.4f, 0.4f, 0.4f);
-    glPushMatrix();
-    glTranslatef(gateX_SE - gateW - post / 2, gateH / 2, gateZ_SE);
+    rcColor3f(0.4f, 0.4f, 0.4f);
+    rcPushMatrix();
+    rcTranslatef(gateX_SE - gateW - post / 2, gateH / 2, gateZ_SE);
     drawRectPrism(post, gateH, post);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(gateX_SE + gateW + post / 2, gateH / 2, gateZ_SE);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(gateX_SE + gateW + post / 2, gateH / 2, gateZ_SE);
     drawRectPrism(post, gateH, post);
-    glPopMatrix();
+    rcPopMatrix();
 
-    glEnable(GL_LIGHTING);
+    glsEnable(GL_LIGHTING);
+}
+
+// Sun by day, moon by night
+void sunColor(float &r, float &g, float &b, float &intensity)
+{
+    if (isNightMode)
+    {
+        r = 0.85f;
+        g = 0.85f;
+        b = 0.75f; // Moon color
+        intensity = 0.35f;
+    }
+    else
+    {
+        r = 1.0f;
+        g = 0.85f;
+        b = 0.2f; // Sun color
+        intensity = 1.0f;
+    }
+}
+
+// Lights the scene from the sun or moon; the modelview must hold the view
+void applySunLight()
+{
+    float sunR, sunG, sunB, lightIntensity;
+    sunColor(sunR, sunG, sunB, lightIntensity);
+    float sunX = 200.0f * cos(sunAngle * M_PI / 180.0f);
+    float sunY = 200.0f * sin(sunAngle * M_PI / 180.0f);
+    float sunZ = 0;
+
+    // Update light0 position and properties
+    GLfloat light_position[] = {sunX, sunY, sunZ, 1.0f};
+    GLfloat light_diffuse[] = {lightIntensity * sunR, lightIntensity * sunG, lightIntensity * sunB, 1.0f};
+    GLfloat light_ambient[] = {lightIntensity * 0.3f, lightIntensity * 0.3f, lightIntensity * 0.3f, 1.0f}; // Slightly more ambient from sun/moon
+
+    rcSyncModelview(); // The light position is transformed by the view
+    glLightfv(GL_LIGHT0, GL_POSITION, light_position);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
+    shaderPipelineSetLight(rcModelview() * Vec4(sunX, sunY, sunZ, 1.0f),
+                           Vec4(light_diffuse[0], light_diffuse[1], light_diffuse[2], light_diffuse[3]),
+                           Vec4(light_ambient[0], light_ambient[1], light_ambient[2], light_ambient[3]));
+}
+
+// Toward the sun or moon, as applySunLight places it
+Vec3 sunDirection()
+{
+    return Vec3(cos(sunAngle * M_PI / 180.0f), sin(sunAngle * M_PI / 180.0f), 0.0f);
+}
+
+// Degrees above the horizon
+float sunElevation()
+{
+    return asin(sunDirection().y) * 180.0f / M_PI;
+}
+
+// Shadows what is drawn next under this view, as deep as the light is strong
+void bindCampusShadows(const Mat4 &view)
+{
+    float sunR, sunG, sunB, lightIntensity;
+    sunColor(sunR, sunG, sunB, lightIntensity);
+    float strength = lightIntensity * std::min((sunElevation() - SHADOW_MIN_ELEVATION) / SHADOW_FADE, 1.0f);
+    shadowMapBind(view, 1.0f - SHADOW_STRENGTH * strength, 1.0f - CLOUD_SHADOW_STRENGTH * strength);
 }
 
 void drawSkyAndSunMoon()
@@ -372,10 +823,6 @@ void drawSkyAndSunMoon()
         skyR2 = 0.1f;
         skyG2 = 0.1f;
         skyB2 = 0.3f; // Top night sky
-        sunR = 0.85f;
-        sunG = 0.85f;
-        sunB = 0.75f; // Moon color
-        lightIntensity = 0.35f;
     }
     else
     {
@@ -385,71 +832,54 @@ void drawSkyAndSunMoon()
         skyR2 = 0.3f;
         skyG2 = 0.6f;
         skyB2 = 0.9f; // Top day sky (zenith)
-        sunR = 1.0f;
-        sunG = 0.85f;
-        sunB = 0.2f; // Sun color
-        lightIntensity = 1.0f;
     }
+    sunColor(sunR, sunG, sunB, lightIntensity);
     // Set clear color to average sky color, actual gradient drawn with a large quad
     glClearColor((skyR1 + skyR2) / 2.0f, (skyG1 + skyG2) / 2.0f, (skyB1 + skyB2) / 2.0f, 1.0f);
 
     // Draw Sky Dome/Box (simple large quad for now)
-    glDisable(GL_LIGHTING);
-    glDepthMask(GL_FALSE); // Draw sky behind everything
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, 1, 0, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    glBegin(GL_QUADS);
-    glColor3f(skyR1, skyG1, skyB1);
-    glVertex2f(0, 0);
-    glVertex2f(1, 0);
-    glColor3f(skyR2, skyG2, skyB2);
-    glVertex2f(1, 1);
-    glVertex2f(0, 1);
-    glEnd();
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glDepthMask(GL_TRUE);
-    glEnable(GL_LIGHTING);
+    glsDisable(GL_LIGHTING);
+    glsDepthMask(GL_FALSE); // Draw sky behind everything
+    rcPushProjection(mat4Ortho2D(0, 1, 0, 1));
+    rcPushMatrix();
+    rcLoadMatrix(Mat4());
+    imBegin(GL_QUADS);
+    rcColor3f(skyR1, skyG1, skyB1);
+    imVertex2f(0, 0);
+    imVertex2f(1, 0);
+    rcColor3f(skyR2, skyG2, skyB2);
+    imVertex2f(1, 1);
+    imVertex2f(0, 1);
+    imEnd();
+    rcPopMatrix();
+    rcPopProjection();
+    glsDepthMask(GL_TRUE);
+    glsEnable(GL_LIGHTING);
 
     // Sun/Moon position
     float sunX = 200.0f * cos(sunAngle * M_PI / 180.0f); // Further away
     float sunY = 200.0f * sin(sunAngle * M_PI / 180.0f);
     float sunZ = 0;
-
-    // Update light0 position and properties
-    GLfloat light_position[] = {sunX, sunY, sunZ, 1.0f};
-    GLfloat light_diffuse[] = {lightIntensity * sunR, lightIntensity * sunG, lightIntensity * sunB, 1.0f};
-    GLfloat light_ambient[] = {lightIntensity * 0.3f, lightIntensity * 0.3f, lightIntensity * 0.3f, 1.0f}; // Slightly more ambient from sun/moon
-
-    glLightfv(GL_LIGHT0, GL_POSITION, light_position);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
+    applySunLight();
 
     // Draw the sun/moon object
-    glDisable(GL_LIGHTING);
-    glColor3f(sunR, sunG, sunB);
-    glPushMatrix();
+    glsDisable(GL_LIGHTING);
+    rcColor3f(sunR, sunG, sunB);
+    rcPushMatrix();
     // Place sun/moon relative to camera lookAt but very far, so it seems to be at infinity
     // This is a simplification. A true skybox or skydome would handle this better.
-    glTranslatef(camLookAtX + sunX * 0.8f, camLookAtY + sunY * 0.8f, camLookAtZ + sunZ * 0.8f);
-    glutSolidSphere(isNightMode ? 10.0 : 12.0, 20, 20); // Slightly larger
-    glPopMatrix();
-    glEnable(GL_LIGHTING);
+    rcTranslatef(camLookAtX + sunX * 0.8f, camLookAtY + sunY * 0.8f, camLookAtZ + sunZ * 0.8f);
+    drawSphere(isNightMode ? 10.0f : 12.0f); // Slightly larger
+    rcPopMatrix();
+    glsEnable(GL_LIGHTING);
 
     // Stars at night
     if (isNightMode)
     {
-        glDisable(GL_LIGHTING);
-        glColor3f(1.0f, 1.0f, 0.9f);
-        glBegin(GL_POINTS);
-        for (int i = 0; i < 150; ++i)
+        glsDisable(GL_LIGHTING);
+        rcColor3f(1.0f, 1.0f, 0.9f);
+        imBegin(GL_POINTS);
+        for (int i = 0; i < qualitySettings().starCount; ++i)
         {
             float r = 250.0f;
             // Use a hash-like formula for random angles per star
@@ -460,123 +890,135 @@ void drawSkyAndSunMoon()
                 // Twinkle: vary size per frame and star
                 float twinkle = 1.5f + (float)((rand() + i * 31) % 10) / 10.0f;
                 glPointSize(twinkle);
-                glVertex3f(
+                imVertex3f(
                     camLookAtX + r * cos(phi) * cos(theta),
                     camLookAtY + r * sin(phi),
                     camLookAtZ + r * cos(phi) * sin(theta)
                 );
             }
         }
-        glEnd();
-        glEnable(GL_LIGHTING);
+        imEnd();
+        glsEnable(GL_LIGHTING);
     }
 }
 
+// Composite cloud from several spheres, in the current colour
+void drawCloudPuffs(float x, float y, float z, float scale)
+{
+    rcPushMatrix();
+    rcTranslatef(x, y, z);
+    const SphereInstance puffs[] = {
+        {0.0f, 0.0f, 0.0f, 1.0f * scale},
+        {0.7f * scale, 0.15f * scale, 0.1f * scale, 0.85f * scale},
+        {-0.8f * scale, 0.05f * scale, 0.35f * scale, 0.9f * scale},
+        {-0.3f * scale, -0.15f * scale, 0.05f * scale, 0.7f * scale},
+    };
+    drawSphereInstances(puffs, 4);
+    rcPopMatrix();
+}
+
 void drawSingleCloud(float x, float y, float z, float scale)
 {
-    glColor4f(0.92f, 0.92f, 0.98f, 0.75f); // Slightly brighter, still semi-transparent
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    // Composite cloud from several spheres
-    glutSolidSphere(1.0 * scale, 12, 12);
-    glTranslatef(0.7f * scale, 0.15f * scale, 0.1f * scale);
-    glutSolidSphere(0.85f * scale, 10, 10);
-    glTranslatef(-1.5f * scale, -0.1f * scale, 0.25f * scale);
-    glutSolidSphere(0.9f * scale, 10, 10);
-    glTranslatef(0.5f * scale, -0.2f * scale, -0.3f * scale);
-    glutSolidSphere(0.7f * scale, 8, 8);
-    glPopMatrix();
+    rcColor4f(0.92f, 0.92f, 0.98f, 0.75f); // Slightly brighter, still semi-transparent
+    drawCloudPuffs(x, y, z, scale);
 }
 
+// The puffs are translucent, so the render queue draws them after everything
+// opaque, blended and without depth writes
 void drawAnimatedClouds()
 {
-    glEnable(GL_BLEND);
-    glDepthMask(GL_FALSE);
-
-    for (const auto &cloud : clouds)
+    int cloudCount = std::min(qualitySettings().cloudCount, static_cast<int>(clouds.size()));
+    for (int i = 0; i < cloudCount; ++i)
     {
+        const Cloud &cloud = clouds[i];
         // Reduce the multiplier for slower movement
         drawSingleCloud(cloud.x + cloudOffset * cloud.speed * 2.0f, cloud.y, cloud.z, cloud.scale);
     }
-
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
 }
 
-void drawRoads()
+// Draws the clouds into the dynamic shadow map, opaque so they write depth
+void drawCloudShadowCasters(const Mat4 &projection, const Mat4 &view)
 {
-    glColor3f(0.18f, 0.18f, 0.20f); // Darker asphalt color
-    // Main horizontal road
-    glPushMatrix();
-    glTranslatef(0, 0.05f, 0);          // Closer to ground
-    drawRectPrism(180.0f, 0.1f, 12.0f); // Wider roads
-    glPopMatrix();
+    Mat4 sceneView = viewMatrix;
+    viewMatrix = view;
+    rcPushProjection(projection);
+    rcLoadMatrix(viewMatrix);
+    renderQueueBegin();
+    rcColor3f(1.0f, 1.0f, 1.0f);
+    int cloudCount = std::min(qualitySettings().cloudCount, static_cast<int>(clouds.size()));
+    for (int i = 0; i < cloudCount; ++i)
+    {
+        const Cloud &cloud = clouds[i];
+        drawCloudPuffs(cloud.x + cloudOffset * cloud.speed * 2.0f, cloud.y, cloud.z, cloud.scale);
+    }
+    renderQueueFlush();
+    rcPopProjection();
+    viewMatrix = sceneView;
+}
 
-    // Main vertical road
-    glPushMatrix();
-    glTranslatef(-30, 0.05f, 0);
-    drawRectPrism(12.0f, 0.1f, 120.0f);
-    glPopMatrix();
+const float ROAD_MARKING_SPACING = 12.0f;
+const float ROAD_MARKING_MARGIN = 10.0f; // Unmarked stretch at each end
+const float ROAD_LANE_OFFSET = 2.5f;     // Markings either side of the centre line
+
+void drawRoadSurface(const LayoutRoad &road)
+{
+    bool alongX = road.axis == 0;
+    rcPushMatrix();
+    rcTranslatef(road.position[0], road.position[1], road.position[2]);
+    drawRectPrism(alongX ? road.length : road.width, 0.1f, alongX ? road.width : road.length);
+    rcPopMatrix();
+}
 
-    glPushMatrix();
-    glTranslatef(30, 0.05f, 0);
-    drawRectPrism(12.0f, 0.1f, 120.0f);
-    glPopMatrix();
+void drawRoads()
+{
+    const CampusLayout &layout = campusLayout();
+    const std::vector<uint32_t> &roads = visibleObjects[LAYOUT_ROADS];
+    rcColor3f(0.18f, 0.18f, 0.20f); // Darker asphalt color
+    for (uint32_t i : roads)
+        drawRoadSurface(layout.roads[i]);
 
     // Road lines (thinner, more off-white)
-    glColor3f(0.85f, 0.85f, 0.8f);
-    glDisable(GL_LIGHTING); // Make lines emissive-like
-    for (int i = -80; i < 80; i += 12)
-    { // Adjusted spacing
-        glPushMatrix();
-        glTranslatef(static_cast<float>(i), 0.1f, 2.5f); // Centered on a 2-lane road
-        drawRectPrism(6.0f, 0.05f, 0.3f);                // Thinner lines
-        glTranslatef(0, 0, -5.0f);
-        drawRectPrism(6.0f, 0.05f, 0.3f);
-        glPopMatrix();
-    }
-    for (int i = -50; i < 50; i += 12)
-    { // Vertical road lines
-        glPushMatrix();
-        glTranslatef(-30 + 2.5f, 0.1f, static_cast<float>(i));
-        glRotatef(90, 0, 1, 0);
-        drawRectPrism(6.0f, 0.05f, 0.3f);
-        glPopMatrix();
-
-        glPushMatrix();
-        glTranslatef(-30 - 2.5f, 0.1f, static_cast<float>(i));
-        glRotatef(90, 0, 1, 0);
-        drawRectPrism(6.0f, 0.05f, 0.3f);
-        glPopMatrix();
-
-        glPushMatrix();
-        glTranslatef(30 + 2.5f, 0.1f, static_cast<float>(i));
-        glRotatef(90, 0, 1, 0);
-        drawRectPrism(6.0f, 0.05f, 0.3f);
-        glPopMatrix();
-
-        glPushMatrix();
-        glTranslatef(30 - 2.5f, 0.1f, static_cast<float>(i));
-        glRotatef(90, 0, 1, 0);
-        drawRectPrism(6.0f, 0.05f, 0.3f);
-        glPopMatrix();
-    }
-    glEnable(GL_LIGHTING);
+    rcColor3f(0.85f, 0.85f, 0.8f);
+    glsDisable(GL_LIGHTING); // Make lines emissive-like
+    for (uint32_t i : roads)
+    {
+        const LayoutRoad &road = layout.roads[i];
+        float end = road.length / 2.0f - ROAD_MARKING_MARGIN;
+        for (float along = -end; along < end; along += ROAD_MARKING_SPACING)
+        {
+            for (float lane = ROAD_LANE_OFFSET; lane >= -ROAD_LANE_OFFSET; lane -= 2.0f * ROAD_LANE_OFFSET)
+            {
+                rcPushMatrix();
+                if (road.axis == 0)
+                {
+                    rcTranslatef(road.position[0] + along, road.position[1] + 0.05f, road.position[2] + lane);
+                }
+                else
+                {
+                    rcTranslatef(road.position[0] + lane, road.position[1] + 0.05f, road.position[2] + along);
+                    rcRotatef(90, 0, 1, 0);
+                }
+                drawRectPrism(6.0f, 0.05f, 0.3f);
+                rcPopMatrix();
+            }
+        }
+    }
+    glsEnable(GL_LIGHTING);
 }
 
 void drawDetailedBuilding(float x, float y, float z, float w, float h, float d, float r, float g, float b, int windowsX, int windowsZ_front, int windowsZ_side, int floors)
 {
-    glColor3f(r, g, b);
-    glPushMatrix();
-    glTranslatef(x, y + h / 2.0f, z);
+    rcColor3f(r, g, b);
+    rcPushMatrix();
+    rcTranslatef(x, y + h / 2.0f, z);
     drawRectPrism(w, h, d); // Main structure
 
     // Roof
-    glColor3f(r * 0.6f, g * 0.6f, b * 0.6f); // Darker roof
-    glPushMatrix();
-    glTranslatef(0, h / 2.0f + 0.15f, 0);    // Thinner roof lip
+    rcColor3f(r * 0.6f, g * 0.6f, b * 0.6f); // Darker roof
+    rcPushMatrix();
+    rcTranslatef(0, h / 2.0f + 0.15f, 0);    // Thinner roof lip
     drawRectPrism(w + 0.5f, 0.3f, d + 0.5f); // Slightly smaller overhang
-    glPopMatrix();
+    rcPopMatrix();
 
     // Windows & Doors
     float floorHeight = h / floors;
@@ -599,27 +1041,27 @@ void drawDetailedBuilding(float x, float y, float z, float w, float h, float d,
             {
                 float winZ = -d / 2.0f + (i + 1) * winSpacingZ_front - winSpacingZ_front / 2.0f;
                 // Front face
-                glPushMatrix();
-                glTranslatef(w / 2.0f + windowDepth / 2.0f, currentFloorY + windowHeight / 2.0f, winZ);
+                rcPushMatrix();
+                rcTranslatef(w / 2.0f + windowDepth / 2.0f, currentFloorY + windowHeight / 2.0f, winZ);
                 if (isNightMode && (rand() % 3 == 0))
-                    glColor3f(0.9f, 0.8f, 0.3f); // Lit window
+                    rcColor3f(0.9f, 0.8f, 0.3f); // Lit window
                 else
-                    glColor3f(0.5f, 0.7f, 0.8f);                                                   // Day window / Unlit
+                    rcColor3f(0.5f, 0.7f, 0.8f);                                                   // Day window / Unlit
                 drawRectPrism(windowDepth, windowHeight, windowWidth * 0.8f);                      // Window pane
-                glColor3f(r * 0.5f, g * 0.5f, b * 0.5f);                                           // Frame
+                rcColor3f(r * 0.5f, g * 0.5f, b * 0.5f);                                           // Frame
                 drawRectPrism(windowDepth * 1.2f, windowHeight + 0.2f, windowWidth * 0.8f + 0.2f); // Frame
-                glPopMatrix();
+                rcPopMatrix();
                 // Back face (optional, can skip if not visible)
-                glPushMatrix();
-                glTranslatef(-w / 2.0f - windowDepth / 2.0f, currentFloorY + windowHeight / 2.0f, winZ);
+                rcPushMatrix();
+                rcTranslatef(-w / 2.0f - windowDepth / 2.0f, currentFloorY + windowHeight / 2.0f, winZ);
                 if (isNightMode && (rand() % 3 == 0))
-                    glColor3f(0.9f, 0.8f, 0.3f);
+                    rcColor3f(0.9f, 0.8f, 0.3f);
                 else
-                    glColor3f(0.5f, 0.7f, 0.8f);
+                    rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowDepth, windowHeight, windowWidth * 0.8f);
-                glColor3f(r * 0.5f, g * 0.5f, b * 0.5f);
+                rcColor3f(r * 0.5f, g * 0.5f, b * 0.5f);
                 drawRectPrism(windowDepth * 1.2f, windowHeight + 0.2f, windowWidth * 0.8f + 0.2f);
-                glPopMatrix();
+                rcPopMatrix();
             }
         }
 
@@ -631,90 +1073,91 @@ void drawDetailedBuilding(float x, float y, float z, float w, float h, float d,
             {
                 float winX = -w / 2.0f + (i + 1) * winSpacingX - winSpacingX / 2.0f;
                 // Left face
-                glPushMatrix();
-                glTranslatef(winX, currentFloorY + windowHeight / 2.0f, d / 2.0f + windowDepth / 2.0f);
+                rcPushMatrix();
+                rcTranslatef(winX, currentFloorY + windowHeight / 2.0f, d / 2.0f + windowDepth / 2.0f);
                 if (isNightMode && (rand() % 3 == 0))
-                    glColor3f(0.9f, 0.8f, 0.3f);
+                    rcColor3f(0.9f, 0.8f, 0.3f);
                 else
-                    glColor3f(0.5f, 0.7f, 0.8f);
+                    rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowWidth, windowHeight, windowDepth);
-                glColor3f(r * 0.5f, g * 0.5f, b * 0.5f);
+                rcColor3f(r * 0.5f, g * 0.5f, b * 0.5f);
                 drawRectPrism(windowWidth + 0.2f, windowHeight + 0.2f, windowDepth * 1.2f);
-                glPopMatrix();
+                rcPopMatrix();
                 // Right face (optional)
-                glPushMatrix();
-                glTranslatef(winX, currentFloorY + windowHeight / 2.0f, -d / 2.0f - windowDepth / 2.0f);
+                rcPushMatrix();
+                rcTranslatef(winX, currentFloorY + windowHeight / 2.0f, -d / 2.0f - windowDepth / 2.0f);
                 if (isNightMode && (rand() % 3 == 0))
-                    glColor3f(0.9f, 0.8f, 0.3f);
+                    rcColor3f(0.9f, 0.8f, 0.3f);
                 else
-                    glColor3f(0.5f, 0.7f, 0.8f);
+                    rcColor3f(0.5f, 0.7f, 0.8f);
                 drawRectPrism(windowWidth, windowHeight, windowDepth);
-                glColor3f(r * 0.5f, g * 0.5f, b * 0.5f);
+                rcColor3f(r * 0.5f, g * 0.5f, b * 0.5f);
                 drawRectPrism(windowWidth + 0.2f, windowHeight + 0.2f, windowDepth * 1.2f);
-                glPopMatrix();
+                rcPopMatrix();
             }
         }
         // Door (only on ground floor, front face, center)
         if (f == 0)
         {
-            glColor3f(r * 0.4f, g * 0.4f, b * 0.35f); // Darker door color
-            glPushMatrix();
-            glTranslatef(w / 2.0f + windowDepth / 2.0f, -h / 2.0f + doorHeight / 2.0f, 0); // Centered on Z
+            rcColor3f(r * 0.4f, g * 0.4f, b * 0.35f); // Darker door color
+            rcPushMatrix();
+            rcTranslatef(w / 2.0f + windowDepth / 2.0f, -h / 2.0f + doorHeight / 2.0f, 0); // Centered on Z
             drawRectPrism(windowDepth * 1.5f, doorHeight, doorWidth);
-            glPopMatrix();
+            rcPopMatrix();
         }
     }
-    glPopMatrix(); // End of building transformation
+    rcPopMatrix(); // End of building transformation
 }
 
 void drawTree(float x, float y, float z)
 {
     // Tree trunk
-    glColor3f(0.4f, 0.26f, 0.13f); // Dark brown
-    glPushMatrix();
-    glTranslatef(x, y + 2.0f, z);
-    glScalef(0.5f, 4.0f, 0.5f);
+    rcColor3f(0.4f, 0.26f, 0.13f); // Dark brown
+    rcPushMatrix();
+    rcTranslatef(x, y + 2.0f, z);
+    rcScalef(0.5f, 4.0f, 0.5f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Canopy layers (three overlapping green spheres for realism)
-    glColor3f(0.0f, 0.5f, 0.0f); // Dark green
-    glPushMatrix();
-    glTranslatef(x, y + 6.0f, z);
-    glutSolidSphere(2.0, 16, 16);
-    glTranslatef(0.7f, 0.5f, 0.3f);
-    glutSolidSphere(1.5, 16, 16);
-    glTranslatef(-1.4f, 0.0f, -0.6f);
-    glutSolidSphere(1.5, 16, 16);
-    glPopMatrix();
+    rcColor3f(0.0f, 0.5f, 0.0f); // Dark green
+    rcPushMatrix();
+    rcTranslatef(x, y + 6.0f, z);
+    const SphereInstance canopy[] = {
+        {0.0f, 0.0f, 0.0f, 2.0f},
+        {0.7f, 0.5f, 0.3f, 1.5f},
+        {-0.7f, 0.5f, -0.3f, 1.5f},
+    };
+    drawSphereInstances(canopy, 3);
+    rcPopMatrix();
 }
 
 void drawChair(float x, float y, float z)
 {
-    glColor3f(0.6f, 0.4f, 0.2f); // Wooden color
+    rcColor3f(0.6f, 0.4f, 0.2f); // Wooden color
 
     // Seat
-    glPushMatrix();
-    glTranslatef(x, y + 0.5f, z);
-    glScalef(2.2f, 0.2f, 1.0f);
+    rcPushMatrix();
+    rcTranslatef(x, y + 0.5f, z);
+    rcScalef(2.2f, 0.2f, 1.0f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Backrest
-    glPushMatrix();
-    glTranslatef(x, y + 1.0f, z - 0.45f);
-    glScalef(2.2f, 1.0f, 0.2f);
+    rcPushMatrix();
+    rcTranslatef(x, y + 1.0f, z - 0.45f);
+    rcScalef(2.2f, 1.0f, 0.2f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Armrests
     for (float dx = -0.55f; dx <= 0.55f; dx += 1.1f)
     {
-        glPushMatrix();
-        glTranslatef(x + dx, y + 0.75f, z);
-        glScalef(0.1f, 0.1f, 1.0f);
+        rcPushMatrix();
+        rcTranslatef(x + dx, y + 0.75f, z);
+        rcScalef(0.1f, 0.1f, 1.0f);
         drawCube(1.0);
-        glPopMatrix();
+        rcPopMatrix();
     }
 
     // Legs
@@ -722,187 +1165,166 @@ void drawChair(float x, float y, float z)
     {
         for (float dz = -0.45f; dz <= 0.45f; dz += 0.9f)
         {
-            glPushMatrix();
-            glTranslatef(x + dx, y, z + dz);
-            glScalef(0.1f, 0.5f, 0.1f);
+            rcPushMatrix();
+            rcTranslatef(x + dx, y, z + dz);
+            rcScalef(0.1f, 0.5f, 0.1f);
             drawCube(1.0);
-            glPopMatrix();
+            rcPopMatrix();
         }
     }
 }
 
 void drawPathTile(float x, float y, float z)
 {
-    glColor3f(0.5f, 0.5f, 0.5f); // Stone gray
-    glPushMatrix();
-    glTranslatef(x, y + 0.01f, z);
-    glScalef(1.0f, 0.05f, 1.0f);
+    rcColor3f(0.5f, 0.5f, 0.5f); // Stone gray
+    rcPushMatrix();
+    rcTranslatef(x, y + 0.01f, z);
+    rcScalef(1.0f, 0.05f, 1.0f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 }
 
-void drawWalkingPath(float startX, float zCenter, int tileCount)
+void drawWalkingPath(float startX, float y, float zCenter, int tileCount)
 {
     for (int i = 0; i < tileCount; ++i)
     {
-        drawPathTile(startX + i * 1.1f, 0, zCenter);
+        drawPathTile(startX + i * 1.1f, y, zCenter);
     }
 }
 
 void drawGardenArea()
 {
     // Wider grass patch
-    glColor3f(0.2f, 0.6f, 0.25f); // Grass green
-    glPushMatrix();
-    glTranslatef(-19, -0.5f, 85);
-    glScalef(60.0f, 1.02f, 30.0f);
+    rcColor3f(0.2f, 0.6f, 0.25f); // Grass green
+    rcPushMatrix();
+    rcTranslatef(-19, -0.5f, 85);
+    rcScalef(60.0f, 1.02f, 30.0f);
     drawCube(1.0);
-    glPopMatrix();
-
-    // Walking path
-    drawWalkingPath(-48, 85, 46);
+    rcPopMatrix();
 
-    // Trees around the area
-    drawTree(-45, 0, 78);
-    drawTree(-38, 0, 92);
-    drawTree(-30, 0, 76);
-    drawTree(-22, 0, 95);
-    drawTree(-14, 0, 79);
-    drawTree(-6, 0, 94);
-    drawTree(2, 0, 76);
-    drawTree(10, 0, 93);
+    // Its walking path and trees come from the layout
 
     // === CHAIRS ===
-    glPushMatrix();
-    glTranslatef(-43, 0, 82);
+    rcPushMatrix();
+    rcTranslatef(-43, 0, 82);
     drawChair(0, 0, 0);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(-30, 0, 82);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(-30, 0, 82);
     drawChair(0, 0, 0);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(-17, 0, 82);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(-17, 0, 82);
     drawChair(0, 0, 0);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(-6, 0, 82);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(-6, 0, 82);
     drawChair(0, 0, 0);
-    glPopMatrix();
+    rcPopMatrix();
 
-    glPushMatrix();
-    glTranslatef(-38, 0, 89);
-    glRotatef(180, 0, 1, 0);
+    rcPushMatrix();
+    rcTranslatef(-38, 0, 89);
+    rcRotatef(180, 0, 1, 0);
     drawChair(0, 0, 0);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(-25, 0, 89);
-    glRotatef(180, 0, 1, 0);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(-25, 0, 89);
+    rcRotatef(180, 0, 1, 0);
     drawChair(0, 0, 0);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(-12, 0, 89);
-    glRotatef(180, 0, 1, 0);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(-12, 0, 89);
+    rcRotatef(180, 0, 1, 0);
     drawChair(0, 0, 0);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(-1, 0, 89);
-    glRotatef(180, 0, 1, 0);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(-1, 0, 89);
+    rcRotatef(180, 0, 1, 0);
     drawChair(0, 0, 0);
-    glPopMatrix();
+    rcPopMatrix();
 }
 
-void drawCampusBuildings()
-{
-
-    // Shared Academic Block parameters
-    float abWidth = 35, abHeight = 30, abDepth = 18;
-    float abR = 0.75f, abG = 0.65f, abB = 0.58f;
-    int abXSeg = 3, abYSeg = 5, abZSeg = 2, abWindowDepth = 4;
-
-    float yAdmin = 0;
-    float yLibrary = 0;
-    float yCafe = 0;
-    float yDormW1 = 0;
-    float yDormW2 = 0;
-    float yDormM1 = 0;
-    float yDormM2 = 0;
-    float yAcedem1 = 0;
-    float yAcedem2 = 0;
-    float yAcedem3 = 0;
-    float yAcedem4 = 0;
-
-    if(hoveredAdminBlock)
-    {yAdmin= 0.5;}
-    else {yAdmin = 0;}
-
-    if(hoveredLibrary){yLibrary = 0.5;}
-    else {yLibrary = 0;}
-
-    if(hoveredCafe){yCafe=0.5;}
-    else {yCafe = 0;}
-
-    if(hoveredAcademic1){yAcedem1=0.5;}
-    else {yAcedem1 = 0;}
-
-    if(hoveredAcademic2){yAcedem2=0.5;}
-    else {yAcedem2 = 0;}
-
-    if(hoveredAcademic3){yAcedem3=0.5;}
-    else {yAcedem3 = 0;}
-    if(hoveredAcademic4){yAcedem4=0.5;}
-    else {yAcedem4 = 0;}
-
-    if(hoveredWomensDorm1){yDormW1=0.5;}
-    else {yDormW1 = 0;}
-
-    if(hoveredWomensDorm2){yDormW2=0.5;}
-    else {yDormW2 = 0;}
-
-    if(hoveredMensDorm1){yDormM1=0.5;}
-    else {yDormM1 = 0;}
-
-    if(hoveredMensDorm2){yDormM2=0.5;}
-    else {yDormM2 = 0;}
+typedef void (*BuildingDrawer)(float x, float y, float z, float width, float height, float depth, float r,
+                               float g, float b, int windowsX, int windowsZ_front, int windowsZ_side, int floors,
+                               const char *label);
+const BuildingDrawer buildingDrawers[LAYOUT_BUILDING_KIND_COUNT] = {drawAcademicBlock, drawLibrary, drawDormitory,
+                                                                    drawAdminBlock, drawCafe};
+typedef void (*BuildingLabelDrawer)(float x, float y, float z, float height, const char *label);
+const BuildingLabelDrawer buildingLabelDrawers[LAYOUT_BUILDING_KIND_COUNT] = {
+    drawAcademicBlockLabel, drawLibraryLabel, drawDormitoryLabel, drawAdminBlockLabel, drawCafeLabel};
 
+bool buildingHovered(const LayoutBuilding &building)
+{
+    return building.slot >= 0 && building.slot < BUILDING_SLOT_COUNT && *hoveredSlot[building.slot];
+}
 
-    // Academic Blocks
-    // Example parameters, repeat for each block:
-     drawAcademicBlock(-60, yAcedem1, -25, 35, 30, 18, 0.75f, 0.65f, 0.58f, 3, 5, 2, 4, "Academic Block 1");
-     drawAcademicBlock(-60, yAcedem2, 25, 35, 30, 18, 0.75f, 0.65f, 0.58f, 3, 5, 2, 4, "Academic Block 2");
-     drawAcademicBlock(-100, yAcedem3, -25, 35, 30, 18, 0.75f, 0.65f, 0.58f, 3, 5, 2, 4, "Academic Block 3"); 
-     drawAcademicBlock(-100, yAcedem4, 25, 35, 30, 18, 0.75f, 0.65f, 0.58f, 3, 5, 2, 4, "Academic Block 4");
+void drawCampusBuildings()
+{
+    const CampusLayout &layout = campusLayout();
+    for (uint32_t i : visibleObjects[LAYOUT_BUILDINGS])
+    {
+        const LayoutBuilding &b = layout.buildings[i];
+        if (b.kind >= LAYOUT_BUILDING_KIND_COUNT)
+            continue;
+        float y = b.position[1] + (buildingHovered(b) ? 0.5f : 0.0f); // Hovered buildings lift
+        buildingDrawers[b.kind](b.position[0], y, b.position[2], b.size[0], b.size[1], b.size[2], b.color[0],
+                                b.color[1], b.color[2], b.windowsX, b.windowsZFront, b.windowsZSide, b.floors,
+                                layoutString(layout, b.label));
+    }
 
-    // Library
-    drawLibrary(
-        0, yLibrary, -25,
-        35, 45, 28,
-        0.85f, 0.8f, 0.75f,
-        5, 4, 3, 5,
-        "Central Library");
+    // Garden behind Cafe
+    drawGardenArea();
+}
 
-    // Hostels
-    drawDormitory(70, yDormM1, -60, 18, 24, 12, 0.74f, 0.74f, 0.67f, 2, 3, 2, 4, "Mens Dorm 1");
-    drawDormitory(70, yDormM2, -35, 18, 24, 12, 0.72f, 0.74f, 0.65f, 2, 3, 2, 4, "Mens Dorm 2");
-    drawDormitory(70, yDormW1, 35,  18, 24, 12, 0.75f, 0.75f, 0.68f, 2, 3, 2, 4, "Womens Dorm 1");
-    drawDormitory(70, yDormW2, 60,  18, 24, 12, 0.76f, 0.75f, 0.68f, 2, 3, 2, 4, "Womens Dorm 2");
-    // Admin Block
+// The same without labels, for impostor cells
+void drawCampusBuildingMeshes()
+{
+    const CampusLayout &layout = campusLayout();
+    for (uint32_t i : visibleObjects[LAYOUT_BUILDINGS])
+    {
+        const LayoutBuilding &b = layout.buildings[i];
+        if (b.kind >= LAYOUT_BUILDING_KIND_COUNT)
+            continue;
+        rcPushMatrix();
+        rcTranslatef(b.position[0], b.position[1] + (buildingHovered(b) ? 0.5f : 0.0f), b.position[2]);
+        drawBuildingMesh(layoutBuildingShape(b), *buildingGeometries[b.kind]);
+        rcPopMatrix();
+    }
+    drawGardenArea();
+}
 
-drawAdminBlock(0, yAdmin, 25, 26, 20, 16, 0.85f, 0.85f, 0.7f, 2, 3, 2, 3, "Admin Block");
-    // Cafe
-    drawCafe(0, yCafe, 50, 16, 12, 12, 0.9f, 0.75f, 0.75f, 2, 2, 2, 2, "Cafe");
+// Bitmap labels keep their size on screen, so they stay live over the impostor
+void drawCampusLabels()
+{
+    const CampusLayout &layout = campusLayout();
+    for (uint32_t i : visibleObjects[LAYOUT_BUILDINGS])
+    {
+        const LayoutBuilding &b = layout.buildings[i];
+        if (b.kind >= LAYOUT_BUILDING_KIND_COUNT)
+            continue;
+        float y = b.position[1] + (buildingHovered(b) ? 0.5f : 0.0f);
+        buildingLabelDrawers[b.kind](b.position[0], y, b.position[2], b.size[1], layoutString(layout, b.label));
+    }
+}
 
+// HUD boxes: user/admin toggle, hovered or selected building and its status
+void drawBuildingInfoBoxes()
+{
     if(isAdmin)
 {     drawInfoBox(5, 10, 70, 30, "Admin");
 }else
 {     drawInfoBox(5, 10, 70, 30, "User");}
 
 int buldingIndex = -1;
-std::  string bulding[12] = {
-    "Admin Block", "Academic Block 1", "Academic Block 2", "Academic Block 3",
-    "Academic Block 4", "Library", "Womens Dormitory 1", "Womens Dormitory 2",
-    "Mens Dormitory 1", "Mens Dormitory 2", "Cafe","Location"
-};
+std::string bulding[12]; // Slot names from the layout, then the fallback
+const CampusLayout &layout = campusLayout();
+for (uint32_t i = 0; i < layout.buildingCount; ++i)
+{
+    int slot = layout.buildings[i].slot;
+    if (slot >= 0 && slot < BUILDING_SLOT_COUNT)
+        bulding[slot] = layoutString(layout, layout.buildings[i].name);
+}
+bulding[11] = "Location";
 
 
     // Selection takes priority over hover
@@ -980,9 +1402,6 @@ if(isNightMode && (buldingIndex==0 || buldingIndex==1 || buldingIndex==2 || buld
 drawInfoBox(70, 10, Wid, 30, state[buldingIndex][1]);
 else
 drawInfoBox(70, 10, Wid, 30, state[buldingIndex][buldingStatus[buldingIndex]]);
-
-    // Garden behind Cafe
-    drawGardenArea();
 }
 
 bool rayIntersectsBox(float rayOrigin[3], float rayDir[3], float boxCenter[3], float boxSize[3])
@@ -1008,21 +1427,17 @@ bool rayIntersectsBox(float rayOrigin[3], float rayDir[3], float boxCenter[3], f
 
 void checkHover(int x, int y)
 {
-    GLdouble model[16], proj[16];
-    GLint view[4];
-    glGetDoublev(GL_MODELVIEW_MATRIX, model);
-    glGetDoublev(GL_PROJECTION_MATRIX, proj);
-    glGetIntegerv(GL_VIEWPORT, view);
-
-    int winY = view[3] - y;
-
-    GLdouble wx1, wy1, wz1, wx2, wy2, wz2;
-    
-    gluUnProject(x, winY, 0.0, model, proj, view, &wx1, &wy1, &wz1);
-    gluUnProject(x, winY, 1.0, model, proj, view, &wx2, &wy2, &wz2);
-
-    float rayOrigin[3] = { (float)wx1, (float)wy1, (float)wz1 };
-    float rayDir[3] = { (float)(wx2 - wx1), (float)(wy2 - wy1), (float)(wz2 - wz1) };
+    // Unproject the cursor at the near and far planes
+    Mat4 clipToWorld = inverse(projectionMatrix * viewMatrix);
+    float ndcX = 2.0f * x / viewportWidth - 1.0f;
+    float ndcY = 1.0f - 2.0f * y / viewportHeight;
+    Vec4 nearPoint = clipToWorld * Vec4(ndcX, ndcY, -1.0f, 1.0f);
+    Vec4 farPoint = clipToWorld * Vec4(ndcX, ndcY, 1.0f, 1.0f);
+    Vec3 p1 = nearPoint.xyz() * (1.0f / nearPoint.w);
+    Vec3 p2 = farPoint.xyz() * (1.0f / farPoint.w);
+
+    float rayOrigin[3] = { p1.x, p1.y, p1.z };
+    float rayDir[3] = { p2.x - p1.x, p2.y - p1.y, p2.z - p1.z };
 
     // Normalize direction
     float len = sqrt(rayDir[0]*rayDir[0] + rayDir[1]*rayDir[1] + rayDir[2]*rayDir[2]);
@@ -1030,53 +1445,30 @@ void checkHover(int x, int y)
         rayDir[0] /= len; rayDir[1] /= len; rayDir[2] /= len;
     }
 
-    float boxCenterAdmin[3] = {0.0f, 10.0f, 25.0f}; // y=0 + h/2 for center
-    float boxSizeAdmin[3] = {26.0f, 20.0f, 16.0f};
-    hoveredAdminBlock = rayIntersectsBox(rayOrigin, rayDir, boxCenterAdmin, boxSizeAdmin);
-
-
-    float boxCenterAcademic1[3] = {-60.0f, 0.0f, -25.0f};
-    float boxSizeAcademic1[3] = {35.0f, 30.0f, 18.0f};
-    hoveredAcademic1 = rayIntersectsBox(rayOrigin, rayDir, boxCenterAcademic1, boxSizeAcademic1);
-
-    float boxCenterAcademic2[3] = {-60.0f, 0.0f, 25.0f};
-    float boxSizeAcademic2[3] = {35.0f, 30.0f, 18.0f};
-    hoveredAcademic2 = rayIntersectsBox(rayOrigin, rayDir, boxCenterAcademic2, boxSizeAcademic2);
-    
-    float boxCenterAcademic3[3] = {-100.0f, 0.0f, -25.0f};
-    float boxSizeAcademic3[3] = {35.0f, 30.0f, 18.0f};
-    hoveredAcademic3 = rayIntersectsBox(rayOrigin, rayDir, boxCenterAcademic3,boxSizeAcademic3 );
-
-    float boxCenterAcademic4[3] = {-100.0f, 0.0f, 25.0f};
-    float boxSizeAcademic4[3] = {35.0f, 30.0f, 18.0f};
-    hoveredAcademic4 = rayIntersectsBox(rayOrigin, rayDir, boxCenterAcademic4, boxSizeAcademic4);
-
-    float boxCenterLibrary[3] = {0.0f, 22.5f, -25.0f}; // y=0 + h/2 for center
-    float boxSizeLibrary[3] = {35.0f, 45.0f, 28.0f};
-    hoveredLibrary = rayIntersectsBox(rayOrigin, rayDir, boxCenterLibrary, boxSizeLibrary);
-
-    float boxCenterCafe[3] = {0.0f, 6.0f, 50.0f}; // y=0 + h/2 for center
-    float boxSizeCafe[3] = {16.0f, 12.0f, 12.0f};
-    hoveredCafe = rayIntersectsBox(rayOrigin, rayDir, boxCenterCafe, boxSizeCafe);
-
-    float boxCenterMensDorm1[3] = {70.0f, 12.0f, -60.0f}; // y=0 + h/2 for center
-    float boxSizeMensDorm1[3] = {18.0f, 24.0f, 12.0f};
-    hoveredMensDorm1 = rayIntersectsBox(rayOrigin, rayDir, boxCenterMensDorm1, boxSizeMensDorm1);
-
-    float boxCenterMensDorm2[3] = {70.0f, 12.0f, -35.0f}; // y=0 + h/2 for center
-    float boxSizeMensDorm2[3] = {18.0f, 24.0f, 12.0f};
-    hoveredMensDorm2 = rayIntersectsBox(rayOrigin, rayDir, boxCenterMensDorm2, boxSizeMensDorm2);
-
-    float boxCenterWomensDorm1[3] = {70.0f, 12.0f, 35.0f}; // y=0 + h/2 for center
-    float boxSizeWomensDorm1[3] = {18.0f, 24.0f, 12.0f};
-    hoveredWomensDorm1 = rayIntersectsBox(rayOrigin, rayDir, boxCenterWomensDorm1, boxSizeWomensDorm1);
-    
-    float boxCenterWomensDorm2[3] = {70.0f, 12.0f, 60.0f}; // y=0 + h/2 for center
-    float boxSizeWomensDorm2[3] = {18.0f, 24.0f, 12.0f};
-    hoveredWomensDorm2 = rayIntersectsBox(rayOrigin, rayDir, boxCenterWomensDorm2, boxSizeWomensDorm2);
-
+    // Buildings are picked by their layout AABBs, the bounds they are drawn
+    // in; the layout BVH narrows down which to test
+    for (int slot = 0; slot < BUILDING_SLOT_COUNT; ++slot)
+        *hoveredSlot[slot] = false;
+    const CampusLayout &layout = campusLayout();
+    layoutBvhRay(p1, Vec3(rayDir[0], rayDir[1], rayDir[2]), layoutQuery);
+    for (uint32_t candidate : layoutQuery)
+    {
+        const LayoutAabb &box = layout.aabbs[candidate];
+        if (box.section != LAYOUT_BUILDINGS || box.index >= layout.buildingCount)
+            continue;
+        const LayoutBuilding &b = layout.buildings[box.index];
+        if (b.slot < 0 || b.slot >= BUILDING_SLOT_COUNT)
+            continue;
+        float boxCenter[3], boxSize[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            boxCenter[axis] = (box.min[axis] + box.max[axis]) / 2.0f;
+            boxSize[axis] = box.max[axis] - box.min[axis];
+        }
+        if (rayIntersectsBox(rayOrigin, rayDir, boxCenter, boxSize))
+            *hoveredSlot[b.slot] = true;
+    }
 
- 
         hoveredAvailability = (x >= WINDOW_WIDTH - 100 && x <= WINDOW_WIDTH - 10 &&
         y >= 40 && y <= 100);
     
@@ -1088,39 +1480,39 @@ void checkHover(int x, int y)
 // Draws a single parking space with white marking
 void drawParkingSpace(float x, float y, float z, float angle = 0.0f)
 {
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glRotatef(angle, 0, 1, 0);
+    rcPushMatrix();
+    rcTranslatef(x, y, z);
+    rcRotatef(angle, 0, 1, 0);
 
     // Pavement for the space
-    glColor3f(0.32f, 0.32f, 0.35f); // Dark gray
-    glPushMatrix();
-    glScalef(2.5f, 0.05f, 5.5f);
+    rcColor3f(0.32f, 0.32f, 0.35f); // Dark gray
+    rcPushMatrix();
+    rcScalef(2.5f, 0.05f, 5.5f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 
     // White marking lines for the space
-    glColor3f(1.0f, 1.0f, 1.0f);
+    rcColor3f(1.0f, 1.0f, 1.0f);
     // Left line
-    glPushMatrix();
-    glTranslatef(-1.2f, 0.03f, 0);
-    glScalef(0.08f, 0.02f, 5.4f);
+    rcPushMatrix();
+    rcTranslatef(-1.2f, 0.03f, 0);
+    rcScalef(0.08f, 0.02f, 5.4f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
     // Right line
-    glPushMatrix();
-    glTranslatef(1.2f, 0.03f, 0);
-    glScalef(0.08f, 0.02f, 5.4f);
+    rcPushMatrix();
+    rcTranslatef(1.2f, 0.03f, 0);
+    rcScalef(0.08f, 0.02f, 5.4f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
     // Back line
-    glPushMatrix();
-    glTranslatef(0, 0.03f, -2.7f);
-    glScalef(2.5f, 0.02f, 0.07f);
+    rcPushMatrix();
+    rcTranslatef(0, 0.03f, -2.7f);
+    rcScalef(2.5f, 0.02f, 0.07f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 
-    glPopMatrix();
+    rcPopMatrix();
 }
 
 // Draws the full parking lot for 20 cars, 2 rows of 10, facing each other
@@ -1131,12 +1523,12 @@ void drawParkingLot(float baseX, float baseY, float baseZ)
     float lotWidth = carsPerRow * spaceWidth + (carsPerRow - 1) * 0.3f;
 
     // Draw ground lot area
-    glColor3f(0.28f, 0.28f, 0.32f);
-    glPushMatrix();
-    glTranslatef(baseX, baseY - 0.03f, baseZ);
-    glScalef(lotWidth, 0.07f, 2 * spaceLength + gapBetweenRows + 2.5f);
+    rcColor3f(0.28f, 0.28f, 0.32f);
+    rcPushMatrix();
+    rcTranslatef(baseX, baseY - 0.03f, baseZ);
+    rcScalef(lotWidth, 0.07f, 2 * spaceLength + gapBetweenRows + 2.5f);
     drawCube(1.0);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Draw parking spaces: one row
     for (int i = 0; i < carsPerRow; ++i)
@@ -1154,8 +1546,8 @@ void drawParkingLot(float baseX, float baseY, float baseZ)
     drawTree(baseX + lotWidth / 2 + 2.5f, baseY, baseZ + spaceLength);
 
     // Optional: Label or sign
-    glColor3f(0, 0, 0);
-    glRasterPos3f(baseX, baseY + 0.2f, baseZ - spaceLength - 1.5f);
+    rcColor3f(0, 0, 0);
+    rcRasterPos3f(baseX, baseY + 0.2f, baseZ - spaceLength - 1.5f);
     const char *label = "Parking";
     for (const char *c = label; *c; c++)
     {
@@ -1166,48 +1558,48 @@ void drawParkingLot(float baseX, float baseY, float baseZ)
 void drawBasketballCourt(float x, float y, float z)
 {
     // --- Court base (Dark blue) ---
-    glColor3f(0.0f, 0.0f, 0.5f);
-    glPushMatrix();
-    glTranslatef(x, y, z);
+    rcColor3f(0.0f, 0.0f, 0.5f);
+    rcPushMatrix();
+    rcTranslatef(x, y, z);
     drawRectPrism(28.0f, 0.05f, 15.0f); // Court size (X by Z)
-    glPopMatrix();
+    rcPopMatrix();
 
     // --- Court boundary lines ---
-    glDisable(GL_LIGHTING);
-    glColor3f(1.2f, 1.2f, 1.2f); // White lines
+    glsDisable(GL_LIGHTING);
+    rcColor3f(1.2f, 1.2f, 1.2f); // White lines
 
     // Outer lines
-    glPushMatrix();
-    glTranslatef(x + 14.0f, y + 0.06f, z);
+    rcPushMatrix();
+    rcTranslatef(x + 14.0f, y + 0.06f, z);
     drawRectPrism(0.1f, 0.01f, 15.0f);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(x - 14.0f, y + 0.06f, z);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(x - 14.0f, y + 0.06f, z);
     drawRectPrism(0.1f, 0.01f, 15.0f);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(x, y + 0.06f, z + 7.5f);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(x, y + 0.06f, z + 7.5f);
     drawRectPrism(28.0f, 0.01f, 0.1f);
-    glPopMatrix();
-    glPushMatrix();
-    glTranslatef(x, y + 0.06f, z - 7.5f);
+    rcPopMatrix();
+    rcPushMatrix();
+    rcTranslatef(x, y + 0.06f, z - 7.5f);
     drawRectPrism(28.0f, 0.01f, 0.1f);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Center line (Z axis)
-    glPushMatrix();
-    glTranslatef(x, y + 0.06f, z);
+    rcPushMatrix();
+    rcTranslatef(x, y + 0.06f, z);
     drawRectPrism(0.2f, 0.01f, 15.0f);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Paint areas on east and west
     for (float side = -1.0f; side <= 1.0f; side += 2.0f)
     {
         float laneX = x + side * (14.0f - 4.0f);
-        glPushMatrix();
-        glTranslatef(laneX, y + 0.06f, z);
+        rcPushMatrix();
+        rcTranslatef(laneX, y + 0.06f, z);
         drawRectPrism(6.0f, 0.01f, 4.0f);
-        glPopMatrix();
+        rcPopMatrix();
     }
 
     // Free throw arcs (East/West)
@@ -1219,10 +1611,10 @@ void drawBasketballCourt(float x, float y, float z)
             float theta = M_PI * i / 18;
             float z1 = z + cos(theta) * 3.0f;
             float x1 = arcX + sin(theta) * 3.0f * dir;
-            glPushMatrix();
-            glTranslatef(x1, y + 0.06f, z1);
+            rcPushMatrix();
+            rcTranslatef(x1, y + 0.06f, z1);
             drawRectPrism(0.1f, 0.01f, 0.1f);
-            glPopMatrix();
+            rcPopMatrix();
         }
     }
 
@@ -1235,173 +1627,250 @@ void drawBasketballCourt(float x, float y, float z)
         float rimX = x + side * 13.75f;
 
         // Pole
-        glColor3f(0.5f, 0.2f, 0.2f);
-        glPushMatrix();
-        glTranslatef(poleX, y + 1.0f, z);
+        rcColor3f(0.5f, 0.2f, 0.2f);
+        rcPushMatrix();
+        rcTranslatef(poleX, y + 1.0f, z);
         drawRectPrism(0.2f, 2.0f, 0.2f);
-        glPopMatrix();
+        rcPopMatrix();
 
         // Backboard
-        glColor3f(1.0f, 1.0f, 1.0f);
-        glPushMatrix();
-        glTranslatef(backboardX, y + 3.0f, z);
+        rcColor3f(1.0f, 1.0f, 1.0f);
+        rcPushMatrix();
+        rcTranslatef(backboardX, y + 3.0f, z);
         drawRectPrism(0.05f, 1.0f, 1.8f);
-        glPopMatrix();
+        rcPopMatrix();
 
         // Rim
-        glColor3f(1.0f, 0.0f, 0.0f);
-        glPushMatrix();
-        glTranslatef(rimX, y + 2.6f, z);
+        rcColor3f(1.0f, 0.0f, 0.0f);
+        rcPushMatrix();
+        rcTranslatef(rimX, y + 2.6f, z);
         drawRectPrism(0.1f, 0.05f, 0.6f);
-        glPopMatrix();
+        rcPopMatrix();
     }
 
-    glEnable(GL_LIGHTING);
+    glsEnable(GL_LIGHTING);
 
     // --- Fence ---
-    glColor3f(0.5f, 0.0f, 0.0f);
+    rcColor3f(0.5f, 0.0f, 0.0f);
     float fenceH = 2.5f;
     for (float fx = x - 14; fx <= x + 14; fx += 2.0f)
     {
         for (float fz = z - 7.5f; fz <= z + 7.5f; fz += 15.0f)
         {
-            glPushMatrix();
-            glTranslatef(fx, y + fenceH / 2.0f, fz);
+            rcPushMatrix();
+            rcTranslatef(fx, y + fenceH / 2.0f, fz);
             drawRectPrism(0.1f, fenceH, 0.1f);
-            glPopMatrix();
+            rcPopMatrix();
         }
     }
     for (float fz = z - 7.5f + 2.0f; fz <= z + 7.5f - 2.0f; fz += 2.0f)
     {
         for (float fx = x - 14; fx <= x + 14; fx += 28.0f)
         {
-            glPushMatrix();
-            glTranslatef(fx, y + fenceH / 2.0f, fz);
+            rcPushMatrix();
+            rcTranslatef(fx, y + fenceH / 2.0f, fz);
             drawRectPrism(0.1f, fenceH, 0.1f);
-            glPopMatrix();
+            rcPopMatrix();
         }
     }
 }
 
-void drawFootballCourt()
+void drawFootballCourt(float centerX, float fieldY, float centerZ)
 {
     // Scaled-down dimensions
     float length = 60.0f; // Z direction
     float width = 30.0f;  // X direction
 
-    // Field position
-    float centerZ = 0.0f;   // Aligned with hostels (middle of Hostel A, B, C)
-    float centerX = 105.0f; // To the right of hostels (hostels are at x = 70)
-    float fieldY = 0.1f;
-
     // Draw green field
-    glColor3f(0.1f, 0.4f, 0.1f);
-    glPushMatrix();
-    glTranslatef(centerX, fieldY - 0.02f, centerZ);
+    rcColor3f(0.1f, 0.4f, 0.1f);
+    rcPushMatrix();
+    rcTranslatef(centerX, fieldY - 0.02f, centerZ);
     drawRectPrism(width, 0.05f, length);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Field markings
-    glDisable(GL_LIGHTING);
-    glColor3f(1.0f, 1.0f, 1.0f);
+    glsDisable(GL_LIGHTING);
+    rcColor3f(1.0f, 1.0f, 1.0f);
     glLineWidth(2.0f);
 
     float halfL = length / 2.0f;
     float halfW = width / 2.0f;
 
     // Outer boundary
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(centerX - halfW, fieldY, centerZ - halfL);
-    glVertex3f(centerX + halfW, fieldY, centerZ - halfL);
-    glVertex3f(centerX + halfW, fieldY, centerZ + halfL);
-    glVertex3f(centerX - halfW, fieldY, centerZ + halfL);
-    glEnd();
+    imBegin(GL_LINE_LOOP);
+    imVertex3f(centerX - halfW, fieldY, centerZ - halfL);
+    imVertex3f(centerX + halfW, fieldY, centerZ - halfL);
+    imVertex3f(centerX + halfW, fieldY, centerZ + halfL);
+    imVertex3f(centerX - halfW, fieldY, centerZ + halfL);
+    imEnd();
 
     // Center line
-    glBegin(GL_LINES);
-    glVertex3f(centerX - halfW, fieldY, centerZ);
-    glVertex3f(centerX + halfW, fieldY, centerZ);
-    glEnd();
+    imBegin(GL_LINES);
+    imVertex3f(centerX - halfW, fieldY, centerZ);
+    imVertex3f(centerX + halfW, fieldY, centerZ);
+    imEnd();
 
     // Center circle
     float centerRadius = 6.0f;
-    glBegin(GL_LINE_LOOP);
+    imBegin(GL_LINE_LOOP);
     for (int i = 0; i < 36; ++i)
     {
         float angle = 2.0f * M_PI * i / 36;
-        glVertex3f(centerX + centerRadius * cos(angle), fieldY, centerZ + centerRadius * sin(angle));
+        imVertex3f(centerX + centerRadius * cos(angle), fieldY, centerZ + centerRadius * sin(angle));
     }
-    glEnd();
+    imEnd();
 
     // Penalty areas
     float boxW = 18.0f, boxD = 9.0f;
 
     // Left penalty box
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(centerX - boxW / 2, fieldY, centerZ - halfL);
-    glVertex3f(centerX + boxW / 2, fieldY, centerZ - halfL);
-    glVertex3f(centerX + boxW / 2, fieldY, centerZ - halfL + boxD);
-    glVertex3f(centerX - boxW / 2, fieldY, centerZ - halfL + boxD);
-    glEnd();
+    imBegin(GL_LINE_LOOP);
+    imVertex3f(centerX - boxW / 2, fieldY, centerZ - halfL);
+    imVertex3f(centerX + boxW / 2, fieldY, centerZ - halfL);
+    imVertex3f(centerX + boxW / 2, fieldY, centerZ - halfL + boxD);
+    imVertex3f(centerX - boxW / 2, fieldY, centerZ - halfL + boxD);
+    imEnd();
 
     // Right penalty box
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(centerX - boxW / 2, fieldY, centerZ + halfL);
-    glVertex3f(centerX + boxW / 2, fieldY, centerZ + halfL);
-    glVertex3f(centerX + boxW / 2, fieldY, centerZ + halfL - boxD);
-    glVertex3f(centerX - boxW / 2, fieldY, centerZ + halfL - boxD);
-    glEnd();
+    imBegin(GL_LINE_LOOP);
+    imVertex3f(centerX - boxW / 2, fieldY, centerZ + halfL);
+    imVertex3f(centerX + boxW / 2, fieldY, centerZ + halfL);
+    imVertex3f(centerX + boxW / 2, fieldY, centerZ + halfL - boxD);
+    imVertex3f(centerX - boxW / 2, fieldY, centerZ + halfL - boxD);
+    imEnd();
 
     // Penalty spots
     glPointSize(3.0f);
-    glBegin(GL_POINTS);
-    glVertex3f(centerX, fieldY, centerZ - halfL + 7.5f);
-    glVertex3f(centerX, fieldY, centerZ + halfL - 7.5f);
-    glEnd();
+    imBegin(GL_POINTS);
+    imVertex3f(centerX, fieldY, centerZ - halfL + 7.5f);
+    imVertex3f(centerX, fieldY, centerZ + halfL - 7.5f);
+    imEnd();
 
     // Arcs at penalty areas
     float arcRadius = 6.0f;
-    glBegin(GL_LINE_STRIP);
+    imBegin(GL_LINE_STRIP);
     for (int i = -6; i <= 6; ++i)
     {
         float angle = M_PI * i / 18.0f;
-        glVertex3f(centerX + arcRadius * sin(angle), fieldY, centerZ - halfL + 7.5f + arcRadius * cos(angle));
+        imVertex3f(centerX + arcRadius * sin(angle), fieldY, centerZ - halfL + 7.5f + arcRadius * cos(angle));
     }
-    glEnd();
+    imEnd();
 
-    glBegin(GL_LINE_STRIP);
+    imBegin(GL_LINE_STRIP);
     for (int i = -6; i <= 6; ++i)
     {
         float angle = M_PI * i / 18.0f;
-        glVertex3f(centerX + arcRadius * sin(angle), fieldY, centerZ + halfL - 7.5f - arcRadius * cos(angle));
+        imVertex3f(centerX + arcRadius * sin(angle), fieldY, centerZ + halfL - 7.5f - arcRadius * cos(angle));
     }
-    glEnd();
+    imEnd();
 
     // Goals
     float goalW = 6.0f, postH = 2.0f;
     float postThickness = 0.1f;
 
     // Left goal
-    glPushMatrix();
-    glTranslatef(centerX - goalW / 2, fieldY, centerZ - halfL - 0.3f);
+    rcPushMatrix();
+    rcTranslatef(centerX - goalW / 2, fieldY, centerZ - halfL - 0.3f);
     drawRectPrism(postThickness, postH, postThickness);
-    glTranslatef(goalW, 0, 0);
+    rcTranslatef(goalW, 0, 0);
     drawRectPrism(postThickness, postH, postThickness);
-    glTranslatef(-goalW / 2, postH, 0);
+    rcTranslatef(-goalW / 2, postH, 0);
     drawRectPrism(goalW, postThickness, postThickness);
-    glPopMatrix();
+    rcPopMatrix();
 
     // Right goal
-    glPushMatrix();
-    glTranslatef(centerX - goalW / 2, fieldY, centerZ + halfL + 0.3f);
+    rcPushMatrix();
+    rcTranslatef(centerX - goalW / 2, fieldY, centerZ + halfL + 0.3f);
     drawRectPrism(postThickness, postH, postThickness);
-    glTranslatef(goalW, 0, 0);
+    rcTranslatef(goalW, 0, 0);
     drawRectPrism(postThickness, postH, postThickness);
-    glTranslatef(-goalW / 2, postH, 0);
+    rcTranslatef(-goalW / 2, postH, 0);
     drawRectPrism(goalW, postThickness, postThickness);
-    glPopMatrix();
+    rcPopMatrix();
 
-    glEnable(GL_LIGHTING);
+    glsEnable(GL_LIGHTING);
+}
+
+// Parking lots, courts, trees and walking paths placed by the layout
+void drawLayoutGrounds()
+{
+    const CampusLayout &layout = campusLayout();
+    for (uint32_t i : visibleObjects[LAYOUT_PARKING_LOTS])
+    {
+        const float *p = layout.parkingLots[i].position;
+        drawParkingLot(p[0], p[1], p[2]);
+    }
+    for (uint32_t i : visibleObjects[LAYOUT_COURTS])
+    {
+        const float *p = layout.courts[i].position;
+        if (layout.courts[i].kind == LAYOUT_BASKETBALL)
+            drawBasketballCourt(p[0], p[1], p[2]);
+        else if (layout.courts[i].kind == LAYOUT_FOOTBALL)
+            drawFootballCourt(p[0], p[1], p[2]);
+    }
+    for (uint32_t i : visibleObjects[LAYOUT_TREES])
+    {
+        const float *p = layout.trees[i].position;
+        drawTree(p[0], p[1], p[2]);
+    }
+    for (uint32_t i : visibleObjects[LAYOUT_PATHS])
+    {
+        const LayoutPath &path = layout.paths[i];
+        drawWalkingPath(path.start[0], path.start[1], path.start[2], static_cast<int>(path.tiles));
+    }
+}
+
+// Flat slab over an object's footprint, its top at height y
+void drawFootprintSlab(const CampusLayout &layout, uint32_t aabb, float y)
+{
+    const LayoutAabb &box = layout.aabbs[aabb];
+    rcPushMatrix();
+    rcTranslatef(0.5f * (box.min[0] + box.max[0]), y - 0.025f, 0.5f * (box.min[2] + box.max[2]));
+    drawRectPrism(box.max[0] - box.min[0], 0.05f, box.max[2] - box.min[2]);
+    rcPopMatrix();
+}
+
+// Coarse stand-ins for objects whose chunk is out of stream range or still
+// loading: plain boxes for buildings, bare surfaces for roads and grounds,
+// one sphere per tree, and no labels
+void drawLayoutProxies()
+{
+    const CampusLayout &layout = campusLayout();
+    for (uint32_t i : proxyObjects[LAYOUT_BUILDINGS])
+    {
+        const LayoutBuilding &b = layout.buildings[i];
+        float y = b.position[1] + (buildingHovered(b) ? 0.5f : 0.0f);
+        rcColor3f(b.color[0], b.color[1], b.color[2]);
+        rcPushMatrix();
+        rcTranslatef(b.position[0], y + b.size[1] / 2.0f, b.position[2]);
+        drawRectPrism(b.size[0], b.size[1], b.size[2]);
+        rcPopMatrix();
+    }
+    rcColor3f(0.18f, 0.18f, 0.20f);
+    for (uint32_t i : proxyObjects[LAYOUT_ROADS])
+        drawRoadSurface(layout.roads[i]);
+    rcColor3f(0.28f, 0.28f, 0.32f);
+    for (uint32_t i : proxyObjects[LAYOUT_PARKING_LOTS])
+        drawFootprintSlab(layout, layout.parkingLots[i].aabb, layout.parkingLots[i].position[1]);
+    for (uint32_t i : proxyObjects[LAYOUT_COURTS])
+    {
+        const LayoutCourt &court = layout.courts[i];
+        if (court.kind == LAYOUT_BASKETBALL)
+            rcColor3f(0.0f, 0.0f, 0.5f);
+        else
+            rcColor3f(0.1f, 0.4f, 0.1f);
+        drawFootprintSlab(layout, court.aabb, court.position[1]);
+    }
+    rcColor3f(0.5f, 0.5f, 0.5f);
+    for (uint32_t i : proxyObjects[LAYOUT_PATHS])
+        drawFootprintSlab(layout, layout.paths[i].aabb, layout.paths[i].start[1] + 0.035f);
+    rcColor3f(0.0f, 0.5f, 0.0f);
+    for (uint32_t i : proxyObjects[LAYOUT_TREES])
+    {
+        const float *p = layout.trees[i].position;
+        const SphereInstance canopy = {p[0], p[1] + 6.0f, p[2], 2.0f};
+        drawSphereInstances(&canopy, 1);
+    }
 }
 
 void drawSimplifiedBirds()
@@ -1409,27 +1878,27 @@ void drawSimplifiedBirds()
     // Example: a few "V" shaped birds, animated slightly
     if (!isNightMode)
     {
-        glColor3f(0.15f, 0.15f, 0.15f);
-        glDisable(GL_LIGHTING);
+        rcColor3f(0.15f, 0.15f, 0.15f);
+        glsDisable(GL_LIGHTING);
         glLineWidth(2.5f);
-        for (int i = 0; i < 4; ++i)
-        {                                                                   // 3 birds
+        for (int i = 0; i < qualitySettings().birdCount; ++i)
+        {
             float birdX = 20.0f + i * 15 + sin(cloudOffset * 0.1f + i) * 5; // Move side to side
             float birdY = 60.0f + sin(cloudOffset * 0.05f + i * 0.5f) * 3;  // Move up and down
             float birdZ = 20.0f + i * 10;
             float wingAngle = sin(cloudOffset * 0.2f + i) * 15.0f; // Flapping motion
 
-            glPushMatrix();
-            glTranslatef(birdX, birdY, birdZ);
-            glBegin(GL_LINES);
-            glVertex3f(0, 0, 0);
-            glVertex3f(2 * cos(wingAngle * M_PI / 180.0f), 2 * sin(wingAngle * M_PI / 180.0f), 0);
-            glVertex3f(0, 0, 0);
-            glVertex3f(-2 * cos(wingAngle * M_PI / 180.0f), 2 * sin(wingAngle * M_PI / 180.0f), 0);
-            glEnd();
-            glPopMatrix();
+            rcPushMatrix();
+            rcTranslatef(birdX, birdY, birdZ);
+            imBegin(GL_LINES);
+            imVertex3f(0, 0, 0);
+            imVertex3f(2 * cos(wingAngle * M_PI / 180.0f), 2 * sin(wingAngle * M_PI / 180.0f), 0);
+            imVertex3f(0, 0, 0);
+            imVertex3f(-2 * cos(wingAngle * M_PI / 180.0f), 2 * sin(wingAngle * M_PI / 180.0f), 0);
+            imEnd();
+            rcPopMatrix();
         }
-        glEnable(GL_LIGHTING);
+        glsEnable(GL_LIGHTING);
     }
 }
 
@@ -1437,46 +1906,362 @@ void drawSimplifiedBirds()
 
 // --- GLUT Callbacks ---
 
-void campusDisplay()
+SceneKey currentSceneKey()
+{
+    SceneKey key;
+    key.camPos[0] = camPosX;
+    key.camPos[1] = camPosY;
+    key.camPos[2] = camPosZ;
+    key.camLookAt[0] = camLookAtX;
+    key.camLookAt[1] = camLookAtY;
+    key.camLookAt[2] = camLookAtZ;
+    key.sunAngle = sunAngle;
+    key.cloudOffset = cloudOffset;
+    key.nightMode = isNightMode;
+    for (int slot = 0; slot < BUILDING_SLOT_COUNT; ++slot)
+        key.hovered[slot] = *hoveredSlot[slot];
+    key.qualityLevel = qualityLevel();
+    key.overdrawView = overdrawView;
+    key.viewportW = viewportWidth;
+    key.viewportH = viewportHeight;
+    key.layoutGeneration = layoutGeneration;
+    key.streamGeneration = worldPartitionGeneration();
+    key.impostorGeneration = impostorGeneration();
+    key.occlusionGeneration = occlusionCullingGeneration();
+    return key;
+}
+
+bool sameSceneKey(const SceneKey &a, const SceneKey &b)
+{
+    return std::equal(a.camPos, a.camPos + 3, b.camPos) &&
+           std::equal(a.camLookAt, a.camLookAt + 3, b.camLookAt) &&
+           a.sunAngle == b.sunAngle && a.cloudOffset == b.cloudOffset &&
+           a.nightMode == b.nightMode &&
+           std::equal(a.hovered, a.hovered + BUILDING_SLOT_COUNT, b.hovered) && a.qualityLevel == b.qualityLevel &&
+           a.overdrawView == b.overdrawView && a.viewportW == b.viewportW && a.viewportH == b.viewportH && a.layoutGeneration == b.layoutGeneration &&
+           a.streamGeneration == b.streamGeneration && a.impostorGeneration == b.impostorGeneration &&
+           a.occlusionGeneration == b.occlusionGeneration;
+}
+
+// Whole layout objects outside the view, or hidden from the eye's PVS cell,
+// are dropped before they are drawn. Only a camera's view has an eye for the
+// PVS; orthographic captures go by the view alone.
+void cullLayoutObjects(bool fromEye)
+{
+    const CampusLayout &layout = campusLayout();
+    const uint32_t counts[LAYOUT_ROUTE] = {layout.buildingCount, layout.roadCount, layout.parkingLotCount,
+                                           layout.courtCount,    layout.treeCount, layout.pathCount};
+    layoutBvhCull(frustumFromMatrix(rcProjection() * viewMatrix), layoutQuery);
+    const uint64_t *potentiallyVisible = fromEye ? layoutPvsFind(transformPoint(inverse(viewMatrix), Vec3())) : nullptr;
+    for (int section = 0; section < LAYOUT_ROUTE; ++section)
+    {
+        visibleObjects[section].clear();
+        proxyObjects[section].clear();
+    }
+    for (uint32_t i : layoutQuery)
+    {
+        const LayoutAabb &box = layout.aabbs[i];
+        if (potentiallyVisible && !layoutPvsVisible(potentiallyVisible, i))
+            continue;
+        if (box.section < LAYOUT_ROUTE && box.index < counts[box.section])
+            (worldPartitionDetailed(i) ? visibleObjects : proxyObjects)[box.section].push_back(box.index);
+    }
+}
+
+// Drops the detailed buildings the last occlusion queries found hidden; false
+// if there are no queries to go by
+bool occlusionCullBuildings()
+{
+    if (!campusOptions.occlusionCulling || !occlusionCullingBegin(transformPoint(inverse(viewMatrix), Vec3())))
+        return false;
+    const CampusLayout &layout = campusLayout();
+    std::vector<uint32_t> &buildings = visibleObjects[LAYOUT_BUILDINGS];
+    buildings.erase(std::remove_if(buildings.begin(), buildings.end(),
+                                   [&](uint32_t i) { return !occlusionCullingDraw(layout.buildings[i].aabb); }),
+                    buildings.end());
+    return true;
+}
+
+void drawScene3D()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear color set by drawSkyAndSunMoon
+    rcLoadMatrix(viewMatrix);
+
+    // Sphere LODs are picked by size in whatever this pass renders into
+    int targetW = viewportWidth, targetH = viewportHeight;
+    if (sceneTargetAvailable())
+        sceneTargetSize(targetW, targetH);
+    sphereMeshSetProjection(CAMERA_FOV_Y, targetH);
+    sphereMeshSetLodBias(qualitySettings().sphereLodBias);
+    bool countingOverdraw = overdrawView && overdrawBegin();
 
+    renderQueueBegin();
     drawSkyAndSunMoon(); // Call this first to set sky color and light
 
-    glLoadIdentity();
-    gluLookAt(camPosX, camPosY, camPosZ,          // Camera position
-              camLookAtX, camLookAtY, camLookAtZ, // Look at point
-              0.0f, 1.0f, 0.0f);                  // Up vector
+    bool occlusionQueried = false;
+    if (impostorActive)
+    {
+        impostorDraw(Vec3(camPosX, camPosY, camPosZ));
+        cullLayoutObjects(true);
+        drawCampusLabels();
+    }
+    else
+    {
+        if (shadowsActive)
+            bindCampusShadows(viewMatrix);
+        drawGroundPlane();
+        cullLayoutObjects(true);
+        occlusionQueried = occlusionCullBuildings();
+        drawRoads();
+        drawCampusBuildings();
+        drawLayoutGrounds();
+        drawLayoutProxies();
+        // Only the campus takes shadows; the clouds must not sample the
+        // dynamic map they are drawn into
+        renderQueueFlush();
+        shadowMapUnbind();
+    }
+    // drawCars();
+    drawSimplifiedBirds();
+    drawAnimatedClouds();
+    renderQueueFlush(); // Opaque front to back, then the clouds back to front
+    if (countingOverdraw)
+        overdrawEnd(targetW, targetH); // Before the query boxes, which are not part of the picture
+    if (occlusionQueried)
+        occlusionCullingEnd(campusLayout()); // The clouds write no depth, so only opaque geometry hides
+    buildingMeshCacheUpdate();
+}
 
+// Draws the static campus under this projection and view: everything but the
+// sky, clouds, birds and labels. Impostor cells and the static shadow map hold it.
+void drawStaticCampus(const Mat4 &projection, const Mat4 &view)
+{
+    Mat4 sceneView = viewMatrix;
+    viewMatrix = view; // Culling goes by it
+    rcPushProjection(projection);
+    rcLoadMatrix(viewMatrix);
+    applySunLight();
+    renderQueueBegin();
     drawGroundPlane();
+    cullLayoutObjects(false);
     drawRoads();
-    drawCampusBuildings();
-    drawParkingLot(0, 0, -70);
-    drawBasketballCourt(102, 5.0f, -80.0f);
+    drawCampusBuildingMeshes();
+    drawLayoutGrounds();
+    drawLayoutProxies();
+    renderQueueFlush();
+    rcPopProjection();
+    viewMatrix = sceneView;
+}
 
-    drawFootballCourt();
-    // drawCars();
-    drawSimplifiedBirds();
-    drawAnimatedClouds();
+// Impostor cells are shadowed like the scene
+void captureImpostorCell(const Mat4 &projection, const Mat4 &view)
+{
+    if (shadowsActive)
+        bindCampusShadows(view);
+    drawStaticCampus(projection, view);
+    shadowMapUnbind();
+}
+
+// Decides whether this frame is shadowed and brings the shadow maps up to
+// date. Changes to what the static map holds drop it; hovering and quality
+// changes included, as they move or add geometry.
+void updateCampusShadows()
+{
+    shadowsActive = campusOptions.shadows && shadowMapAvailable() && sunElevation() > SHADOW_MIN_ELEVATION;
+    if (!shadowsActive)
+        return;
+
+    ShadowKey key;
+    key.layoutGeneration = layoutGeneration;
+    key.streamGeneration = worldPartitionGeneration();
+    for (int slot = 0; slot < BUILDING_SLOT_COUNT; ++slot)
+        key.hovered[slot] = *hoveredSlot[slot];
+    key.qualityLevel = qualityLevel();
+    if (key.layoutGeneration != shadowKey.layoutGeneration || key.streamGeneration != shadowKey.streamGeneration ||
+        !std::equal(key.hovered, key.hovered + BUILDING_SLOT_COUNT, shadowKey.hovered) || key.qualityLevel != shadowKey.qualityLevel)
+        shadowMapInvalidate();
+    shadowKey = key;
+
+    bool cloudsMoved = cloudOffset != shadowCloudOffset || cloudGeneration != shadowCloudGeneration;
+    shadowCloudOffset = cloudOffset;
+    shadowCloudGeneration = cloudGeneration;
+    profilerBeginPass(PROFILE_SHADOW);
+    shadowMapPrepare(sunDirection(), drawStaticCampus, drawCloudShadowCasters, cloudsMoved);
+    profilerEndPass(PROFILE_SHADOW);
+}
+
+// Decides whether this frame draws the campus as its impostor and captures
+// the cells it needs. Changes to what is drawn drop the cells; the sun
+// moving, hovering and quality changes only make them stale.
+void updateCampusImpostor()
+{
+    Vec3 eye(camPosX, camPosY, camPosZ);
+    impostorActive = campusOptions.impostorDistance > 0.0f && camDistance >= campusOptions.impostorDistance &&
+                     impostorUsable(eye);
+    if (!impostorActive)
+        return;
+
+    ImpostorKey key;
+    key.layoutGeneration = layoutGeneration;
+    key.streamGeneration = worldPartitionGeneration();
+    key.nightMode = isNightMode;
+    key.sunAngle = sunAngle;
+    for (int slot = 0; slot < BUILDING_SLOT_COUNT; ++slot)
+        key.hovered[slot] = *hoveredSlot[slot];
+    key.qualityLevel = qualityLevel();
+    if (key.layoutGeneration != impostorKey.layoutGeneration || key.streamGeneration != impostorKey.streamGeneration ||
+        key.nightMode != impostorKey.nightMode)
+        impostorInvalidate();
+    else if (std::fabs(key.sunAngle - impostorKey.sunAngle) < IMPOSTOR_SUN_STEP &&
+             std::equal(key.hovered, key.hovered + BUILDING_SLOT_COUNT, impostorKey.hovered) &&
+             key.qualityLevel == impostorKey.qualityLevel)
+        key.sunAngle = impostorKey.sunAngle; // Measured from the last capture, not the last frame
+    else
+        impostorRefresh();
+    impostorKey = key;
+    impostorPrepare(eye, captureImpostorCell);
+}
+
+// Average overdraw and the heatmap's colour scale, bottom left
+void drawOverdrawLegend()
+{
+    const OverdrawStats &stats = overdrawStats();
+    std::ostringstream text;
+    text << "Overdraw " << std::fixed << std::setprecision(2) << stats.average << "x, " << std::setprecision(1)
+         << 100.0 * stats.heavyShare << "% of pixels " << OVERDRAW_HEAVY << "+, max " << stats.maximum;
+    renderText3D(10, 40, 0, GLUT_BITMAP_HELVETICA_12, text.str(), 1, 1, 1);
+
+    glsDisable(GL_DEPTH_TEST); // Labels go over their swatches
+    const int swatch = 24;
+    for (int level = 0; level < OVERDRAW_LEVELS; ++level)
+    {
+        float rgb[3];
+        overdrawColor(level, rgb);
+        rcColor3f(rgb[0], rgb[1], rgb[2]);
+        int x = 10 + level * swatch;
+        imBegin(GL_QUADS);
+        imVertex2f(x, 10);
+        imVertex2f(x + swatch, 10);
+        imVertex2f(x + swatch, 30);
+        imVertex2f(x, 30);
+        imEnd();
+        std::string label = std::to_string(level) + (level + 1 == OVERDRAW_LEVELS ? "+" : "");
+        float shade = level >= 4 ? 0.0f : 1.0f; // Dark text on the bright end of the scale
+        renderText3D(x + 4, 15, 0, GLUT_BITMAP_HELVETICA_12, label, shade, shade, shade);
+    }
+    glsEnable(GL_DEPTH_TEST);
+}
+
+void drawHud()
+{
+    drawBuildingInfoBoxes();
 
     // Draw some text UI for mode
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    glDisable(GL_LIGHTING);
+    rcPushProjection(mat4Ortho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT));
+    rcPushMatrix(); // renderText3D positions through the CPU matrix stack
+    rcLoadMatrix(Mat4());
+    glsDisable(GL_LIGHTING);
     renderText3D(10, WINDOW_HEIGHT - 25, 0, GLUT_BITMAP_HELVETICA_18, isNightMode ? "Night Mode" : "Day Mode", 1, 1, 1);
     renderText3D(10, WINDOW_HEIGHT - 45, 0, GLUT_BITMAP_HELVETICA_12, "N:Toggle Day/Night | Mouse:Orbit/Zoom | Arrows/RMB:Pan", 1, 1, 1);
-    glEnable(GL_LIGHTING);
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
+    if (overdrawView)
+        drawOverdrawLegend();
+    glsEnable(GL_LIGHTING);
+    rcPopMatrix();
+    rcPopProjection();
+}
+
+void campusDisplay()
+{
+    // Animation advances at the redisplay timer rate; redraws triggered by
+    // input in between keep the last state so they can reuse the cached scene
+    if (startupTaskPending)
+    {
+        startupTaskPending = false;
+        runStartupTask();
+    }
 
+    CameraPose benchmarkPose;
+    int benchmarkBackend;
+    bool benchmarking = benchmarkBeginFrame(benchmarkPose, benchmarkBackend);
+    if (benchmarking)
+    {
+        // The animation holds still so both backends draw identical frames
+        applyCameraPose(benchmarkPose);
+        renderBackendSelect(benchmarkBackend);
+        sceneTargetInvalidate();
+    }
+    else if (sceneFrameDue || renderRateHz <= 0)
+    {
+        // Latest published simulation snapshot, blended between its last two ticks
+        SimState frameState = simInterpolated();
+        sunAngle = frameState.sunAngle;
+        cloudOffset = frameState.cloudOffset;
+        isNightMode = frameState.nightMode;
+        sceneFrameDue = false;
+    }
+    // Benchmark frames wait for their chunks, so both backends draw the same scene
+    streamCampus(benchmarking);
+    layoutPvsPoll(benchmarking);
+    occlusionCullingPoll();
+    updateCampusShadows();
+    updateCampusImpostor();
+
+    if (sceneTargetAvailable())
+    {
+        SceneKey key = currentSceneKey();
+        if (!sceneTargetValid() || !sameSceneKey(key, lastSceneKey))
+        {
+            profilerBeginPass(PROFILE_SCENE);
+            sceneTargetBegin();
+            drawScene3D();
+            sceneTargetEnd();
+            profilerEndPass(PROFILE_SCENE);
+            lastSceneKey = key;
+        }
+        profilerBeginPass(PROFILE_COMPOSITE);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // HUD text is depth tested
+        sceneTargetComposite();
+        profilerEndPass(PROFILE_COMPOSITE);
+    }
+    else
+    {
+        profilerBeginPass(PROFILE_SCENE);
+        drawScene3D();
+        profilerEndPass(PROFILE_SCENE);
+    }
+
+    profilerBeginPass(PROFILE_HUD);
+    drawHud();
+    profilerEndPass(PROFILE_HUD);
     glutSwapBuffers();
+    profilerEndFrame();
+
+    if (benchmarking)
+    {
+        // Resolution and quality hold still too; frames run back to back
+        if (benchmarkEndFrame())
+            finishBenchmark();
+        else
+            glutPostRedisplay();
+        return;
+    }
+
+    // Without the redisplay timer, keep drawing until the chunks in range are in
+    if (renderRateHz <= 0 && (worldPartitionLoading() || buildingMeshStreaming()))
+        glutPostRedisplay();
+
+    // Resolution and quality changes apply from the next scene render
+    double sceneMs;
+    if (profilerTakeSample(PROFILE_SCENE, sceneMs))
+    {
+        if (dynamicResolutionUpdate(sceneMs))
+            sceneTargetSetScale(dynamicResolutionScale());
+        // Detail costs CPU submission as well as GPU time
+        double frameMs = std::max(sceneMs, profilerCpuMs(PROFILE_SCENE));
+        bool resolutionAtMax = !campusOptions.dynamicResolution ||
+                               dynamicResolutionScale() >= campusOptions.resolutionScaleMax;
+        qualityUpdate(frameMs, resolutionAtMax);
+    }
 }
 
 void campusReshape(int w, int h)
@@ -1485,36 +2270,47 @@ void campusReshape(int w, int h)
         h = 1;
     float ratio = 1.0f * w / h;
     glViewport(0, 0, w, h);
+    viewportWidth = w;
+    viewportHeight = h;
+    sceneTargetResize(w, h);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(50.0f, ratio, 1.0f, 1000.0f); // Slightly wider FOV
+    projectionMatrix = mat4Perspective(CAMERA_FOV_Y, ratio, 1.0f, 1000.0f); // Slightly wider FOV
+    glLoadMatrixf(projectionMatrix.m);
+    rcSetProjection(projectionMatrix);
     glMatrixMode(GL_MODELVIEW);
 }
 
+// Redisplay timer. The simulation runs on its own thread (Simulation.cpp), so
+// this only decides how often frames are drawn.
 void campusUpdate(int value)
 {
-    // Day/Night cycle
-    if (!isNightMode)
-    {
-        sunAngle += 0.08f; // Slower sun movement for longer day
-        if (sunAngle > 180.0f)
-            sunAngle = 0.0f;
-    }
-    else
-    {
-    sunAngle += 0.04f; // Moon moves slower at night (optional)
-    if (sunAngle > 360.0f)
-        sunAngle = 180.0f;
-        }
+    if (value != renderTimerGeneration || renderRateHz <= 0)
+        return; // Stale timer, or on-demand rendering
 
-    cloudOffset += 0.1f;
-    if (cloudOffset > 800.0f)
-        cloudOffset = -800.0f; 
+    sceneFrameDue = true;
+    glutPostRedisplay();
+    glutTimerFunc(1000 / renderRateHz, campusUpdate, renderTimerGeneration);
+}
 
+void cycleRenderRate()
+{
+    static const int rates[] = {60, 30, 144, 0};
+    int next = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (rates[i] == renderRateHz)
+            next = (i + 1) % 4;
+    }
+    renderRateHz = rates[next];
+    ++renderTimerGeneration;
+    if (renderRateHz > 0)
+        glutTimerFunc(0, campusUpdate, renderTimerGeneration);
 
-    glutPostRedisplay();
-    glutTimerFunc(16, campusUpdate, 0); // ~60 FPS
-    // Update camera position based on angle
+    if (renderRateHz > 0)
+        std::cout << "Render rate: " << renderRateHz << " Hz" << std::endl;
+    else
+        std::cout << "Render rate: on demand" << std::endl;
 }
 
 void campusKeyboard(unsigned char key, int x, int y)
@@ -1523,11 +2319,71 @@ void campusKeyboard(unsigned char key, int x, int y)
     {
     case 'n':
     case 'N':
-        isNightMode = !isNightMode;
-        if (!isNightMode)
-            sunAngle = 0;
+        simToggleNightMode();
+        break;
+    case '+':
+    case '=':
+        simTimeScale = std::min(simTimeScale * 2.0f, 64.0f);
+        simSetTimeScale(simTimeScale);
+        std::cout << "Simulation speed: x" << simTimeScale << std::endl;
+        break;
+    case '-':
+        simTimeScale = std::max(simTimeScale / 2.0f, 0.125f);
+        simSetTimeScale(simTimeScale);
+        std::cout << "Simulation speed: x" << simTimeScale << std::endl;
+        break;
+    case 'f':
+    case 'F':
+        cycleRenderRate();
+        break;
+    case 'r':
+    case 'R':
+        campusOptions.dynamicResolution = !campusOptions.dynamicResolution;
+        dynamicResolutionReset();
+        sceneTargetSetScale(dynamicResolutionScale());
+        std::cout << "Dynamic resolution " << (campusOptions.dynamicResolution ? "on" : "off") << std::endl;
+        break;
+    case 'p':
+    case 'P':
+        profilerReporting = !profilerReporting;
+        break;
+    case 'o':
+    case 'O':
+        overdrawView = !overdrawView;
+        std::cout << "Overdraw view " << (overdrawView ? "on" : "off") << std::endl;
+        break;
+    case 'b':
+    case 'B':
+        if (benchmarkActive())
+            break;
+        if (renderBackendNext() == renderBackendCurrent())
+        {
+            std::cout << "No other backend available" << std::endl;
+            break;
+        }
+        renderBackendSelect(renderBackendNext());
+        sceneTargetInvalidate();
+        std::cout << "Backend: " << renderBackendInfo(renderBackendCurrent()).name << std::endl;
+        break;
+    case 'a':
+    case 'A':
+        // Current backend against the next one
+        if (!benchmarkActive() && renderBackendNext() != renderBackendCurrent())
+            startBenchmark(renderBackendCurrent(), renderBackendNext(), false);
+        break;
+    case 'q':
+    case 'Q':
+        // auto -> low -> medium -> high -> ultra -> auto
+        if (!qualityIsFixed())
+            qualitySetFixed(0);
+        else if (qualityLevel() + 1 < QUALITY_LEVEL_COUNT)
+            qualitySetFixed(qualityLevel() + 1);
+        else
+            qualitySetFixed(-1);
+        std::cout << "Quality: " << (qualityIsFixed() ? qualitySettings().name : "auto") << std::endl;
         break;
     case 27: // ESC key
+        simShutdown();
         exit(0);
         break;
     }
@@ -0,0 +1,330 @@
+#include "CampusImpostor.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "MatrixStack.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+enum ImpostorViewState
+{
+    VIEW_EMPTY,
+    VIEW_STALE, // Captured under older lighting or status
+    VIEW_CURRENT
+};
+
+struct ImpostorView
+{
+    ImpostorViewState state;
+    int slot;
+    unsigned lastUsed; // Frame it was last drawn in
+};
+
+const int IMPOSTOR_GRID = 16;            // Views per side of the direction grid, about 11 degrees apart
+const int IMPOSTOR_VIEWS = IMPOSTOR_GRID * IMPOSTOR_GRID;
+const int IMPOSTOR_SLOT_GRID = 8;        // Slots per atlas side
+const int IMPOSTOR_SLOTS = IMPOSTOR_SLOT_GRID * IMPOSTOR_SLOT_GRID;
+const int IMPOSTOR_SLOT_SIZE = 384;      // Pixels per slot side
+const int IMPOSTOR_ATLAS = IMPOSTOR_SLOT_GRID * IMPOSTOR_SLOT_SIZE;
+const float IMPOSTOR_MIN_RANGE = 2.5f;   // Eye distance from the centre, in bounding radii
+const float IMPOSTOR_FADE = 0.5f;        // Part of the way between two views spent cross-fading
+const float IMPOSTOR_MIN_WEIGHT = 0.01f; // Cards that would add less are left out
+
+static GLuint atlasTex = 0;
+static GLuint captureFbo = 0;
+static GLuint captureColorRb = 0;
+static GLuint captureDepthRb = 0;
+static bool available = false;
+static ImpostorView views[IMPOSTOR_VIEWS];
+static int slotView[IMPOSTOR_SLOTS]; // -1 = free
+static unsigned frame = 0;
+static Vec3 center;
+static float radius = 1.0f;
+static unsigned generation = 0;
+
+// Grid position of a direction, in views: p = d.xz / (|x| + |y| + |z|)
+// folds the upper hemisphere onto a diamond, turned 45 degrees to fill the square
+static void encodeDirection(const Vec3 &d, float &u, float &v)
+{
+    float sum = std::fabs(d.x) + std::max(d.y, 0.0f) + std::fabs(d.z);
+    float x = sum > 0.0f ? d.x / sum : 0.0f;
+    float z = sum > 0.0f ? d.z / sum : 0.0f;
+    u = 0.5f * (x + z + 1.0f) * IMPOSTOR_GRID;
+    v = 0.5f * (x - z + 1.0f) * IMPOSTOR_GRID;
+}
+
+// Direction through the middle of a view's grid square, from the centre towards the viewer
+static Vec3 viewDirection(int view)
+{
+    float a = 2.0f * ((view % IMPOSTOR_GRID) + 0.5f) / IMPOSTOR_GRID - 1.0f;
+    float b = 2.0f * ((view / IMPOSTOR_GRID) + 0.5f) / IMPOSTOR_GRID - 1.0f;
+    float x = 0.5f * (a + b), z = 0.5f * (a - b);
+    return normalize(Vec3(x, 1.0f - std::fabs(x) - std::fabs(z), z));
+}
+
+static Vec3 viewUp(const Vec3 &d)
+{
+    return std::fabs(d.y) > 0.999f ? Vec3(0.0f, 0.0f, -1.0f) : Vec3(0.0f, 1.0f, 0.0f);
+}
+
+// Weight of the far view of a pair, f of the way from the near one; the
+// nearest view is shown alone except within the fade band between them
+static float fadeWeight(float f)
+{
+    return std::max(0.0f, std::min(1.0f, (f - 0.5f) / IMPOSTOR_FADE + 0.5f));
+}
+
+// The up to four views around the direction of the eye, with weights summing to 1
+static int viewsAround(const Vec3 &eye, int picked[4], float weights[4])
+{
+    float u, v;
+    encodeDirection(normalize(eye - center), u, v);
+    u -= 0.5f; // View middles at whole numbers
+    v -= 0.5f;
+    int u0 = std::max(0, std::min(IMPOSTOR_GRID - 2, static_cast<int>(std::floor(u))));
+    int v0 = std::max(0, std::min(IMPOSTOR_GRID - 2, static_cast<int>(std::floor(v))));
+    float fu = fadeWeight(u - u0);
+    float fv = fadeWeight(v - v0);
+
+    int count = 0;
+    float total = 0.0f;
+    for (int k = 0; k < 4; ++k)
+    {
+        int du = k & 1, dv = k >> 1;
+        float weight = (du ? fu : 1.0f - fu) * (dv ? fv : 1.0f - fv);
+        if (weight < IMPOSTOR_MIN_WEIGHT)
+            continue;
+        picked[count] = (v0 + dv) * IMPOSTOR_GRID + u0 + du;
+        weights[count++] = weight;
+        total += weight;
+    }
+    for (int k = 0; k < count; ++k)
+        weights[k] /= total;
+    return count;
+}
+
+// A free slot, or the one whose view was drawn least recently and is not
+// needed this frame
+static int takeSlot()
+{
+    int best = -1;
+    for (int slot = 0; slot < IMPOSTOR_SLOTS; ++slot)
+    {
+        if (slotView[slot] < 0)
+            return slot;
+        const ImpostorView &view = views[slotView[slot]];
+        if (view.lastUsed != frame && (best < 0 || view.lastUsed < views[slotView[best]].lastUsed))
+            best = slot;
+    }
+    views[slotView[best]].state = VIEW_EMPTY;
+    views[slotView[best]].slot = -1;
+    return best;
+}
+
+static void captureView(int index, ImpostorCaptureFn capture)
+{
+    ImpostorView &view = views[index];
+    if (view.slot < 0)
+    {
+        view.slot = takeSlot();
+        slotView[view.slot] = index;
+    }
+    Vec3 d = viewDirection(index);
+    Mat4 viewMatrix = mat4LookAt(center + d * (2.0f * radius), center, viewUp(d));
+    Mat4 projection = mat4Ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    capture(projection, viewMatrix);
+    glBindTexture(GL_TEXTURE_2D, atlasTex);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, (view.slot % IMPOSTOR_SLOT_GRID) * IMPOSTOR_SLOT_SIZE,
+                        (view.slot / IMPOSTOR_SLOT_GRID) * IMPOSTOR_SLOT_SIZE, 0, 0, IMPOSTOR_SLOT_SIZE,
+                        IMPOSTOR_SLOT_SIZE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    view.state = VIEW_CURRENT;
+    ++generation;
+}
+
+bool impostorInit()
+{
+    if (!glHasFramebufferObject)
+        return false;
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (maxSize < IMPOSTOR_ATLAS)
+    {
+        std::cout << "Campus impostor off: a " << IMPOSTOR_ATLAS << " px atlas is over the " << maxSize
+                  << " px texture limit" << std::endl;
+        return false;
+    }
+
+    glGenTextures(1, &atlasTex);
+    glBindTexture(GL_TEXTURE_2D, atlasTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, IMPOSTOR_ATLAS, IMPOSTOR_ATLAS, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Views are rendered one at a time here and copied into their slots
+    pglGenRenderbuffers(1, &captureColorRb);
+    pglBindRenderbuffer(GL_RENDERBUFFER, captureColorRb);
+    pglRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, IMPOSTOR_SLOT_SIZE, IMPOSTOR_SLOT_SIZE);
+    pglGenRenderbuffers(1, &captureDepthRb);
+    pglBindRenderbuffer(GL_RENDERBUFFER, captureDepthRb);
+    pglRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IMPOSTOR_SLOT_SIZE, IMPOSTOR_SLOT_SIZE);
+    pglBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    pglGenFramebuffers(1, &captureFbo);
+    pglBindFramebuffer(GL_FRAMEBUFFER, captureFbo);
+    pglFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, captureColorRb);
+    pglFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureDepthRb);
+    GLenum status = pglCheckFramebufferStatus(GL_FRAMEBUFFER);
+    pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Campus impostor off: capture framebuffer incomplete (0x" << std::hex << status << std::dec
+                  << ")" << std::endl;
+        pglDeleteFramebuffers(1, &captureFbo);
+        pglDeleteRenderbuffers(1, &captureColorRb);
+        pglDeleteRenderbuffers(1, &captureDepthRb);
+        glDeleteTextures(1, &atlasTex);
+        captureFbo = captureColorRb = captureDepthRb = atlasTex = 0;
+        return false;
+    }
+
+    available = true;
+    impostorInvalidate();
+    std::cout << "Campus impostor: " << IMPOSTOR_VIEWS << " views, " << IMPOSTOR_SLOTS << " kept at " << IMPOSTOR_SLOT_SIZE
+              << " px in a " << IMPOSTOR_ATLAS << " px atlas" << std::endl;
+    return true;
+}
+
+void impostorSetBounds(const Vec3 &newCenter, float newRadius)
+{
+    if (newCenter.x == center.x && newCenter.y == center.y && newCenter.z == center.z && newRadius == radius)
+        return;
+    center = newCenter;
+    radius = std::max(newRadius, 1.0f);
+    impostorInvalidate();
+}
+
+void impostorInvalidate()
+{
+    for (ImpostorView &view : views)
+        view = {VIEW_EMPTY, -1, 0};
+    std::fill(slotView, slotView + IMPOSTOR_SLOTS, -1);
+}
+
+void impostorRefresh()
+{
+    for (ImpostorView &view : views)
+    {
+        if (view.state == VIEW_CURRENT)
+            view.state = VIEW_STALE;
+    }
+}
+
+bool impostorUsable(const Vec3 &eye)
+{
+    return available && length(eye - center) >= IMPOSTOR_MIN_RANGE * radius;
+}
+
+void impostorPrepare(const Vec3 &eye, ImpostorCaptureFn capture)
+{
+    if (!impostorUsable(eye))
+        return;
+    ++frame;
+    int picked[4];
+    float weights[4];
+    int count = viewsAround(eye, picked, weights);
+
+    // Missing views are needed now; stale ones can wait a frame each
+    int due[4];
+    int dueCount = 0;
+    bool refreshing = false;
+    for (int k = 0; k < count; ++k)
+    {
+        ImpostorView &view = views[picked[k]];
+        view.lastUsed = frame;
+        if (view.state == VIEW_EMPTY || (view.state == VIEW_STALE && !refreshing))
+        {
+            refreshing = refreshing || view.state == VIEW_STALE;
+            due[dueCount++] = picked[k];
+        }
+    }
+    if (dueCount == 0)
+        return;
+
+    GLint viewport[4];
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    pglBindFramebuffer(GL_FRAMEBUFFER, captureFbo);
+    glViewport(0, 0, IMPOSTOR_SLOT_SIZE, IMPOSTOR_SLOT_SIZE);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Clear where nothing is drawn
+    for (int k = 0; k < dueCount; ++k)
+        captureView(due[k], capture);
+    pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void impostorDraw(const Vec3 &eye)
+{
+    int picked[4];
+    float weights[4];
+    int count = viewsAround(eye, picked, weights);
+
+    rcSyncModelview();
+    bool blending = glsIsEnabled(GL_BLEND);
+    glsDisable(GL_LIGHTING);
+    glsDisable(GL_DEPTH_TEST); // Cards are flat; what is drawn later goes over them
+    glsDepthMask(GL_FALSE);
+    glsEnable(GL_BLEND);
+    glsEnable(GL_TEXTURE_2D);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); // Cleared texels are black, so filtered edges come premultiplied
+    glBindTexture(GL_TEXTURE_2D, atlasTex);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+    // Each card covers its share of the cards drawn so far, leaving their weighted average
+    const float corners[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    const float span = static_cast<float>(IMPOSTOR_SLOT_SIZE) / IMPOSTOR_ATLAS;
+    float drawn = 0.0f;
+    glBegin(GL_QUADS);
+    for (int k = 0; k < count; ++k)
+    {
+        const ImpostorView &view = views[picked[k]];
+        if (view.state == VIEW_EMPTY)
+            continue;
+        drawn += weights[k];
+        float share = weights[k] / drawn;
+        glColor4f(share, share, share, share);
+
+        // Square to its own direction, so the picture lines up where it was taken
+        Vec3 d = viewDirection(picked[k]);
+        Vec3 side = normalize(cross(-d, viewUp(d)));
+        Vec3 up = cross(side, -d);
+        float s0 = (view.slot % IMPOSTOR_SLOT_GRID) * span;
+        float t0 = (view.slot / IMPOSTOR_SLOT_GRID) * span;
+        for (const float *c : corners)
+        {
+            Vec3 p = center + (side * c[0] + up * c[1]) * radius;
+            glTexCoord2f(s0 + 0.5f * (c[0] + 1.0f) * span, t0 + 0.5f * (c[1] + 1.0f) * span);
+            glVertex3f(p.x, p.y, p.z);
+        }
+    }
+    glEnd();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glsDisable(GL_TEXTURE_2D);
+    glsSet(GL_BLEND, blending);
+    glsDepthMask(GL_TRUE);
+    glsEnable(GL_DEPTH_TEST);
+    glsEnable(GL_LIGHTING);
+}
+
+unsigned impostorGeneration()
+{
+    return generation;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Math3D.h"
+
+// Far-away stand-in for the static campus: ground, roads, buildings, lots,
+// courts, trees and paths. The upper hemisphere of view directions is folded
+// hemi-octahedrally onto a square grid of views, so neighbouring directions
+// are neighbouring views. A view is an orthographic picture of the campus
+// from its direction, kept in one slot of a texture atlas. From far enough
+// away the campus is drawn as the cards of the views around the view
+// direction, cross-faded, instead of as geometry: a few textured quads.
+//
+// Views are captured the first time a frame needs them, into a free slot or
+// the one used least recently. A change to what is drawn drops them all. A
+// lighting or status change only marks them stale; a stale view in use is
+// captured again, one per frame, and meanwhile its old picture stands in.
+
+// Draws the static campus for a capture under this projection and view
+typedef void (*ImpostorCaptureFn)(const Mat4 &projection, const Mat4 &view);
+
+// Creates the atlas; false without framebuffer objects
+bool impostorInit();
+// Sphere around everything captured. Drops every view if it moved.
+void impostorSetBounds(const Vec3 &center, float radius);
+void impostorInvalidate(); // Drops every view
+void impostorRefresh();    // Marks every view stale
+
+// True if the campus can stand in as cards from this eye: the atlas exists
+// and the eye is far enough out that the cards' flatness does not show
+bool impostorUsable(const Vec3 &eye);
+// Captures the views a frame from this eye needs. Call before the 3D pass,
+// with no other framebuffer bound.
+void impostorPrepare(const Vec3 &eye, ImpostorCaptureFn capture);
+// Draws the cards under the current modelview, which must hold the view
+void impostorDraw(const Vec3 &eye);
+// Changes whenever a view is captured
+unsigned impostorGeneration();
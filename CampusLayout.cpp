@@ -0,0 +1,232 @@
+#include "CampusLayout.h"
+#include "DefaultLayout.h"
+#include "LayoutCompiler.h"
+#include "LayoutDiff.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+const uint32_t LAYOUT_RECORD_SIZE[LAYOUT_SECTION_COUNT] = {
+    sizeof(LayoutBuilding), sizeof(LayoutRoad),       sizeof(LayoutParkingLot), sizeof(LayoutCourt), sizeof(LayoutTree),
+    sizeof(LayoutPath),     sizeof(LayoutRoutePoint), sizeof(LayoutAabb),       1,
+};
+
+static CampusLayout current;
+static std::vector<unsigned char> compiled; // Image of the built-in layout
+static MappedFile mapped = {};
+
+const char *campusLayoutDefaultText()
+{
+    return DEFAULT_LAYOUT;
+}
+
+// Every record's AABB lies in the AABB table
+template <typename Record>
+static bool checkAabbs(const Record *records, uint32_t count, const char *what, uint32_t aabbCount, std::string &error)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        if (records[i].aabb >= aabbCount)
+        {
+            error = std::string(what) + " " + std::to_string(i) + " has AABB " + std::to_string(records[i].aabb) +
+                    " of " + std::to_string(aabbCount);
+            return false;
+        }
+    return true;
+}
+
+// Indices between records, which the renderer uses without checking again
+static bool checkReferences(const CampusLayout &layout, std::string &error)
+{
+    for (uint32_t i = 0; i < layout.buildingCount; ++i)
+        if (layout.buildings[i].kind >= LAYOUT_BUILDING_KIND_COUNT)
+        {
+            error = "building " + std::to_string(i) + " has unknown kind " + std::to_string(layout.buildings[i].kind);
+            return false;
+        }
+    for (uint32_t i = 0; i < layout.courtCount; ++i)
+        if (layout.courts[i].kind >= LAYOUT_COURT_KIND_COUNT)
+        {
+            error = "court " + std::to_string(i) + " has unknown kind " + std::to_string(layout.courts[i].kind);
+            return false;
+        }
+    for (uint32_t i = 0; i < layout.roadCount; ++i)
+        if (layout.roads[i].axis != 0 && layout.roads[i].axis != 2)
+        {
+            error = "road " + std::to_string(i) + " has axis " + std::to_string(layout.roads[i].axis);
+            return false;
+        }
+    uint32_t n = layout.aabbCount;
+    if (!checkAabbs(layout.buildings, layout.buildingCount, "building", n, error) ||
+        !checkAabbs(layout.roads, layout.roadCount, "road", n, error) ||
+        !checkAabbs(layout.parkingLots, layout.parkingLotCount, "parking lot", n, error) ||
+        !checkAabbs(layout.courts, layout.courtCount, "court", n, error) ||
+        !checkAabbs(layout.trees, layout.treeCount, "tree", n, error) ||
+        !checkAabbs(layout.paths, layout.pathCount, "path", n, error))
+        return false;
+
+    const uint32_t counts[LAYOUT_ROUTE] = {layout.buildingCount, layout.roadCount, layout.parkingLotCount,
+                                           layout.courtCount,    layout.treeCount, layout.pathCount};
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        const LayoutAabb &aabb = layout.aabbs[i];
+        if (aabb.section >= LAYOUT_ROUTE || aabb.index >= counts[aabb.section])
+        {
+            error = "AABB " + std::to_string(i) + " names object " + std::to_string(aabb.index) + " of section " +
+                    std::to_string(aabb.section);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool campusLayoutView(const void *data, size_t size, CampusLayout &layout, std::string &error)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    if (size < sizeof(LayoutHeader) || reinterpret_cast<uintptr_t>(data) % 4 != 0)
+    {
+        error = "too small for a layout header";
+        return false;
+    }
+    const LayoutHeader &header = *reinterpret_cast<const LayoutHeader *>(bytes);
+    if (std::memcmp(header.magic, "SCLY", 4) != 0)
+    {
+        error = "not a campus layout";
+        return false;
+    }
+    if (header.byteOrder != LAYOUT_BYTE_ORDER)
+    {
+        error = "layouts are little-endian and this host is not";
+        return false;
+    }
+    if (header.version != LAYOUT_VERSION)
+    {
+        error = "layout version " + std::to_string(header.version) + ", expected " + std::to_string(LAYOUT_VERSION);
+        return false;
+    }
+    if (header.fileSize != size)
+    {
+        error = "truncated layout";
+        return false;
+    }
+    for (int i = 0; i < LAYOUT_SECTION_COUNT; ++i)
+    {
+        const LayoutSection &section = header.sections[i];
+        uint64_t end = section.offset + static_cast<uint64_t>(section.count) * LAYOUT_RECORD_SIZE[i];
+        if (section.offset % 4 != 0 || section.offset < sizeof(LayoutHeader) || end > size)
+        {
+            error = "section " + std::to_string(i) + " lies outside the layout";
+            return false;
+        }
+    }
+    const LayoutSection &strings = header.sections[LAYOUT_STRINGS];
+    if (strings.count == 0 || bytes[strings.offset + strings.count - 1] != '\0')
+    {
+        error = "unterminated string table";
+        return false;
+    }
+
+    const LayoutSection *s = header.sections;
+    CampusLayout view;
+    view.image = data;
+    view.imageSize = size;
+    view.buildings = reinterpret_cast<const LayoutBuilding *>(bytes + s[LAYOUT_BUILDINGS].offset);
+    view.buildingCount = s[LAYOUT_BUILDINGS].count;
+    view.roads = reinterpret_cast<const LayoutRoad *>(bytes + s[LAYOUT_ROADS].offset);
+    view.roadCount = s[LAYOUT_ROADS].count;
+    view.parkingLots = reinterpret_cast<const LayoutParkingLot *>(bytes + s[LAYOUT_PARKING_LOTS].offset);
+    view.parkingLotCount = s[LAYOUT_PARKING_LOTS].count;
+    view.courts = reinterpret_cast<const LayoutCourt *>(bytes + s[LAYOUT_COURTS].offset);
+    view.courtCount = s[LAYOUT_COURTS].count;
+    view.trees = reinterpret_cast<const LayoutTree *>(bytes + s[LAYOUT_TREES].offset);
+    view.treeCount = s[LAYOUT_TREES].count;
+    view.paths = reinterpret_cast<const LayoutPath *>(bytes + s[LAYOUT_PATHS].offset);
+    view.pathCount = s[LAYOUT_PATHS].count;
+    view.route = reinterpret_cast<const LayoutRoutePoint *>(bytes + s[LAYOUT_ROUTE].offset);
+    view.routeCount = s[LAYOUT_ROUTE].count;
+    view.aabbs = reinterpret_cast<const LayoutAabb *>(bytes + s[LAYOUT_AABBS].offset);
+    view.aabbCount = s[LAYOUT_AABBS].count;
+    view.strings = reinterpret_cast<const char *>(bytes + strings.offset);
+    view.stringBytes = strings.count;
+    if (!checkReferences(view, error))
+        return false;
+    layout = view;
+    return true;
+}
+
+// Binary layouts stay mapped; text ones are compiled into image
+static bool openLayout(const char *path, MappedFile &file, std::vector<unsigned char> &image, CampusLayout &layout,
+                       std::string &error)
+{
+    if (!mapFile(path, file))
+    {
+        error = std::string("cannot map ") + path;
+        return false;
+    }
+    if (file.size >= 4 && std::memcmp(file.data, "SCLY", 4) == 0)
+    {
+        if (campusLayoutView(file.data, file.size, layout, error))
+            return true;
+        unmapFile(file);
+        return false;
+    }
+    std::string text(static_cast<const char *>(file.data), file.size);
+    unmapFile(file);
+    return layoutCompileText(text, image, error) && campusLayoutView(image.data(), image.size(), layout, error);
+}
+
+static void makeCurrent(MappedFile &file, std::vector<unsigned char> &image, const CampusLayout &layout)
+{
+    unmapFile(mapped);
+    mapped = file;
+    compiled.swap(image); // The buffer moves with it, so layout's views stay valid
+    current = layout;
+}
+
+bool campusLayoutLoad(const char *path, std::string &error)
+{
+    MappedFile file = {};
+    std::vector<unsigned char> image;
+    CampusLayout layout;
+    if (!openLayout(path, file, image, layout, error))
+        return false;
+    makeCurrent(file, image, layout);
+    return true;
+}
+
+bool campusLayoutReload(const char *path, LayoutDiff &diff, std::string &error)
+{
+    MappedFile file = {};
+    std::vector<unsigned char> image;
+    CampusLayout layout;
+    if (!openLayout(path, file, image, layout, error))
+        return false;
+    layoutDiff(current, layout, diff);
+    makeCurrent(file, image, layout);
+    return true;
+}
+
+void campusLayoutLoadDefault()
+{
+    std::vector<unsigned char> image;
+    std::string error;
+    CampusLayout layout;
+    if (!layoutCompileText(DEFAULT_LAYOUT, image, error) || !campusLayoutView(image.data(), image.size(), layout, error))
+    {
+        std::cout << "Built-in layout: " << error << std::endl; // Only a broken build gets here
+        return;
+    }
+    unmapFile(mapped);
+    compiled.swap(image);
+    current = layout;
+}
+
+const CampusLayout &campusLayout()
+{
+    return current;
+}
+
+const char *layoutString(const CampusLayout &layout, uint32_t offset)
+{
+    return offset < layout.stringBytes ? layout.strings + offset : "";
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary campus layout. Everything the renderer and the picker place in the
+// world - buildings, roads, parking lots, courts, trees, paths and the car
+// route - comes from one file laid out exactly as these structs are in
+// memory: little-endian, 4-byte fields, each section 16-byte aligned. The file
+// is mapped and used in place; loading only checks the header and the indices
+// between records. Text layouts are compiled to this form by LayoutCompiler.h
+// (tools/layoutc.cpp).
+
+const uint32_t LAYOUT_VERSION = 1;
+const uint32_t LAYOUT_BYTE_ORDER = 0x01020304; // Reads back differently on a big-endian host
+
+enum LayoutSectionId
+{
+    LAYOUT_BUILDINGS,
+    LAYOUT_ROADS,
+    LAYOUT_PARKING_LOTS,
+    LAYOUT_COURTS,
+    LAYOUT_TREES,
+    LAYOUT_PATHS,
+    LAYOUT_ROUTE,
+    LAYOUT_AABBS,
+    LAYOUT_STRINGS, // Count is in bytes
+    LAYOUT_SECTION_COUNT
+};
+
+struct LayoutSection
+{
+    uint32_t offset; // From the start of the file
+    uint32_t count;
+};
+
+struct LayoutHeader
+{
+    char magic[4]; // "SCLY"
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t fileSize;
+    LayoutSection sections[LAYOUT_SECTION_COUNT];
+};
+
+enum LayoutBuildingKind
+{
+    LAYOUT_ACADEMIC_BLOCK,
+    LAYOUT_LIBRARY,
+    LAYOUT_DORMITORY,
+    LAYOUT_ADMIN_BLOCK,
+    LAYOUT_CAFE,
+    LAYOUT_BUILDING_KIND_COUNT
+};
+
+// Kind names in text layouts, which are also the BuildingGeometry names;
+// constexpr so StaticBuildings.cpp can read DEFAULT_LAYOUT at compile time
+constexpr const char *LAYOUT_BUILDING_KIND_NAMES[LAYOUT_BUILDING_KIND_COUNT] = {"academic", "library", "dormitory",
+                                                                           "admin", "cafe"};
+
+enum LayoutCourtKind
+{
+    LAYOUT_BASKETBALL,
+    LAYOUT_FOOTBALL,
+    LAYOUT_COURT_KIND_COUNT
+};
+
+// Strings are offsets into the string table; AABBs index the AABB table
+struct LayoutBuilding
+{
+    uint32_t kind;
+    float position[3]; // Centre of the ground floor
+    float size[3];
+    float color[3];
+    int32_t windowsX, windowsZFront, windowsZSide, floors;
+    int32_t slot; // Status/selection slot of the info box, -1 = not selectable
+    uint32_t label; // Drawn above the building
+    uint32_t name;  // Shown in the info box
+    uint32_t aabb;
+};
+
+struct LayoutRoad
+{
+    float position[3];
+    float length, width;
+    uint32_t axis; // 0 = runs along X, 2 = along Z
+    uint32_t aabb;
+};
+
+struct LayoutParkingLot
+{
+    float position[3];
+    uint32_t aabb;
+};
+
+struct LayoutCourt
+{
+    uint32_t kind;
+    float position[3];
+    uint32_t aabb;
+};
+
+struct LayoutTree
+{
+    float position[3];
+    uint32_t aabb;
+};
+
+struct LayoutPath
+{
+    float start[3]; // First tile; the rest follow along +X
+    uint32_t tiles;
+    uint32_t aabb;
+};
+
+struct LayoutRoutePoint
+{
+    float x, z;
+};
+
+struct LayoutAabb
+{
+    float min[3], max[3];
+    uint32_t section; // LayoutSectionId of the object
+    uint32_t index;
+};
+
+static_assert(sizeof(LayoutHeader) == 16 + 8 * LAYOUT_SECTION_COUNT, "layout header must not be padded");
+static_assert(sizeof(LayoutBuilding) == 72, "layout records are part of the file format");
+static_assert(sizeof(LayoutRoad) == 28 && sizeof(LayoutParkingLot) == 16 && sizeof(LayoutCourt) == 20 &&
+                  sizeof(LayoutTree) == 16 && sizeof(LayoutPath) == 20 && sizeof(LayoutRoutePoint) == 8 &&
+                  sizeof(LayoutAabb) == 32,
+              "layout records are part of the file format");
+
+// Record size of each section, 1 for the string table
+extern const uint32_t LAYOUT_RECORD_SIZE[LAYOUT_SECTION_COUNT];
+
+struct LayoutDiff;
+
+// Views into the mapped file
+struct CampusLayout
+{
+    const void *image; // The whole file
+    size_t imageSize;
+    const LayoutBuilding *buildings;
+    uint32_t buildingCount;
+    const LayoutRoad *roads;
+    uint32_t roadCount;
+    const LayoutParkingLot *parkingLots;
+    uint32_t parkingLotCount;
+    const LayoutCourt *courts;
+    uint32_t courtCount;
+    const LayoutTree *trees;
+    uint32_t treeCount;
+    const LayoutPath *paths;
+    uint32_t pathCount;
+    const LayoutRoutePoint *route;
+    uint32_t routeCount;
+    const LayoutAabb *aabbs;
+    uint32_t aabbCount;
+    const char *strings;
+    uint32_t stringBytes;
+};
+
+// Checks the header, section bounds and the kinds and indices records refer to
+// each other by, then points layout into the image. The image must stay alive
+// and 4-byte aligned.
+bool campusLayoutView(const void *data, size_t size, CampusLayout &layout, std::string &error);
+
+// Maps a compiled layout file, or compiles a text one, and makes it current
+bool campusLayoutLoad(const char *path, std::string &error);
+// Loads path the same way and fills diff (LayoutDiff.h) from the layout it
+// replaces, which stays mapped until the diff is done. On failure the
+// current layout is kept.
+bool campusLayoutReload(const char *path, LayoutDiff &diff, std::string &error);
+// Compiles the built-in campus and makes it current
+void campusLayoutLoadDefault();
+const CampusLayout &campusLayout();
+
+// String table lookup; "" for an offset outside the table
+const char *layoutString(const CampusLayout &layout, uint32_t offset);
+
+// The built-in campus in the text form LayoutCompiler.h reads
+const char *campusLayoutDefaultText();
@@ -0,0 +1,169 @@
+#include "CubeBatch.h"
+#include "GLExt.h"
+#include "Profiler.h"
+#include "ShaderPipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+struct CubeVertex
+{
+    GLfloat position[3]; // Eye space
+    GLfloat normal[3];
+    GLubyte color[4];
+};
+
+static std::vector<CubeVertex> vertices;
+static std::vector<GLuint> indices;
+static GLuint vertexBuffer = 0;
+static GLuint indexBuffer = 0;
+static GLuint vertexArray = 0; // Shader pipeline only
+
+void drawCube(float size)
+{
+    renderQueueCube(size, size, size);
+}
+
+void drawRectPrism(float w, float h, float d)
+{
+    renderQueueCube(w, h, d);
+}
+
+void cubeBatchAppend(const Mat4 &modelview, const GLubyte color[4])
+{
+    const float *m = modelview.m;
+
+    // Normals go through the inverse transpose of the upper 3x3. Its cofactor
+    // matrix differs only by a factor, which the normalize removes.
+    float cof[3][3];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            int r1 = (r + 1) % 3, r2 = (r + 2) % 3, c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+            cof[r][c] = m[c1 * 4 + r1] * m[c2 * 4 + r2] - m[c2 * 4 + r1] * m[c1 * 4 + r2];
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            // Eye-space face normal: column `axis` of the cofactor matrix
+            Vec3 n = normalize(Vec3(cof[0][axis], cof[1][axis], cof[2][axis]) * static_cast<float>(sign));
+
+            GLuint base = static_cast<GLuint>(vertices.size());
+            static const float corners[4][2] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+            for (int i = 0; i < 4; ++i)
+            {
+                // Counter-clockwise seen from outside: reverse the winding on the negative face
+                const float *corner = corners[sign > 0 ? i : 3 - i];
+                float local[3];
+                local[axis] = 0.5f * sign;
+                local[u] = corner[0];
+                local[v] = corner[1];
+
+                Vec3 p = transformPoint(modelview, Vec3(local[0], local[1], local[2]));
+                CubeVertex vertex = {{p.x, p.y, p.z}, {n.x, n.y, n.z}, {color[0], color[1], color[2], color[3]}};
+                vertices.push_back(vertex);
+            }
+            static const GLuint quad[6] = {0, 1, 2, 0, 2, 3};
+            for (GLuint index : quad)
+                indices.push_back(base + index);
+        }
+    }
+}
+
+static void setVertexAttribs()
+{
+    pglEnableVertexAttribArray(SHADER_ATTRIB_POSITION);
+    pglVertexAttribPointer(SHADER_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(CubeVertex, position)));
+    pglEnableVertexAttribArray(SHADER_ATTRIB_NORMAL);
+    pglVertexAttribPointer(SHADER_ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(CubeVertex, normal)));
+    pglEnableVertexAttribArray(SHADER_ATTRIB_COLOR);
+    pglVertexAttribPointer(SHADER_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CubeVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(CubeVertex, color)));
+}
+
+static void uploadBuffers()
+{
+    // Re-specifying the whole store each draw lets the driver orphan the old one
+    pglBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    pglBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(CubeVertex), vertices.data(), GL_STREAM_DRAW);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    pglBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STREAM_DRAW);
+}
+
+static void drawWithShaders()
+{
+    if (vertexArray == 0)
+    {
+        pglGenVertexArrays(1, &vertexArray);
+        pglBindVertexArray(vertexArray);
+        pglBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        setVertexAttribs();
+    }
+    else
+    {
+        pglBindVertexArray(vertexArray);
+    }
+    uploadBuffers(); // The element buffer binding is part of the vertex array
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    shaderPipelineUse();
+    shaderPipelineSetModelview(Mat4()); // Vertices are already in eye space
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+    pglBindVertexArray(0);
+    shaderPipelineRelease();
+}
+
+void cubeBatchDraw()
+{
+    if (indices.empty())
+        return;
+    if (glHasVertexBufferObject && vertexBuffer == 0)
+    {
+        pglGenBuffers(1, &vertexBuffer);
+        pglGenBuffers(1, &indexBuffer);
+    }
+    if (shaderPipelineActive())
+    {
+        drawWithShaders();
+        profilerCount(PROFILE_DRAW_CALLS);
+        vertices.clear();
+        indices.clear();
+        return;
+    }
+
+    const char *vertexBase = reinterpret_cast<const char *>(vertices.data());
+    const GLvoid *indexBase = indices.data();
+    if (vertexBuffer != 0)
+    {
+        uploadBuffers();
+        vertexBase = nullptr;
+        indexBase = nullptr;
+    }
+    glLoadIdentity(); // Cube vertices are already in eye space
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(CubeVertex), vertexBase + offsetof(CubeVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(CubeVertex), vertexBase + offsetof(CubeVertex, normal));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(CubeVertex), vertexBase + offsetof(CubeVertex, color));
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, indexBase);
+    profilerCount(PROFILE_DRAW_CALLS);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (vertexBuffer != 0)
+    {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    vertices.clear();
+    indices.clear();
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "MatrixStack.h"
+#include "RenderQueue.h"
+#include <GL/glut.h>
+
+// The scene's boxes. drawCube/drawRectPrism keep their old call surface but,
+// instead of one immediate-mode glutSolidCube each, record the box in the
+// render queue with the current transform (MatrixStack.h) and colour
+// (rcColor*). At flush the queue hands runs of cubes back here; they are
+// transformed to eye space into one streaming buffer and drawn with a single
+// call per run.
+
+// Axis-aligned cube of edge size / box of w x h x d centred at the origin
+void drawCube(float size);
+void drawRectPrism(float w, float h, float d);
+
+// Appends a unit cube under modelview (box scale included)
+void cubeBatchAppend(const Mat4 &modelview, const GLubyte color[4]);
+// Draws and clears the appended cubes with the current state, on the shader
+// pipeline when it is active. Leaves GL's modelview as the identity.
+void cubeBatchDraw();
@@ -0,0 +1,57 @@
+#pragma once
+
+// The campus as drawCampusBuildings and drawScene3D used to place it, which
+// campusLayoutDefaultText hands out. StaticBuildings.cpp reads its building
+// lines at compile time for the shapes it precompiles.
+constexpr char DEFAULT_LAYOUT[] = R"(# Smart campus layout, compiled by tools/layoutc
+#
+# building KIND X Y Z  WIDTH HEIGHT DEPTH  R G B  WINDOWS_X WINDOWS_FRONT WINDOWS_SIDE FLOORS  SLOT "LABEL" "NAME"
+# road X Y Z LENGTH WIDTH x|z
+# parking X Y Z
+# court basketball|football X Y Z
+# tree X Y Z
+# path X Y Z TILES
+# route X Z
+
+building academic -60 0 -25   35 30 18  0.75 0.65 0.58  3 5 2 4  1  "Academic Block 1" "Academic Block 1"
+building academic -60 0 25    35 30 18  0.75 0.65 0.58  3 5 2 4  2  "Academic Block 2" "Academic Block 2"
+building academic -100 0 -25  35 30 18  0.75 0.65 0.58  3 5 2 4  3  "Academic Block 3" "Academic Block 3"
+building academic -100 0 25   35 30 18  0.75 0.65 0.58  3 5 2 4  4  "Academic Block 4" "Academic Block 4"
+building library 0 0 -25      35 45 28  0.85 0.8 0.75   5 4 3 5  5  "Central Library" "Library"
+building dormitory 70 0 -60   18 24 12  0.74 0.74 0.67  2 3 2 4  8  "Mens Dorm 1" "Mens Dormitory 1"
+building dormitory 70 0 -35   18 24 12  0.72 0.74 0.65  2 3 2 4  9  "Mens Dorm 2" "Mens Dormitory 2"
+building dormitory 70 0 35    18 24 12  0.75 0.75 0.68  2 3 2 4  6  "Womens Dorm 1" "Womens Dormitory 1"
+building dormitory 70 0 60    18 24 12  0.76 0.75 0.68  2 3 2 4  7  "Womens Dorm 2" "Womens Dormitory 2"
+building admin 0 0 25         26 20 16  0.85 0.85 0.7   2 3 2 3  0  "Admin Block" "Admin Block"
+building cafe 0 0 50          16 12 12  0.9 0.75 0.75   2 2 2 2  10 "Cafe" "Cafe"
+
+road 0 0.05 0    180 12 x
+road -30 0.05 0  120 12 z
+road 30 0.05 0   120 12 z
+
+parking 0 0 -70
+
+court basketball 102 5 -80
+court football 105 0.1 0
+
+# Garden behind the cafe
+tree -45 0 78
+tree -38 0 92
+tree -30 0 76
+tree -22 0 95
+tree -14 0 79
+tree -6 0 94
+tree 2 0 76
+tree 10 0 93
+path -48 0 85 46
+
+route -80 40
+route -30 40
+route -30 -50
+route 30 -50
+route 30 40
+route 80 40
+route 80 -50
+route -80 -50
+route -80 40
+)";
@@ -0,0 +1,81 @@
+#include "DynamicResolution.h"
+#include "Options.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Samples per decision; also gives a new scale time to show up. The median is
+// used so a single hitch (or a bogus first query) cannot move the scale.
+static const int SAMPLES_PER_DECISION = 15;
+// Scale is kept on a grid so small jitter does not reallocate the target
+static const float SCALE_STEP = 0.05f;
+// Above target by this factor: scale down. Below by this factor: scale up.
+static const double OVER_BUDGET = 1.05;
+static const double UNDER_BUDGET = 0.75;
+
+static float currentScale = 1.0f;
+static double samples[SAMPLES_PER_DECISION];
+static int sampleCount = 0;
+
+static float clampScale(float s)
+{
+    s = std::round(s / SCALE_STEP) * SCALE_STEP;
+    return std::max(campusOptions.resolutionScaleMin, std::min(campusOptions.resolutionScaleMax, s));
+}
+
+void dynamicResolutionReset()
+{
+    currentScale = campusOptions.resolutionScaleMax;
+    sampleCount = 0;
+}
+
+float dynamicResolutionScale()
+{
+    return currentScale;
+}
+
+bool dynamicResolutionUpdate(double sceneMs)
+{
+    if (!campusOptions.dynamicResolution)
+        return false;
+
+    samples[sampleCount] = sceneMs;
+    if (++sampleCount < SAMPLES_PER_DECISION)
+        return false;
+    sampleCount = 0;
+
+    std::nth_element(samples, samples + SAMPLES_PER_DECISION / 2, samples + SAMPLES_PER_DECISION);
+    double median = samples[SAMPLES_PER_DECISION / 2];
+    double target = campusOptions.frameTargetMs;
+
+    // Fill cost goes with pixel count, i.e. with the square of the scale
+    float wanted = currentScale;
+    const char *reason = nullptr;
+    if (median > target * OVER_BUDGET)
+    {
+        double factor = std::max(0.7, std::min(0.98, std::sqrt(target / median)));
+        wanted = static_cast<float>(currentScale * factor);
+        reason = "over";
+        if (clampScale(wanted) == currentScale)
+            wanted = currentScale - SCALE_STEP; // Always make progress while over budget
+    }
+    else if (median < target * UNDER_BUDGET)
+    {
+        double factor = std::min(1.1, std::sqrt(target / median));
+        wanted = static_cast<float>(currentScale * factor);
+        reason = "under";
+    }
+
+    float next = clampScale(wanted);
+    if (!reason || next == currentScale)
+        return false;
+
+    std::ostringstream line;
+    line << "Dynamic resolution: scene " << std::fixed << std::setprecision(2) << median << " ms " << reason << " "
+         << target << " ms target, scale " << currentScale << " -> " << next;
+    std::cout << line.str() << std::endl;
+    currentScale = next;
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Frame-time governor for the resolution of the 3D pass. Fed with measured
+// scene-pass GPU times, it moves the scale between the configured bounds
+// (CampusOptions) to hold the frame target, and logs every decision.
+
+// Back to the highest allowed scale
+void dynamicResolutionReset();
+
+// Current scale per axis, 1 = native window resolution
+float dynamicResolutionScale();
+
+// Adds one scene-pass time; returns true if the scale changed
+bool dynamicResolutionUpdate(double sceneMs);
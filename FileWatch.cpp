@@ -0,0 +1,119 @@
+#include "FileWatch.h"
+#include <chrono>
+#include <string>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+const int SETTLE_MS = 100; // Quiet time before a change is reported
+const int POLL_MS = 250;   // Between modification time checks
+
+static std::string watchedPath;
+static std::string watchedName; // Within its directory, as inotify reports it
+static int notifyFd = -1;
+static bool pending = false;
+static Clock::time_point lastEvent;
+static Clock::time_point lastPoll;
+static long long polledTime = 0, polledSize = -1;
+
+static void statFile(long long &time, long long &size)
+{
+    struct stat info;
+    if (stat(watchedPath.c_str(), &info) != 0)
+    {
+        time = 0;
+        size = -1;
+        return;
+    }
+    time = static_cast<long long>(info.st_mtime);
+    size = static_cast<long long>(info.st_size);
+}
+
+bool fileWatchStart(const char *path)
+{
+    fileWatchStop();
+    watchedPath = path;
+    size_t slash = watchedPath.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "." : watchedPath.substr(0, slash + 1);
+    watchedName = slash == std::string::npos ? watchedPath : watchedPath.substr(slash + 1);
+    statFile(polledTime, polledSize);
+    lastPoll = Clock::now();
+
+#ifdef __linux__
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd >= 0 && inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+        return true;
+    if (notifyFd >= 0)
+        close(notifyFd);
+    notifyFd = -1;
+#endif
+    return polledSize >= 0; // Polling
+}
+
+void fileWatchStop()
+{
+#ifdef __linux__
+    if (notifyFd >= 0)
+        close(notifyFd);
+#endif
+    notifyFd = -1;
+    watchedPath.clear();
+    pending = false;
+}
+
+static bool readEvents()
+{
+    bool seen = false;
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            if (event->len > 0 && watchedName == event->name)
+                seen = true;
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+    return seen;
+}
+
+bool fileWatchChanged()
+{
+    if (watchedPath.empty())
+        return false;
+    Clock::time_point now = Clock::now();
+    bool changed = false;
+    if (notifyFd >= 0)
+    {
+        changed = readEvents();
+    }
+    else if (now - lastPoll >= std::chrono::milliseconds(POLL_MS))
+    {
+        lastPoll = now;
+        long long time, size;
+        statFile(time, size);
+        changed = time != polledTime || size != polledSize;
+        polledTime = time;
+        polledSize = size;
+    }
+    if (changed)
+    {
+        pending = true;
+        lastEvent = now;
+    }
+    if (!pending || now - lastEvent < std::chrono::milliseconds(SETTLE_MS))
+        return false;
+    pending = false;
+    return true;
+}
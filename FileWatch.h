@@ -0,0 +1,13 @@
+#pragma once
+
+// Notices when one file is rewritten. On Linux inotify watches the file's
+// directory, which also catches tools that save by renaming a new file over
+// the old one; elsewhere, or without inotify, the file's modification time
+// and size are polled. Changes are reported once they have been quiet for a
+// moment, so a file still being written is not read half done.
+
+bool fileWatchStart(const char *path);
+void fileWatchStop();
+
+// True once per settled change; cheap enough to call every frame
+bool fileWatchChanged();
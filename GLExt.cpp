@@ -0,0 +1,83 @@
+#include "GLExt.h"
+#include <GL/freeglut.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#define CAMPUS_GL_DEFINE(type, name) type pgl##name = nullptr;
+CAMPUS_GL_FUNCTIONS(CAMPUS_GL_DEFINE)
+#undef CAMPUS_GL_DEFINE
+
+bool glHasFramebufferObject = false;
+bool glHasTimerQuery = false;
+bool glHasOcclusionQuery = false;
+bool glHasVertexBufferObject = false;
+bool glHasShaderPipeline = false;
+
+static GLUTproc loadProc(const char *name)
+{
+    static const char *suffixes[] = {"", "EXT", "ARB"};
+    for (const char *suffix : suffixes)
+    {
+        GLUTproc p = glutGetProcAddress((std::string(name) + suffix).c_str());
+        if (p)
+            return p;
+    }
+    return nullptr;
+}
+
+bool glVersionAtLeast(int major, int minor)
+{
+    const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    int vMajor = 0, vMinor = 0;
+    if (!version || std::sscanf(version, "%d.%d", &vMajor, &vMinor) != 2)
+        return false;
+    return vMajor > major || (vMajor == major && vMinor >= minor);
+}
+
+bool glHasExtension(const char *extension)
+{
+    const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+    if (!extensions || !extension)
+        return false;
+    // Match whole names only, GL_EXT_foo must not match GL_EXT_foo_bar
+    size_t len = std::strlen(extension);
+    for (const char *p = std::strstr(extensions, extension); p; p = std::strstr(p + len, extension))
+    {
+        if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+            return true;
+    }
+    return false;
+}
+
+void glExtInit()
+{
+#define CAMPUS_GL_LOAD(type, name) pgl##name = reinterpret_cast<type>(loadProc("gl" #name));
+    CAMPUS_GL_FUNCTIONS(CAMPUS_GL_LOAD)
+#undef CAMPUS_GL_LOAD
+
+    glHasFramebufferObject = pglGenFramebuffers && pglDeleteFramebuffers && pglBindFramebuffer &&
+                             pglFramebufferTexture2D && pglFramebufferRenderbuffer &&
+                             pglCheckFramebufferStatus && pglGenRenderbuffers &&
+                             pglDeleteRenderbuffers && pglBindRenderbuffer && pglRenderbufferStorage;
+    glHasTimerQuery = pglGenQueries && pglDeleteQueries && pglBeginQuery && pglEndQuery &&
+                      pglGetQueryObjectiv && pglGetQueryObjectui64v &&
+                      (glVersionAtLeast(3, 3) || glHasExtension("GL_ARB_timer_query") ||
+                       glHasExtension("GL_EXT_timer_query"));
+    glHasOcclusionQuery = pglGenQueries && pglDeleteQueries && pglBeginQuery && pglEndQuery && pglGetQueryObjectiv;
+    glHasVertexBufferObject = pglGenBuffers && pglDeleteBuffers && pglBindBuffer && pglBufferData && pglBufferSubData;
+    glHasShaderPipeline = glHasVertexBufferObject && glVersionAtLeast(3, 3) && pglBindBufferBase &&
+                          pglCreateShader && pglDeleteShader && pglShaderSource && pglCompileShader &&
+                          pglGetShaderiv && pglGetShaderInfoLog && pglCreateProgram && pglDeleteProgram &&
+                          pglAttachShader && pglLinkProgram && pglGetProgramiv && pglGetProgramInfoLog &&
+                          pglUseProgram && pglGetUniformLocation && pglUniform1i && pglUniform2f &&
+                          pglUniformMatrix4fv && pglGetUniformBlockIndex &&
+                          pglUniformBlockBinding && pglGenVertexArrays && pglDeleteVertexArrays &&
+                          pglBindVertexArray && pglEnableVertexAttribArray && pglVertexAttribPointer &&
+                          pglVertexAttrib4fv && pglVertexAttribDivisor && pglDrawElementsInstanced;
+
+    std::cout << "OpenGL " << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+    if (!glHasFramebufferObject)
+        std::cout << "Framebuffer objects unavailable, rendering directly to the window" << std::endl;
+}
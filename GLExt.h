@@ -0,0 +1,80 @@
+#pragma once
+#include <GL/glut.h>
+#include <GL/glext.h>
+
+// OpenGL entry points beyond 1.1 are not exported by opengl32 on Windows, so
+// they are loaded at runtime through glutGetProcAddress. Pointers use a "pgl"
+// prefix to stay clear of prototypes some gl.h headers already declare.
+// Each entry is (type, name); loading tries the core name, then the EXT/ARB
+// suffixed one.
+#define CAMPUS_GL_FUNCTIONS(X)                                                 \
+    X(PFNGLGENFRAMEBUFFERSPROC, GenFramebuffers)                               \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, DeleteFramebuffers)                         \
+    X(PFNGLBINDFRAMEBUFFERPROC, BindFramebuffer)                               \
+    X(PFNGLFRAMEBUFFERTEXTURE2DPROC, FramebufferTexture2D)                     \
+    X(PFNGLFRAMEBUFFERRENDERBUFFERPROC, FramebufferRenderbuffer)               \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, CheckFramebufferStatus)                 \
+    X(PFNGLGENRENDERBUFFERSPROC, GenRenderbuffers)                             \
+    X(PFNGLDELETERENDERBUFFERSPROC, DeleteRenderbuffers)                       \
+    X(PFNGLBINDRENDERBUFFERPROC, BindRenderbuffer)                             \
+    X(PFNGLRENDERBUFFERSTORAGEPROC, RenderbufferStorage)                       \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture)                                   \
+    X(PFNGLGENQUERIESPROC, GenQueries)                                         \
+    X(PFNGLDELETEQUERIESPROC, DeleteQueries)                                   \
+    X(PFNGLBEGINQUERYPROC, BeginQuery)                                         \
+    X(PFNGLENDQUERYPROC, EndQuery)                                             \
+    X(PFNGLGETQUERYOBJECTIVPROC, GetQueryObjectiv)                             \
+    X(PFNGLGETQUERYOBJECTUI64VPROC, GetQueryObjectui64v)                       \
+    X(PFNGLGENBUFFERSPROC, GenBuffers)                                         \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers)                                   \
+    X(PFNGLBINDBUFFERPROC, BindBuffer)                                         \
+    X(PFNGLBUFFERDATAPROC, BufferData)                                         \
+    X(PFNGLBUFFERSUBDATAPROC, BufferSubData)                                   \
+    X(PFNGLBINDBUFFERBASEPROC, BindBufferBase)                                 \
+    X(PFNGLCREATESHADERPROC, CreateShader)                                     \
+    X(PFNGLDELETESHADERPROC, DeleteShader)                                     \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource)                                     \
+    X(PFNGLCOMPILESHADERPROC, CompileShader)                                   \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv)                                       \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog)                             \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram)                                   \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram)                                   \
+    X(PFNGLATTACHSHADERPROC, AttachShader)                                     \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram)                                       \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv)                                     \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog)                           \
+    X(PFNGLUSEPROGRAMPROC, UseProgram)                                         \
+    X(PFNGLGETUNIFORMLOCATIONPROC, GetUniformLocation)                         \
+    X(PFNGLUNIFORM1IPROC, Uniform1i)                                           \
+    X(PFNGLUNIFORM2FPROC, Uniform2f)                                           \
+    X(PFNGLUNIFORM3FVPROC, Uniform3fv)                                         \
+    X(PFNGLUNIFORMMATRIX4FVPROC, UniformMatrix4fv)                             \
+    X(PFNGLGETUNIFORMBLOCKINDEXPROC, GetUniformBlockIndex)                     \
+    X(PFNGLUNIFORMBLOCKBINDINGPROC, UniformBlockBinding)                       \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays)                               \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays)                         \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray)                               \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray)               \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer)                       \
+    X(PFNGLVERTEXATTRIB4FVPROC, VertexAttrib4fv)                               \
+    X(PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor)                       \
+    X(PFNGLDRAWELEMENTSINSTANCEDPROC, DrawElementsInstanced)
+
+#define CAMPUS_GL_DECLARE(type, name) extern type pgl##name;
+CAMPUS_GL_FUNCTIONS(CAMPUS_GL_DECLARE)
+#undef CAMPUS_GL_DECLARE
+
+// Feature flags, valid after glExtInit
+extern bool glHasFramebufferObject;
+extern bool glHasTimerQuery; // GL_TIME_ELAPSED queries for GPU pass timing
+extern bool glHasOcclusionQuery; // GL_SAMPLES_PASSED queries for occlusion culling
+extern bool glHasVertexBufferObject;
+// GLSL 3.30 programs, vertex array objects, uniform buffers and instancing
+extern bool glHasShaderPipeline;
+
+// Context version and extension-string checks
+bool glVersionAtLeast(int major, int minor);
+bool glHasExtension(const char *extension);
+
+// Loads every entry point; call once after the GLUT window exists
+void glExtInit();
@@ -0,0 +1,137 @@
+#include "GLState.h"
+#include "GLExt.h"
+#include "Profiler.h"
+
+enum CachedState
+{
+    STATE_UNKNOWN,
+    STATE_OFF,
+    STATE_ON
+};
+
+// Capabilities worth shadowing; anything else passes straight through
+static const GLenum trackedCaps[] = {
+    GL_LIGHTING, GL_DEPTH_TEST, GL_BLEND, GL_LIGHT0, GL_COLOR_MATERIAL,
+    GL_NORMALIZE, GL_CULL_FACE, GL_STENCIL_TEST, GL_POLYGON_OFFSET_FILL,
+};
+static const int TRACKED_CAP_COUNT = sizeof(trackedCaps) / sizeof(trackedCaps[0]);
+// Per texture unit
+static const GLenum unitCaps[] = {
+    GL_TEXTURE_2D, GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R, GL_TEXTURE_GEN_Q,
+};
+static const int UNIT_CAP_COUNT = sizeof(unitCaps) / sizeof(unitCaps[0]);
+
+static CachedState capStates[TRACKED_CAP_COUNT];
+static CachedState unitCapStates[GLS_TEXTURE_UNITS][UNIT_CAP_COUNT];
+static CachedState depthMaskState = STATE_UNKNOWN;
+static int activeUnit = -1; // Unknown
+
+static int currentUnit()
+{
+    if (activeUnit < 0)
+    {
+        GLint texture = GL_TEXTURE0;
+        if (pglActiveTexture)
+            glGetIntegerv(GL_ACTIVE_TEXTURE, &texture);
+        activeUnit = texture - GL_TEXTURE0;
+    }
+    return activeUnit;
+}
+
+// Shadowed state of cap, on the active unit for per-unit ones; null if untracked
+static CachedState *capState(GLenum cap)
+{
+    for (int i = 0; i < TRACKED_CAP_COUNT; ++i)
+    {
+        if (trackedCaps[i] == cap)
+            return &capStates[i];
+    }
+    for (int i = 0; i < UNIT_CAP_COUNT; ++i)
+    {
+        if (unitCaps[i] == cap)
+        {
+            int unit = currentUnit();
+            return unit < GLS_TEXTURE_UNITS ? &unitCapStates[unit][i] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// True if the request changes the cached state (and records it)
+static bool update(CachedState &state, bool enabled)
+{
+    CachedState wanted = enabled ? STATE_ON : STATE_OFF;
+    if (state == wanted)
+    {
+        profilerCount(PROFILE_STATE_SKIPPED);
+        return false;
+    }
+    state = wanted;
+    profilerCount(PROFILE_STATE_CHANGES);
+    return true;
+}
+
+void glsSet(GLenum cap, bool enabled)
+{
+    CachedState *state = capState(cap);
+    if (state && !update(*state, enabled))
+        return;
+    if (!state)
+        profilerCount(PROFILE_STATE_CHANGES);
+    if (enabled)
+        glEnable(cap);
+    else
+        glDisable(cap);
+}
+
+void glsEnable(GLenum cap)
+{
+    glsSet(cap, true);
+}
+
+void glsDisable(GLenum cap)
+{
+    glsSet(cap, false);
+}
+
+void glsDepthMask(GLboolean flag)
+{
+    if (update(depthMaskState, flag == GL_TRUE))
+        glDepthMask(flag);
+}
+
+void glsActiveTexture(GLenum texture)
+{
+    int unit = static_cast<int>(texture - GL_TEXTURE0);
+    if (unit == activeUnit)
+    {
+        profilerCount(PROFILE_STATE_SKIPPED);
+        return;
+    }
+    activeUnit = unit;
+    profilerCount(PROFILE_STATE_CHANGES);
+    pglActiveTexture(texture);
+}
+
+bool glsIsEnabled(GLenum cap)
+{
+    CachedState *state = capState(cap);
+    if (!state)
+        return glIsEnabled(cap) == GL_TRUE;
+    if (*state == STATE_UNKNOWN)
+        *state = glIsEnabled(cap) ? STATE_ON : STATE_OFF;
+    return *state == STATE_ON;
+}
+
+void glsInvalidate()
+{
+    for (CachedState &state : capStates)
+        state = STATE_UNKNOWN;
+    for (CachedState(&unit)[UNIT_CAP_COUNT] : unitCapStates)
+    {
+        for (CachedState &state : unit)
+            state = STATE_UNKNOWN;
+    }
+    depthMaskState = STATE_UNKNOWN;
+    activeUnit = -1;
+}
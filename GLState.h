@@ -0,0 +1,26 @@
+#pragma once
+#include <GL/glut.h>
+
+// Shadow copy of the capabilities and depth mask the renderer toggles every
+// frame. Requests that match the known state are dropped before reaching the
+// driver; real changes and skipped ones are counted for the profiler.
+// All code that toggles these must go through gls*, or call glsInvalidate.
+//
+// GL_TEXTURE_2D and GL_TEXTURE_GEN_* belong to a texture unit and apply to
+// the active one, which is shadowed too: select units with glsActiveTexture.
+// Units from GLS_TEXTURE_UNITS up pass straight through.
+
+void glsEnable(GLenum cap);
+void glsDisable(GLenum cap);
+void glsSet(GLenum cap, bool enabled);
+void glsDepthMask(GLboolean flag);
+// Makes GL_TEXTURE0 + n the active texture unit; needs multitexture (GLExt.h)
+void glsActiveTexture(GLenum texture);
+
+const int GLS_TEXTURE_UNITS = 4;
+
+// Cached value; asks GL only if the state is not yet known
+bool glsIsEnabled(GLenum cap);
+
+// Forgets the shadowed state, so the next request for each one reaches GL
+void glsInvalidate();
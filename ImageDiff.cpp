@@ -0,0 +1,129 @@
+#include "ImageDiff.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+bool readPpm(const std::string &path, Image &image)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    if (!(in >> magic >> image.width >> image.height >> maxValue) || magic != "P6" || maxValue != 255 ||
+        image.width <= 0 || image.height <= 0)
+        return false;
+    in.get(); // Single whitespace before the data
+    image.rgb.resize(static_cast<size_t>(image.width) * image.height * 3);
+    in.read(reinterpret_cast<char *>(image.rgb.data()), image.rgb.size());
+    return static_cast<size_t>(in.gcount()) == image.rgb.size();
+}
+
+bool writePpm(const std::string &path, const Image &image)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << image.width << " " << image.height << "\n255\n";
+    out.write(reinterpret_cast<const char *>(image.rgb.data()), image.rgb.size());
+    return static_cast<bool>(out);
+}
+
+struct Lab
+{
+    float l, a, b;
+};
+
+static float labF(float t)
+{
+    return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+}
+
+// sRGB (D65) to CIE Lab
+static std::vector<Lab> toLab(const Image &image)
+{
+    static float linear[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        tableReady = true;
+    }
+
+    std::vector<Lab> lab(static_cast<size_t>(image.width) * image.height);
+    for (size_t i = 0; i < lab.size(); ++i)
+    {
+        float r = linear[image.rgb[i * 3]], g = linear[image.rgb[i * 3 + 1]], b = linear[image.rgb[i * 3 + 2]];
+        float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+        float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+        float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+        float fx = labF(x), fy = labF(y), fz = labF(z);
+        lab[i] = {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+    }
+    return lab;
+}
+
+static float deltaE(const Lab &p, const Lab &q)
+{
+    float dl = p.l - q.l, da = p.a - q.a, db = p.b - q.b;
+    return std::sqrt(dl * dl + da * da + db * db);
+}
+
+DiffResult compareImages(const Image &reference, const Image &test, const DiffTolerance &tolerance, Image *heatmap)
+{
+    DiffResult result = {false, 1.0, 0.0f, false};
+    if (reference.width != test.width || reference.height != test.height || reference.rgb.empty())
+        return result;
+    result.sizesMatch = true;
+
+    int w = reference.width, h = reference.height;
+    std::vector<Lab> ref = toLab(reference);
+    std::vector<Lab> tst = toLab(test);
+    if (heatmap)
+    {
+        heatmap->width = w;
+        heatmap->height = h;
+        heatmap->rgb.assign(reference.rgb.size(), 0);
+    }
+
+    size_t failures = 0;
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            size_t i = static_cast<size_t>(y) * w + x;
+            float direct = deltaE(ref[i], tst[i]);
+            result.maxDeltaE = std::max(result.maxDeltaE, direct);
+            float nearest = direct;
+            for (int ny = std::max(0, y - 1); ny <= std::min(h - 1, y + 1) && nearest > tolerance.deltaE; ++ny)
+            {
+                for (int nx = std::max(0, x - 1); nx <= std::min(w - 1, x + 1); ++nx)
+                    nearest = std::min(nearest, deltaE(ref[static_cast<size_t>(ny) * w + nx], tst[i]));
+            }
+            bool failed = nearest > tolerance.deltaE;
+            if (failed)
+                ++failures;
+            if (!heatmap)
+                continue;
+
+            unsigned char *out = &heatmap->rgb[i * 3];
+            if (failed)
+            {
+                out[0] = 255;
+                out[1] = static_cast<unsigned char>(std::min(255.0f, (nearest - tolerance.deltaE) * 10.0f));
+            }
+            else if (direct > 0.5f)
+            {
+                out[2] = static_cast<unsigned char>(std::min(255.0f, 80.0f + direct * 40.0f));
+            }
+            else
+            {
+                unsigned char grey = static_cast<unsigned char>(ref[i].l * 0.3f * 2.55f);
+                out[0] = out[1] = out[2] = grey;
+            }
+        }
+    }
+    result.failFraction = static_cast<double>(failures) / (static_cast<double>(w) * h);
+    result.passed = result.failFraction <= tolerance.maxFailFraction;
+    return result;
+}
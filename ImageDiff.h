@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// RGB images, binary PPM files and a perceptual comparison for checking that
+// optimised render paths still produce the same frames.
+
+struct Image
+{
+    int width = 0, height = 0;
+    std::vector<unsigned char> rgb; // Top row first
+};
+
+bool readPpm(const std::string &path, Image &image);
+bool writePpm(const std::string &path, const Image &image);
+
+struct DiffTolerance
+{
+    float deltaE;           // CIE76 difference (in Lab) a pixel may show, ~2.3 is just noticeable
+    double maxFailFraction; // Share of failing pixels an image may have
+};
+
+struct DiffResult
+{
+    bool sizesMatch;
+    double failFraction;
+    float maxDeltaE;
+    bool passed;
+};
+
+// A test pixel fails when it is further than tolerance.deltaE from the
+// reference pixel and from each of its 3x3 neighbours, so edges that moved by
+// a pixel (different but valid rasterization) do not count. The heatmap, if
+// given, shows the reference in dim grey, tolerated differences in blue and
+// failures from red to yellow by size.
+DiffResult compareImages(const Image &reference, const Image &test, const DiffTolerance &tolerance, Image *heatmap);
@@ -0,0 +1,145 @@
+#include "ImmediateMode.h"
+#include "GLExt.h"
+#include "MatrixStack.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "ShaderPipeline.h"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+struct ImVertex
+{
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLubyte color[4];
+};
+
+static bool collecting = false; // Between imBegin and imEnd on the shader path
+static GLenum primitive = GL_POINTS;
+static GLfloat currentNormal[3] = {0.0f, 0.0f, 1.0f};
+static std::vector<ImVertex> vertices;
+static std::vector<ImVertex> triangles; // Quads and polygons after splitting
+static GLuint vertexBuffer = 0;
+static GLuint vertexArray = 0;
+
+void imBegin(GLenum mode)
+{
+    collecting = shaderPipelineActive();
+    if (!collecting)
+    {
+        rcSyncModelview();
+        glBegin(mode);
+        return;
+    }
+    primitive = mode;
+    vertices.clear();
+}
+
+void imNormal3f(float x, float y, float z)
+{
+    if (!collecting)
+    {
+        glNormal3f(x, y, z);
+        return;
+    }
+    currentNormal[0] = x;
+    currentNormal[1] = y;
+    currentNormal[2] = z;
+}
+
+void imVertex2f(float x, float y)
+{
+    imVertex3f(x, y, 0.0f);
+}
+
+void imVertex3f(float x, float y, float z)
+{
+    if (!collecting)
+    {
+        glVertex3f(x, y, z);
+        return;
+    }
+    const GLfloat *color = rcCurrentColor();
+    ImVertex v = {{x, y, z}, {currentNormal[0], currentNormal[1], currentNormal[2]}, {}};
+    for (int i = 0; i < 4; ++i)
+        v.color[i] = static_cast<GLubyte>(std::lround(std::fmin(1.0f, std::fmax(0.0f, color[i])) * 255.0f));
+    vertices.push_back(v);
+}
+
+// Rewrites primitives core GL lacks as triangles; returns the mode to draw
+static GLenum triangulate(const std::vector<ImVertex> *&out)
+{
+    out = &vertices;
+    if (primitive != GL_QUADS && primitive != GL_POLYGON)
+        return primitive;
+
+    triangles.clear();
+    size_t count = vertices.size();
+    if (primitive == GL_QUADS)
+    {
+        for (size_t q = 0; q + 3 < count; q += 4)
+        {
+            static const int corners[6] = {0, 1, 2, 0, 2, 3};
+            for (int corner : corners)
+                triangles.push_back(vertices[q + corner]);
+        }
+    }
+    else
+    {
+        for (size_t i = 1; i + 1 < count; ++i)
+        {
+            triangles.push_back(vertices[0]);
+            triangles.push_back(vertices[i]);
+            triangles.push_back(vertices[i + 1]);
+        }
+    }
+    out = &triangles;
+    return GL_TRIANGLES;
+}
+
+void imEnd()
+{
+    if (!collecting)
+    {
+        glEnd();
+        profilerCount(PROFILE_DRAW_CALLS);
+        return;
+    }
+    collecting = false;
+    const std::vector<ImVertex> *batch = nullptr;
+    GLenum mode = triangulate(batch);
+    if (batch->empty())
+        return;
+
+    if (vertexArray == 0)
+    {
+        pglGenBuffers(1, &vertexBuffer);
+        pglGenVertexArrays(1, &vertexArray);
+        pglBindVertexArray(vertexArray);
+        pglBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        pglEnableVertexAttribArray(SHADER_ATTRIB_POSITION);
+        pglVertexAttribPointer(SHADER_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(ImVertex),
+                               reinterpret_cast<const GLvoid *>(offsetof(ImVertex, position)));
+        pglEnableVertexAttribArray(SHADER_ATTRIB_NORMAL);
+        pglVertexAttribPointer(SHADER_ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(ImVertex),
+                               reinterpret_cast<const GLvoid *>(offsetof(ImVertex, normal)));
+        pglEnableVertexAttribArray(SHADER_ATTRIB_COLOR);
+        pglVertexAttribPointer(SHADER_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImVertex),
+                               reinterpret_cast<const GLvoid *>(offsetof(ImVertex, color)));
+    }
+    else
+    {
+        pglBindVertexArray(vertexArray);
+        pglBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    }
+    pglBufferData(GL_ARRAY_BUFFER, batch->size() * sizeof(ImVertex), batch->data(), GL_STREAM_DRAW);
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shaderPipelineUse();
+    shaderPipelineSetModelview(rcModelview());
+    glDrawArrays(mode, 0, static_cast<GLsizei>(batch->size()));
+    pglBindVertexArray(0);
+    shaderPipelineRelease();
+    profilerCount(PROFILE_DRAW_CALLS);
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <GL/glut.h>
+
+// glBegin/glEnd replacement for the scene's lines, points and overlay quads.
+// On the legacy path the calls go straight to GL. With the shader pipeline
+// active the vertices are collected, with the current rcColor* colour and the
+// current modelview (MatrixStack.h), and drawn in one call at imEnd; quads and
+// polygons are split into triangles since core GL has neither.
+
+void imBegin(GLenum mode);
+void imNormal3f(float x, float y, float z);
+void imVertex2f(float x, float y);
+void imVertex3f(float x, float y, float z);
+void imEnd();
@@ -0,0 +1,411 @@
+#include "LayoutBvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+const size_t LEAF_ITEMS = 4;
+const size_t LEAF_SPLIT = 16; // A leaf grown this full by insertions splits
+
+struct BvhNode
+{
+    float min[3], max[3]; // Empty (min > max) once a leaf loses every item
+    int left, right;      // Children, -1 in a leaf
+    int parent;
+    std::vector<uint32_t> items; // Leaves only
+};
+
+// Children always come after their parent, so refitting from the back
+// reaches every child before its parent
+static std::vector<BvhNode> nodes;
+static std::vector<float> bounds; // Per AABB index: min xyz, max xyz
+static std::vector<int> itemLeaf;
+static size_t changesSinceBuild = 0;
+static LayoutBvhStats stats = {};
+
+static void loadBounds(const CampusLayout &layout)
+{
+    bounds.resize(static_cast<size_t>(layout.aabbCount) * 6);
+    for (uint32_t i = 0; i < layout.aabbCount; ++i)
+    {
+        const LayoutAabb &box = layout.aabbs[i];
+        float *b = &bounds[i * 6];
+        std::copy(box.min, box.min + 3, b);
+        std::copy(box.max, box.max + 3, b + 3);
+        if (box.section == LAYOUT_BUILDINGS && box.index < layout.buildingCount)
+        {
+            const LayoutBuilding &building = layout.buildings[box.index];
+            b[4] = std::max(b[4], building.position[1] + building.size[1] + BUILDING_LABEL_CLEARANCE);
+        }
+    }
+}
+
+static void setEmpty(float *min, float *max)
+{
+    std::fill(min, min + 3, FLT_MAX);
+    std::fill(max, max + 3, -FLT_MAX);
+}
+
+static void grow(float *min, float *max, const float *otherMin, const float *otherMax)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        min[axis] = std::min(min[axis], otherMin[axis]);
+        max[axis] = std::max(max[axis], otherMax[axis]);
+    }
+}
+
+static float surfaceArea(const float *min, const float *max)
+{
+    if (min[0] > max[0])
+        return 0.0f;
+    float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+static int newNode(int parent)
+{
+    BvhNode node;
+    node.left = node.right = -1;
+    node.parent = parent;
+    setEmpty(node.min, node.max);
+    nodes.push_back(std::move(node));
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+static void fitNode(int index)
+{
+    BvhNode &node = nodes[index];
+    setEmpty(node.min, node.max);
+    if (node.left < 0)
+    {
+        for (uint32_t item : node.items)
+            grow(node.min, node.max, &bounds[item * 6], &bounds[item * 6 + 3]);
+    }
+    else
+    {
+        for (int child : {node.left, node.right})
+            grow(node.min, node.max, nodes[child].min, nodes[child].max);
+    }
+    ++stats.refitNodes;
+}
+
+// Spreads the low 10 bits of v out to every third bit
+static uint32_t spreadBits(uint32_t v)
+{
+    v &= 0x3FF;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+// Orders items along a Morton curve through their centres, so that any run
+// of them is spatially compact and halving a run is a good split
+static void mortonSort(std::vector<uint32_t> &items)
+{
+    float lo[3], hi[3];
+    setEmpty(lo, hi);
+    for (uint32_t item : items)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float centre = bounds[item * 6 + axis] + bounds[item * 6 + 3 + axis];
+            lo[axis] = std::min(lo[axis], centre);
+            hi[axis] = std::max(hi[axis], centre);
+        }
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> keyed(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        uint32_t code = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float centre = bounds[items[i] * 6 + axis] + bounds[items[i] * 6 + 3 + axis];
+            float t = hi[axis] > lo[axis] ? (centre - lo[axis]) / (hi[axis] - lo[axis]) : 0.0f;
+            code |= spreadBits(static_cast<uint32_t>(t * 1023.0f)) << axis;
+        }
+        keyed[i] = {code, items[i]};
+    }
+    std::sort(keyed.begin(), keyed.end());
+    for (size_t i = 0; i < items.size(); ++i)
+        items[i] = keyed[i].second;
+}
+
+// Makes nodes[index] the root of a subtree over items[begin, end), which are
+// in Morton order
+static void buildNode(int index, const std::vector<uint32_t> &items, size_t begin, size_t end)
+{
+    if (end - begin <= LEAF_ITEMS)
+    {
+        BvhNode &leaf = nodes[index];
+        leaf.left = leaf.right = -1;
+        leaf.items.assign(items.begin() + begin, items.begin() + end);
+        for (uint32_t item : leaf.items)
+            itemLeaf[item] = index;
+        fitNode(index);
+        return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    int left = newNode(index), right = newNode(index);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    std::vector<uint32_t>().swap(nodes[index].items);
+    buildNode(left, items, begin, mid);
+    buildNode(right, items, mid, end);
+    fitNode(index);
+}
+
+static void countNodes()
+{
+    stats.nodes = static_cast<int>(nodes.size());
+    stats.leaves = 0;
+    stats.depth = 0;
+    std::vector<std::pair<int, int>> stack = {{0, 1}};
+    while (!stack.empty())
+    {
+        std::pair<int, int> top = stack.back();
+        stack.pop_back();
+        const BvhNode &node = nodes[top.first];
+        stats.depth = std::max(stats.depth, top.second);
+        if (node.left < 0)
+        {
+            ++stats.leaves;
+            continue;
+        }
+        stack.push_back({node.left, top.second + 1});
+        stack.push_back({node.right, top.second + 1});
+    }
+}
+
+void layoutBvhBuild(const CampusLayout &layout)
+{
+    nodes.clear();
+    stats.refitNodes = 0;
+    stats.rebuilt = true;
+    changesSinceBuild = 0;
+    loadBounds(layout);
+    itemLeaf.assign(layout.aabbCount, -1);
+    std::vector<uint32_t> items(layout.aabbCount);
+    std::iota(items.begin(), items.end(), 0u);
+    mortonSort(items);
+    nodes.reserve(items.size() / 2 + 1);
+    newNode(-1);
+    buildNode(0, items, 0, items.size());
+    countNodes();
+}
+
+// The leaf whose box grows least taking the item in
+static int chooseLeaf(uint32_t item)
+{
+    const float *itemMin = &bounds[item * 6], *itemMax = &bounds[item * 6 + 3];
+    int index = 0;
+    while (nodes[index].left >= 0)
+    {
+        float best = FLT_MAX;
+        int bestChild = nodes[index].left;
+        for (int child : {nodes[index].left, nodes[index].right})
+        {
+            float min[3], max[3];
+            std::copy(nodes[child].min, nodes[child].min + 3, min);
+            std::copy(nodes[child].max, nodes[child].max + 3, max);
+            float before = surfaceArea(min, max);
+            grow(min, max, itemMin, itemMax);
+            float growth = surfaceArea(min, max) - before;
+            if (growth < best)
+            {
+                best = growth;
+                bestChild = child;
+            }
+        }
+        index = bestChild;
+    }
+    return index;
+}
+
+void layoutBvhUpdate(const CampusLayout &layout, const LayoutDiff &diff)
+{
+    const LayoutTableDiff &changes = diff.aabbs;
+    changesSinceBuild += layoutTableChanges(changes);
+    if (nodes.empty() || changesSinceBuild * 4 > layout.aabbCount)
+    {
+        layoutBvhBuild(layout);
+        return;
+    }
+    stats.refitNodes = 0;
+    stats.rebuilt = false;
+    loadBounds(layout);
+
+    // Renumber what survived and drop what went
+    itemLeaf.assign(layout.aabbCount, -1);
+    std::vector<int> changedLeaves;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        BvhNode &node = nodes[i];
+        if (node.left >= 0)
+            continue;
+        size_t kept = 0;
+        for (uint32_t item : node.items)
+        {
+            uint32_t now = item < changes.remap.size() ? changes.remap[item] : LAYOUT_NO_INDEX;
+            if (now == LAYOUT_NO_INDEX)
+                continue;
+            node.items[kept++] = now;
+            itemLeaf[now] = static_cast<int>(i);
+        }
+        if (kept != node.items.size())
+            changedLeaves.push_back(static_cast<int>(i));
+        node.items.resize(kept);
+    }
+    for (uint32_t item : changes.modified)
+    {
+        if (itemLeaf[item] >= 0)
+            changedLeaves.push_back(itemLeaf[item]);
+    }
+    for (uint32_t item : changes.added)
+    {
+        int leaf = chooseLeaf(item);
+        nodes[leaf].items.push_back(item);
+        itemLeaf[item] = leaf;
+        changedLeaves.push_back(leaf);
+    }
+
+    // Refit the changed leaves and their ancestors, children first
+    std::sort(changedLeaves.begin(), changedLeaves.end());
+    changedLeaves.erase(std::unique(changedLeaves.begin(), changedLeaves.end()), changedLeaves.end());
+    std::vector<char> stale(nodes.size(), 0);
+    for (int leaf : changedLeaves)
+    {
+        if (nodes[leaf].items.size() > LEAF_SPLIT)
+        {
+            std::vector<uint32_t> items;
+            items.swap(nodes[leaf].items);
+            mortonSort(items);
+            buildNode(leaf, items, 0, items.size());
+        }
+        else
+        {
+            fitNode(leaf);
+        }
+        for (int p = nodes[leaf].parent; p >= 0 && !stale[p]; p = nodes[p].parent)
+            stale[p] = 1;
+    }
+    for (size_t i = stale.size(); i-- > 0;)
+    {
+        if (stale[i])
+            fitNode(static_cast<int>(i));
+    }
+    countNodes();
+}
+
+// -1 if the box is wholly outside a plane in mask; otherwise mask without the
+// planes it is wholly inside, which its children need not test again
+static int clipBox(const Frustum &frustum, const float *min, const float *max, int mask)
+{
+    for (int p = 0; p < 6; ++p)
+    {
+        if (!(mask & (1 << p)))
+            continue;
+        const Vec4 &plane = frustum.planes[p];
+        const float n[3] = {plane.x, plane.y, plane.z};
+        float outer = plane.w, inner = plane.w;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            outer += n[axis] * (n[axis] >= 0.0f ? max[axis] : min[axis]);
+            inner += n[axis] * (n[axis] >= 0.0f ? min[axis] : max[axis]);
+        }
+        if (outer < 0.0f)
+            return -1;
+        if (inner >= 0.0f)
+            mask &= ~(1 << p);
+    }
+    return mask;
+}
+
+void layoutBvhCull(const Frustum &frustum, std::vector<uint32_t> &visible)
+{
+    visible.clear();
+    if (nodes.empty())
+        return;
+    std::vector<std::pair<int, int>> stack = {{0, 63}};
+    while (!stack.empty())
+    {
+        std::pair<int, int> top = stack.back();
+        stack.pop_back();
+        const BvhNode &node = nodes[top.first];
+        if (node.min[0] > node.max[0])
+            continue;
+        int mask = top.second == 0 ? 0 : clipBox(frustum, node.min, node.max, top.second);
+        if (mask < 0)
+            continue;
+        if (node.left < 0)
+        {
+            for (uint32_t item : node.items)
+            {
+                if (mask == 0 || clipBox(frustum, &bounds[item * 6], &bounds[item * 6 + 3], mask) >= 0)
+                    visible.push_back(item);
+            }
+            continue;
+        }
+        stack.push_back({node.right, mask});
+        stack.push_back({node.left, mask});
+    }
+    std::sort(visible.begin(), visible.end());
+}
+
+static bool rayEntersBox(const Vec3 &origin, const Vec3 &direction, const float *min, const float *max)
+{
+    const float o[3] = {origin.x, origin.y, origin.z}, d[3] = {direction.x, direction.y, direction.z};
+    float tmin = -FLT_MAX, tmax = FLT_MAX;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (std::fabs(d[axis]) < 1e-6f)
+        {
+            if (o[axis] < min[axis] || o[axis] > max[axis])
+                return false;
+            continue;
+        }
+        float t1 = (min[axis] - o[axis]) / d[axis], t2 = (max[axis] - o[axis]) / d[axis];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        tmin = std::max(tmin, t1);
+        tmax = std::min(tmax, t2);
+        if (tmin > tmax)
+            return false;
+    }
+    return tmax > 0.0f;
+}
+
+void layoutBvhRay(const Vec3 &origin, const Vec3 &direction, std::vector<uint32_t> &hits)
+{
+    hits.clear();
+    if (nodes.empty())
+        return;
+    std::vector<int> stack = {0};
+    while (!stack.empty())
+    {
+        const BvhNode &node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.min[0] > node.max[0] || !rayEntersBox(origin, direction, node.min, node.max))
+            continue;
+        if (node.left < 0)
+        {
+            for (uint32_t item : node.items)
+            {
+                if (rayEntersBox(origin, direction, &bounds[item * 6], &bounds[item * 6 + 3]))
+                    hits.push_back(item);
+            }
+            continue;
+        }
+        stack.push_back(node.right);
+        stack.push_back(node.left);
+    }
+    std::sort(hits.begin(), hits.end());
+}
+
+LayoutBvhStats layoutBvhStats()
+{
+    return stats;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "CampusLayout.h"
+#include "LayoutDiff.h"
+#include "Math3D.h"
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over the layout's AABB table, to cull whole
+// objects against the view frustum before they are drawn and to find picking
+// candidates. Leaves hold a few AABB indices. A building's box reaches up
+// over its label and the hover lift, so culling never drops a visible label.
+//
+// A reloaded layout refits the tree instead of rebuilding it: surviving items
+// are renumbered, removed ones dropped, added ones go to the leaf whose box
+// grows least, and only boxes on the way from a changed leaf to the root are
+// recomputed. A leaf that grows too full splits in place; if more than a
+// quarter of the objects changed, the tree is built again.
+
+const float BUILDING_LABEL_CLEARANCE = 3.5f; // The highest label (the library's, h + 3) plus the hover lift
+
+void layoutBvhBuild(const CampusLayout &layout);
+// Applies a reload, given the diff from the previous layout to this one
+void layoutBvhUpdate(const CampusLayout &layout, const LayoutDiff &diff);
+
+// AABB indices whose boxes touch a world-space frustum, in table order
+void layoutBvhCull(const Frustum &frustum, std::vector<uint32_t> &visible);
+// AABB indices whose boxes a ray enters ahead of its origin
+void layoutBvhRay(const Vec3 &origin, const Vec3 &direction, std::vector<uint32_t> &hits);
+
+struct LayoutBvhStats
+{
+    int nodes, leaves, depth;
+    int refitNodes; // Boxes recomputed by the last update, all of them after a build
+    bool rebuilt;   // The last update built the tree again
+};
+
+LayoutBvhStats layoutBvhStats();
@@ -0,0 +1,332 @@
+#include "LayoutCompiler.h"
+#include "CampusLayout.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+// Extents of what the draw functions put around an object's position
+const float BUILDING_OVERHANG = 0.25f; // Roof, window frames and door past the walls
+const float ROOF_HEIGHT = 0.3f;
+const float ROAD_THICKNESS = 0.1f;
+const float ROAD_MARKING_TOP = 0.075f; // Above the road centre
+const float PARKING_LOT_HALF_WIDTH = 41.55f; // Lot plus the corner trees
+const float PARKING_LOT_HALF_DEPTH = 10.25f;
+const float PARKING_LOT_HEIGHT = 8.0f;
+const float BASKETBALL_HALF_SIZE[3] = {14.1f, 3.5f, 7.55f}; // Y is the backboard top
+const float FOOTBALL_HALF_SIZE[3] = {15.0f, 2.05f, 30.35f}; // Y is the crossbar top, goal posts sink as deep
+const float TREE_CANOPY_REACH = 2.2f;
+const float TREE_HEIGHT = 8.0f;
+const float PATH_TILE_SPACING = 1.1f;
+const float PATH_TILE_HALF = 0.5f;
+
+struct LayoutSource
+{
+    std::vector<LayoutBuilding> buildings;
+    std::vector<LayoutRoad> roads;
+    std::vector<LayoutParkingLot> parkingLots;
+    std::vector<LayoutCourt> courts;
+    std::vector<LayoutTree> trees;
+    std::vector<LayoutPath> paths;
+    std::vector<LayoutRoutePoint> route;
+    std::vector<LayoutAabb> aabbs;
+    std::string strings;
+    std::map<std::string, uint32_t> stringOffsets;
+};
+
+static uint32_t addString(LayoutSource &source, const std::string &text)
+{
+    auto found = source.stringOffsets.find(text);
+    if (found != source.stringOffsets.end())
+        return found->second;
+    uint32_t offset = static_cast<uint32_t>(source.strings.size());
+    source.strings.append(text);
+    source.strings.push_back('\0');
+    source.stringOffsets[text] = offset;
+    return offset;
+}
+
+static uint32_t addAabb(LayoutSource &source, LayoutSectionId section, size_t index, float x0, float y0, float z0,
+                        float x1, float y1, float z1)
+{
+    LayoutAabb box = {{x0, y0, z0}, {x1, y1, z1}, static_cast<uint32_t>(section), static_cast<uint32_t>(index)};
+    source.aabbs.push_back(box);
+    return static_cast<uint32_t>(source.aabbs.size() - 1);
+}
+
+// Whitespace-separated fields; double quotes group a field with spaces
+static bool splitFields(const std::string &line, std::vector<std::string> &fields)
+{
+    fields.clear();
+    size_t i = 0;
+    while (i < line.size())
+    {
+        if (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')
+        {
+            ++i;
+            continue;
+        }
+        if (line[i] == '#')
+            break;
+        if (line[i] == '"')
+        {
+            size_t close = line.find('"', i + 1);
+            if (close == std::string::npos)
+                return false;
+            fields.push_back(line.substr(i + 1, close - i - 1));
+            i = close + 1;
+            continue;
+        }
+        size_t end = line.find_first_of(" \t\r#", i);
+        if (end == std::string::npos)
+            end = line.size();
+        fields.push_back(line.substr(i, end - i));
+        i = end;
+    }
+    return true;
+}
+
+static bool toFloat(const std::string &text, float &out)
+{
+    char *end = nullptr;
+    out = std::strtof(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+
+static bool toInt(const std::string &text, int32_t &out)
+{
+    char *end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    out = static_cast<int32_t>(value);
+    return !text.empty() && *end == '\0';
+}
+
+static bool floats(const std::vector<std::string> &fields, size_t first, float *out, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (!toFloat(fields[first + i], out[i]))
+            return false;
+    }
+    return true;
+}
+
+static int findName(const char *const *names, int count, const std::string &name)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (name == names[i])
+            return i;
+    }
+    return -1;
+}
+
+static bool addBuilding(LayoutSource &source, const std::vector<std::string> &f)
+{
+    if (f.size() != 18)
+        return false;
+    LayoutBuilding b = {};
+    int kind = findName(LAYOUT_BUILDING_KIND_NAMES, LAYOUT_BUILDING_KIND_COUNT, f[1]);
+    int32_t counts[5];
+    for (int i = 0; i < 5; ++i)
+    {
+        if (!toInt(f[11 + i], counts[i]))
+            return false;
+    }
+    if (kind < 0 || !floats(f, 2, b.position, 3) || !floats(f, 5, b.size, 3) || !floats(f, 8, b.color, 3) ||
+        counts[3] <= 0)
+        return false;
+    b.kind = static_cast<uint32_t>(kind);
+    b.windowsX = counts[0];
+    b.windowsZFront = counts[1];
+    b.windowsZSide = counts[2];
+    b.floors = counts[3];
+    b.slot = counts[4];
+    b.label = addString(source, f[16]);
+    b.name = addString(source, f[17]);
+    float hx = b.size[0] / 2.0f + BUILDING_OVERHANG, hz = b.size[2] / 2.0f + BUILDING_OVERHANG;
+    const float *p = b.position;
+    b.aabb = addAabb(source, LAYOUT_BUILDINGS, source.buildings.size(), p[0] - hx, p[1], p[2] - hz, p[0] + hx,
+                     p[1] + b.size[1] + ROOF_HEIGHT, p[2] + hz);
+    source.buildings.push_back(b);
+    return true;
+}
+
+static bool addRoad(LayoutSource &source, const std::vector<std::string> &f)
+{
+    if (f.size() != 7 || (f[6] != "x" && f[6] != "z"))
+        return false;
+    LayoutRoad r = {};
+    float size[2];
+    if (!floats(f, 1, r.position, 3) || !floats(f, 4, size, 2))
+        return false;
+    r.length = size[0];
+    r.width = size[1];
+    r.axis = f[6] == "x" ? 0 : 2;
+    float hx = (r.axis == 0 ? r.length : r.width) / 2.0f, hz = (r.axis == 0 ? r.width : r.length) / 2.0f;
+    const float *p = r.position;
+    r.aabb = addAabb(source, LAYOUT_ROADS, source.roads.size(), p[0] - hx, p[1] - ROAD_THICKNESS / 2.0f, p[2] - hz,
+                     p[0] + hx, p[1] + ROAD_MARKING_TOP, p[2] + hz);
+    source.roads.push_back(r);
+    return true;
+}
+
+static bool addParkingLot(LayoutSource &source, const std::vector<std::string> &f)
+{
+    LayoutParkingLot lot = {};
+    if (f.size() != 4 || !floats(f, 1, lot.position, 3))
+        return false;
+    const float *p = lot.position;
+    lot.aabb = addAabb(source, LAYOUT_PARKING_LOTS, source.parkingLots.size(), p[0] - PARKING_LOT_HALF_WIDTH,
+                       p[1] - 0.1f, p[2] - PARKING_LOT_HALF_DEPTH, p[0] + PARKING_LOT_HALF_WIDTH,
+                       p[1] + PARKING_LOT_HEIGHT, p[2] + PARKING_LOT_HALF_DEPTH);
+    source.parkingLots.push_back(lot);
+    return true;
+}
+
+static bool addCourt(LayoutSource &source, const std::vector<std::string> &f)
+{
+    static const char *kinds[LAYOUT_COURT_KIND_COUNT] = {"basketball", "football"};
+    if (f.size() != 5)
+        return false;
+    LayoutCourt c = {};
+    int kind = findName(kinds, LAYOUT_COURT_KIND_COUNT, f[1]);
+    if (kind < 0 || !floats(f, 2, c.position, 3))
+        return false;
+    c.kind = static_cast<uint32_t>(kind);
+    const float *half = kind == LAYOUT_BASKETBALL ? BASKETBALL_HALF_SIZE : FOOTBALL_HALF_SIZE;
+    float below = kind == LAYOUT_BASKETBALL ? 0.05f : 1.0f;
+    const float *p = c.position;
+    c.aabb = addAabb(source, LAYOUT_COURTS, source.courts.size(), p[0] - half[0], p[1] - below, p[2] - half[2],
+                     p[0] + half[0], p[1] + half[1], p[2] + half[2]);
+    source.courts.push_back(c);
+    return true;
+}
+
+static bool addTree(LayoutSource &source, const std::vector<std::string> &f)
+{
+    LayoutTree t = {};
+    if (f.size() != 4 || !floats(f, 1, t.position, 3))
+        return false;
+    const float *p = t.position;
+    t.aabb = addAabb(source, LAYOUT_TREES, source.trees.size(), p[0] - TREE_CANOPY_REACH, p[1],
+                     p[2] - TREE_CANOPY_REACH, p[0] + TREE_CANOPY_REACH, p[1] + TREE_HEIGHT, p[2] + TREE_CANOPY_REACH);
+    source.trees.push_back(t);
+    return true;
+}
+
+static bool addPath(LayoutSource &source, const std::vector<std::string> &f)
+{
+    LayoutPath path = {};
+    int32_t tiles = 0;
+    if (f.size() != 5 || !floats(f, 1, path.start, 3) || !toInt(f[4], tiles) || tiles <= 0)
+        return false;
+    path.tiles = static_cast<uint32_t>(tiles);
+    const float *p = path.start;
+    path.aabb = addAabb(source, LAYOUT_PATHS, source.paths.size(), p[0] - PATH_TILE_HALF, p[1], p[2] - PATH_TILE_HALF,
+                        p[0] + (tiles - 1) * PATH_TILE_SPACING + PATH_TILE_HALF, p[1] + 0.05f, p[2] + PATH_TILE_HALF);
+    source.paths.push_back(path);
+    return true;
+}
+
+static bool addRoutePoint(LayoutSource &source, const std::vector<std::string> &f)
+{
+    float point[2];
+    if (f.size() != 3 || !floats(f, 1, point, 2))
+        return false;
+    source.route.push_back({point[0], point[1]});
+    return true;
+}
+
+// Appends records as little-endian 32-bit words, whatever the host order
+static void appendWords(std::vector<unsigned char> &image, const void *records, size_t bytes)
+{
+    const unsigned char *in = static_cast<const unsigned char *>(records);
+    for (size_t i = 0; i + 4 <= bytes; i += 4)
+    {
+        uint32_t word;
+        std::memcpy(&word, in + i, 4);
+        for (int b = 0; b < 4; ++b)
+            image.push_back(static_cast<unsigned char>(word >> (8 * b)));
+    }
+}
+
+static void alignImage(std::vector<unsigned char> &image)
+{
+    while (image.size() % 16 != 0)
+        image.push_back(0);
+}
+
+template <typename T>
+static void appendSection(std::vector<unsigned char> &image, LayoutHeader &header, LayoutSectionId id,
+                          const std::vector<T> &records)
+{
+    alignImage(image);
+    header.sections[id].offset = static_cast<uint32_t>(image.size());
+    header.sections[id].count = static_cast<uint32_t>(records.size());
+    appendWords(image, records.data(), records.size() * sizeof(T));
+}
+
+bool layoutCompileText(const std::string &text, std::vector<unsigned char> &image, std::string &error)
+{
+    LayoutSource source;
+    addString(source, ""); // Offset 0 reads as empty
+    std::istringstream lines(text);
+    std::string line;
+    std::vector<std::string> fields;
+    for (int number = 1; std::getline(lines, line); ++number)
+    {
+        if (!splitFields(line, fields))
+            fields.assign(1, std::string()); // Unterminated quote, reported below
+        if (fields.empty())
+            continue;
+        const std::string &type = fields[0];
+        bool ok = false;
+        if (type == "building")
+            ok = addBuilding(source, fields);
+        else if (type == "road")
+            ok = addRoad(source, fields);
+        else if (type == "parking")
+            ok = addParkingLot(source, fields);
+        else if (type == "court")
+            ok = addCourt(source, fields);
+        else if (type == "tree")
+            ok = addTree(source, fields);
+        else if (type == "path")
+            ok = addPath(source, fields);
+        else if (type == "route")
+            ok = addRoutePoint(source, fields);
+        if (!ok)
+        {
+            error = "line " + std::to_string(number) + ": cannot read \"" + line + "\"";
+            return false;
+        }
+    }
+
+    LayoutHeader header = {};
+    std::memcpy(header.magic, "SCLY", 4);
+    header.version = LAYOUT_VERSION;
+    header.byteOrder = LAYOUT_BYTE_ORDER;
+    image.assign(sizeof(LayoutHeader), 0);
+    appendSection(image, header, LAYOUT_BUILDINGS, source.buildings);
+    appendSection(image, header, LAYOUT_ROADS, source.roads);
+    appendSection(image, header, LAYOUT_PARKING_LOTS, source.parkingLots);
+    appendSection(image, header, LAYOUT_COURTS, source.courts);
+    appendSection(image, header, LAYOUT_TREES, source.trees);
+    appendSection(image, header, LAYOUT_PATHS, source.paths);
+    appendSection(image, header, LAYOUT_ROUTE, source.route);
+    appendSection(image, header, LAYOUT_AABBS, source.aabbs);
+    alignImage(image);
+    header.sections[LAYOUT_STRINGS].offset = static_cast<uint32_t>(image.size());
+    header.sections[LAYOUT_STRINGS].count = static_cast<uint32_t>(source.strings.size());
+    image.insert(image.end(), source.strings.begin(), source.strings.end());
+    alignImage(image);
+    header.fileSize = static_cast<uint32_t>(image.size());
+
+    // The magic stays as bytes; every other header field is a word
+    std::vector<unsigned char> headerBytes(header.magic, header.magic + 4);
+    appendWords(headerBytes, reinterpret_cast<const unsigned char *>(&header) + 4, sizeof(LayoutHeader) - 4);
+    std::copy(headerBytes.begin(), headerBytes.end(), image.begin());
+    return true;
+}
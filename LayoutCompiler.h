@@ -0,0 +1,9 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Compiles a text campus layout into the binary form of CampusLayout.h. One
+// object per line, '#' starts a comment; see campusLayoutDefaultText() for
+// every record type. AABBs are worked out here from the extents the draw
+// functions give each object. Errors name the line.
+bool layoutCompileText(const std::string &text, std::vector<unsigned char> &image, std::string &error);
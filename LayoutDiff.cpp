@@ -0,0 +1,233 @@
+#include "LayoutDiff.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+// The AABB index is the last field of every object record and is left out of
+// the comparison: it shifts whenever an object is added or removed before it
+static_assert(offsetof(LayoutBuilding, aabb) + 4 == sizeof(LayoutBuilding) &&
+                  offsetof(LayoutRoad, aabb) + 4 == sizeof(LayoutRoad) &&
+                  offsetof(LayoutParkingLot, aabb) + 4 == sizeof(LayoutParkingLot) &&
+                  offsetof(LayoutCourt, aabb) + 4 == sizeof(LayoutCourt) &&
+                  offsetof(LayoutTree, aabb) + 4 == sizeof(LayoutTree) &&
+                  offsetof(LayoutPath, aabb) + 4 == sizeof(LayoutPath),
+              "object records end in their AABB index");
+static_assert(offsetof(LayoutBuilding, name) == offsetof(LayoutBuilding, label) + 4 &&
+                  offsetof(LayoutBuilding, aabb) == offsetof(LayoutBuilding, name) + 4,
+              "building strings sit just before the AABB index");
+
+const int64_t RESYNC_WINDOW = 8; // Records searched either side of the expected one
+
+struct LayoutTable
+{
+    const unsigned char *records;
+    uint32_t count;
+    uint32_t recordSize;
+};
+
+static LayoutTable layoutTable(const CampusLayout &layout, int section)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(layout.image);
+    const LayoutSection &s = reinterpret_cast<const LayoutHeader *>(bytes)->sections[section];
+    return {bytes + s.offset, s.count, LAYOUT_RECORD_SIZE[section]};
+}
+
+static uint32_t recordAabb(const LayoutTable &table, uint32_t index)
+{
+    uint32_t aabb;
+    std::memcpy(&aabb, table.records + (index + 1) * table.recordSize - sizeof(aabb), sizeof(aabb));
+    return aabb;
+}
+
+static uint64_t mixWord(uint64_t hash, uint32_t word)
+{
+    return (hash ^ word) * 1099511628211ull;
+}
+
+// FNV-1a a word at a time; records are whole 4-byte words
+static uint64_t hashWords(uint64_t hash, const unsigned char *data, size_t size)
+{
+    for (size_t i = 0; i + 4 <= size; i += 4)
+    {
+        uint32_t word;
+        std::memcpy(&word, data + i, 4);
+        hash = mixWord(hash, word);
+    }
+    return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const char *text)
+{
+    for (; *text; ++text)
+        hash = mixWord(hash, static_cast<unsigned char>(*text));
+    return mixWord(hash, 0);
+}
+
+// Bytes compared directly: all but the AABB index, and for buildings the string offsets
+static size_t plainBytes(int section)
+{
+    return section == LAYOUT_BUILDINGS ? offsetof(LayoutBuilding, label)
+                                       : LAYOUT_RECORD_SIZE[section] - sizeof(uint32_t);
+}
+
+static uint64_t recordHash(const CampusLayout &layout, const LayoutTable &table, int section, uint32_t index)
+{
+    const unsigned char *record = table.records + index * table.recordSize;
+    uint64_t hash = hashWords(14695981039346656037ull, record, plainBytes(section));
+    if (section == LAYOUT_BUILDINGS)
+    {
+        const LayoutBuilding &b = *reinterpret_cast<const LayoutBuilding *>(record);
+        hash = hashString(hash, layoutString(layout, b.label));
+        hash = hashString(hash, layoutString(layout, b.name));
+    }
+    return hash;
+}
+
+static bool sameRecord(const CampusLayout &from, const LayoutTable &a, uint32_t i, const CampusLayout &to,
+                       const LayoutTable &b, uint32_t j, int section)
+{
+    const unsigned char *x = a.records + i * a.recordSize, *y = b.records + j * b.recordSize;
+    if (std::memcmp(x, y, plainBytes(section)) != 0)
+        return false;
+    if (section != LAYOUT_BUILDINGS)
+        return true;
+    const LayoutBuilding &p = *reinterpret_cast<const LayoutBuilding *>(x);
+    const LayoutBuilding &q = *reinterpret_cast<const LayoutBuilding *>(y);
+    return std::strcmp(layoutString(from, p.label), layoutString(to, q.label)) == 0 &&
+           std::strcmp(layoutString(from, p.name), layoutString(to, q.name)) == 0;
+}
+
+static void diffTable(const CampusLayout &from, const CampusLayout &to, int section, LayoutTableDiff &out,
+                      LayoutTableDiff &aabbs)
+{
+    LayoutTable a = layoutTable(from, section), b = layoutTable(to, section);
+    out = LayoutTableDiff();
+    out.remap.assign(a.count, LAYOUT_NO_INDEX);
+
+    // Records mostly stay in order: walk both tables together, resyncing over
+    // small insertions and deletions nearby and through a hash index of the
+    // old records, built at the first miss, over anything further
+    std::vector<std::pair<uint64_t, uint32_t>> hashes;
+    bool hashed = false;
+    std::vector<uint32_t> unmatched;
+    int64_t offset = 0; // Old index minus new index
+    for (uint32_t j = 0; j < b.count; ++j)
+    {
+        int64_t found = -1;
+        for (int64_t d = 0; d <= RESYNC_WINDOW && found < 0; ++d)
+        {
+            for (int64_t i : {j + offset + d, j + offset - d})
+            {
+                if (i >= 0 && i < a.count && out.remap[i] == LAYOUT_NO_INDEX &&
+                    sameRecord(from, a, static_cast<uint32_t>(i), to, b, j, section))
+                {
+                    found = i;
+                    break;
+                }
+            }
+        }
+        if (found < 0)
+        {
+            if (!hashed)
+            {
+                hashes.resize(a.count);
+                for (uint32_t i = 0; i < a.count; ++i)
+                    hashes[i] = {recordHash(from, a, section, i), i};
+                std::sort(hashes.begin(), hashes.end());
+                hashed = true;
+            }
+            uint64_t hash = recordHash(to, b, section, j);
+            auto it = std::lower_bound(hashes.begin(), hashes.end(), std::make_pair(hash, 0u));
+            for (; found < 0 && it != hashes.end() && it->first == hash; ++it)
+            {
+                if (out.remap[it->second] == LAYOUT_NO_INDEX && sameRecord(from, a, it->second, to, b, j, section))
+                    found = it->second;
+            }
+        }
+        if (found < 0)
+        {
+            unmatched.push_back(j);
+            continue;
+        }
+        out.remap[found] = j;
+        offset = found - j;
+    }
+
+    // Leftovers pair up in order as edits of each other
+    size_t next = 0;
+    for (uint32_t i = 0; i < a.count; ++i)
+    {
+        if (out.remap[i] != LAYOUT_NO_INDEX)
+            continue;
+        if (next < unmatched.size())
+        {
+            out.remap[i] = unmatched[next];
+            out.modified.push_back(unmatched[next++]);
+        }
+        else
+        {
+            out.removed.push_back(i);
+        }
+    }
+    out.added.assign(unmatched.begin() + next, unmatched.end());
+
+    // The same changes by AABB index
+    for (uint32_t i = 0; i < a.count; ++i)
+    {
+        uint32_t oldAabb = recordAabb(a, i);
+        if (oldAabb < aabbs.remap.size() && out.remap[i] != LAYOUT_NO_INDEX)
+            aabbs.remap[oldAabb] = recordAabb(b, out.remap[i]);
+    }
+    for (uint32_t i : out.removed)
+        aabbs.removed.push_back(recordAabb(a, i));
+    for (uint32_t j : out.modified)
+        aabbs.modified.push_back(recordAabb(b, j));
+    for (uint32_t j : out.added)
+        aabbs.added.push_back(recordAabb(b, j));
+}
+
+void layoutDiff(const CampusLayout &from, const CampusLayout &to, LayoutDiff &diff)
+{
+    diff.aabbs = LayoutTableDiff();
+    diff.aabbs.remap.assign(from.aabbCount, LAYOUT_NO_INDEX);
+    for (int section = 0; section < LAYOUT_ROUTE; ++section)
+        diffTable(from, to, section, diff.tables[section], diff.aabbs);
+    // Indices past the table mean a damaged record; drop them
+    auto outside = [&](uint32_t aabb) { return aabb >= to.aabbCount; };
+    for (std::vector<uint32_t> *list : {&diff.aabbs.added, &diff.aabbs.modified})
+        list->erase(std::remove_if(list->begin(), list->end(), outside), list->end());
+    for (uint32_t &aabb : diff.aabbs.remap)
+    {
+        if (aabb != LAYOUT_NO_INDEX && outside(aabb))
+            aabb = LAYOUT_NO_INDEX;
+    }
+
+    diff.routeChanged = from.routeCount != to.routeCount ||
+                        std::memcmp(from.route, to.route, from.routeCount * sizeof(LayoutRoutePoint)) != 0;
+}
+
+uint32_t layoutTableChanges(const LayoutTableDiff &table)
+{
+    return static_cast<uint32_t>(table.added.size() + table.removed.size() + table.modified.size());
+}
+
+bool layoutDiffKeepsIndices(const LayoutDiff &diff, uint32_t aabbCount)
+{
+    if (diff.aabbs.remap.size() != aabbCount)
+        return false;
+    for (uint32_t i = 0; i < aabbCount; ++i)
+    {
+        if (diff.aabbs.remap[i] != i)
+            return false;
+    }
+    return true;
+}
+
+uint32_t layoutDiffChanges(const LayoutDiff &diff)
+{
+    uint32_t changes = 0;
+    for (const LayoutTableDiff &table : diff.tables)
+        changes += layoutTableChanges(table);
+    return changes;
+}
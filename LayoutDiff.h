@@ -0,0 +1,37 @@
+#pragma once
+#include "CampusLayout.h"
+#include <cstdint>
+#include <vector>
+
+// What changed between two layouts, for reloading one in place. Objects carry
+// no ids, so records are matched by content, with string offsets compared as
+// the strings they point at: an identical record is unchanged wherever it
+// moved in its table. The old and new records left over in a table then pair
+// up in order as modified, and the surplus is removed or added.
+
+const uint32_t LAYOUT_NO_INDEX = 0xFFFFFFFFu;
+
+struct LayoutTableDiff
+{
+    std::vector<uint32_t> added;    // New indices
+    std::vector<uint32_t> removed;  // Old indices
+    std::vector<uint32_t> modified; // New indices
+    std::vector<uint32_t> remap;    // Old index -> new index, LAYOUT_NO_INDEX if removed
+};
+
+struct LayoutDiff
+{
+    LayoutTableDiff tables[LAYOUT_ROUTE]; // Object sections, buildings to paths
+    LayoutTableDiff aabbs; // The same changes in AABB-table numbering, which spans every object
+    bool routeChanged;
+};
+
+void layoutDiff(const CampusLayout &from, const CampusLayout &to, LayoutDiff &diff);
+
+// Objects added, removed or modified in one table, or in all of them
+uint32_t layoutTableChanges(const LayoutTableDiff &table);
+uint32_t layoutDiffChanges(const LayoutDiff &diff);
+// True if every object kept its AABB index in a layout of aabbCount. Records
+// that only moved are unchanged but renumbered, which everything indexed by
+// AABB has to follow.
+bool layoutDiffKeepsIndices(const LayoutDiff &diff, uint32_t aabbCount);
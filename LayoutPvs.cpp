@@ -0,0 +1,256 @@
+#include "LayoutPvs.h"
+#include "LayoutBvh.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+const float PVS_MARGIN = 32.0f;            // Cells reach this far past the layout
+const float PVS_OCCLUDER_SHRINK = 0.5f;    // Walls carry windows and trim; only their core blocks sight
+const double PVS_MAX_WORK = 2e8;           // Cells x objects x buildings
+
+struct PvsBox
+{
+    float min[3], max[3];
+};
+
+struct PvsOccluder
+{
+    PvsBox box;
+    uint32_t aabb; // The building's own, which it does not hide
+};
+
+struct PvsJob
+{
+    std::vector<PvsBox> targets; // Per AABB index
+    std::vector<bool> hideable;  // Objects the sets may hide; the rest are always visible
+    std::vector<PvsOccluder> occluders;
+    float originX, originZ;
+    int columns, rows;
+    size_t words; // Per cell
+    std::vector<uint64_t> bits;
+    std::atomic<bool> cancel;
+    double ms;
+};
+
+static std::shared_ptr<PvsJob> running;
+static std::future<void> worker;
+static std::shared_ptr<PvsJob> ready; // The sets in use
+
+static bool overlaps(const PvsBox &a, const PvsBox &b)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (a.min[axis] > b.max[axis] || b.min[axis] > a.max[axis])
+            return false;
+    }
+    return true;
+}
+
+// True if every segment from a to b crosses the plane at this coordinate on
+// axis inside the occluder. a must lie wholly below the plane on that axis
+// and b wholly above it. A segment crosses at the fraction t of its length
+// that falls as either end moves up the axis, so t over all segments spans
+// the values at the two pairs of extreme ends, and the crossings on each
+// other axis span those of the boxes' matching faces at those two t.
+static bool crossesInside(const PvsBox &a, const PvsBox &b, const PvsBox &occluder, int axis, float plane)
+{
+    if (b.min[axis] <= a.max[axis])
+        return false; // Both touch the plane; segments along it need not cross it
+    float t[2] = {(plane - a.max[axis]) / (b.max[axis] - a.max[axis]),
+                  (plane - a.min[axis]) / (b.min[axis] - a.min[axis])};
+    for (int other = 0; other < 3; ++other)
+    {
+        if (other == axis)
+            continue;
+        for (float f : t)
+        {
+            if ((1.0f - f) * a.min[other] + f * b.min[other] < occluder.min[other] ||
+                (1.0f - f) * a.max[other] + f * b.max[other] > occluder.max[other])
+                return false;
+        }
+    }
+    return true;
+}
+
+// True if every segment from somewhere in the eye box to somewhere in the
+// target runs into the occluder: the occluder lies between them on an axis and
+// all of the segments cross one of its faces on that axis inside it
+static bool hides(const PvsBox &eyes, const PvsBox &target, const PvsBox &occluder)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const PvsBox *a = &eyes, *b = &target;
+        if (b->max[axis] <= occluder.min[axis])
+            std::swap(a, b); // Segments run both ways
+        if (a->max[axis] > occluder.min[axis] || b->min[axis] < occluder.max[axis])
+            continue;
+        if (crossesInside(*a, *b, occluder, axis, occluder.min[axis]) ||
+            crossesInside(*a, *b, occluder, axis, occluder.max[axis]))
+            return true;
+    }
+    return false;
+}
+
+// False only if a single building hides the whole target from the whole eye box
+static bool visibleFrom(const PvsJob &job, const PvsBox &eyes, uint32_t target)
+{
+    const PvsBox &box = job.targets[target];
+    PvsBox span;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        span.min[axis] = std::min(eyes.min[axis], box.min[axis]);
+        span.max[axis] = std::max(eyes.max[axis], box.max[axis]);
+    }
+    for (const PvsOccluder &occluder : job.occluders)
+    {
+        if (occluder.aabb != target && overlaps(occluder.box, span) && hides(eyes, box, occluder.box))
+            return false;
+    }
+    return true;
+}
+
+static void computeCell(PvsJob &job, int band, int row, int column)
+{
+    uint64_t *bits = &job.bits[((static_cast<size_t>(band) * job.rows + row) * job.columns + column) * job.words];
+    PvsBox eyes = {{job.originX + column * PVS_CELL_SIZE, band * PVS_BAND_HEIGHT, job.originZ + row * PVS_CELL_SIZE},
+                   {job.originX + (column + 1) * PVS_CELL_SIZE, (band + 1) * PVS_BAND_HEIGHT,
+                    job.originZ + (row + 1) * PVS_CELL_SIZE}};
+    uint32_t count = static_cast<uint32_t>(job.targets.size());
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (!job.hideable[i] || visibleFrom(job, eyes, i))
+            bits[i >> 6] |= 1ull << (i & 63);
+    }
+}
+
+static void computeSets(std::shared_ptr<PvsJob> job)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int band = 0; band < PVS_BANDS; ++band)
+    {
+        for (int row = 0; row < job->rows; ++row)
+        {
+            for (int column = 0; column < job->columns; ++column)
+            {
+                if (job->cancel)
+                    return;
+                computeCell(*job, band, row, column);
+            }
+        }
+    }
+    job->ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void abandon()
+{
+    if (!running)
+        return;
+    running->cancel = true;
+    worker.get();
+    running.reset();
+}
+
+void layoutPvsBuild(const CampusLayout &layout)
+{
+    abandon();
+    ready.reset();
+
+    std::shared_ptr<PvsJob> job = std::make_shared<PvsJob>();
+    job->cancel = false;
+    job->ms = 0.0;
+    job->targets.resize(layout.aabbCount);
+    job->hideable.assign(layout.aabbCount, false);
+    float lo[2] = {FLT_MAX, FLT_MAX}, hi[2] = {-FLT_MAX, -FLT_MAX};
+    size_t hideableCount = 0;
+    for (uint32_t i = 0; i < layout.aabbCount; ++i)
+    {
+        const LayoutAabb &aabb = layout.aabbs[i];
+        PvsBox &box = job->targets[i];
+        std::copy(aabb.min, aabb.min + 3, box.min);
+        std::copy(aabb.max, aabb.max + 3, box.max);
+        if (aabb.section >= LAYOUT_ROUTE)
+            continue;
+        job->hideable[i] = true;
+        ++hideableCount;
+        lo[0] = std::min(lo[0], box.min[0]);
+        lo[1] = std::min(lo[1], box.min[2]);
+        hi[0] = std::max(hi[0], box.max[0]);
+        hi[1] = std::max(hi[1], box.max[2]);
+        if (aabb.section != LAYOUT_BUILDINGS || aabb.index >= layout.buildingCount)
+            continue;
+
+        // A label shows over a hidden roof, as in the BVH
+        const LayoutBuilding &b = layout.buildings[aabb.index];
+        box.max[1] = std::max(box.max[1], b.position[1] + b.size[1] + BUILDING_LABEL_CLEARANCE);
+        PvsOccluder occluder;
+        occluder.box = {{b.position[0] - 0.5f * b.size[0] + PVS_OCCLUDER_SHRINK, b.position[1] + PVS_OCCLUDER_SHRINK,
+                         b.position[2] - 0.5f * b.size[2] + PVS_OCCLUDER_SHRINK},
+                        {b.position[0] + 0.5f * b.size[0] - PVS_OCCLUDER_SHRINK,
+                         b.position[1] + b.size[1] - PVS_OCCLUDER_SHRINK,
+                         b.position[2] + 0.5f * b.size[2] - PVS_OCCLUDER_SHRINK}};
+        occluder.aabb = i;
+        if (occluder.box.min[0] < occluder.box.max[0] && occluder.box.min[1] < occluder.box.max[1] &&
+            occluder.box.min[2] < occluder.box.max[2])
+            job->occluders.push_back(occluder);
+    }
+    if (hideableCount == 0 || job->occluders.empty())
+        return; // Nothing to hide, or nothing to hide behind
+
+    job->originX = lo[0] - PVS_MARGIN;
+    job->originZ = lo[1] - PVS_MARGIN;
+    job->columns = static_cast<int>(std::ceil((hi[0] - lo[0] + 2.0f * PVS_MARGIN) / PVS_CELL_SIZE));
+    job->rows = static_cast<int>(std::ceil((hi[1] - lo[1] + 2.0f * PVS_MARGIN) / PVS_CELL_SIZE));
+    double cells = static_cast<double>(job->columns) * job->rows * PVS_BANDS;
+    if (cells * hideableCount * job->occluders.size() > PVS_MAX_WORK)
+    {
+        std::cout << "PVS: skipped, " << cells << " cells x " << hideableCount << " objects x "
+                  << job->occluders.size() << " buildings is too much to test" << std::endl;
+        return;
+    }
+    job->words = (layout.aabbCount + 63) / 64;
+    job->bits.assign(static_cast<size_t>(cells) * job->words, 0);
+
+    running = job;
+    worker = std::async(std::launch::async, computeSets, job);
+}
+
+void layoutPvsPoll(bool wait)
+{
+    if (!running || (!wait && worker.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+        return;
+    worker.get();
+    ready = running;
+    running.reset();
+
+    size_t cells = ready->bits.size() / ready->words;
+    size_t objects = std::count(ready->hideable.begin(), ready->hideable.end(), true);
+    size_t visible = 0;
+    for (size_t c = 0; c < cells; ++c)
+    {
+        const uint64_t *bits = &ready->bits[c * ready->words];
+        for (uint32_t i = 0; i < ready->targets.size(); ++i)
+            visible += ready->hideable[i] && layoutPvsVisible(bits, i);
+    }
+    std::cout << "PVS: " << ready->columns << "x" << ready->rows << " cells in " << PVS_BANDS << " bands, "
+              << static_cast<int>(100.0 * (1.0 - static_cast<double>(visible) / (cells * objects)))
+              << "% of objects hidden from the average cell, in " << static_cast<int>(ready->ms) << " ms"
+              << std::endl;
+}
+
+const uint64_t *layoutPvsFind(const Vec3 &eye)
+{
+    if (!ready || eye.y >= PVS_EYE_MAX_Y)
+        return nullptr;
+    int column = static_cast<int>(std::floor((eye.x - ready->originX) / PVS_CELL_SIZE));
+    int row = static_cast<int>(std::floor((eye.z - ready->originZ) / PVS_CELL_SIZE));
+    if (column < 0 || column >= ready->columns || row < 0 || row >= ready->rows)
+        return nullptr;
+    int band = std::max(0, static_cast<int>(std::floor(eye.y / PVS_BAND_HEIGHT)));
+    return &ready->bits[((static_cast<size_t>(band) * ready->rows + row) * ready->columns + column) * ready->words];
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "CampusLayout.h"
+#include "Math3D.h"
+#include <cstdint>
+
+// Potentially visible sets for street-level cameras. The ground under and
+// around the layout is split into square cells, each in a few height bands
+// up to PVS_EYE_MAX_Y, and every cell keeps one bit per AABB index: whether
+// the object may be seen from anywhere in the cell. Buildings are the
+// occluders, shrunk past their windows and trim. An object is hidden from a
+// cell only if one building blocks every line of sight from anywhere in the
+// cell to anywhere in its box, which is tested exactly; the sets never hide
+// anything visible. Buildings are not fused, so an object behind a row of
+// them that no single one covers is kept.
+//
+// The sets are computed on a worker thread whenever a layout is loaded or
+// reloaded; until they are ready, and for eyes outside or above the cells,
+// everything is drawn. Layouts too large to sample in reasonable time get no
+// sets at all.
+
+const float PVS_CELL_SIZE = 16.0f;
+const float PVS_BAND_HEIGHT = 12.0f;
+const int PVS_BANDS = 2;
+const float PVS_EYE_MAX_Y = PVS_BAND_HEIGHT * PVS_BANDS;
+
+// Starts computing the sets of a newly loaded or reloaded layout. Sets for
+// the previous layout are dropped at once, and a computation still running
+// for it is abandoned.
+void layoutPvsBuild(const CampusLayout &layout);
+// Once per frame: takes the sets once they are done. With wait set it
+// blocks until they are, as pixel validation needs.
+void layoutPvsPoll(bool wait);
+
+// Visibility bits of the cell holding this eye, one per AABB index, or null
+// if everything has to be drawn
+const uint64_t *layoutPvsFind(const Vec3 &eye);
+
+inline bool layoutPvsVisible(const uint64_t *bits, uint32_t aabb)
+{
+    return (bits[aabb >> 6] >> (aabb & 63)) & 1;
+}
@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool mapFile(const char *path, MappedFile &m)
+{
+    m = MappedFile();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    HANDLE view = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (view)
+        m.data = MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+    if (!m.data)
+    {
+        if (view)
+            CloseHandle(view);
+        CloseHandle(file);
+        return false;
+    }
+    m.file = file;
+    m.view = view;
+    m.size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file
+    if (data == MAP_FAILED)
+        return false;
+    m.data = data;
+    m.size = static_cast<size_t>(info.st_size);
+    return true;
+#endif
+}
+
+void unmapFile(MappedFile &m)
+{
+    if (!m.data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m.data);
+    CloseHandle(static_cast<HANDLE>(m.view));
+    CloseHandle(static_cast<HANDLE>(m.file));
+#else
+    munmap(const_cast<void *>(m.data), m.size);
+#endif
+    m = MappedFile();
+}
+
+bool replaceFile(const char *from, const char *to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from, to) == 0;
+#endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// A read-only file mapping (mmap, or a file mapping object on Windows)
+struct MappedFile
+{
+    const void *data; // nullptr when nothing is mapped
+    size_t size;
+    void *file, *view; // Windows handles
+};
+
+bool mapFile(const char *path, MappedFile &file);
+void unmapFile(MappedFile &file);
+
+// Moves from over to, replacing it; on POSIX readers that still map the old
+// file keep their copy, while Windows fails if to is open or mapped
+bool replaceFile(const char *from, const char *to);
@@ -0,0 +1,234 @@
+#include "Math3D.h"
+#ifdef CAMPUS_MATH_SSE
+#include <emmintrin.h>
+#endif
+
+Mat4 mat4Rotation(float angleDegrees, const Vec3 &axis)
+{
+    Vec3 a = normalize(axis);
+    float radians = angleDegrees * PI / 180.0f;
+    float c = std::cos(radians), s = std::sin(radians), t = 1.0f - c;
+    return Mat4(t * a.x * a.x + c, t * a.x * a.y + s * a.z, t * a.x * a.z - s * a.y, 0.0f,
+                t * a.x * a.y - s * a.z, t * a.y * a.y + c, t * a.y * a.z + s * a.x, 0.0f,
+                t * a.x * a.z + s * a.y, t * a.y * a.z - s * a.x, t * a.z * a.z + c, 0.0f,
+                0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Mat4 mat4LookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up)
+{
+    Vec3 f = normalize(center - eye);
+    Vec3 s = normalize(cross(f, up));
+    Vec3 u = cross(s, f);
+    return Mat4(s.x, u.x, -f.x, 0.0f,
+                s.y, u.y, -f.y, 0.0f,
+                s.z, u.z, -f.z, 0.0f,
+                -dot(s, eye), -dot(u, eye), dot(f, eye), 1.0f);
+}
+
+Mat4 mat4Perspective(float fovYDegrees, float aspect, float zNear, float zFar)
+{
+    float f = 1.0f / std::tan(fovYDegrees * PI / 360.0f);
+    return Mat4(f / aspect, 0.0f, 0.0f, 0.0f,
+                0.0f, f, 0.0f, 0.0f,
+                0.0f, 0.0f, (zFar + zNear) / (zNear - zFar), -1.0f,
+                0.0f, 0.0f, 2.0f * zFar * zNear / (zNear - zFar), 0.0f);
+}
+
+Mat4 mat4Ortho2D(float left, float right, float bottom, float top)
+{
+    return Mat4(2.0f / (right - left), 0.0f, 0.0f, 0.0f,
+                0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
+                0.0f, 0.0f, -1.0f, 0.0f,
+                -(right + left) / (right - left), -(top + bottom) / (top - bottom), 0.0f, 1.0f);
+}
+
+Mat4 mat4Ortho(float left, float right, float bottom, float top, float zNear, float zFar)
+{
+    return Mat4(2.0f / (right - left), 0.0f, 0.0f, 0.0f,
+                0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
+                0.0f, 0.0f, -2.0f / (zFar - zNear), 0.0f,
+                -(right + left) / (right - left), -(top + bottom) / (top - bottom),
+                -(zFar + zNear) / (zFar - zNear), 1.0f);
+}
+
+#ifdef CAMPUS_MATH_SSE
+
+// Each column of the result is a combination of a's columns weighted by b's
+Mat4 operator*(const Mat4 &a, const Mat4 &b)
+{
+    __m128 c0 = _mm_loadu_ps(a.m), c1 = _mm_loadu_ps(a.m + 4);
+    __m128 c2 = _mm_loadu_ps(a.m + 8), c3 = _mm_loadu_ps(a.m + 12);
+    Mat4 r;
+    for (int c = 0; c < 4; ++c)
+    {
+        const float *w = b.m + c * 4;
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(w[0])), _mm_mul_ps(c1, _mm_set1_ps(w[1]))),
+                                _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(w[2])), _mm_mul_ps(c3, _mm_set1_ps(w[3]))));
+        _mm_storeu_ps(r.m + c * 4, sum);
+    }
+    return r;
+}
+
+Vec4 operator*(const Mat4 &a, const Vec4 &v)
+{
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a.m), _mm_set1_ps(v.x)),
+                                       _mm_mul_ps(_mm_loadu_ps(a.m + 4), _mm_set1_ps(v.y))),
+                            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a.m + 8), _mm_set1_ps(v.z)),
+                                       _mm_mul_ps(_mm_loadu_ps(a.m + 12), _mm_set1_ps(v.w))));
+    float out[4];
+    _mm_storeu_ps(out, sum);
+    return Vec4(out[0], out[1], out[2], out[3]);
+}
+
+#define SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SWIZZLE(v, x, y, z, w) _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), SHUFFLE_MASK(x, y, z, w)))
+#define SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, SHUFFLE_MASK(x, y, z, w))
+
+// 2x2 blocks packed as (m00, m01, m10, m11): A * B, adj(A) * B and A * adj(B)
+static inline __m128 mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+static inline __m128 mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+static inline __m128 mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Block-wise inverse of [A B; C D] via 2x2 adjugates. Written for rows, it
+// works on GL's columns unchanged since inverse(transpose(M)) = transpose(inverse(M)).
+Mat4 inverse(const Mat4 &a)
+{
+    __m128 r0 = _mm_loadu_ps(a.m), r1 = _mm_loadu_ps(a.m + 4);
+    __m128 r2 = _mm_loadu_ps(a.m + 8), r3 = _mm_loadu_ps(a.m + 12);
+
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    // (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(_mm_mul_ps(SHUFFLE(r0, r2, 0, 2, 0, 2), SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                               _mm_mul_ps(SHUFFLE(r0, r2, 1, 3, 1, 3), SHUFFLE(r1, r3, 0, 2, 0, 2)));
+    __m128 detA = SWIZZLE(detSub, 0, 0, 0, 0);
+    __m128 detB = SWIZZLE(detSub, 1, 1, 1, 1);
+    __m128 detC = SWIZZLE(detSub, 2, 2, 2, 2);
+    __m128 detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+    __m128 dC = mat2AdjMul(D, C);
+    __m128 aB = mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, dC));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, aB));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, aB));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, dC));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+    __m128 tr = _mm_mul_ps(aB, SWIZZLE(dC, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 1, 0, 3, 2));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 2, 3, 0, 1));
+    __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+    if (_mm_cvtss_f32(det) == 0.0f)
+        return Mat4();
+
+    __m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+    X = _mm_mul_ps(X, scale);
+    Y = _mm_mul_ps(Y, scale);
+    Z = _mm_mul_ps(Z, scale);
+    W = _mm_mul_ps(W, scale);
+
+    Mat4 r;
+    _mm_storeu_ps(r.m, SHUFFLE(X, Y, 3, 1, 3, 1));
+    _mm_storeu_ps(r.m + 4, SHUFFLE(X, Y, 2, 0, 2, 0));
+    _mm_storeu_ps(r.m + 8, SHUFFLE(Z, W, 3, 1, 3, 1));
+    _mm_storeu_ps(r.m + 12, SHUFFLE(Z, W, 2, 0, 2, 0));
+    return r;
+}
+
+#undef SHUFFLE
+#undef SWIZZLE
+#undef SHUFFLE_MASK
+
+#else
+
+Mat4 operator*(const Mat4 &a, const Mat4 &b)
+{
+    Mat4 r;
+    for (int c = 0; c < 4; ++c)
+        for (int row = 0; row < 4; ++row)
+            r.m[c * 4 + row] = a.m[row] * b.m[c * 4] + a.m[4 + row] * b.m[c * 4 + 1] +
+                               a.m[8 + row] * b.m[c * 4 + 2] + a.m[12 + row] * b.m[c * 4 + 3];
+    return r;
+}
+
+Vec4 operator*(const Mat4 &a, const Vec4 &v)
+{
+    return a.column(0) * v.x + a.column(1) * v.y + a.column(2) * v.z + a.column(3) * v.w;
+}
+
+// Cofactors from the 2x2 minors of the first and last two columns
+Mat4 inverse(const Mat4 &a)
+{
+    const float *m = a.m;
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[6] - m[4] * m[2];
+    float s2 = m[0] * m[7] - m[4] * m[3];
+    float s3 = m[1] * m[6] - m[5] * m[2];
+    float s4 = m[1] * m[7] - m[5] * m[3];
+    float s5 = m[2] * m[7] - m[6] * m[3];
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[9] * m[15] - m[13] * m[11];
+    float c3 = m[9] * m[14] - m[13] * m[10];
+    float c2 = m[8] * m[15] - m[12] * m[11];
+    float c1 = m[8] * m[14] - m[12] * m[10];
+    float c0 = m[8] * m[13] - m[12] * m[9];
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f)
+        return Mat4();
+    float k = 1.0f / det;
+    return Mat4((m[5] * c5 - m[6] * c4 + m[7] * c3) * k,
+                (-m[1] * c5 + m[2] * c4 - m[3] * c3) * k,
+                (m[13] * s5 - m[14] * s4 + m[15] * s3) * k,
+                (-m[9] * s5 + m[10] * s4 - m[11] * s3) * k,
+                (-m[4] * c5 + m[6] * c2 - m[7] * c1) * k,
+                (m[0] * c5 - m[2] * c2 + m[3] * c1) * k,
+                (-m[12] * s5 + m[14] * s2 - m[15] * s1) * k,
+                (m[8] * s5 - m[10] * s2 + m[11] * s1) * k,
+                (m[4] * c4 - m[5] * c2 + m[7] * c0) * k,
+                (-m[0] * c4 + m[1] * c2 - m[3] * c0) * k,
+                (m[12] * s4 - m[13] * s2 + m[15] * s0) * k,
+                (-m[8] * s4 + m[9] * s2 - m[11] * s0) * k,
+                (-m[4] * c3 + m[5] * c1 - m[6] * c0) * k,
+                (m[0] * c3 - m[1] * c1 + m[2] * c0) * k,
+                (-m[12] * s3 + m[13] * s1 - m[14] * s0) * k,
+                (m[8] * s3 - m[9] * s1 + m[10] * s0) * k);
+}
+
+#endif
+
+Frustum frustumFromMatrix(const Mat4 &clip)
+{
+    Vec4 r0 = clip.row(0), r1 = clip.row(1), r2 = clip.row(2), r3 = clip.row(3);
+    Frustum f;
+    f.planes[0] = r3 + r0;
+    f.planes[1] = r3 + r0 * -1.0f;
+    f.planes[2] = r3 + r1;
+    f.planes[3] = r3 + r1 * -1.0f;
+    f.planes[4] = r3 + r2;
+    f.planes[5] = r3 + r2 * -1.0f;
+    for (Vec4 &p : f.planes)
+        p = p * (1.0f / length(p.xyz()));
+    return f;
+}
+
+bool frustumSphereVisible(const Frustum &frustum, const Vec3 &center, float radius)
+{
+    for (const Vec4 &p : frustum.planes)
+    {
+        if (dot(p, Vec4(center, 1.0f)) < -radius)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cmath>
+
+// Small vector/matrix library for the CPU-side transforms (camera, matrix
+// stack, batching, picking, culling). Matrices are column-major like GL, so
+// Mat4::m can be handed to glLoadMatrixf directly. Construction is constexpr;
+// the 4x4 multiply and inverse use SSE2 when the target has it.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CAMPUS_MATH_SSE 1
+#endif
+
+// <cmath> only has M_PI on some platforms (not MinGW in strict modes)
+constexpr float PI = 3.14159265358979323846f;
+
+struct Vec3
+{
+    float x, y, z;
+
+    constexpr Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+    constexpr Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+};
+
+struct Vec4
+{
+    float x, y, z, w;
+
+    constexpr Vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+    constexpr Vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+    constexpr Vec4(const Vec3 &v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    constexpr Vec3 xyz() const { return Vec3(x, y, z); }
+};
+
+struct Mat4
+{
+    float m[16]; // Column-major: element (row r, column c) is m[c * 4 + r]
+
+    // Identity
+    constexpr Mat4() : m{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1} {}
+    // Columns given in order
+    constexpr Mat4(float c0x, float c0y, float c0z, float c0w,
+                   float c1x, float c1y, float c1z, float c1w,
+                   float c2x, float c2y, float c2z, float c2w,
+                   float c3x, float c3y, float c3z, float c3w)
+        : m{c0x, c0y, c0z, c0w, c1x, c1y, c1z, c1w, c2x, c2y, c2z, c2w, c3x, c3y, c3z, c3w} {}
+
+    constexpr float at(int row, int column) const { return m[column * 4 + row]; }
+    constexpr Vec4 column(int c) const { return Vec4(m[c * 4], m[c * 4 + 1], m[c * 4 + 2], m[c * 4 + 3]); }
+    constexpr Vec4 row(int r) const { return Vec4(m[r], m[4 + r], m[8 + r], m[12 + r]); }
+};
+
+constexpr Vec3 operator+(const Vec3 &a, const Vec3 &b) { return Vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+constexpr Vec3 operator-(const Vec3 &a, const Vec3 &b) { return Vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+constexpr Vec3 operator-(const Vec3 &a) { return Vec3(-a.x, -a.y, -a.z); }
+constexpr Vec3 operator*(const Vec3 &a, float s) { return Vec3(a.x * s, a.y * s, a.z * s); }
+constexpr Vec3 operator*(float s, const Vec3 &a) { return a * s; }
+constexpr Vec4 operator+(const Vec4 &a, const Vec4 &b) { return Vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); }
+constexpr Vec4 operator*(const Vec4 &a, float s) { return Vec4(a.x * s, a.y * s, a.z * s, a.w * s); }
+
+constexpr float dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr float dot(const Vec4 &a, const Vec4 &b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+constexpr Vec3 cross(const Vec3 &a, const Vec3 &b)
+{
+    return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+inline float length(const Vec3 &a) { return std::sqrt(dot(a, a)); }
+inline Vec3 normalize(const Vec3 &a)
+{
+    float len = length(a);
+    return len > 0.0f ? a * (1.0f / len) : a;
+}
+
+constexpr Mat4 mat4Translation(float x, float y, float z)
+{
+    return Mat4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1);
+}
+constexpr Mat4 mat4Scale(float x, float y, float z)
+{
+    return Mat4(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1);
+}
+constexpr Mat4 transpose(const Mat4 &a)
+{
+    return Mat4(a.m[0], a.m[4], a.m[8], a.m[12], a.m[1], a.m[5], a.m[9], a.m[13],
+                a.m[2], a.m[6], a.m[10], a.m[14], a.m[3], a.m[7], a.m[11], a.m[15]);
+}
+
+// Rotation about an axis like glRotatef (degrees)
+Mat4 mat4Rotation(float angleDegrees, const Vec3 &axis);
+// Equivalents of gluLookAt, gluPerspective, gluOrtho2D and glOrtho
+Mat4 mat4LookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up);
+Mat4 mat4Perspective(float fovYDegrees, float aspect, float zNear, float zFar);
+Mat4 mat4Ortho2D(float left, float right, float bottom, float top);
+Mat4 mat4Ortho(float left, float right, float bottom, float top, float zNear, float zFar);
+
+Mat4 operator*(const Mat4 &a, const Mat4 &b);
+Vec4 operator*(const Mat4 &a, const Vec4 &v);
+// General inverse; returns the identity for a singular matrix
+Mat4 inverse(const Mat4 &a);
+
+inline Vec3 transformPoint(const Mat4 &a, const Vec3 &p)
+{
+    return Vec3(a.m[0] * p.x + a.m[4] * p.y + a.m[8] * p.z + a.m[12],
+                a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z + a.m[13],
+                a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14]);
+}
+inline Vec3 transformDirection(const Mat4 &a, const Vec3 &d)
+{
+    return Vec3(a.m[0] * d.x + a.m[4] * d.y + a.m[8] * d.z,
+                a.m[1] * d.x + a.m[5] * d.y + a.m[9] * d.z,
+                a.m[2] * d.x + a.m[6] * d.y + a.m[10] * d.z);
+}
+
+// Six normalized clip planes (left, right, bottom, top, near, far) in the
+// space the matrix maps from, e.g. eye space for a projection matrix
+struct Frustum
+{
+    Vec4 planes[6];
+};
+
+Frustum frustumFromMatrix(const Mat4 &clip);
+bool frustumSphereVisible(const Frustum &frustum, const Vec3 &center, float radius);
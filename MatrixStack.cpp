@@ -0,0 +1,123 @@
+#include "MatrixStack.h"
+#include <vector>
+
+static std::vector<Mat4> matrixStack(1);
+static bool glModelviewCurrent = false; // GL's modelview equals the top
+static Mat4 projectionMatrix;
+static std::vector<Mat4> savedProjections;
+static Frustum eyeFrustum = frustumFromMatrix(Mat4());
+
+void rcLoadMatrix(const Mat4 &m)
+{
+    matrixStack.back() = m;
+    glModelviewCurrent = false;
+}
+
+void rcMultMatrix(const Mat4 &m)
+{
+    matrixStack.back() = matrixStack.back() * m;
+    glModelviewCurrent = false;
+}
+
+void rcPushMatrix()
+{
+    matrixStack.push_back(matrixStack.back());
+}
+
+void rcPopMatrix()
+{
+    if (matrixStack.size() > 1)
+    {
+        matrixStack.pop_back();
+        glModelviewCurrent = false;
+    }
+}
+
+void rcTranslatef(float x, float y, float z)
+{
+    // Only the last column changes; skip the full multiply
+    Mat4 &m = matrixStack.back();
+    for (int r = 0; r < 3; ++r)
+        m.m[12 + r] += m.m[r] * x + m.m[4 + r] * y + m.m[8 + r] * z;
+    glModelviewCurrent = false;
+}
+
+void rcRotatef(float angle, float x, float y, float z)
+{
+    rcMultMatrix(mat4Rotation(angle, Vec3(x, y, z)));
+}
+
+void rcScalef(float x, float y, float z)
+{
+    Mat4 &m = matrixStack.back();
+    for (int r = 0; r < 4; ++r)
+    {
+        m.m[r] *= x;
+        m.m[4 + r] *= y;
+        m.m[8 + r] *= z;
+    }
+    glModelviewCurrent = false;
+}
+
+const Mat4 &rcModelview()
+{
+    return matrixStack.back();
+}
+
+void rcSyncModelview()
+{
+    if (glModelviewCurrent)
+        return;
+    glLoadMatrixf(matrixStack.back().m);
+    glModelviewCurrent = true;
+}
+
+void rcModelviewChanged()
+{
+    glModelviewCurrent = false;
+}
+
+void rcRasterPos3f(float x, float y, float z)
+{
+    rcSyncModelview();
+    glRasterPos3f(x, y, z);
+}
+
+void rcSetProjection(const Mat4 &projection)
+{
+    projectionMatrix = projection;
+    eyeFrustum = frustumFromMatrix(projection);
+}
+
+const Mat4 &rcProjection()
+{
+    return projectionMatrix;
+}
+
+static void loadGlProjection(const Mat4 &projection)
+{
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(projection.m);
+    glMatrixMode(GL_MODELVIEW);
+}
+
+void rcPushProjection(const Mat4 &projection)
+{
+    savedProjections.push_back(projectionMatrix);
+    rcSetProjection(projection);
+    loadGlProjection(projection);
+}
+
+void rcPopProjection()
+{
+    if (savedProjections.empty())
+        return;
+    rcSetProjection(savedProjections.back());
+    savedProjections.pop_back();
+    loadGlProjection(projectionMatrix);
+}
+
+bool rcEyeSphereVisible(const Vec3 &center, float radius)
+{
+    return frustumSphereVisible(eyeFrustum, center, radius);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Math3D.h"
+#include <GL/glut.h>
+
+// CPU copy of the modelview stack. Scene code transforms with the rc* calls,
+// which mirror glPushMatrix/glTranslatef/etc. but never touch GL; GL's
+// modelview is loaded lazily, only before something GL itself transforms
+// (immediate-mode vertices, raster positions, light positions, mesh draws).
+
+void rcLoadMatrix(const Mat4 &m);
+void rcMultMatrix(const Mat4 &m);
+void rcPushMatrix();
+void rcPopMatrix();
+void rcTranslatef(float x, float y, float z);
+void rcRotatef(float angle, float x, float y, float z);
+void rcScalef(float x, float y, float z);
+
+// Top of the stack
+const Mat4 &rcModelview();
+
+// Loads the top into GL's modelview if it changed since the last load. The
+// GL matrix mode must be GL_MODELVIEW.
+void rcSyncModelview();
+// Call after replacing GL's modelview directly; the next sync reloads it
+void rcModelviewChanged();
+
+// Raster position through the modelview, synced first
+void rcRasterPos3f(float x, float y, float z);
+
+// Projection used for view-frustum culling and by the shader pipeline. The
+// push/pop pair swaps in an overlay projection (2D sky, HUD) and loads it into
+// GL's projection as well.
+void rcSetProjection(const Mat4 &projection);
+const Mat4 &rcProjection();
+void rcPushProjection(const Mat4 &projection);
+void rcPopProjection();
+// True if an eye-space bounding sphere touches the view frustum
+bool rcEyeSphereVisible(const Vec3 &center, float radius);
@@ -0,0 +1,452 @@
+#include "MeshBaker.h"
+#include "BakeGeometry.h"
+#include "GLExt.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include "ShaderPipeline.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <map>
+
+static bool baking = false;
+static MeshBakeRecording recorded;
+static std::atomic<unsigned> nextMeshId(1);
+
+unsigned meshBakeNewId()
+{
+    return nextMeshId++;
+}
+
+void meshBakeBegin()
+{
+    baking = true;
+    recorded = MeshBakeRecording();
+}
+
+bool meshBakeActive()
+{
+    return baking;
+}
+
+// True if each column of the upper 3x3 lies along a different axis
+static bool axisAligned(const Mat4 &m, int axisOfColumn[3])
+{
+    bool used[3] = {false, false, false};
+    for (int c = 0; c < 3; ++c)
+    {
+        Vec3 column = m.column(c).xyz();
+        float tolerance = 1e-5f * length(column);
+        const float components[3] = {column.x, column.y, column.z};
+        int axis = -1;
+        for (int r = 0; r < 3; ++r)
+        {
+            if (std::fabs(components[r]) <= tolerance)
+                continue;
+            if (axis >= 0)
+                return false;
+            axis = r;
+        }
+        if (axis < 0 || used[axis])
+            return false;
+        used[axis] = true;
+        axisOfColumn[c] = axis;
+    }
+    return true;
+}
+
+static void addRotatedBox(const Mat4 &m, const GLubyte color[4])
+{
+    Mat4 normalMatrix = transpose(inverse(m));
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            float local[3] = {};
+            local[axis] = static_cast<float>(sign);
+            BakeQuad q;
+            q.normal = normalize(transformDirection(normalMatrix, Vec3(local[0], local[1], local[2])));
+            static const float corners[4][2] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+            for (int i = 0; i < 4; ++i)
+            {
+                const float *corner = corners[sign > 0 ? i : 3 - i];
+                local[axis] = 0.5f * sign;
+                local[u] = corner[0];
+                local[v] = corner[1];
+                q.corners[i] = transformPoint(m, Vec3(local[0], local[1], local[2]));
+            }
+            std::memcpy(q.color, color, sizeof(q.color));
+            recorded.quads.push_back(q);
+        }
+    }
+}
+
+void meshBakeBox(const Mat4 &modelview, const GLubyte color[4])
+{
+    int axisOfColumn[3];
+    if (!axisAligned(modelview, axisOfColumn))
+    {
+        addRotatedBox(modelview, color);
+        return;
+    }
+
+    const float center[3] = {modelview.m[12], modelview.m[13], modelview.m[14]};
+    BakeBox box;
+    for (int c = 0; c < 3; ++c)
+    {
+        int axis = axisOfColumn[c];
+        float half = 0.5f * length(modelview.column(c).xyz());
+        box.lo[axis] = center[axis] - half;
+        box.hi[axis] = center[axis] + half;
+    }
+    recorded.boxes.push_back(box);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int sign = -1; sign <= 1; sign += 2)
+            recorded.faces.push_back(bakeBoxFace(box, axis, sign, color));
+    }
+}
+
+static void removeHiddenFaces(MeshBakeRecording &recording, MeshBakeStats &stats)
+{
+    std::vector<BakeFace> &faces = recording.faces;
+    const std::vector<BakeBox> &boxes = recording.boxes;
+    size_t kept = 0;
+    for (size_t i = 0; i < faces.size(); ++i)
+    {
+        BakeFace f = faces[i];
+        if (bakeHideFace(f, boxes.data(), static_cast<int>(boxes.size())))
+        {
+            ++stats.facesRemoved;
+            continue;
+        }
+        if (f.trimmed)
+            ++stats.facesTrimmed;
+        faces[kept++] = f;
+    }
+    faces.resize(kept);
+}
+
+// Vertices are welded on position, normal and colour, quantised so that
+// float noise from different boxes does not keep them apart
+typedef std::array<long, 7> VertexKey;
+
+static GLuint weldVertex(BakedMesh &mesh, std::map<VertexKey, GLuint> &welded, const Vec3 &p, const Vec3 &n,
+                         const GLubyte color[4])
+{
+    long packedColor = (static_cast<long>(color[0]) << 24) | (color[1] << 16) | (color[2] << 8) | color[3];
+    VertexKey key = {std::lround(p.x / BAKE_EPSILON), std::lround(p.y / BAKE_EPSILON),
+                     std::lround(p.z / BAKE_EPSILON), std::lround(n.x * 1024.0f), std::lround(n.y * 1024.0f), std::lround(n.z * 1024.0f),
+                     packedColor};
+    auto found = welded.find(key);
+    if (found != welded.end())
+        return found->second;
+    BakedVertex vertex = {{p.x, p.y, p.z}, {n.x, n.y, n.z}, {color[0], color[1], color[2], color[3]}};
+    GLuint index = static_cast<GLuint>(mesh.vertices.size());
+    mesh.vertices.push_back(vertex);
+    welded[key] = index;
+    return index;
+}
+
+static void addQuad(BakedMesh &mesh, std::map<VertexKey, GLuint> &welded, const Vec3 corners[4], const Vec3 &normal,
+                    const GLubyte color[4])
+{
+    GLuint index[4];
+    for (int i = 0; i < 4; ++i)
+        index[i] = weldVertex(mesh, welded, corners[i], normal, color);
+    static const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for (int i : quad)
+        mesh.indices.push_back(index[i]);
+}
+
+void meshBakeTake(MeshBakeRecording &recording)
+{
+    baking = false;
+    recording = std::move(recorded);
+    recorded = MeshBakeRecording();
+}
+
+void meshBakeEnd(BakedMesh &mesh, MeshBakeStats &stats)
+{
+    MeshBakeRecording recording;
+    meshBakeTake(recording);
+    meshBakeBuild(recording, mesh, stats);
+}
+
+void meshBakeBuild(MeshBakeRecording &recording, BakedMesh &mesh, MeshBakeStats &stats)
+{
+    std::vector<BakeFace> &faces = recording.faces;
+    stats = MeshBakeStats();
+    stats.boxes = static_cast<int>(recording.boxes.size() + recording.quads.size() / 6);
+    stats.trianglesBefore = stats.boxes * 12;
+    stats.verticesBefore = stats.boxes * 24;
+
+    removeHiddenFaces(recording, stats);
+    faces.resize(bakeMergeFaces(faces.data(), static_cast<int>(faces.size()), stats.facesMerged));
+
+    mesh = BakedMesh();
+    mesh.id = meshBakeNewId();
+    std::map<VertexKey, GLuint> welded;
+    for (const BakeFace &f : faces)
+    {
+        if (bakeFaceEmpty(f))
+            continue;
+        float p[4][3], n[3];
+        bakeFaceCorners(f, p, n);
+        Vec3 corners[4];
+        for (int i = 0; i < 4; ++i)
+            corners[i] = Vec3(p[i][0], p[i][1], p[i][2]);
+        addQuad(mesh, welded, corners, Vec3(n[0], n[1], n[2]), f.color);
+    }
+    for (const BakeQuad &q : recording.quads)
+        addQuad(mesh, welded, q.corners, q.normal, q.color);
+
+    mesh.indexCount = static_cast<GLsizei>(mesh.indices.size());
+    if (!mesh.vertices.empty())
+    {
+        const GLfloat *first = mesh.vertices[0].position;
+        mesh.boundsMin = mesh.boundsMax = Vec3(first[0], first[1], first[2]);
+        for (const BakedVertex &vertex : mesh.vertices)
+        {
+            const GLfloat *p = vertex.position;
+            mesh.boundsMin = Vec3(std::min(mesh.boundsMin.x, p[0]), std::min(mesh.boundsMin.y, p[1]),
+                                  std::min(mesh.boundsMin.z, p[2]));
+            mesh.boundsMax = Vec3(std::max(mesh.boundsMax.x, p[0]), std::max(mesh.boundsMax.y, p[1]),
+                                  std::max(mesh.boundsMax.z, p[2]));
+        }
+    }
+    stats.trianglesAfter = mesh.indexCount / 3;
+    stats.verticesAfter = static_cast<int>(mesh.vertices.size());
+
+    recording = MeshBakeRecording();
+}
+
+static void setVertexAttribs()
+{
+    pglEnableVertexAttribArray(SHADER_ATTRIB_POSITION);
+    pglVertexAttribPointer(SHADER_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(BakedVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(BakedVertex, position)));
+    pglEnableVertexAttribArray(SHADER_ATTRIB_NORMAL);
+    pglVertexAttribPointer(SHADER_ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(BakedVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(BakedVertex, normal)));
+    pglEnableVertexAttribArray(SHADER_ATTRIB_COLOR);
+    pglVertexAttribPointer(SHADER_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BakedVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(BakedVertex, color)));
+}
+
+static void setPackedVertexAttribs()
+{
+    pglEnableVertexAttribArray(SHADER_ATTRIB_POSITION);
+    pglVertexAttribPointer(SHADER_ATTRIB_POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(PackedVertex, position)));
+    pglEnableVertexAttribArray(SHADER_ATTRIB_NORMAL);
+    pglVertexAttribPointer(SHADER_ATTRIB_NORMAL, 2, GL_BYTE, GL_TRUE, sizeof(PackedVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(PackedVertex, normal)));
+    pglEnableVertexAttribArray(SHADER_ATTRIB_COLOR);
+    pglVertexAttribPointer(SHADER_ATTRIB_COLOR, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(PackedVertex),
+                           reinterpret_cast<const GLvoid *>(offsetof(PackedVertex, color)));
+}
+
+const PackedVertex *bakedMeshPacked(const BakedMesh &mesh)
+{
+    return mesh.packedView ? mesh.packedView : mesh.packed.data();
+}
+
+size_t bakedMeshPackedCount(const BakedMesh &mesh)
+{
+    return mesh.packedView ? mesh.packedViewCount : mesh.packed.size();
+}
+
+static void uploadIndices(BakedMesh &mesh)
+{
+    size_t packedCount = bakedMeshPackedCount(mesh);
+    size_t vertexCount = packedCount == 0 ? mesh.vertices.size() : packedCount;
+    pglGenBuffers(1, &mesh.indexBuffer);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    if (mesh.indexView)
+    {
+        pglBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount * sizeof(GLushort), mesh.indexView, GL_STATIC_DRAW);
+        mesh.indexType = GL_UNSIGNED_SHORT;
+    }
+    else if (vertexCount <= 65536)
+    {
+        std::vector<GLushort> shortIndices(mesh.indices.begin(), mesh.indices.end());
+        pglBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(),
+                      GL_STATIC_DRAW);
+        mesh.indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        pglBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(GLuint), mesh.indices.data(),
+                      GL_STATIC_DRAW);
+        mesh.indexType = GL_UNSIGNED_INT;
+    }
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static GLuint uploadVertices(const void *data, size_t bytes)
+{
+    GLuint buffer = 0;
+    pglGenBuffers(1, &buffer);
+    pglBindBuffer(GL_ARRAY_BUFFER, buffer);
+    pglBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STATIC_DRAW);
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    return buffer;
+}
+
+static void uploadForShaders(BakedMesh &mesh)
+{
+    bool packed = bakedMeshPackedCount(mesh) > 0;
+    if (packed)
+    {
+        mesh.packedBuffer = uploadVertices(bakedMeshPacked(mesh), bakedMeshPackedCount(mesh) * sizeof(PackedVertex));
+        mesh.paletteBuffer = shaderPipelineCreatePalette(mesh.palette.data(), static_cast<int>(mesh.palette.size() / 4));
+    }
+    else if (mesh.vertexBuffer == 0)
+    {
+        mesh.vertexBuffer = uploadVertices(mesh.vertices.data(), mesh.vertices.size() * sizeof(BakedVertex));
+    }
+    pglGenVertexArrays(1, &mesh.vertexArray);
+    pglBindVertexArray(mesh.vertexArray);
+    pglBindBuffer(GL_ARRAY_BUFFER, packed ? mesh.packedBuffer : mesh.vertexBuffer);
+    if (packed)
+        setPackedVertexAttribs();
+    else
+        setVertexAttribs();
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    pglBindVertexArray(0);
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void drawWithShaders(BakedMesh &mesh, const Mat4 &modelview)
+{
+    bool packed = bakedMeshPackedCount(mesh) > 0;
+    if (mesh.vertexArray == 0)
+        uploadForShaders(mesh);
+    pglBindVertexArray(mesh.vertexArray);
+    shaderPipelineUse();
+    shaderPipelineSetModelview(modelview);
+    if (packed)
+        shaderPipelineSetPackedVertices(mesh.boundsMin, mesh.boundsMax - mesh.boundsMin, mesh.paletteBuffer);
+    glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, nullptr);
+    pglBindVertexArray(0);
+    shaderPipelineRelease();
+}
+
+// The fixed-function path needs full vertices; packed meshes are decoded
+static void unpackForLegacy(BakedMesh &mesh)
+{
+    size_t count = bakedMeshPackedCount(mesh);
+    if (!mesh.vertices.empty() || count == 0)
+        return;
+    const PackedVertex *packed = bakedMeshPacked(mesh);
+    mesh.vertices.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        mesh.vertices.push_back(unpackVertex(mesh, packed[i]));
+}
+
+static void uploadForLegacy(BakedMesh &mesh)
+{
+    unpackForLegacy(mesh);
+    mesh.vertexBuffer = uploadVertices(mesh.vertices.data(), mesh.vertices.size() * sizeof(BakedVertex));
+    if (bakedMeshPackedCount(mesh) > 0)
+        std::vector<BakedVertex>().swap(mesh.vertices); // Decoded only for the upload
+}
+
+size_t bakedMeshUpload(BakedMesh &mesh)
+{
+    if (mesh.indexCount == 0 || !glHasVertexBufferObject)
+        return 0;
+    size_t before = bakedMeshBytes(mesh);
+    if (mesh.indexBuffer == 0)
+        uploadIndices(mesh);
+    if (shaderPipelineActive() && mesh.vertexArray == 0)
+        uploadForShaders(mesh);
+    else if (!shaderPipelineActive() && mesh.vertexBuffer == 0)
+        uploadForLegacy(mesh);
+    size_t after = bakedMeshBytes(mesh);
+    return after > before ? after - before : 0;
+}
+
+void bakedMeshDraw(BakedMesh &mesh, const Mat4 &modelview)
+{
+    if (mesh.indexCount == 0)
+        return;
+    if (glHasVertexBufferObject && mesh.indexBuffer == 0)
+        uploadIndices(mesh);
+    if (shaderPipelineActive())
+    {
+        drawWithShaders(mesh, modelview);
+        profilerCount(PROFILE_DRAW_CALLS);
+        return;
+    }
+
+    const char *vertexBase = nullptr;
+    const GLvoid *indexBase = nullptr;
+    GLenum indexType = mesh.indexType;
+    if (mesh.indexBuffer == 0)
+    {
+        unpackForLegacy(mesh);
+        vertexBase = reinterpret_cast<const char *>(mesh.vertices.data());
+        indexBase = mesh.indexView ? static_cast<const GLvoid *>(mesh.indexView) : mesh.indices.data();
+        indexType = mesh.indexView ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+    else
+    {
+        if (mesh.vertexBuffer == 0)
+            uploadForLegacy(mesh);
+        pglBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    }
+    glLoadMatrixf(modelview.m);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(BakedVertex), vertexBase + offsetof(BakedVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(BakedVertex), vertexBase + offsetof(BakedVertex, normal));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BakedVertex), vertexBase + offsetof(BakedVertex, color));
+    glDrawElements(GL_TRIANGLES, mesh.indexCount, indexType, indexBase);
+    profilerCount(PROFILE_DRAW_CALLS);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (mesh.indexBuffer != 0)
+    {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void bakedMeshRelease(BakedMesh &mesh)
+{
+    if (mesh.vertexArray != 0)
+        pglDeleteVertexArrays(1, &mesh.vertexArray);
+    GLuint *buffers[] = {&mesh.vertexBuffer, &mesh.packedBuffer, &mesh.paletteBuffer, &mesh.indexBuffer};
+    for (GLuint *buffer : buffers)
+    {
+        if (*buffer != 0)
+            pglDeleteBuffers(1, buffer);
+        *buffer = 0;
+    }
+    mesh.vertexArray = 0;
+}
+
+size_t bakedMeshBytes(const BakedMesh &mesh)
+{
+    size_t packedCount = bakedMeshPackedCount(mesh);
+    size_t bytes = mesh.vertices.capacity() * sizeof(BakedVertex) + mesh.packed.capacity() * sizeof(PackedVertex) +
+                   mesh.palette.capacity() + mesh.indices.capacity() * sizeof(GLuint);
+    if (mesh.indexBuffer != 0)
+        bytes += mesh.indexCount * (mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+    if (mesh.vertexBuffer != 0)
+        bytes += (packedCount > 0 ? packedCount : mesh.vertices.size()) * sizeof(BakedVertex);
+    if (mesh.packedBuffer != 0)
+        bytes += packedCount * sizeof(PackedVertex);
+    if (mesh.paletteBuffer != 0)
+        bytes += mesh.palette.size();
+    return bytes;
+}
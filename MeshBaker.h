@@ -0,0 +1,124 @@
+#pragma once
+#include "BakeGeometry.h"
+#include "Math3D.h"
+#include <GL/glut.h>
+#include <vector>
+
+// Bakes static box geometry into one indexed mesh. Between meshBakeBegin and
+// meshBakeEnd the render queue hands every drawRectPrism/drawCube to the baker
+// instead of queueing it, in the space of the modelview at the time (load the
+// identity first to bake in local space). meshBakeEnd then optimises the boxes:
+//
+//   - faces whose outside lies inside another box are removed, or trimmed
+//     when the box covers them across their full width or height
+//   - coplanar faces of one colour that share a whole edge are merged
+//   - vertices with the same position, normal and colour are welded
+//
+// Only axis-aligned boxes take part; rotated ones are kept face for face.
+//
+// Recording needs the render queue and so the main thread; the optimising
+// does not. meshBakeTake hands the recording over for meshBakeBuild to run
+// anywhere, which is how streamed buildings bake on a worker thread.
+
+// Bump when baking or optimising changes the meshes produced, so mesh caches
+// (MeshCache.h) written by older builds read as stale
+const unsigned MESH_GENERATOR_VERSION = 1;
+
+struct BakedVertex
+{
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLubyte color[4];
+};
+
+// Compact form written by meshOptimize (MeshOptimizer.h)
+struct PackedVertex
+{
+    GLushort position[3]; // Fraction of the mesh bounds, 0-65535
+    GLbyte normal[2];     // Octahedral encoding
+    GLubyte color;        // Index into the mesh palette
+    GLubyte pad[3];       // Keeps the stride a multiple of 4
+};
+
+struct BakedMesh
+{
+    unsigned id; // Distinct per bake, used to group draws of one mesh
+    // Full vertices as baked. Once packed they are only rebuilt, from the
+    // packed ones, for the legacy path, which cannot decode them.
+    std::vector<BakedVertex> vertices;
+    std::vector<PackedVertex> packed;
+    std::vector<GLubyte> palette; // RGBA per entry
+    std::vector<GLuint> indices;
+    // Packed vertices and 16-bit indices held elsewhere - compile-time tables
+    // or a mapped mesh cache - used in place of packed and indices when set
+    const PackedVertex *packedView;
+    size_t packedViewCount;
+    const GLushort *indexView;
+    GLsizei indexCount;
+    Vec3 boundsMin, boundsMax;
+    // Created at first draw; 0 while drawing from client memory
+    GLuint vertexBuffer; // Full vertices
+    GLuint packedBuffer;
+    GLuint paletteBuffer;
+    GLuint indexBuffer;
+    GLenum indexType; // Of the index buffer; 16-bit when the vertices allow
+    GLuint vertexArray; // Shader pipeline only
+};
+
+struct MeshBakeStats
+{
+    int boxes;
+    int trianglesBefore; // As the cube batch would draw them
+    int trianglesAfter;
+    int verticesBefore;
+    int verticesAfter;
+    int facesRemoved; // Enclosed faces
+    int facesTrimmed;
+    int facesMerged;
+};
+
+// Face of a rotated box, kept as is
+struct BakeQuad
+{
+    Vec3 corners[4]; // Counter-clockwise seen from outside
+    Vec3 normal;
+    GLubyte color[4];
+};
+
+struct MeshBakeRecording
+{
+    std::vector<BakeBox> boxes;
+    std::vector<BakeFace> faces; // Six per box
+    std::vector<BakeQuad> quads;
+};
+
+// Id for a mesh built outside the baker (StaticBuildings.h); thread safe
+unsigned meshBakeNewId();
+void meshBakeBegin();
+bool meshBakeActive();
+// Records a unit cube under modelview (box scale included); called by the render queue
+void meshBakeBox(const Mat4 &modelview, const GLubyte color[4]);
+// Optimises the recorded boxes into mesh and stops recording
+void meshBakeEnd(BakedMesh &mesh, MeshBakeStats &stats);
+// Stops recording and moves what was recorded into recording
+void meshBakeTake(MeshBakeRecording &recording);
+// Optimises a taken recording into mesh, consuming it. Touches no GL or
+// baker state, so it may run on any thread.
+void meshBakeBuild(MeshBakeRecording &recording, BakedMesh &mesh, MeshBakeStats &stats);
+
+// Draws the mesh under modelview with the current state, on the shader
+// pipeline when it is active, from packed vertices if there are any. Leaves
+// GL's modelview changed.
+void bakedMeshDraw(BakedMesh &mesh, const Mat4 &modelview);
+
+// Creates the GL buffers the current pipeline draws the mesh from, which
+// drawing otherwise does the first time. Returns the bytes uploaded.
+size_t bakedMeshUpload(BakedMesh &mesh);
+// Deletes the mesh's GL buffers; it uploads again if drawn afterwards
+void bakedMeshRelease(BakedMesh &mesh);
+// Memory the mesh holds: its own vertex and index arrays plus its GL buffers
+size_t bakedMeshBytes(const BakedMesh &mesh);
+
+// Packed vertices of the mesh, from its view if it has one
+const PackedVertex *bakedMeshPacked(const BakedMesh &mesh);
+size_t bakedMeshPackedCount(const BakedMesh &mesh);
@@ -0,0 +1,358 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "ShaderPipeline.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+
+const uint32_t MESH_CACHE_BYTE_ORDER = 0x01020304;
+
+struct MeshCacheHeader
+{
+    char magic[4]; // "SCMC"
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t fileSize;
+    uint32_t generatorVersion;
+    uint32_t layoutKey[2]; // Low word first
+    uint32_t meshCount;    // Records follow the header
+};
+
+struct MeshCacheRecord
+{
+    BuildingShape shape;
+    char geometry[16];
+    uint32_t vertexOffset, vertexCount; // PackedVertex
+    uint32_t indexOffset, indexCount;   // GLushort
+    uint32_t paletteOffset, paletteColors;
+    float boundsMin[3], boundsMax[3];
+};
+
+static_assert(sizeof(MeshCacheHeader) == 32 && sizeof(MeshCacheRecord) == 104, "mesh cache records are part of the file format");
+
+// A mesh copied for the writer thread
+struct MeshCacheBlob
+{
+    MeshCacheRecord record;
+    std::vector<PackedVertex> vertices;
+    std::vector<GLushort> indices;
+    std::vector<GLubyte> palette;
+};
+
+struct MeshCacheResult
+{
+    bool ok;
+    size_t meshes, bytes;
+    double ms;
+};
+
+static std::string cachePath;
+static uint64_t cacheKey = 0;
+static MappedFile mapped = {};
+static const MeshCacheRecord *records = nullptr;
+static uint32_t recordCount = 0;
+static std::future<MeshCacheResult> writing;
+static bool replacePending = false; // A finished write waits beside the cache file
+
+uint64_t meshCacheLayoutKey(const void *image, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(image);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool recordInFile(const MeshCacheRecord &r, size_t fileSize)
+{
+    uint64_t vertexEnd = r.vertexOffset + static_cast<uint64_t>(r.vertexCount) * sizeof(PackedVertex);
+    uint64_t indexEnd = r.indexOffset + static_cast<uint64_t>(r.indexCount) * sizeof(GLushort);
+    uint64_t paletteEnd = r.paletteOffset + static_cast<uint64_t>(r.paletteColors) * 4;
+    return r.vertexOffset % 4 == 0 && r.indexOffset % 2 == 0 && vertexEnd <= fileSize && indexEnd <= fileSize &&
+           paletteEnd <= fileSize && r.vertexCount <= 65536 && r.paletteColors <= SHADER_PALETTE_SIZE &&
+           r.indexCount % 3 == 0;
+}
+
+static const char *checkCache(const MappedFile &file, uint64_t layoutKey)
+{
+    if (file.size < sizeof(MeshCacheHeader))
+        return "too small";
+    const MeshCacheHeader &header = *static_cast<const MeshCacheHeader *>(file.data);
+    if (std::memcmp(header.magic, "SCMC", 4) != 0 || header.byteOrder != MESH_CACHE_BYTE_ORDER ||
+        header.version != MESH_CACHE_VERSION || header.fileSize != file.size)
+        return "not a mesh cache of this version";
+    if (header.generatorVersion != MESH_GENERATOR_VERSION)
+        return "baked by another generator version";
+    if (header.layoutKey[0] != static_cast<uint32_t>(layoutKey) ||
+        header.layoutKey[1] != static_cast<uint32_t>(layoutKey >> 32))
+        return "baked for another layout";
+    if (sizeof(MeshCacheHeader) + static_cast<uint64_t>(header.meshCount) * sizeof(MeshCacheRecord) > file.size)
+        return "truncated";
+    const MeshCacheRecord *r = reinterpret_cast<const MeshCacheRecord *>(&header + 1);
+    for (uint32_t i = 0; i < header.meshCount; ++i)
+    {
+        if (!recordInFile(r[i], file.size))
+            return "damaged";
+    }
+    return nullptr;
+}
+
+static void useMapping(const MappedFile &file)
+{
+    mapped = file;
+    const MeshCacheHeader &header = *static_cast<const MeshCacheHeader *>(mapped.data);
+    records = reinterpret_cast<const MeshCacheRecord *>(&header + 1);
+    recordCount = header.meshCount;
+}
+
+bool meshCacheOpen(const char *path, uint64_t layoutKey)
+{
+    unmapFile(mapped);
+    records = nullptr;
+    recordCount = 0;
+    cachePath = path;
+    cacheKey = layoutKey;
+
+    MappedFile file;
+    if (!mapFile(path, file))
+    {
+        std::cout << "Mesh cache " << path << " not found, building it" << std::endl;
+        return false;
+    }
+    const char *problem = checkCache(file, layoutKey);
+    if (problem)
+    {
+        std::cout << "Mesh cache " << path << " is stale (" << problem << "), rebuilding it" << std::endl;
+        unmapFile(file);
+        return false;
+    }
+    useMapping(file);
+    std::cout << "Mesh cache " << path << ": " << recordCount << " meshes" << std::endl;
+    return true;
+}
+
+bool meshCacheEnabled()
+{
+    return !cachePath.empty();
+}
+
+void meshCacheRekey(uint64_t layoutKey)
+{
+    cacheKey = layoutKey;
+}
+
+bool meshCacheFind(const BuildingShape &shape, const char *geometry, BakedMesh &mesh)
+{
+    const unsigned char *base = static_cast<const unsigned char *>(mapped.data);
+    for (uint32_t i = 0; i < recordCount; ++i)
+    {
+        const MeshCacheRecord &r = records[i];
+        if (!sameBuildingShape(r.shape, shape) || std::strncmp(r.geometry, geometry, sizeof(r.geometry)) != 0)
+            continue;
+        const GLushort *indices = reinterpret_cast<const GLushort *>(base + r.indexOffset);
+        for (uint32_t k = 0; k < r.indexCount; ++k)
+        {
+            if (indices[k] >= r.vertexCount)
+                return false; // Damaged; bake instead
+        }
+        mesh = BakedMesh();
+        mesh.id = meshBakeNewId();
+        mesh.packedView = reinterpret_cast<const PackedVertex *>(base + r.vertexOffset);
+        mesh.packedViewCount = r.vertexCount;
+        mesh.indexView = indices;
+        mesh.indexCount = static_cast<GLsizei>(r.indexCount);
+        mesh.palette.assign(base + r.paletteOffset, base + r.paletteOffset + r.paletteColors * 4);
+        mesh.boundsMin = Vec3(r.boundsMin[0], r.boundsMin[1], r.boundsMin[2]);
+        mesh.boundsMax = Vec3(r.boundsMax[0], r.boundsMax[1], r.boundsMax[2]);
+        return true;
+    }
+    return false;
+}
+
+static void pad(std::vector<unsigned char> &image, size_t alignment)
+{
+    while (image.size() % alignment != 0)
+        image.push_back(0);
+}
+
+template <typename T>
+static uint32_t append(std::vector<unsigned char> &image, const std::vector<T> &data)
+{
+    pad(image, 4);
+    uint32_t offset = static_cast<uint32_t>(image.size());
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data.data());
+    image.insert(image.end(), bytes, bytes + data.size() * sizeof(T));
+    return offset;
+}
+
+static std::string temporaryPath()
+{
+    return cachePath + ".tmp";
+}
+
+// Writes beside the cache; meshCacheReplace moves it over once nothing maps the cache
+static MeshCacheResult writeCache(std::string temporary, uint64_t key, std::vector<MeshCacheBlob> blobs)
+{
+    auto start = std::chrono::steady_clock::now();
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, "SCMC", 4);
+    header.version = MESH_CACHE_VERSION;
+    header.byteOrder = MESH_CACHE_BYTE_ORDER;
+    header.generatorVersion = MESH_GENERATOR_VERSION;
+    header.layoutKey[0] = static_cast<uint32_t>(key);
+    header.layoutKey[1] = static_cast<uint32_t>(key >> 32);
+    header.meshCount = static_cast<uint32_t>(blobs.size());
+
+    std::vector<unsigned char> image(sizeof(MeshCacheHeader) + blobs.size() * sizeof(MeshCacheRecord), 0);
+    for (MeshCacheBlob &blob : blobs)
+    {
+        blob.record.vertexOffset = append(image, blob.vertices);
+        blob.record.indexOffset = append(image, blob.indices);
+        blob.record.paletteOffset = append(image, blob.palette);
+    }
+    pad(image, 4);
+    header.fileSize = static_cast<uint32_t>(image.size());
+    std::memcpy(image.data(), &header, sizeof(header));
+    for (size_t i = 0; i < blobs.size(); ++i)
+        std::memcpy(image.data() + sizeof(header) + i * sizeof(MeshCacheRecord), &blobs[i].record, sizeof(MeshCacheRecord));
+
+    bool ok = false;
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+        ok = static_cast<bool>(out);
+    }
+    if (!ok)
+        std::remove(temporary.c_str());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return {ok, blobs.size(), image.size(), ms};
+}
+
+void meshCacheWrite(const std::vector<MeshCacheItem> &items)
+{
+    if (!meshCacheEnabled() || meshCachePoll() || replacePending)
+        return;
+    std::vector<MeshCacheBlob> blobs;
+    for (const MeshCacheItem &item : items)
+    {
+        const BakedMesh &mesh = *item.mesh;
+        size_t vertexCount = bakedMeshPackedCount(mesh);
+        if (vertexCount == 0 || vertexCount > 65536)
+            continue;
+        MeshCacheBlob blob;
+        std::memset(&blob.record, 0, sizeof(blob.record));
+        blob.record.shape = item.shape;
+        std::strncpy(blob.record.geometry, item.geometry, sizeof(blob.record.geometry) - 1);
+        const PackedVertex *packed = bakedMeshPacked(mesh);
+        blob.vertices.assign(packed, packed + vertexCount);
+        if (mesh.indexView)
+            blob.indices.assign(mesh.indexView, mesh.indexView + mesh.indexCount);
+        else
+            blob.indices.assign(mesh.indices.begin(), mesh.indices.end());
+        blob.palette = mesh.palette;
+        blob.record.vertexCount = static_cast<uint32_t>(vertexCount);
+        blob.record.indexCount = static_cast<uint32_t>(blob.indices.size());
+        blob.record.paletteColors = static_cast<uint32_t>(mesh.palette.size() / 4);
+        const Vec3 *bounds[2] = {&mesh.boundsMin, &mesh.boundsMax};
+        float *out[2] = {blob.record.boundsMin, blob.record.boundsMax};
+        for (int k = 0; k < 2; ++k)
+        {
+            out[k][0] = bounds[k]->x;
+            out[k][1] = bounds[k]->y;
+            out[k][2] = bounds[k]->z;
+        }
+        blobs.push_back(std::move(blob));
+    }
+
+    // Meshes in the file but no longer in memory, such as shapes streamed
+    // out since, are carried over
+    std::unordered_set<uint64_t> written;
+    for (const MeshCacheItem &item : items)
+        written.insert(buildingShapeHash(item.shape, item.geometry));
+    const unsigned char *base = static_cast<const unsigned char *>(mapped.data);
+    for (uint32_t i = 0; i < recordCount; ++i)
+    {
+        const MeshCacheRecord &r = records[i];
+        std::string geometry(r.geometry, strnlen(r.geometry, sizeof(r.geometry)));
+        if (written.count(buildingShapeHash(r.shape, geometry.c_str())))
+            continue;
+        MeshCacheBlob blob;
+        blob.record = r;
+        const PackedVertex *vertices = reinterpret_cast<const PackedVertex *>(base + r.vertexOffset);
+        const GLushort *indices = reinterpret_cast<const GLushort *>(base + r.indexOffset);
+        blob.vertices.assign(vertices, vertices + r.vertexCount);
+        blob.indices.assign(indices, indices + r.indexCount);
+        blob.palette.assign(base + r.paletteOffset, base + r.paletteOffset + r.paletteColors * 4);
+        blobs.push_back(std::move(blob));
+    }
+    writing = std::async(std::launch::async, writeCache, temporaryPath(), cacheKey, std::move(blobs));
+}
+
+bool meshCachePoll()
+{
+    if (!writing.valid())
+        return false;
+    if (writing.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return true;
+    MeshCacheResult result = writing.get();
+    if (result.ok)
+    {
+        std::cout << "Wrote " << result.meshes << " meshes (" << result.bytes << " bytes) to " << cachePath
+                  << " in " << result.ms << " ms" << std::endl;
+        replacePending = true;
+    }
+    else
+        std::cout << "Cannot write the mesh cache " << cachePath << std::endl;
+    return false;
+}
+
+bool meshCacheReplacePending()
+{
+    return replacePending;
+}
+
+void meshCacheDetach(BakedMesh &mesh)
+{
+    const unsigned char *base = static_cast<const unsigned char *>(mapped.data);
+    const unsigned char *view = reinterpret_cast<const unsigned char *>(mesh.packedView);
+    if (!base || view < base || view >= base + mapped.size)
+        return;
+    mesh.packed.assign(mesh.packedView, mesh.packedView + mesh.packedViewCount);
+    mesh.indices.assign(mesh.indexView, mesh.indexView + mesh.indexCount);
+    mesh.packedView = nullptr;
+    mesh.packedViewCount = 0;
+    mesh.indexView = nullptr;
+}
+
+void meshCacheReplace()
+{
+    if (!replacePending)
+        return;
+    replacePending = false;
+    // Windows cannot replace a file that is open, so the old one goes first
+    unmapFile(mapped);
+    records = nullptr;
+    recordCount = 0;
+    std::string temporary = temporaryPath();
+    if (!replaceFile(temporary.c_str(), cachePath.c_str()))
+    {
+        std::cout << "Cannot replace the mesh cache " << cachePath << std::endl;
+        std::remove(temporary.c_str());
+    }
+    // Later lookups find the new meshes too
+    MappedFile file;
+    if (!mapFile(cachePath.c_str(), file))
+        return;
+    if (checkCache(file, cacheKey))
+        unmapFile(file);
+    else
+        useMapping(file);
+}
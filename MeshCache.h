@@ -0,0 +1,54 @@
+#pragma once
+#include "BuildingMesh.h"
+#include "MeshBaker.h"
+#include <cstdint>
+#include <vector>
+
+// Baked building meshes kept on disk between runs, so a restart does not bake
+// the same campus again. The file is keyed by a hash of the layout image and
+// MESH_GENERATOR_VERSION; any other key reads as stale and the cache is
+// rewritten from the meshes baked this run. The file stays mapped and cached
+// meshes point into it (BakedMesh views), so their first draw uploads straight
+// from the mapping; they copy out what they view before the file is replaced,
+// which is then unmapped, as Windows will not replace an open file. Records
+// are in host byte order behind a byte-order marker, like the layout file; a
+// foreign marker also reads as stale.
+
+const uint32_t MESH_CACHE_VERSION = 1; // File format, next to the generator version in the key
+
+// 64-bit FNV-1a of a layout image
+uint64_t meshCacheLayoutKey(const void *image, size_t size);
+
+// Maps path and keeps it if it holds meshes for this key. Remembers path for
+// meshCacheWrite either way; returns false when the cache must be rebuilt.
+bool meshCacheOpen(const char *path, uint64_t layoutKey);
+bool meshCacheEnabled();
+// Keys later writes to a reloaded layout. Cached meshes stay valid, as they
+// only depend on their shape.
+void meshCacheRekey(uint64_t layoutKey);
+
+// Points mesh at the cached mesh for shape from the named generator
+bool meshCacheFind(const BuildingShape &shape, const char *geometry, BakedMesh &mesh);
+
+struct MeshCacheItem
+{
+    BuildingShape shape;
+    const char *geometry;
+    const BakedMesh *mesh; // Packed, at most 65536 vertices; others are skipped
+};
+
+// Copies the meshes now and writes them beside the cache path on a background
+// thread, with those of the current file that items lack, for meshCacheReplace
+// to move over the file once complete. Ignored while a write is running or
+// waiting to replace the file.
+void meshCacheWrite(const std::vector<MeshCacheItem> &items);
+// Reports a finished write; true while one is still running
+bool meshCachePoll();
+// A finished write waits to replace the cache file
+bool meshCacheReplacePending();
+// Gives mesh its own copy of what it views in the cache file, if anything
+void meshCacheDetach(BakedMesh &mesh);
+// Unmaps the cache file, replaces it with the finished write and maps that;
+// lookups then read the new file. Every mesh found in the old file must have
+// been detached and no draw may still use it.
+void meshCacheReplace();
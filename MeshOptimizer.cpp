@@ -0,0 +1,281 @@
+#include "MeshOptimizer.h"
+#include "ShaderPipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Forsyth's scoring: the modelled LRU cache, the bonus for the vertices of the
+// triangle just emitted, and the decay of the score down the cache
+static const int FORSYTH_CACHE_SIZE = 32;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+static float vertexScore(int cachePosition, int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3),
+                             CACHE_DECAY_POWER);
+    }
+    // Vertices with few triangles left are finished off first
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+}
+
+static void forsythReorder(std::vector<GLuint> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles of each vertex; the first `remaining` of a vertex's run are
+    // the ones not emitted yet
+    std::vector<int> remaining(vertexCount, 0);
+    for (GLuint index : indices)
+        ++remaining[index];
+    std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    std::vector<int> vertexTriangles(indices.size());
+    std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        vertexTriangles[fill[indices[i]]++] = static_cast<int>(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[best])
+            best = static_cast<int>(t);
+    }
+
+    std::vector<GLuint> reordered;
+    reordered.reserve(indices.size());
+    std::vector<GLuint> cache;
+    std::vector<GLuint> grown;
+    size_t scanFrom = 0; // Every triangle before this has been emitted
+    while (best >= 0)
+    {
+        emitted[best] = true;
+        const GLuint *triangle = &indices[best * 3];
+        grown.assign(triangle, triangle + 3);
+        for (int k = 0; k < 3; ++k)
+        {
+            GLuint v = triangle[k];
+            reordered.push_back(v);
+            // Move the triangle past the vertex's live run
+            int *run = &vertexTriangles[firstTriangle[v]];
+            int *last = run + --remaining[v];
+            std::iter_swap(std::find(run, last + 1, best), last);
+        }
+
+        // The triangle's vertices go to the front of the cache
+        for (GLuint v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                grown.push_back(v);
+        }
+        for (size_t i = 0; i < grown.size(); ++i)
+        {
+            GLuint v = grown[i];
+            cachePosition[v] = i < static_cast<size_t>(FORSYTH_CACHE_SIZE) ? static_cast<int>(i) : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+        for (GLuint v : grown)
+        {
+            for (int i = 0; i < remaining[v]; ++i)
+            {
+                int t = vertexTriangles[firstTriangle[v] + i];
+                triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+            }
+        }
+        if (grown.size() > static_cast<size_t>(FORSYTH_CACHE_SIZE))
+            grown.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(grown);
+
+        // Next: the best triangle touching the cache, else the best anywhere
+        best = -1;
+        float bestScore = -1.0f;
+        for (GLuint v : cache)
+        {
+            for (int i = 0; i < remaining[v]; ++i)
+            {
+                int t = vertexTriangles[firstTriangle[v] + i];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        if (best < 0)
+        {
+            while (scanFrom < triangleCount && emitted[scanFrom])
+                ++scanFrom;
+            for (size_t t = scanFrom; t < triangleCount; ++t)
+            {
+                if (!emitted[t] && triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = static_cast<int>(t);
+                }
+            }
+        }
+    }
+    indices.swap(reordered);
+}
+
+// Renumbers vertices in the order the indices first use them
+static void reorderVertices(BakedMesh &mesh)
+{
+    std::vector<GLuint> remap(mesh.vertices.size(), ~0u);
+    std::vector<BakedVertex> ordered;
+    ordered.reserve(mesh.vertices.size());
+    for (GLuint &index : mesh.indices)
+    {
+        if (remap[index] == ~0u)
+        {
+            remap[index] = static_cast<GLuint>(ordered.size());
+            ordered.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(ordered);
+}
+
+float averageCacheMissRatio(const std::vector<GLuint> &indices, size_t vertexCount, int cacheSize)
+{
+    if (indices.size() < 3)
+        return 0.0f;
+    // A vertex is cached while fewer than cacheSize misses followed its own
+    std::vector<long> missNumber(vertexCount, -1);
+    long misses = 0;
+    for (GLuint index : indices)
+    {
+        if (missNumber[index] < 0 || misses - missNumber[index] >= cacheSize)
+            missNumber[index] = misses++;
+    }
+    return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+static GLbyte toSnorm8(float v)
+{
+    return static_cast<GLbyte>(std::lround(std::max(-1.0f, std::min(1.0f, v)) * 127.0f));
+}
+
+static void octahedralEncode(const GLfloat n[3], GLbyte out[2])
+{
+    float sum = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+    float x = n[0] / sum, y = n[1] / sum;
+    if (n[2] < 0.0f)
+    {
+        // Fold the lower hemisphere over the diagonals
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = toSnorm8(x);
+    out[1] = toSnorm8(y);
+}
+
+static Vec3 octahedralDecode(const GLbyte e[2])
+{
+    Vec3 n(std::max(e[0] / 127.0f, -1.0f), std::max(e[1] / 127.0f, -1.0f), 0.0f);
+    n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+static Vec3 boundsExtent(const BakedMesh &mesh)
+{
+    return mesh.boundsMax - mesh.boundsMin;
+}
+
+static bool packVertices(BakedMesh &mesh)
+{
+    std::vector<GLubyte> palette;
+    std::vector<PackedVertex> packed(mesh.vertices.size());
+    Vec3 extent = boundsExtent(mesh);
+    const float minimum[3] = {mesh.boundsMin.x, mesh.boundsMin.y, mesh.boundsMin.z};
+    const float size[3] = {extent.x, extent.y, extent.z};
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        const BakedVertex &vertex = mesh.vertices[i];
+        PackedVertex &p = packed[i];
+        std::memset(&p, 0, sizeof(p));
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float fraction = size[axis] > 0.0f ? (vertex.position[axis] - minimum[axis]) / size[axis] : 0.0f;
+            p.position[axis] = static_cast<GLushort>(std::lround(std::max(0.0f, std::min(1.0f, fraction)) * 65535.0f));
+        }
+        octahedralEncode(vertex.normal, p.normal);
+
+        size_t entry = 0;
+        while (entry * 4 < palette.size() && std::memcmp(&palette[entry * 4], vertex.color, 4) != 0)
+            ++entry;
+        if (entry * 4 == palette.size())
+        {
+            if (entry == static_cast<size_t>(SHADER_PALETTE_SIZE))
+                return false;
+            palette.insert(palette.end(), vertex.color, vertex.color + 4);
+        }
+        p.color = static_cast<GLubyte>(entry);
+    }
+    mesh.packed.swap(packed);
+    mesh.palette.swap(palette);
+    return true;
+}
+
+BakedVertex unpackVertex(const BakedMesh &mesh, const PackedVertex &packed)
+{
+    Vec3 extent = boundsExtent(mesh);
+    Vec3 normal = octahedralDecode(packed.normal);
+    const GLubyte *color = &mesh.palette[packed.color * 4];
+    BakedVertex vertex = {{mesh.boundsMin.x + packed.position[0] / 65535.0f * extent.x,
+                           mesh.boundsMin.y + packed.position[1] / 65535.0f * extent.y,
+                           mesh.boundsMin.z + packed.position[2] / 65535.0f * extent.z},
+                          {normal.x, normal.y, normal.z},
+                          {color[0], color[1], color[2], color[3]}};
+    return vertex;
+}
+
+void meshOptimize(BakedMesh &mesh, MeshOptimizeStats &stats)
+{
+    size_t vertexCount = mesh.vertices.size();
+    stats = MeshOptimizeStats();
+    stats.acmrBefore = averageCacheMissRatio(mesh.indices, vertexCount, VERTEX_CACHE_MEASURE_SIZE);
+    stats.bytesPerVertexBefore = sizeof(BakedVertex);
+    stats.bytesPerIndexBefore = sizeof(GLuint);
+
+    forsythReorder(mesh.indices, vertexCount);
+    reorderVertices(mesh);
+    stats.acmrAfter = averageCacheMissRatio(mesh.indices, vertexCount, VERTEX_CACHE_MEASURE_SIZE);
+    stats.bytesPerIndexAfter = vertexCount <= 65536 ? sizeof(GLushort) : sizeof(GLuint);
+
+    if (packVertices(mesh))
+    {
+        std::vector<BakedVertex>().swap(mesh.vertices);
+        stats.bytesPerVertexAfter = sizeof(PackedVertex);
+        stats.paletteSize = static_cast<int>(mesh.palette.size() / 4);
+    }
+    else
+    {
+        stats.bytesPerVertexAfter = sizeof(BakedVertex);
+    }
+}
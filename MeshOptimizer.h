@@ -0,0 +1,38 @@
+#pragma once
+#include "MeshBaker.h"
+#include <vector>
+
+// Post-processing for baked meshes, run once after meshBakeEnd:
+//
+//   - triangles are reordered for the post-transform vertex cache with
+//     Forsyth's linear-speed heuristic, then vertices renumbered in order of
+//     first use so fetches walk the buffer forwards
+//   - vertices are packed from 28 bytes to 12 (PackedVertex): positions
+//     quantised to 16 bits across the mesh bounds, normals octahedral in two
+//     bytes, colours an index into a palette of at most 256 entries
+//   - indices go out as 16-bit when the vertex count allows
+//
+// A mesh with more colours than the palette holds is reordered but stays
+// unpacked.
+
+struct MeshOptimizeStats
+{
+    float acmrBefore; // Cache misses per triangle
+    float acmrAfter;
+    int bytesPerVertexBefore;
+    int bytesPerVertexAfter;
+    int bytesPerIndexBefore;
+    int bytesPerIndexAfter;
+    int paletteSize; // 0 when left unpacked
+};
+
+// Size of the FIFO cache the miss ratio is measured with, a common hardware size
+const int VERTEX_CACHE_MEASURE_SIZE = 16;
+
+void meshOptimize(BakedMesh &mesh, MeshOptimizeStats &stats);
+
+// Average cache miss ratio of a triangle list through a FIFO cache
+float averageCacheMissRatio(const std::vector<GLuint> &indices, size_t vertexCount, int cacheSize);
+
+// Full-precision vertex of a packed mesh
+BakedVertex unpackVertex(const BakedMesh &mesh, const PackedVertex &packed);
@@ -0,0 +1,265 @@
+#include "OcclusionCulling.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "LayoutBvh.h"
+#include "MatrixStack.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+const unsigned OCCLUSION_RETEST_INTERVAL = 8; // Passes between queries on a visible building
+const float OCCLUSION_BOX_MARGIN = 0.25f;     // Keeps a box in front of its own walls in the depth buffer
+const float OCCLUSION_NEAR_MARGIN = 1.5f;     // Reach of the near plane's corners; a box this close may be clipped
+const int OCCLUSION_QUERY_BATCH = 256;        // Query names generated at a time
+
+struct OcclusionObject
+{
+    GLuint query;      // In flight, 0 if none
+    bool visible;      // As of the last result
+    unsigned lastPass; // Pass it was last in view in
+    unsigned since;    // Pass it came into view at; older results no longer apply
+};
+
+struct PendingQuery
+{
+    uint32_t aabb;
+    unsigned pass; // Issued after it
+};
+
+static bool available = false;
+static std::vector<OcclusionObject> objects; // Per AABB index
+static std::vector<GLuint> freeQueries;
+static std::vector<PendingQuery> pending; // In issue order, from head on
+static size_t head = 0;
+static std::vector<uint32_t> candidates; // In view this pass
+static unsigned pass = 0;
+static unsigned generation = 0;
+static Vec3 passEye;
+
+bool occlusionCullingInit()
+{
+    available = glHasOcclusionQuery;
+    if (!available)
+        std::cout << "Occlusion queries unavailable, drawing every building in view" << std::endl;
+    return available;
+}
+
+void occlusionCullingReset(uint32_t aabbCount)
+{
+    for (size_t i = head; i < pending.size(); ++i)
+        freeQueries.push_back(objects[pending[i].aabb].query); // Results of an in-flight query are never read
+    pending.clear();
+    head = 0;
+    candidates.clear();
+    OcclusionObject fresh = {0, true, 0, 0};
+    objects.assign(aabbCount, fresh);
+    ++generation;
+}
+
+void occlusionCullingRemap(const LayoutTableDiff &aabbs, uint32_t aabbCount)
+{
+    if (aabbs.remap.size() != objects.size())
+    {
+        occlusionCullingReset(aabbCount);
+        return;
+    }
+    OcclusionObject fresh = {0, true, 0, 0};
+    std::vector<OcclusionObject> remapped(aabbCount, fresh);
+    std::vector<bool> changed(aabbCount, false);
+    for (uint32_t i : aabbs.modified)
+        changed[i] = true;
+    std::vector<uint32_t> to(objects.size(), LAYOUT_NO_INDEX);
+    for (uint32_t i = 0; i < objects.size(); ++i)
+    {
+        uint32_t j = aabbs.remap[i];
+        if (j != LAYOUT_NO_INDEX && !changed[j])
+        {
+            remapped[j] = objects[i];
+            to[i] = j;
+        }
+    }
+
+    // Queries on objects that went away or changed are never read
+    std::vector<PendingQuery> kept;
+    for (size_t i = head; i < pending.size(); ++i)
+    {
+        PendingQuery entry = pending[i];
+        if (to[entry.aabb] == LAYOUT_NO_INDEX)
+        {
+            freeQueries.push_back(objects[entry.aabb].query);
+            continue;
+        }
+        entry.aabb = to[entry.aabb];
+        kept.push_back(entry);
+    }
+    pending.swap(kept);
+    head = 0;
+    candidates.clear();
+    objects.swap(remapped);
+    ++generation;
+}
+
+void occlusionCullingForget()
+{
+    for (OcclusionObject &o : objects)
+    {
+        o.visible = true;
+        o.since = pass + 1;
+    }
+    ++generation;
+}
+
+void occlusionCullingPoll()
+{
+    // Results arrive in submission order; stop at the first unfinished one
+    while (head < pending.size())
+    {
+        const PendingQuery &entry = pending[head];
+        OcclusionObject &o = objects[entry.aabb];
+        GLint ready = 0;
+        pglGetQueryObjectiv(o.query, GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready)
+            break;
+        GLint samples = 0;
+        pglGetQueryObjectiv(o.query, GL_QUERY_RESULT, &samples);
+        freeQueries.push_back(o.query);
+        o.query = 0;
+        ++head;
+        if (entry.pass < o.since)
+            continue;
+        bool visible = samples > 0;
+        if (visible && !o.visible)
+            ++generation; // Missing from the cached scene
+        o.visible = visible;
+    }
+    if (head > 0 && head * 2 >= pending.size())
+    {
+        pending.erase(pending.begin(), pending.begin() + head);
+        head = 0;
+    }
+}
+
+unsigned occlusionCullingGeneration()
+{
+    return generation;
+}
+
+bool occlusionCullingBegin(const Vec3 &eye)
+{
+    if (!available)
+        return false;
+    ++pass;
+    passEye = eye;
+    candidates.clear();
+    return true;
+}
+
+bool occlusionCullingDraw(uint32_t aabb)
+{
+    if (aabb >= objects.size())
+        return true;
+    OcclusionObject &o = objects[aabb];
+    if (o.lastPass + 1 != pass)
+    {
+        // Out of view since its last result, which came from elsewhere
+        o.visible = true;
+        o.since = pass;
+    }
+    o.lastPass = pass;
+    candidates.push_back(aabb);
+    profilerCount(PROFILE_OCCLUSION_TESTED);
+    if (!o.visible)
+        profilerCount(PROFILE_OCCLUDED);
+    return o.visible;
+}
+
+static GLuint takeQuery()
+{
+    if (freeQueries.empty())
+    {
+        GLuint names[OCCLUSION_QUERY_BATCH];
+        pglGenQueries(OCCLUSION_QUERY_BATCH, names);
+        freeQueries.insert(freeQueries.end(), names, names + OCCLUSION_QUERY_BATCH);
+    }
+    GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+}
+
+static void drawBox(const float *lo, const float *hi)
+{
+    const float x[2] = {lo[0], hi[0]}, y[2] = {lo[1], hi[1]}, z[2] = {lo[2], hi[2]};
+    glBegin(GL_QUADS);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            // The four corners of the face at this side of the axis, around it
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                int u = corner == 1 || corner == 2, v = corner >= 2;
+                int c[3];
+                c[axis] = side;
+                c[(axis + 1) % 3] = u;
+                c[(axis + 2) % 3] = v;
+                glVertex3f(x[c[0]], y[c[1]], z[c[2]]);
+            }
+        }
+    }
+    glEnd();
+}
+
+void occlusionCullingEnd(const CampusLayout &layout)
+{
+    if (!available)
+        return;
+    rcSyncModelview();
+    bool lighting = glsIsEnabled(GL_LIGHTING), culling = glsIsEnabled(GL_CULL_FACE);
+    glsDisable(GL_LIGHTING);
+    glsDisable(GL_CULL_FACE);
+    glsDepthMask(GL_FALSE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthFunc(GL_LEQUAL); // A visible building's box lies on its walls
+
+    for (uint32_t i : candidates)
+    {
+        OcclusionObject &o = objects[i];
+        if (o.query != 0 || (o.visible && (pass + i) % OCCLUSION_RETEST_INTERVAL != 0))
+            continue;
+        const LayoutAabb &aabb = layout.aabbs[i];
+        float lo[3], hi[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis] = aabb.min[axis] - OCCLUSION_BOX_MARGIN;
+            hi[axis] = aabb.max[axis] + OCCLUSION_BOX_MARGIN;
+        }
+        if (aabb.section == LAYOUT_BUILDINGS && aabb.index < layout.buildingCount)
+        {
+            // A label shows over a hidden roof, as in the BVH
+            const LayoutBuilding &b = layout.buildings[aabb.index];
+            hi[1] = std::max(hi[1], b.position[1] + b.size[1] + BUILDING_LABEL_CLEARANCE);
+        }
+        const float eye[3] = {passEye.x, passEye.y, passEye.z};
+        bool close = true;
+        for (int axis = 0; axis < 3; ++axis)
+            close = close && eye[axis] > lo[axis] - OCCLUSION_NEAR_MARGIN && eye[axis] < hi[axis] + OCCLUSION_NEAR_MARGIN;
+        if (close)
+        {
+            o.visible = true; // The near plane may cut into the box
+            continue;
+        }
+        o.query = takeQuery();
+        pglBeginQuery(GL_SAMPLES_PASSED, o.query);
+        drawBox(lo, hi);
+        pglEndQuery(GL_SAMPLES_PASSED);
+        pending.push_back({i, pass});
+    }
+
+    glDepthFunc(GL_LESS);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glsDepthMask(GL_TRUE);
+    glsSet(GL_CULL_FACE, culling);
+    glsSet(GL_LIGHTING, lighting);
+    candidates.clear();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "CampusLayout.h"
+#include "LayoutDiff.h"
+#include "Math3D.h"
+#include <cstdint>
+
+// Hardware occlusion culling of buildings, with temporal coherence in the
+// manner of coherent hierarchical culling. Each scene pass draws the
+// buildings in view that the last query on them found visible, and skips the
+// rest. Once the pass is drawn, the boxes of buildings that need a decision
+// are rasterized against its depth buffer with colour and depth writes off,
+// each inside a GL_SAMPLES_PASSED query: hidden buildings every pass, visible
+// ones every few passes, staggered. All of a pass's queries are issued in one
+// batch and only read back in later frames, once the GPU has them, so
+// culling never waits on it.
+//
+// The price is a frame or two of lag: a building coming out from behind
+// another shows once its query says so. A building entering the view, or in
+// view again after a gap, is drawn until queried, and a visible result for a
+// hidden building changes occlusionCullingGeneration so a cached scene is
+// redrawn.
+
+// Whether occlusion queries exist; call after glExtInit
+bool occlusionCullingInit();
+// Forgets everything about the previous layout, for one with this many AABBs
+void occlusionCullingReset(uint32_t aabbCount);
+// After a reload: keeps what is known of the objects that did not change,
+// under their new AABB indices, and draws the others until queried
+void occlusionCullingRemap(const LayoutTableDiff &aabbs, uint32_t aabbCount);
+// Draws everything again until queried anew, e.g. for a pixel-exact shot
+void occlusionCullingForget();
+
+// Once per frame, before deciding whether to redraw: takes the results the
+// GPU has finished, without waiting for the others
+void occlusionCullingPoll();
+// Changes whenever a hidden building is found visible
+unsigned occlusionCullingGeneration();
+
+// Starts a scene pass from this eye; false if culling is unavailable
+bool occlusionCullingBegin(const Vec3 &eye);
+// Whether to draw a building in view this pass, by its AABB index. Call once
+// per pass for each one that may be culled.
+bool occlusionCullingDraw(uint32_t aabb);
+// Issues the pass's queries against its finished depth buffer, under the
+// current modelview, which must hold the view
+void occlusionCullingEnd(const CampusLayout &layout);
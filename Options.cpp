@@ -0,0 +1,178 @@
+#include "Options.h"
+#include "RenderBackend.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+CampusOptions campusOptions = {
+    true,  // dynamicResolution
+    0.5f,  // resolutionScaleMin
+    1.0f,  // resolutionScaleMax
+    12.0f, // frameTargetMs
+    -1,    // qualityLevel
+    0,        // backend
+    {-1, -1}, // benchmarkBackends
+    nullptr,  // captureDir
+    nullptr,  // validateDir
+    3.0f,     // diffDeltaE
+    0.1f,     // diffMaxFailPercent
+    nullptr,  // layoutPath
+    true,     // watchLayout
+    nullptr,  // meshCachePath
+    400.0f,   // streamRadius
+    64.0f,    // streamBudgetMb
+    450.0f,   // impostorDistance
+    true,     // occlusionCulling
+    true,     // shadows
+};
+
+static void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "  --dynamic-resolution=0|1   Scale the 3D pass to hold the frame target (default 1)" << std::endl;
+    std::cout << "  --res-min=F                Lowest resolution scale per axis (default 0.5)" << std::endl;
+    std::cout << "  --res-max=F                Highest resolution scale per axis (default 1.0)" << std::endl;
+    std::cout << "  --frame-target-ms=F        GPU time budget for the 3D pass (default 12)" << std::endl;
+    std::cout << "  --quality=LEVEL            auto, low, medium, high or ultra (default auto)" << std::endl;
+    std::cout << "  --backend=NAME             legacy (fixed function) or shader (GL 3.3, default legacy)" << std::endl;
+    std::cout << "  --benchmark=A,B            Check B renders like A, compare their speed over a camera path, then exit" << std::endl;
+    std::cout << "  --capture=DIR              Write reference frames of the validation shots to DIR, then exit" << std::endl;
+    std::cout << "  --validate=DIR             Compare the validation shots with the references in DIR, then exit" << std::endl;
+    std::cout << "  --diff-delta-e=F           Colour difference a pixel may show (CIE76, default 3)" << std::endl;
+    std::cout << "  --diff-max-fail=F          Percentage of pixels allowed to fail (default 0.1)" << std::endl;
+    std::cout << "  --layout=FILE              Campus layout, text or compiled by tools/layoutc (default built-in)" << std::endl;
+    std::cout << "  --watch-layout=0|1         Reload the layout file whenever it changes (default 1)" << std::endl;
+    std::cout << "  --mesh-cache=FILE          Keep baked building meshes in FILE (default: the layout file + .meshes)" << std::endl;
+    std::cout << "  --stream-radius=F          Distance from the look-at drawn in full detail, 0 = everywhere (default 400)" << std::endl;
+    std::cout << "  --stream-budget-mb=F       Memory for building meshes before far chunks are dropped (default 64)" << std::endl;
+    std::cout << "  --impostor-distance=F      Zoomed out this far, draw the campus as pictures of itself, 0 = never (default 450)" << std::endl;
+    std::cout << "  --occlusion-culling=0|1    Skip buildings the last frames found hidden behind others (default 1)" << std::endl;
+    std::cout << "  --shadows=0|1              Sun shadows, redrawn only as the sun moves (default 1)" << std::endl;
+    std::cout << "  --help                     Show this message" << std::endl;
+}
+
+static bool parseQuality(const std::string &text, int &out)
+{
+    static const char *names[] = {"low", "medium", "high", "ultra"};
+    if (text == "auto")
+    {
+        out = -1;
+        return true;
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        if (text == names[i])
+        {
+            out = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseBackendPair(const std::string &text, int out[2])
+{
+    size_t comma = text.find(',');
+    if (comma == std::string::npos)
+        return false;
+    out[0] = renderBackendFind(text.substr(0, comma).c_str());
+    out[1] = renderBackendFind(text.substr(comma + 1).c_str());
+    return out[0] >= 0 && out[1] >= 0;
+}
+
+static bool parseFloat(const std::string &text, float &out)
+{
+    char *end = nullptr;
+    out = std::strtof(text.c_str(), &end);
+    return end && *end == '\0' && !text.empty();
+}
+
+bool parseCampusOptions(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string name = arg, value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos)
+        {
+            name = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        }
+
+        bool ok = true;
+        if (name == "--help")
+            ok = false;
+        else if (name == "--dynamic-resolution")
+            campusOptions.dynamicResolution = (value != "0");
+        else if (name == "--watch-layout")
+            campusOptions.watchLayout = (value != "0");
+        else if (name == "--occlusion-culling")
+            campusOptions.occlusionCulling = (value != "0");
+        else if (name == "--shadows")
+            campusOptions.shadows = (value != "0");
+        else if (name == "--res-min")
+            ok = parseFloat(value, campusOptions.resolutionScaleMin);
+        else if (name == "--res-max")
+            ok = parseFloat(value, campusOptions.resolutionScaleMax);
+        else if (name == "--frame-target-ms")
+            ok = parseFloat(value, campusOptions.frameTargetMs) && campusOptions.frameTargetMs > 0.0f;
+        else if (name == "--quality")
+            ok = parseQuality(value, campusOptions.qualityLevel);
+        else if (name == "--backend")
+        {
+            campusOptions.backend = renderBackendFind(value.c_str());
+            ok = campusOptions.backend >= 0;
+        }
+        else if (name == "--benchmark")
+            ok = parseBackendPair(value, campusOptions.benchmarkBackends);
+        else if (name == "--capture" || name == "--validate")
+        {
+            ok = !value.empty();
+            const char *dir = ok ? argv[i] + eq + 1 : nullptr; // Outlives parsing, unlike value
+            if (name == "--capture")
+                campusOptions.captureDir = dir;
+            else
+                campusOptions.validateDir = dir;
+        }
+        else if (name == "--layout" || name == "--mesh-cache")
+        {
+            ok = !value.empty();
+            const char *path = ok ? argv[i] + eq + 1 : nullptr;
+            if (name == "--layout")
+                campusOptions.layoutPath = path;
+            else
+                campusOptions.meshCachePath = path;
+        }
+        else if (name == "--stream-radius")
+            ok = parseFloat(value, campusOptions.streamRadius) && campusOptions.streamRadius >= 0.0f;
+        else if (name == "--stream-budget-mb")
+            ok = parseFloat(value, campusOptions.streamBudgetMb) && campusOptions.streamBudgetMb >= 0.0f;
+        else if (name == "--impostor-distance")
+            ok = parseFloat(value, campusOptions.impostorDistance) && campusOptions.impostorDistance >= 0.0f;
+        else if (name == "--diff-delta-e")
+            ok = parseFloat(value, campusOptions.diffDeltaE) && campusOptions.diffDeltaE >= 0.0f;
+        else if (name == "--diff-max-fail")
+            ok = parseFloat(value, campusOptions.diffMaxFailPercent) && campusOptions.diffMaxFailPercent >= 0.0f;
+        else
+        {
+            std::cout << "Unknown option: " << arg << std::endl;
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    CampusOptions &o = campusOptions;
+    if (o.resolutionScaleMin <= 0.0f || o.resolutionScaleMax > 1.0f || o.resolutionScaleMin > o.resolutionScaleMax)
+    {
+        std::cout << "Resolution scale bounds must satisfy 0 < res-min <= res-max <= 1" << std::endl;
+        return false;
+    }
+    return true;
+}
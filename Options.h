@@ -0,0 +1,40 @@
+#pragma once
+
+// Command-line settings, given as --name=value after any GLUT options
+struct CampusOptions
+{
+    // Dynamic resolution of the 3D pass, as a fraction of the window size per axis
+    bool dynamicResolution;
+    float resolutionScaleMin;
+    float resolutionScaleMax;
+    float frameTargetMs; // GPU time budget the governors aim for
+
+    int qualityLevel; // Fixed scene detail level, -1 = adapt to the frame target
+
+    int backend;              // Render backend index (RenderBackend.h)
+    int benchmarkBackends[2]; // A/B run to start with, -1 = none
+
+    // Pixel validation (Validation.h). Capture and validate run at startup and exit.
+    const char *captureDir;  // Write reference frames here
+    const char *validateDir; // Compare against the reference frames here
+    float diffDeltaE;        // Per-pixel tolerance, CIE76 delta E
+    float diffMaxFailPercent; // Failing pixels allowed per frame
+
+    const char *layoutPath; // Campus layout file, compiled or text, nullptr = built-in
+    bool watchLayout;       // Reload the layout file when it changes
+    const char *meshCachePath; // Baked mesh cache file, nullptr = beside the layout file (none for the built-in one)
+
+    // World streaming (WorldPartition.h)
+    float streamRadius;   // Chunks this near the look-at draw in detail, 0 = all of them
+    float streamBudgetMb; // Building meshes kept for chunks out of range
+
+    float impostorDistance; // Camera distance from which the campus is drawn as an impostor, 0 = never (CampusImpostor.h)
+    bool occlusionCulling;  // Skip buildings hidden behind others, going by GPU queries (OcclusionCulling.h)
+    bool shadows;           // Sun shadows from cached shadow maps (ShadowMap.h)
+};
+
+extern CampusOptions campusOptions;
+
+// Parses the arguments glutInit left behind. Prints usage and returns false
+// on --help or an unknown/invalid option.
+bool parseCampusOptions(int argc, char **argv);
@@ -0,0 +1,130 @@
+#include "Overdraw.h"
+#include "GLState.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static const float heatColors[OVERDRAW_LEVELS][3] = {
+    {0.0f, 0.0f, 0.0f},   // Never drawn
+    {0.0f, 0.0f, 0.45f},  // Once
+    {0.0f, 0.35f, 1.0f},
+    {0.0f, 0.75f, 0.75f},
+    {0.0f, 0.8f, 0.0f},
+    {0.9f, 0.9f, 0.0f},
+    {1.0f, 0.55f, 0.0f},
+    {1.0f, 0.0f, 0.0f},
+    {1.0f, 1.0f, 1.0f},   // OVERDRAW_LEVELS - 1 or more
+};
+
+static OverdrawStats stats = {0.0, 0, 0.0};
+static std::vector<unsigned char> counts;
+static bool missingReported = false;
+static std::chrono::steady_clock::time_point lastReport;
+
+bool overdrawBegin()
+{
+    GLint stencilBits = 0;
+    glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+    if (stencilBits == 0)
+    {
+        if (!missingReported)
+            std::cout << "Overdraw: no stencil buffer to count fragments in" << std::endl;
+        missingReported = true;
+        return false;
+    }
+    glClear(GL_STENCIL_BUFFER_BIT);
+    glsEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 0, 0xff);
+    glStencilOp(GL_INCR, GL_INCR, GL_INCR); // Depth-rejected fragments were rasterized too
+    return true;
+}
+
+static void readCounts(int width, int height)
+{
+    counts.resize(static_cast<size_t>(width) * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, counts.data());
+
+    size_t total = 0, heavy = 0;
+    int maximum = 0;
+    for (unsigned char c : counts)
+    {
+        total += c;
+        heavy += c >= OVERDRAW_HEAVY;
+        maximum = std::max(maximum, static_cast<int>(c));
+    }
+    double pixels = std::max<double>(static_cast<double>(counts.size()), 1.0);
+    stats.average = total / pixels;
+    stats.maximum = maximum;
+    stats.heavyShare = heavy / pixels;
+
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastReport).count() < 1.0)
+        return;
+    lastReport = now;
+    std::ostringstream line;
+    line << "Overdraw: " << std::fixed << std::setprecision(2) << stats.average << " fragments per pixel, "
+         << std::setprecision(1) << 100.0 * stats.heavyShare << "% of pixels drawn " << OVERDRAW_HEAVY
+         << " times or more, at most " << stats.maximum;
+    std::cout << line.str() << std::endl;
+}
+
+// One full-target quad per level, each landing only on pixels with its count
+static void drawHeatmap()
+{
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, 1, 0, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    bool blending = glsIsEnabled(GL_BLEND);
+    glsDisable(GL_LIGHTING);
+    glsDisable(GL_DEPTH_TEST);
+    glsDisable(GL_BLEND);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    for (int level = 0; level < OVERDRAW_LEVELS; ++level)
+    {
+        // The last level takes every count from its own up
+        glStencilFunc(level + 1 < OVERDRAW_LEVELS ? GL_EQUAL : GL_LEQUAL, level, 0xff);
+        glColor3fv(heatColors[level]);
+        glBegin(GL_QUADS);
+        glVertex2f(0, 0);
+        glVertex2f(1, 0);
+        glVertex2f(1, 1);
+        glVertex2f(0, 1);
+        glEnd();
+    }
+    glsSet(GL_BLEND, blending);
+    glsEnable(GL_DEPTH_TEST);
+    glsEnable(GL_LIGHTING);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+void overdrawEnd(int width, int height)
+{
+    readCounts(width, height);
+    drawHeatmap();
+    glStencilFunc(GL_ALWAYS, 0, 0xff);
+    glsDisable(GL_STENCIL_TEST);
+}
+
+const OverdrawStats &overdrawStats()
+{
+    return stats;
+}
+
+void overdrawColor(int count, float rgb[3])
+{
+    const float *color = heatColors[std::max(0, std::min(count, OVERDRAW_LEVELS - 1))];
+    std::copy(color, color + 3, rgb);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Overdraw view. While on, the 3D pass counts the fragments rasterized at
+// each pixel in the stencil buffer, whether or not they pass the depth test
+// (saturating at 255), and the counts replace the picture as a heatmap. The
+// counts are read back to report the average overdraw factor: fragments per
+// pixel of the pass, so 1.0 would mean every pixel was drawn exactly once.
+
+const int OVERDRAW_LEVELS = 9; // Heatmap colours: 0 to 7 fragments, then 8 or more
+const int OVERDRAW_HEAVY = 4;  // Fragments per pixel reported as heavy overdraw
+
+struct OverdrawStats
+{
+    double average; // Fragments per pixel
+    int maximum;
+    double heavyShare; // Fraction of pixels drawn OVERDRAW_HEAVY times or more
+};
+
+// Starts counting; call after the pass has cleared its target. False if the
+// bound framebuffer has no stencil buffer.
+bool overdrawBegin();
+// Reads the counts of the width x height pass back and draws the heatmap over it
+void overdrawEnd(int width, int height);
+
+// Of the last pass counted
+const OverdrawStats &overdrawStats();
+// Heatmap colour of a fragment count
+void overdrawColor(int count, float rgb[3]);
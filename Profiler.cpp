@@ -0,0 +1,230 @@
+#include "Profiler.h"
+#include "GLExt.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool profilerReporting = false;
+
+static const int QUERY_RING = 4; // Frames a query may stay in flight
+static const char *passNames[PROFILE_PASS_COUNT] = {"shadow", "scene", "composite", "hud"};
+static const char *counterNames[PROFILE_COUNTER_COUNT] = {"state changes", "skipped", "queued", "draws", "in view", "occluded"};
+
+typedef std::chrono::steady_clock ProfileClock;
+
+struct PassTimer
+{
+    GLuint queries[QUERY_RING];
+    bool pending[QUERY_RING];
+    int tags[QUERY_RING];
+    int next;     // Ring slot used by the next begin
+    int active;   // Slot currently recording, -1 if this frame is skipped
+    int oldest;   // Oldest slot that may still be pending
+    ProfileClock::time_point cpuStart;
+    double cpuMs;
+
+    double latestMs;
+    bool fresh;
+
+    double reportSumMs;
+    int reportCount;
+
+    double taggedSumMs[PROFILE_TAG_COUNT];
+    int taggedCount[PROFILE_TAG_COUNT];
+};
+
+static PassTimer timers[PROFILE_PASS_COUNT];
+static bool useQueries = false;
+static ProfileClock::time_point lastReport;
+static long counterTotals[PROFILE_COUNTER_COUNT];
+static int reportFrames = 0;
+static int currentTag = -1;
+
+void profilerInit()
+{
+    useQueries = glHasTimerQuery;
+    for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+    {
+        PassTimer &t = timers[p];
+        if (useQueries)
+            pglGenQueries(QUERY_RING, t.queries);
+        for (int i = 0; i < QUERY_RING; ++i)
+            t.pending[i] = false;
+        t.next = t.oldest = 0;
+        t.active = -1;
+        t.latestMs = 0.0;
+        t.cpuMs = 0.0;
+        t.fresh = false;
+        t.reportSumMs = 0.0;
+        t.reportCount = 0;
+    }
+    profilerResetTagged();
+    lastReport = ProfileClock::now();
+    if (!useQueries)
+        std::cout << "GPU timer queries unavailable, timing passes with glFinish" << std::endl;
+}
+
+const char *profilerPassName(ProfilePass pass)
+{
+    return passNames[pass];
+}
+
+static void recordSample(PassTimer &t, double ms, int tag)
+{
+    t.latestMs = ms;
+    t.fresh = true;
+    t.reportSumMs += ms;
+    ++t.reportCount;
+    if (tag >= 0)
+    {
+        t.taggedSumMs[tag] += ms;
+        ++t.taggedCount[tag];
+    }
+}
+
+void profilerBeginPass(ProfilePass pass)
+{
+    PassTimer &t = timers[pass];
+    if (!useQueries)
+    {
+        glFinish(); // Keep earlier work out of this pass's time
+        t.cpuStart = ProfileClock::now();
+        return;
+    }
+    t.cpuStart = ProfileClock::now();
+    if (t.pending[t.next])
+    {
+        t.active = -1; // Ring full; skip rather than wait on the GPU
+        return;
+    }
+    t.active = t.next;
+    t.tags[t.active] = currentTag;
+    t.next = (t.next + 1) % QUERY_RING;
+    pglBeginQuery(GL_TIME_ELAPSED, t.queries[t.active]);
+}
+
+void profilerEndPass(ProfilePass pass)
+{
+    PassTimer &t = timers[pass];
+    t.cpuMs = std::chrono::duration<double, std::milli>(ProfileClock::now() - t.cpuStart).count();
+    if (!useQueries)
+    {
+        glFinish();
+        recordSample(t, std::chrono::duration<double, std::milli>(ProfileClock::now() - t.cpuStart).count(), currentTag);
+        return;
+    }
+    if (t.active < 0)
+        return;
+    pglEndQuery(GL_TIME_ELAPSED);
+    t.pending[t.active] = true;
+    t.active = -1;
+}
+
+void profilerCount(ProfileCounter counter, int amount)
+{
+    counterTotals[counter] += amount;
+}
+
+void profilerEndFrame()
+{
+    ++reportFrames;
+    if (useQueries)
+    {
+        for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+        {
+            PassTimer &t = timers[p];
+            // Results arrive in submission order; stop at the first unfinished one
+            while (t.pending[t.oldest])
+            {
+                GLint available = 0;
+                pglGetQueryObjectiv(t.queries[t.oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    break;
+                GLuint64 ns = 0;
+                pglGetQueryObjectui64v(t.queries[t.oldest], GL_QUERY_RESULT, &ns);
+                recordSample(t, ns / 1.0e6, t.tags[t.oldest]);
+                t.pending[t.oldest] = false;
+                t.oldest = (t.oldest + 1) % QUERY_RING;
+            }
+        }
+    }
+
+    ProfileClock::time_point now = ProfileClock::now();
+    if (std::chrono::duration<double>(now - lastReport).count() < 1.0)
+        return;
+    lastReport = now;
+
+    if (profilerReporting)
+    {
+        std::ostringstream report;
+        report << "Profile:" << std::fixed << std::setprecision(2);
+        for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+        {
+            const PassTimer &t = timers[p];
+            report << " " << passNames[p] << " ";
+            if (t.reportCount > 0)
+                report << t.reportSumMs / t.reportCount << " ms";
+            else
+                report << "-";
+        }
+        report << " |";
+        for (int c = 0; c < PROFILE_COUNTER_COUNT; ++c)
+            report << " " << counterNames[c] << " " << std::setprecision(1)
+                   << static_cast<double>(counterTotals[c]) / reportFrames;
+        if (counterTotals[PROFILE_OCCLUSION_TESTED] > 0)
+            report << " (" << 100.0 * counterTotals[PROFILE_OCCLUDED] / counterTotals[PROFILE_OCCLUSION_TESTED]
+                   << "% occluded)";
+        report << " per frame";
+        std::cout << report.str() << std::endl;
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; ++c)
+        counterTotals[c] = 0;
+    reportFrames = 0;
+    for (int p = 0; p < PROFILE_PASS_COUNT; ++p)
+    {
+        timers[p].reportSumMs = 0.0;
+        timers[p].reportCount = 0;
+    }
+}
+
+bool profilerTakeSample(ProfilePass pass, double &ms)
+{
+    PassTimer &t = timers[pass];
+    if (!t.fresh)
+        return false;
+    t.fresh = false;
+    ms = t.latestMs;
+    return true;
+}
+
+double profilerCpuMs(ProfilePass pass)
+{
+    return timers[pass].cpuMs;
+}
+
+void profilerSetTag(int tag)
+{
+    currentTag = (tag >= 0 && tag < PROFILE_TAG_COUNT) ? tag : -1;
+}
+
+bool profilerTaggedMs(ProfilePass pass, int tag, double &ms)
+{
+    const PassTimer &t = timers[pass];
+    if (tag < 0 || tag >= PROFILE_TAG_COUNT || t.taggedCount[tag] == 0)
+        return false;
+    ms = t.taggedSumMs[tag] / t.taggedCount[tag];
+    return true;
+}
+
+void profilerResetTagged()
+{
+    for (PassTimer &t : timers)
+    {
+        for (int i = 0; i < PROFILE_TAG_COUNT; ++i)
+        {
+            t.taggedSumMs[i] = 0.0;
+            t.taggedCount[i] = 0;
+        }
+    }
+}
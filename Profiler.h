@@ -0,0 +1,56 @@
+#pragma once
+
+// Per-pass GPU timing with GL_TIME_ELAPSED queries. Results are read back a
+// few frames later, once available, so timing never stalls the pipeline.
+// Without timer queries a pass is timed on the CPU after glFinish instead.
+
+enum ProfilePass
+{
+    PROFILE_SHADOW,    // Shadow maps, when out of date (ShadowMap.h)
+    PROFILE_SCENE,     // 3D pass into the scene target
+    PROFILE_COMPOSITE, // Scene target upscaled into the window
+    PROFILE_HUD,       // Info boxes and mode text
+    PROFILE_PASS_COUNT
+};
+
+const char *profilerPassName(ProfilePass pass);
+
+// Creates the query objects; call after glExtInit
+void profilerInit();
+
+void profilerBeginPass(ProfilePass pass);
+void profilerEndPass(ProfilePass pass);
+
+// Collects finished queries and prints the periodic report; call once per frame
+void profilerEndFrame();
+
+// Returns true once for each newly measured GPU time of the pass
+bool profilerTakeSample(ProfilePass pass, double &ms);
+
+// CPU time spent submitting the pass the last time it ran
+double profilerCpuMs(ProfilePass pass);
+
+// GPU samples can be attributed to a tag, e.g. the backend of an A/B run.
+// A pass belongs to the tag set when it began; -1 leaves it untagged.
+const int PROFILE_TAG_COUNT = 2;
+void profilerSetTag(int tag);
+// Average GPU time of the pass over its samples with the tag; false if none
+bool profilerTaggedMs(ProfilePass pass, int tag, double &ms);
+void profilerResetTagged();
+
+// Per-frame event counts, reported as averages next to the pass times
+enum ProfileCounter
+{
+    PROFILE_STATE_CHANGES,    // GL state changes that reached the driver
+    PROFILE_STATE_SKIPPED,    // Redundant ones dropped by the state cache
+    PROFILE_QUEUED_ITEMS,     // Primitives submitted through the render queue
+    PROFILE_DRAW_CALLS,       // Draw calls for queued and ImmediateMode geometry
+    PROFILE_OCCLUSION_TESTED, // Buildings in view that occlusion queries decide on
+    PROFILE_OCCLUDED,         // Those left out because their last query found them hidden
+    PROFILE_COUNTER_COUNT
+};
+
+void profilerCount(ProfileCounter counter, int amount = 1);
+
+// Toggles the once-per-second report of average pass times on stdout
+extern bool profilerReporting;
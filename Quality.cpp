@@ -0,0 +1,106 @@
+#include "Quality.h"
+#include "Options.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const QualitySettings levels[] = {
+    // name      lod  clouds stars birds
+    {"low", -3, 4, 50, 1},
+    {"medium", -2, 6, 90, 2},
+    {"high", -1, 8, 120, 3},
+    {"ultra", 0, 10, 150, 4}, // Original effect counts, spheres at full LOD
+};
+const int QUALITY_LEVEL_COUNT = sizeof(levels) / sizeof(levels[0]);
+
+// Samples per decision window (median, like the resolution governor)
+static const int SAMPLES_PER_WINDOW = 20;
+// Hysteresis: step down after this many windows over budget, up after this
+// many well under it. The gap between the thresholds keeps it from flapping.
+static const int WINDOWS_TO_DROP = 2;
+static const int WINDOWS_TO_RAISE = 6;
+static const double OVER_BUDGET = 1.1;
+static const double UNDER_BUDGET = 0.6;
+
+static int currentLevel = QUALITY_LEVEL_COUNT - 1;
+static bool fixedLevel = false;
+static double samples[SAMPLES_PER_WINDOW];
+static int sampleCount = 0;
+static int overWindows = 0;
+static int underWindows = 0;
+
+void qualityInit()
+{
+    qualitySetFixed(campusOptions.qualityLevel);
+}
+
+const QualitySettings &qualitySettings()
+{
+    return levels[currentLevel];
+}
+
+int qualityLevel()
+{
+    return currentLevel;
+}
+
+void qualitySetFixed(int level)
+{
+    fixedLevel = level >= 0;
+    if (fixedLevel)
+        currentLevel = std::min(level, QUALITY_LEVEL_COUNT - 1);
+    sampleCount = overWindows = underWindows = 0;
+}
+
+bool qualityIsFixed()
+{
+    return fixedLevel;
+}
+
+bool qualityUpdate(double frameMs, bool resolutionAtMax)
+{
+    if (fixedLevel)
+        return false;
+
+    samples[sampleCount] = frameMs;
+    if (++sampleCount < SAMPLES_PER_WINDOW)
+        return false;
+    sampleCount = 0;
+
+    std::nth_element(samples, samples + SAMPLES_PER_WINDOW / 2, samples + SAMPLES_PER_WINDOW);
+    double median = samples[SAMPLES_PER_WINDOW / 2];
+    double target = campusOptions.frameTargetMs;
+
+    if (median > target * OVER_BUDGET)
+    {
+        ++overWindows;
+        underWindows = 0;
+    }
+    else if (median < target * UNDER_BUDGET && resolutionAtMax)
+    {
+        ++underWindows;
+        overWindows = 0;
+    }
+    else
+    {
+        overWindows = underWindows = 0;
+    }
+
+    int next = currentLevel;
+    if (overWindows >= WINDOWS_TO_DROP && currentLevel > 0)
+        next = currentLevel - 1;
+    else if (underWindows >= WINDOWS_TO_RAISE && currentLevel < QUALITY_LEVEL_COUNT - 1)
+        next = currentLevel + 1;
+    if (next == currentLevel)
+        return false;
+
+    std::ostringstream line;
+    line << "Quality: frame " << std::fixed << std::setprecision(2) << median << " ms "
+         << (next < currentLevel ? "over " : "under ") << target << " ms target, " << levels[currentLevel].name
+         << " -> " << levels[next].name;
+    std::cout << line.str() << std::endl;
+    currentLevel = next;
+    overWindows = underWindows = 0;
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Scene detail knobs, grouped into levels from cheapest to the original look
+struct QualitySettings
+{
+    const char *name;
+    int sphereLodBias; // Added to the projected-size sphere LOD, negative = coarser
+    int cloudCount;
+    int starCount;
+    int birdCount;
+};
+
+extern const int QUALITY_LEVEL_COUNT;
+
+// Picks the starting level from CampusOptions (fixed level or auto)
+void qualityInit();
+
+// Settings of the current level
+const QualitySettings &qualitySettings();
+int qualityLevel();
+
+// -1 = adapt automatically, otherwise hold that level (for benchmarking)
+void qualitySetFixed(int level);
+bool qualityIsFixed();
+
+// Adds one frame cost sample. Steps down after sustained overruns and up after
+// a longer run of headroom (only when dynamic resolution is already at its
+// highest scale). Returns true if the level changed.
+bool qualityUpdate(double frameMs, bool resolutionAtMax);
@@ -0,0 +1,71 @@
+#include "RenderBackend.h"
+#include "ShaderPipeline.h"
+#include <cstring>
+
+static bool legacyAvailable()
+{
+    return true;
+}
+
+static void legacyActivate(bool)
+{
+    // Fixed function is what every submission path does without a pipeline
+}
+
+static const RenderBackend backends[] = {
+    {"legacy", "fixed-function lighting, client arrays and glBegin/glEnd", legacyAvailable, legacyActivate},
+    {"shader", "GL 3.3 programs, vertex arrays, uniform buffers and instancing", shaderPipelineAvailable,
+     shaderPipelineSetActive},
+};
+static const int BACKEND_COUNT = sizeof(backends) / sizeof(backends[0]);
+
+static int current = 0;
+
+int renderBackendCount()
+{
+    return BACKEND_COUNT;
+}
+
+const RenderBackend &renderBackendInfo(int index)
+{
+    return backends[index];
+}
+
+int renderBackendFind(const char *name)
+{
+    for (int i = 0; i < BACKEND_COUNT; ++i)
+    {
+        if (std::strcmp(backends[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+bool renderBackendSelect(int index)
+{
+    if (index < 0 || index >= BACKEND_COUNT || !backends[index].available())
+        return false;
+    if (index != current)
+    {
+        backends[current].activate(false);
+        current = index;
+    }
+    backends[current].activate(true);
+    return true;
+}
+
+int renderBackendCurrent()
+{
+    return current;
+}
+
+int renderBackendNext()
+{
+    for (int step = 1; step < BACKEND_COUNT; ++step)
+    {
+        int index = (current + step) % BACKEND_COUNT;
+        if (backends[index].available())
+            return index;
+    }
+    return current;
+}
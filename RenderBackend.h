@@ -0,0 +1,25 @@
+#pragma once
+
+// The ways the campusDisplay passes can reach GL. Scene, composite and HUD
+// code is shared; the selected backend decides how the primitives it emits
+// (render queue, cube batch, sphere meshes, ImmediateMode) are submitted.
+// Selecting by index or name allows switching at runtime for comparisons.
+struct RenderBackend
+{
+    const char *name;
+    const char *description;
+    bool (*available)(); // Valid after the GL setup in campusInit
+    void (*activate)(bool active);
+};
+
+int renderBackendCount();
+const RenderBackend &renderBackendInfo(int index);
+// Index of the backend called name, -1 if there is none
+int renderBackendFind(const char *name);
+
+// Makes a backend current. Returns false and keeps the current one if it is
+// unavailable on this GL.
+bool renderBackendSelect(int index);
+int renderBackendCurrent();
+// Next available backend after the current one, wrapping around
+int renderBackendNext();
@@ -0,0 +1,258 @@
+#include "RenderQueue.h"
+#include "CubeBatch.h"
+#include "GLState.h"
+#include "MeshBaker.h"
+#include "MatrixStack.h"
+#include "Profiler.h"
+#include "SphereMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+enum PrimitiveKind
+{
+    PRIMITIVE_CUBE,
+    PRIMITIVE_SPHERE,
+    PRIMITIVE_MESH
+};
+
+struct RenderRecord
+{
+    Mat4 modelview; // Includes the box or sphere scale
+    GLubyte color[4];
+    uint8_t kind;
+    uint8_t lit;
+    uint8_t lod;
+    BakedMesh *mesh;
+};
+
+static std::vector<RenderRecord> records;
+static std::vector<RenderItem> items;
+static std::vector<RenderItem> scratch;
+static GLfloat currentColor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+uint64_t renderSortKey(RenderPass pass, unsigned material, float depth)
+{
+    // Non-negative floats order the same as their bit patterns
+    float d = std::max(depth, 0.0f);
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &d, sizeof(depthBits));
+    if (pass == RENDER_PASS_TRANSPARENT)
+        depthBits = ~depthBits;
+    return (static_cast<uint64_t>(pass) << 62) | (static_cast<uint64_t>(material & 0x3FFF) << 48) |
+           (static_cast<uint64_t>(depthBits) << 16);
+}
+
+void radixSortRenderItems(std::vector<RenderItem> &items, std::vector<RenderItem> &scratch)
+{
+    size_t n = items.size();
+    if (n < 2)
+        return;
+    scratch.resize(n);
+    RenderItem *src = items.data();
+    RenderItem *dst = scratch.data();
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[256] = {};
+        for (size_t i = 0; i < n; ++i)
+            ++offsets[(src[i].key >> shift) & 0xFF];
+        if (offsets[(src[0].key >> shift) & 0xFF] == n)
+            continue; // Every key has this digit
+        size_t total = 0;
+        for (size_t &offset : offsets)
+        {
+            size_t count = offset;
+            offset = total;
+            total += count;
+        }
+        for (size_t i = 0; i < n; ++i)
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != items.data())
+        std::copy(src, src + n, items.data());
+}
+
+void renderQueueBegin()
+{
+    records.clear();
+    items.clear();
+    glGetFloatv(GL_CURRENT_COLOR, currentColor);
+}
+
+static GLubyte toByte(float c)
+{
+    return static_cast<GLubyte>(std::lround(std::min(1.0f, std::max(0.0f, c)) * 255.0f));
+}
+
+static float axisLength(const Mat4 &m, int axis)
+{
+    return length(m.column(axis).xyz());
+}
+
+static void record(PrimitiveKind kind, const Mat4 &modelview, const Vec3 &center, float boundingRadius, int lod,
+                   BakedMesh *mesh = nullptr)
+{
+    if (!rcEyeSphereVisible(center, boundingRadius))
+        return;
+
+    RenderRecord r;
+    r.modelview = modelview;
+    for (int i = 0; i < 4; ++i)
+        r.color[i] = toByte(currentColor[i]);
+    r.kind = static_cast<uint8_t>(kind);
+    r.lit = glsIsEnabled(GL_LIGHTING) ? 1 : 0;
+    r.lod = static_cast<uint8_t>(lod);
+    r.mesh = mesh;
+
+    RenderPass pass = r.color[3] < 255 && !mesh ? RENDER_PASS_TRANSPARENT : RENDER_PASS_OPAQUE;
+    // Transparent work must follow depth alone, so it carries no material
+    unsigned variant = mesh ? mesh->id : r.lod;
+    unsigned material = pass == RENDER_PASS_OPAQUE ? (kind << 12) | (r.lit << 11) | (variant & 0x7FF) : 0;
+    RenderItem item;
+    item.key = renderSortKey(pass, material, -center.z);
+    item.record = static_cast<uint32_t>(records.size());
+    records.push_back(r);
+    items.push_back(item);
+}
+
+static Vec3 origin(const Mat4 &m)
+{
+    return Vec3(m.m[12], m.m[13], m.m[14]);
+}
+
+void renderQueueCube(float w, float h, float d)
+{
+    Mat4 m = rcModelview() * mat4Scale(w, h, d);
+    if (meshBakeActive())
+    {
+        GLubyte color[4];
+        for (int i = 0; i < 4; ++i)
+            color[i] = toByte(currentColor[i]);
+        meshBakeBox(m, color);
+        return;
+    }
+    // Half the sum of the edge vectors bounds the box
+    record(PRIMITIVE_CUBE, m, origin(m), 0.5f * (axisLength(m, 0) + axisLength(m, 1) + axisLength(m, 2)), 0);
+}
+
+void renderQueueSphere(int lod, float radius)
+{
+    Mat4 m = rcModelview() * mat4Scale(radius, radius, radius);
+    record(PRIMITIVE_SPHERE, m, origin(m), std::max(axisLength(m, 0), std::max(axisLength(m, 1), axisLength(m, 2))),
+           lod);
+}
+
+void renderQueueMesh(BakedMesh &mesh)
+{
+    const Mat4 &m = rcModelview();
+    Vec3 center = transformPoint(m, (mesh.boundsMin + mesh.boundsMax) * 0.5f);
+    float radius = 0.5f * length(mesh.boundsMax - mesh.boundsMin) *
+                   std::max(axisLength(m, 0), std::max(axisLength(m, 1), axisLength(m, 2)));
+    record(PRIMITIVE_MESH, m, center, radius, 0, &mesh);
+}
+
+// Consecutive items of one primitive and lighting state
+struct Run
+{
+    int kind; // -1 = none
+    int lit;
+    int boundLod;
+};
+
+static void endRun(Run &run)
+{
+    if (run.kind == PRIMITIVE_CUBE)
+    {
+        cubeBatchDraw();
+    }
+    else if (run.kind == PRIMITIVE_SPHERE && run.boundLod >= 0)
+    {
+        sphereMeshUnbind();
+    }
+    run.kind = -1;
+    run.boundLod = -1;
+}
+
+void renderQueueFlush()
+{
+    if (items.empty())
+        return;
+    profilerCount(PROFILE_QUEUED_ITEMS, static_cast<int>(items.size()));
+    radixSortRenderItems(items, scratch);
+
+    bool lightingBefore = glsIsEnabled(GL_LIGHTING);
+    bool blendBefore = glsIsEnabled(GL_BLEND);
+    RenderPass pass = RENDER_PASS_OPAQUE;
+    Run run = {-1, 0, -1};
+    for (const RenderItem &item : items)
+    {
+        const RenderRecord &r = records[item.record];
+        RenderPass itemPass = static_cast<RenderPass>(item.key >> 62);
+        if (itemPass != pass)
+        {
+            endRun(run);
+            pass = itemPass;
+            glsEnable(GL_BLEND);
+            glsDepthMask(GL_FALSE);
+        }
+        if (r.kind != run.kind || r.lit != run.lit)
+        {
+            endRun(run);
+            run.kind = r.kind;
+            run.lit = r.lit;
+            glsSet(GL_LIGHTING, r.lit != 0);
+        }
+
+        if (r.kind == PRIMITIVE_CUBE)
+        {
+            cubeBatchAppend(r.modelview, r.color);
+        }
+        else if (r.kind == PRIMITIVE_MESH)
+        {
+            bakedMeshDraw(*r.mesh, r.modelview);
+        }
+        else
+        {
+            if (run.boundLod != r.lod)
+            {
+                if (run.boundLod >= 0)
+                    sphereMeshUnbind();
+                sphereMeshBind(r.lod);
+                run.boundLod = r.lod;
+            }
+            sphereMeshDrawBound(r.modelview, r.color);
+        }
+    }
+    endRun(run);
+
+    if (pass == RENDER_PASS_TRANSPARENT)
+    {
+        glsDepthMask(GL_TRUE);
+        glsSet(GL_BLEND, blendBefore);
+    }
+    glsSet(GL_LIGHTING, lightingBefore);
+    glColor4fv(currentColor); // Undefined after drawing with a colour array
+    rcModelviewChanged();
+    records.clear();
+    items.clear();
+}
+
+void rcColor3f(float r, float g, float b)
+{
+    rcColor4f(r, g, b, 1.0f);
+}
+
+void rcColor4f(float r, float g, float b, float a)
+{
+    glColor4f(r, g, b, a);
+    currentColor[0] = r;
+    currentColor[1] = g;
+    currentColor[2] = b;
+    currentColor[3] = a;
+}
+
+const GLfloat *rcCurrentColor()
+{
+    return currentColor;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <GL/glut.h>
+#include <cstdint>
+#include <vector>
+
+struct BakedMesh;
+
+// Deferred submission of the scene's cubes, spheres and baked meshes. Each
+// draw is recorded with its transform (from MatrixStack), colour, lighting
+// state and a 64-bit sort key, radix-sorted at flush and submitted so that
+// state changes are grouped and depth order suits the pass:
+//
+//   bits 63-62  pass      opaque before transparent
+//   bits 61-48  material  primitive, lighting, sphere LOD or mesh (0 for
+//                         transparent)
+//   bits 47-16  depth     eye distance as float bits; inverted for transparent
+//                         so it runs back to front, front to back otherwise
+//   bits 15-0   unused
+//
+// Anything drawn with alpha < 1 goes to the transparent pass, which the queue
+// draws with blending on and depth writes off. Immediate-mode geometry is not
+// queued and is drawn as it is issued.
+
+enum RenderPass
+{
+    RENDER_PASS_OPAQUE,
+    RENDER_PASS_TRANSPARENT
+};
+
+struct RenderItem
+{
+    uint64_t key;
+    uint32_t record; // Index into the queue's per-primitive records
+};
+
+uint64_t renderSortKey(RenderPass pass, unsigned material, float depth);
+
+// Stable LSD radix sort by key, 8 bits per pass; digits that are the same in
+// every key are skipped. scratch is resized as needed.
+void radixSortRenderItems(std::vector<RenderItem> &items, std::vector<RenderItem> &scratch);
+
+// Starts recording; call once per 3D pass after the view is loaded
+void renderQueueBegin();
+// Sorts and submits everything recorded, then empties the queue
+void renderQueueFlush();
+
+// Records a w x h x d box centred at the current modelview origin, or hands
+// it to the mesh baker while one is baking (MeshBaker.h)
+void renderQueueCube(float w, float h, float d);
+// Records a sphere mesh level scaled to radius at the current modelview origin
+void renderQueueSphere(int lod, float radius);
+// Records a baked mesh under the current modelview. Its vertex colours are
+// used and it is drawn opaque.
+void renderQueueMesh(BakedMesh &mesh);
+
+// Current colour, recorded with every queued primitive
+void rcColor3f(float r, float g, float b);
+void rcColor4f(float r, float g, float b, float a);
+const GLfloat *rcCurrentColor();
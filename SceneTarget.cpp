@@ -0,0 +1,179 @@
+#include "SceneTarget.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include <iostream>
+
+static GLuint sceneFbo = 0;
+static GLuint sceneColorTex = 0;
+static GLuint sceneDepthRb = 0;
+static int targetWidth = 0, targetHeight = 0; // Scaled render size
+static int windowWidth = 0, windowHeight = 0;
+static float targetScale = 1.0f;
+static bool targetAvailable = false;
+static bool targetValid = false;
+
+static void destroyTarget()
+{
+    if (sceneFbo)
+        pglDeleteFramebuffers(1, &sceneFbo);
+    if (sceneDepthRb)
+        pglDeleteRenderbuffers(1, &sceneDepthRb);
+    if (sceneColorTex)
+        glDeleteTextures(1, &sceneColorTex);
+    sceneFbo = sceneDepthRb = sceneColorTex = 0;
+    targetAvailable = false;
+    targetValid = false;
+}
+
+static int scaledSize(int size)
+{
+    int s = static_cast<int>(size * targetScale + 0.5f);
+    return s < 1 ? 1 : s;
+}
+
+static bool createTarget(int winW, int winH)
+{
+    destroyTarget();
+    windowWidth = winW;
+    windowHeight = winH;
+    if (!glHasFramebufferObject || winW <= 0 || winH <= 0)
+        return false;
+    int width = scaledSize(winW);
+    int height = scaledSize(winH);
+
+    glGenTextures(1, &sceneColorTex);
+    glBindTexture(GL_TEXTURE_2D, sceneColorTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    pglGenRenderbuffers(1, &sceneDepthRb);
+    pglBindRenderbuffer(GL_RENDERBUFFER, sceneDepthRb);
+    pglRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    pglBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    pglGenFramebuffers(1, &sceneFbo);
+    pglBindFramebuffer(GL_FRAMEBUFFER, sceneFbo);
+    pglFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColorTex, 0);
+    pglFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRb);
+    pglFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRb);
+    GLenum status = pglCheckFramebufferStatus(GL_FRAMEBUFFER);
+    pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Scene framebuffer incomplete (0x" << std::hex << status << std::dec
+                  << "), rendering directly to the window" << std::endl;
+        destroyTarget();
+        return false;
+    }
+
+    targetWidth = width;
+    targetHeight = height;
+    targetAvailable = true;
+    return true;
+}
+
+bool sceneTargetInit(int width, int height)
+{
+    return createTarget(width, height);
+}
+
+void sceneTargetResize(int width, int height)
+{
+    if (!glHasFramebufferObject)
+        return;
+    if (targetAvailable && width == windowWidth && height == windowHeight)
+        return;
+    createTarget(width, height);
+}
+
+void sceneTargetSetScale(float scale)
+{
+    targetScale = scale;
+    if (!glHasFramebufferObject)
+        return;
+    if (targetAvailable && scaledSize(windowWidth) == targetWidth && scaledSize(windowHeight) == targetHeight)
+        return;
+    createTarget(windowWidth, windowHeight);
+}
+
+void sceneTargetSize(int &width, int &height)
+{
+    width = targetWidth;
+    height = targetHeight;
+}
+
+bool sceneTargetAvailable()
+{
+    return targetAvailable;
+}
+
+bool sceneTargetValid()
+{
+    return targetAvailable && targetValid;
+}
+
+void sceneTargetInvalidate()
+{
+    targetValid = false;
+}
+
+void sceneTargetBegin()
+{
+    targetValid = false;
+    pglBindFramebuffer(GL_FRAMEBUFFER, sceneFbo);
+    glViewport(0, 0, targetWidth, targetHeight);
+}
+
+void sceneTargetEnd()
+{
+    pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowWidth, windowHeight);
+    targetValid = true;
+}
+
+void sceneTargetComposite()
+{
+    // Linear filtering upscales a reduced-resolution render to the window
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, 1, 0, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    bool blending = glsIsEnabled(GL_BLEND); // The HUD drawn after blends
+    glsDisable(GL_LIGHTING);
+    glsDisable(GL_DEPTH_TEST);
+    glsDisable(GL_BLEND);
+    glsEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, sceneColorTex);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0);
+    glVertex2f(0, 0);
+    glTexCoord2f(1, 0);
+    glVertex2f(1, 0);
+    glTexCoord2f(1, 1);
+    glVertex2f(1, 1);
+    glTexCoord2f(0, 1);
+    glVertex2f(0, 1);
+    glEnd();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glsDisable(GL_TEXTURE_2D);
+    glsSet(GL_BLEND, blending);
+    glsEnable(GL_DEPTH_TEST);
+    glsEnable(GL_LIGHTING);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Offscreen colour+depth target for the 3D pass, with a stencil buffer for the
+// overdraw view (Overdraw.h). While the scene is unchanged the last render is
+// kept and only composited, so HUD-only redraws cost one textured quad plus
+// the overlay. The target may be smaller than the window (dynamic
+// resolution); the HUD is always drawn at native resolution.
+
+// Creates the target for the given window size; false if FBOs are unsupported
+bool sceneTargetInit(int width, int height);
+
+// Reallocates the target for a new window size and invalidates the cache
+void sceneTargetResize(int width, int height);
+
+// Renders the 3D pass at this fraction of the window size per axis; the
+// composite upscales it. Reallocates (and invalidates) only if the size changes.
+void sceneTargetSetScale(float scale);
+
+// Current render size of the target in pixels
+void sceneTargetSize(int &width, int &height);
+
+// True if the target exists and 3D rendering can be redirected into it
+bool sceneTargetAvailable();
+
+// True if the target holds a finished render that can be reused
+bool sceneTargetValid();
+
+// Forces the next frame to re-render the 3D pass
+void sceneTargetInvalidate();
+
+// Redirects rendering into the target; sceneTargetEnd marks it valid
+void sceneTargetBegin();
+void sceneTargetEnd();
+
+// Draws the cached scene as a full-window quad into the default framebuffer
+void sceneTargetComposite();
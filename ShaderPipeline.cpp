@@ -0,0 +1,353 @@
+#include "ShaderPipeline.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "MatrixStack.h"
+#include "ShadowMap.h"
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static const char *vertexSource = R"(#version 330 core
+layout(std140) uniform Camera
+{
+    mat4 projection;
+};
+layout(std140) uniform Lighting
+{
+    vec4 lightPosition; // Eye space
+    vec4 lightDiffuse;
+    vec4 lightAmbient;
+    vec4 globalAmbient;
+};
+layout(std140) uniform Palette
+{
+    vec4 palette[256];
+};
+uniform int lit;
+// Packed vertices: position as a fraction of the bounds, octahedral normal,
+// colour as a palette index
+uniform int packedVertices;
+uniform vec3 boundsMin;
+uniform vec3 boundsExtent;
+uniform int shadowed;
+uniform mat4 eyeToShadow; // Eye space to the shadow maps' texture space (ShadowMap.h)
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec4 color;
+layout(location = 3) in mat4 modelview;
+
+out vec4 vertexColor;
+out vec4 shadowCoord;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return n;
+}
+
+void main()
+{
+    vec3 p = position;
+    vec3 objectNormal = normal;
+    vec4 c = color;
+    if (packedVertices != 0)
+    {
+        p = boundsMin + position * boundsExtent;
+        objectNormal = octahedralDecode(normal.xy);
+        c = palette[int(color.r)];
+    }
+    vec4 eye = modelview * vec4(p, 1.0);
+    gl_Position = projection * eye;
+    if (shadowed != 0)
+        shadowCoord = eyeToShadow * eye;
+    if (lit == 0)
+    {
+        vertexColor = c;
+        return;
+    }
+    // The cofactor matrix is the inverse transpose up to the determinant,
+    // whose magnitude the normalize removes
+    mat3 m = mat3(modelview);
+    mat3 cofactor = mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1]));
+    vec3 n = normalize(cofactor * objectNormal) * sign(dot(m[0], cofactor[0]));
+    vec3 l = normalize(lightPosition.xyz - eye.xyz * lightPosition.w);
+    // Colour material drives ambient and diffuse; there is no specular
+    vec3 shade = globalAmbient.rgb + lightAmbient.rgb + max(dot(n, l), 0.0) * lightDiffuse.rgb;
+    vertexColor = vec4(min(c.rgb * shade, vec3(1.0)), c.a);
+}
+)";
+
+static const char *fragmentSource = R"(#version 330 core
+in vec4 vertexColor;
+in vec4 shadowCoord;
+out vec4 fragColor;
+uniform int shadowed;
+uniform vec2 shadowShade; // Static, dynamic
+uniform sampler2DShadow staticShadow;
+uniform sampler2DShadow dynamicShadow;
+
+void main()
+{
+    fragColor = vertexColor;
+    if (shadowed == 0)
+        return;
+    // As the fixed-function texture combiners work it out
+    float cloud = min(textureProj(dynamicShadow, shadowCoord) + shadowShade.y, 1.0);
+    fragColor.rgb *= mix(shadowShade.x, cloud, textureProj(staticShadow, shadowCoord));
+}
+)";
+
+enum UniformBinding
+{
+    BINDING_CAMERA,
+    BINDING_LIGHTING,
+    BINDING_PALETTE
+};
+
+struct LightingBlock
+{
+    Vec4 lightPosition;
+    Vec4 lightDiffuse;
+    Vec4 lightAmbient;
+    Vec4 globalAmbient;
+};
+
+static bool available = false;
+static bool active = false;
+static GLuint program = 0;
+static GLint litLocation = -1;
+static GLint packedLocation = -1;
+static GLint boundsMinLocation = -1;
+static GLint boundsExtentLocation = -1;
+static GLint shadowedLocation = -1;
+static GLint eyeToShadowLocation = -1;
+static GLint shadowShadeLocation = -1;
+static GLuint cameraBuffer = 0;
+static GLuint lightingBuffer = 0;
+static GLuint defaultPaletteBuffer = 0; // Keeps the block backed for unpacked draws
+
+// CPU copies; uploaded on use when they differ from what the buffers hold
+static Mat4 uploadedProjection;
+static bool projectionUploaded = false;
+static LightingBlock lighting = {Vec4(0.0f, 0.0f, 1.0f, 0.0f), Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                 Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.2f, 0.2f, 0.2f, 1.0f)};
+static bool lightingDirty = true;
+static bool shadowed = false;
+static Mat4 eyeToShadow;
+static float staticShade = 1.0f, dynamicShade = 1.0f;
+static bool shadowsDirty = false;
+
+static GLuint compileShader(GLenum type, const char *source)
+{
+    GLuint shader = pglCreateShader(type);
+    pglShaderSource(shader, 1, &source, nullptr);
+    pglCompileShader(shader);
+    GLint ok = GL_FALSE;
+    pglGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024] = "";
+        pglGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cout << "Shader compile failed: " << log << std::endl;
+        pglDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader)
+{
+    GLuint p = pglCreateProgram();
+    pglAttachShader(p, vertexShader);
+    pglAttachShader(p, fragmentShader);
+    pglLinkProgram(p);
+    GLint ok = GL_FALSE;
+    pglGetProgramiv(p, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024] = "";
+        pglGetProgramInfoLog(p, sizeof(log), nullptr, log);
+        std::cout << "Shader link failed: " << log << std::endl;
+        pglDeleteProgram(p);
+        return 0;
+    }
+    return p;
+}
+
+static GLuint createUniformBuffer(size_t size, UniformBinding binding)
+{
+    GLuint buffer = 0;
+    pglGenBuffers(1, &buffer);
+    pglBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    pglBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    pglBindBuffer(GL_UNIFORM_BUFFER, 0);
+    pglBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+    return buffer;
+}
+
+bool shaderPipelineInit()
+{
+    if (!glHasShaderPipeline)
+    {
+        std::cout << "GL 3.3 unavailable, shader pipeline disabled" << std::endl;
+        return false;
+    }
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (vertexShader && fragmentShader)
+        program = linkProgram(vertexShader, fragmentShader);
+    if (vertexShader)
+        pglDeleteShader(vertexShader);
+    if (fragmentShader)
+        pglDeleteShader(fragmentShader);
+    if (!program)
+        return false;
+
+    pglUniformBlockBinding(program, pglGetUniformBlockIndex(program, "Camera"), BINDING_CAMERA);
+    pglUniformBlockBinding(program, pglGetUniformBlockIndex(program, "Lighting"), BINDING_LIGHTING);
+    pglUniformBlockBinding(program, pglGetUniformBlockIndex(program, "Palette"), BINDING_PALETTE);
+    litLocation = pglGetUniformLocation(program, "lit");
+    packedLocation = pglGetUniformLocation(program, "packedVertices");
+    boundsMinLocation = pglGetUniformLocation(program, "boundsMin");
+    boundsExtentLocation = pglGetUniformLocation(program, "boundsExtent");
+    shadowedLocation = pglGetUniformLocation(program, "shadowed");
+    eyeToShadowLocation = pglGetUniformLocation(program, "eyeToShadow");
+    shadowShadeLocation = pglGetUniformLocation(program, "shadowShade");
+    pglUseProgram(program);
+    pglUniform1i(pglGetUniformLocation(program, "staticShadow"), SHADOW_UNIT_STATIC);
+    pglUniform1i(pglGetUniformLocation(program, "dynamicShadow"), SHADOW_UNIT_DYNAMIC);
+    pglUseProgram(0);
+    cameraBuffer = createUniformBuffer(sizeof(Mat4), BINDING_CAMERA);
+    lightingBuffer = createUniformBuffer(sizeof(LightingBlock), BINDING_LIGHTING);
+    defaultPaletteBuffer = createUniformBuffer(SHADER_PALETTE_SIZE * sizeof(Vec4), BINDING_PALETTE);
+    available = true;
+    return true;
+}
+
+bool shaderPipelineAvailable()
+{
+    return available;
+}
+
+void shaderPipelineSetActive(bool enabled)
+{
+    active = enabled && available;
+}
+
+bool shaderPipelineActive()
+{
+    return active;
+}
+
+void shaderPipelineSetGlobalAmbient(const Vec4 &ambient)
+{
+    lighting.globalAmbient = ambient;
+    lightingDirty = true;
+}
+
+void shaderPipelineSetLight(const Vec4 &eyePosition, const Vec4 &diffuse, const Vec4 &ambient)
+{
+    lighting.lightPosition = eyePosition;
+    lighting.lightDiffuse = diffuse;
+    lighting.lightAmbient = ambient;
+    lightingDirty = true;
+}
+
+void shaderPipelineSetShadows(const Mat4 &newEyeToShadow, float newStaticShade, float newDynamicShade)
+{
+    shadowed = true;
+    eyeToShadow = newEyeToShadow;
+    staticShade = newStaticShade;
+    dynamicShade = newDynamicShade;
+    shadowsDirty = true;
+}
+
+void shaderPipelineClearShadows()
+{
+    shadowed = false;
+}
+
+void shaderPipelineUse()
+{
+    const Mat4 &projection = rcProjection();
+    if (!projectionUploaded || std::memcmp(projection.m, uploadedProjection.m, sizeof(projection.m)) != 0)
+    {
+        pglBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+        pglBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Mat4), projection.m);
+        uploadedProjection = projection;
+        projectionUploaded = true;
+    }
+    if (lightingDirty)
+    {
+        pglBindBuffer(GL_UNIFORM_BUFFER, lightingBuffer);
+        pglBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightingBlock), &lighting);
+        lightingDirty = false;
+    }
+    pglBindBuffer(GL_UNIFORM_BUFFER, 0);
+    pglUseProgram(program);
+    pglUniform1i(litLocation, glsIsEnabled(GL_LIGHTING) ? 1 : 0);
+    pglUniform1i(packedLocation, 0);
+    pglUniform1i(shadowedLocation, shadowed ? 1 : 0);
+    if (shadowed && shadowsDirty)
+    {
+        pglUniformMatrix4fv(eyeToShadowLocation, 1, GL_FALSE, eyeToShadow.m);
+        pglUniform2f(shadowShadeLocation, staticShade, dynamicShade);
+        shadowsDirty = false;
+    }
+}
+
+void shaderPipelineRelease()
+{
+    pglUseProgram(0);
+}
+
+void shaderPipelineSetModelview(const Mat4 &modelview)
+{
+    for (int c = 0; c < 4; ++c)
+        pglVertexAttrib4fv(SHADER_ATTRIB_MODELVIEW + c, modelview.m + c * 4);
+}
+
+GLuint shaderPipelineCreatePalette(const GLubyte *colors, int count)
+{
+    Vec4 entries[SHADER_PALETTE_SIZE];
+    for (int i = 0; i < count && i < SHADER_PALETTE_SIZE; ++i)
+        entries[i] = Vec4(colors[i * 4] / 255.0f, colors[i * 4 + 1] / 255.0f, colors[i * 4 + 2] / 255.0f,
+                          colors[i * 4 + 3] / 255.0f);
+    GLuint buffer = 0;
+    pglGenBuffers(1, &buffer);
+    pglBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    pglBufferData(GL_UNIFORM_BUFFER, sizeof(entries), entries, GL_STATIC_DRAW);
+    pglBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return buffer;
+}
+
+void shaderPipelineSetPackedVertices(const Vec3 &boundsMin, const Vec3 &boundsExtent, GLuint paletteBuffer)
+{
+    const GLfloat minimum[3] = {boundsMin.x, boundsMin.y, boundsMin.z};
+    const GLfloat extent[3] = {boundsExtent.x, boundsExtent.y, boundsExtent.z};
+    pglUniform1i(packedLocation, 1);
+    pglUniform3fv(boundsMinLocation, 1, minimum);
+    pglUniform3fv(boundsExtentLocation, 1, extent);
+    pglBindBufferBase(GL_UNIFORM_BUFFER, BINDING_PALETTE, paletteBuffer);
+}
+
+void shaderPipelineInstanceAttribs(GLuint instanceBuffer)
+{
+    pglBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (int c = 0; c < 4; ++c)
+    {
+        GLuint location = SHADER_ATTRIB_MODELVIEW + c;
+        pglEnableVertexAttribArray(location);
+        pglVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(ShaderInstance),
+                               reinterpret_cast<const GLvoid *>(offsetof(ShaderInstance, modelview) + c * 4 * sizeof(float)));
+        pglVertexAttribDivisor(location, 1);
+    }
+    pglEnableVertexAttribArray(SHADER_ATTRIB_COLOR);
+    pglVertexAttribPointer(SHADER_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ShaderInstance),
+                           reinterpret_cast<const GLvoid *>(offsetof(ShaderInstance, color)));
+    pglVertexAttribDivisor(SHADER_ATTRIB_COLOR, 1);
+}
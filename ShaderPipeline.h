@@ -0,0 +1,66 @@
+#pragma once
+#include "Math3D.h"
+#include <GL/glut.h>
+
+// GL 3.3-style path for the 3D pass: one GLSL 3.30 program reproduces the
+// fixed-function look (per-vertex lighting of GL_LIGHT0 with colour material),
+// with the projection and the light in uniform buffers and per-draw transforms
+// passed as vertex attributes. The cube batch, sphere meshes and ImmediateMode
+// draw through it with vertex array objects while it is active; otherwise they
+// use the legacy fixed-function path. The context stays a compatibility one so
+// both paths can be switched between at runtime.
+
+// Attribute locations shared by every vertex array
+enum ShaderAttrib
+{
+    SHADER_ATTRIB_POSITION = 0,
+    SHADER_ATTRIB_NORMAL = 1,
+    SHADER_ATTRIB_COLOR = 2,     // Normalized unsigned bytes
+    SHADER_ATTRIB_MODELVIEW = 3, // Four columns, locations 3-6
+};
+
+// Entries in a palette for packed vertices
+const int SHADER_PALETTE_SIZE = 256;
+
+// Per-instance data for instanced draws
+struct ShaderInstance
+{
+    Mat4 modelview;
+    GLubyte color[4];
+};
+
+// Compiles the program and creates the uniform buffers; call after glExtInit.
+// Returns false (and leaves the pipeline unavailable) without GL 3.3.
+bool shaderPipelineInit();
+bool shaderPipelineAvailable();
+
+// Selects the shader path for subsequent draws; ignored while unavailable
+void shaderPipelineSetActive(bool active);
+bool shaderPipelineActive();
+
+// Lighting state mirrored from the fixed-function calls. The position is in
+// eye space, as glLightfv stores it.
+void shaderPipelineSetGlobalAmbient(const Vec4 &ambient);
+void shaderPipelineSetLight(const Vec4 &eyePosition, const Vec4 &diffuse, const Vec4 &ambient);
+// Shadows mirrored from the texture units ShadowMap.h sets up
+void shaderPipelineSetShadows(const Mat4 &eyeToShadow, float staticShade, float dynamicShade);
+void shaderPipelineClearShadows();
+
+// Binds the program with the current projection and light. Lighting follows
+// the cached GL_LIGHTING state (GLState.h), like the fixed-function path.
+void shaderPipelineUse();
+void shaderPipelineRelease();
+
+// Transform for vertex arrays without a per-instance modelview
+void shaderPipelineSetModelview(const Mat4 &modelview);
+
+// Packed vertices (MeshOptimizer.h): positions are normalized unsigned shorts
+// spanning the bounds, normals two normalized bytes in octahedral encoding and
+// colours an unnormalized byte index into a palette. Call after
+// shaderPipelineUse; it applies until the next use.
+GLuint shaderPipelineCreatePalette(const GLubyte *colors, int count); // RGBA bytes
+void shaderPipelineSetPackedVertices(const Vec3 &boundsMin, const Vec3 &boundsExtent, GLuint paletteBuffer);
+
+// Points the modelview and colour attributes of the bound vertex array at a
+// buffer of ShaderInstance, advancing once per instance
+void shaderPipelineInstanceAttribs(GLuint instanceBuffer);
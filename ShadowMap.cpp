@@ -0,0 +1,267 @@
+#include "ShadowMap.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "ShaderPipeline.h"
+#include <algorithm>
+#include <iostream>
+
+const int SHADOW_STATIC_SIZE = 2048;
+const int SHADOW_DYNAMIC_SIZE = 512;
+const float SHADOW_SUN_STEP = 2.0f;       // Degrees the sun turns before the static map is rendered again
+const float SHADOW_CASTER_REACH = 120.0f; // Casters this far out toward the sun still cast, e.g. clouds
+const float SHADOW_OFFSET_FACTOR = 2.0f;  // Pushes the back faces in the maps away from the sun
+const float SHADOW_OFFSET_UNITS = 4.0f;
+
+struct ShadowDepthMap
+{
+    GLuint texture, fbo;
+    int size;
+    bool current;
+};
+
+static bool available = false;
+static bool bound = false;
+static ShadowDepthMap staticMap = {0, 0, SHADOW_STATIC_SIZE, false};
+static ShadowDepthMap dynamicMap = {0, 0, SHADOW_DYNAMIC_SIZE, false};
+static Vec3 center;
+static float radius = 1.0f;
+static Vec3 litFrom(0.0f, 1.0f, 0.0f); // Toward the sun, as of the static map
+static Mat4 lightView, lightProjection;
+
+static bool createMap(ShadowDepthMap &map)
+{
+    const GLfloat border[4] = {1.0f, 1.0f, 1.0f, 1.0f}; // Outside the map is lit
+    glGenTextures(1, &map.texture);
+    glBindTexture(GL_TEXTURE_2D, map.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Compares four texels where supported
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_TEXTURE_MODE, GL_LUMINANCE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, map.size, map.size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT,
+                 nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    pglGenFramebuffers(1, &map.fbo);
+    pglBindFramebuffer(GL_FRAMEBUFFER, map.fbo);
+    pglFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, map.texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = pglCheckFramebufferStatus(GL_FRAMEBUFFER);
+    pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status == GL_FRAMEBUFFER_COMPLETE)
+        return true;
+    std::cout << "Shadows off: " << map.size << " px depth framebuffer incomplete (0x" << std::hex << status
+              << std::dec << ")" << std::endl;
+    pglDeleteFramebuffers(1, &map.fbo);
+    glDeleteTextures(1, &map.texture);
+    map.fbo = map.texture = 0;
+    return false;
+}
+
+// Alpha passes through every unit untouched
+static void combineAlpha()
+{
+    glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_REPLACE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_PRIMARY_COLOR);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_ALPHA, GL_SRC_ALPHA);
+}
+
+// The units work out colour * mix(staticShade, min(dynamic + dynamicShade, 1), static),
+// where static and dynamic are the maps' lit fractions; the shader pipeline
+// does the same. Each unit keeps its map bound for good, so the samplers of
+// the shader pipeline always find them.
+static void setupUnits()
+{
+    glsActiveTexture(GL_TEXTURE0 + SHADOW_UNIT_DYNAMIC);
+    glBindTexture(GL_TEXTURE_2D, dynamicMap.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_ADD);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_TEXTURE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_CONSTANT);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
+    combineAlpha();
+
+    glsActiveTexture(GL_TEXTURE0 + SHADOW_UNIT_STATIC);
+    glBindTexture(GL_TEXTURE_2D, staticMap.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_INTERPOLATE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_PREVIOUS);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_CONSTANT);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE2_RGB, GL_TEXTURE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND2_RGB, GL_SRC_COLOR);
+    combineAlpha();
+
+    // Only applies the shade; a unit combines only with a texture enabled
+    glsActiveTexture(GL_TEXTURE0 + SHADOW_UNIT_MODULATE);
+    glBindTexture(GL_TEXTURE_2D, staticMap.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_MODULATE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_PREVIOUS);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_PRIMARY_COLOR);
+    glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
+    combineAlpha();
+    glsActiveTexture(GL_TEXTURE0);
+}
+
+bool shadowMapInit()
+{
+    GLint units = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_UNITS, &units);
+    if (!glHasFramebufferObject || !pglActiveTexture || !glVersionAtLeast(1, 4) || units <= SHADOW_UNIT_MODULATE)
+    {
+        std::cout << "Shadows off: they need framebuffer objects, depth textures and "
+                  << SHADOW_UNIT_MODULATE + 1 << " texture units" << std::endl;
+        return false;
+    }
+    if (!createMap(staticMap))
+        return false;
+    if (!createMap(dynamicMap))
+    {
+        pglDeleteFramebuffers(1, &staticMap.fbo);
+        glDeleteTextures(1, &staticMap.texture);
+        staticMap.fbo = staticMap.texture = 0;
+        return false;
+    }
+    setupUnits();
+    available = true;
+    std::cout << "Shadows: " << SHADOW_STATIC_SIZE << " px static map, " << SHADOW_DYNAMIC_SIZE
+              << " px dynamic map" << std::endl;
+    return true;
+}
+
+bool shadowMapAvailable()
+{
+    return available;
+}
+
+void shadowMapSetBounds(const Vec3 &newCenter, float newRadius)
+{
+    if (newCenter.x == center.x && newCenter.y == center.y && newCenter.z == center.z && newRadius == radius)
+        return;
+    center = newCenter;
+    radius = std::max(newRadius, 1.0f);
+    shadowMapInvalidate();
+}
+
+void shadowMapInvalidate()
+{
+    staticMap.current = false;
+}
+
+static void renderMap(ShadowDepthMap &map, ShadowCasterFn casters)
+{
+    pglBindFramebuffer(GL_FRAMEBUFFER, map.fbo);
+    glViewport(0, 0, map.size, map.size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    casters(lightProjection, lightView);
+    map.current = true;
+}
+
+void shadowMapPrepare(const Vec3 &toSun, ShadowCasterFn staticCasters, ShadowCasterFn dynamicCasters,
+                      bool dynamicMoved)
+{
+    if (!available)
+        return;
+    Vec3 direction = normalize(toSun);
+    bool turned = dot(direction, litFrom) < std::cos(SHADOW_SUN_STEP * PI / 180.0f);
+    if (staticMap.current && dynamicMap.current && !turned && !dynamicMoved)
+        return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    bool culling = glsIsEnabled(GL_CULL_FACE);
+    glsEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glsEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(SHADOW_OFFSET_FACTOR, SHADOW_OFFSET_UNITS);
+    glsDepthMask(GL_TRUE);
+
+    if (!staticMap.current || turned)
+    {
+        // Measured from the last render, not the last frame
+        litFrom = direction;
+        float distance = radius + SHADOW_CASTER_REACH;
+        Vec3 up = std::fabs(direction.z) < 0.9f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3(1.0f, 0.0f, 0.0f);
+        lightView = mat4LookAt(center + direction * distance, center, up);
+        lightProjection = mat4Ortho(-radius, radius, -radius, radius, 0.0f, distance + radius);
+        renderMap(staticMap, staticCasters);
+        dynamicMap.current = false; // Same light
+    }
+    if (!dynamicMap.current || dynamicMoved)
+        renderMap(dynamicMap, dynamicCasters);
+
+    pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glsDisable(GL_POLYGON_OFFSET_FILL);
+    glCullFace(GL_BACK);
+    glsSet(GL_CULL_FACE, culling);
+}
+
+static void enableUnit(int unit, const Mat4 &eyeToShadow)
+{
+    glsActiveTexture(GL_TEXTURE0 + unit);
+    glsEnable(GL_TEXTURE_2D);
+    if (unit == SHADOW_UNIT_MODULATE)
+        return;
+    const GLenum coords[4] = {GL_S, GL_T, GL_R, GL_Q};
+    const GLenum gens[4] = {GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R, GL_TEXTURE_GEN_Q};
+    for (int row = 0; row < 4; ++row)
+    {
+        const GLfloat plane[4] = {eyeToShadow.m[row], eyeToShadow.m[4 + row], eyeToShadow.m[8 + row],
+                                  eyeToShadow.m[12 + row]};
+        glTexGeni(coords[row], GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+        glTexGenfv(coords[row], GL_EYE_PLANE, plane);
+        glsEnable(gens[row]);
+    }
+}
+
+void shadowMapBind(const Mat4 &view, float staticShade, float dynamicShade)
+{
+    if (!available || !staticMap.current || !dynamicMap.current)
+        return;
+    const Mat4 bias = mat4Translation(0.5f, 0.5f, 0.5f) * mat4Scale(0.5f, 0.5f, 0.5f);
+    Mat4 eyeToShadow = bias * lightProjection * lightView * inverse(view);
+
+    // Eye planes are taken through the inverse modelview; with none they are eye space as given
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    enableUnit(SHADOW_UNIT_DYNAMIC, eyeToShadow);
+    const GLfloat dynamicColor[4] = {dynamicShade, dynamicShade, dynamicShade, 1.0f};
+    glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, dynamicColor);
+    enableUnit(SHADOW_UNIT_STATIC, eyeToShadow);
+    const GLfloat staticColor[4] = {staticShade, staticShade, staticShade, 1.0f};
+    glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, staticColor);
+    enableUnit(SHADOW_UNIT_MODULATE, eyeToShadow);
+    glsActiveTexture(GL_TEXTURE0);
+    glPopMatrix();
+
+    shaderPipelineSetShadows(eyeToShadow, staticShade, dynamicShade);
+    bound = true;
+}
+
+void shadowMapUnbind()
+{
+    if (!bound)
+        return;
+    for (int unit : {SHADOW_UNIT_DYNAMIC, SHADOW_UNIT_STATIC, SHADOW_UNIT_MODULATE})
+    {
+        glsActiveTexture(GL_TEXTURE0 + unit);
+        glsDisable(GL_TEXTURE_2D);
+        glsDisable(GL_TEXTURE_GEN_S);
+        glsDisable(GL_TEXTURE_GEN_T);
+        glsDisable(GL_TEXTURE_GEN_R);
+        glsDisable(GL_TEXTURE_GEN_Q);
+    }
+    glsActiveTexture(GL_TEXTURE0);
+    shaderPipelineClearShadows();
+    bound = false;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "Math3D.h"
+
+// Sun shadows from two cached depth maps, both orthographic along the sun
+// direction over a bounding sphere of the campus. The static map holds
+// everything that stays put and is only rendered again when the sun has
+// turned more than a few degrees since it was, or when what it holds changes;
+// most frames cost it nothing. A small dynamic map holds the clouds, whose
+// shadows move every frame, and is rendered whenever they move.
+//
+// Casters are drawn with their front faces culled, so the maps hold the
+// faces turned away from the sun and lit surfaces never shadow themselves.
+// While bound, both render backends scale the colour of everything drawn by
+// its shade: the dynamic map's shade where only a cloud hides the sun, the
+// static map's where anything else does. Fixed-function draws go through
+// eye-linear texgen and texture combiners on units 1 to 3, the shader
+// pipeline through shadow samplers; unit 0 is left to ordinary texturing.
+
+// Texture units the maps are bound to; the last one applies their shade
+const int SHADOW_UNIT_DYNAMIC = 1;
+const int SHADOW_UNIT_STATIC = 2;
+const int SHADOW_UNIT_MODULATE = 3;
+
+// Draws casters into a map under this projection and view; colour is ignored
+typedef void (*ShadowCasterFn)(const Mat4 &projection, const Mat4 &view);
+
+// Creates the maps; false without framebuffer objects, depth textures or
+// four texture units. Call after glExtInit.
+bool shadowMapInit();
+bool shadowMapAvailable();
+// Sphere around everything that receives shadows. Drops the static map if it moved.
+void shadowMapSetBounds(const Vec3 &center, float radius);
+void shadowMapInvalidate(); // Static casters changed; drops the static map
+
+// Renders the maps that are out of date for light from this direction (toward
+// the sun): the static one if dropped or the sun has turned far enough, the
+// dynamic one then or if its casters moved. Call before the 3D pass, with no
+// other framebuffer bound.
+void shadowMapPrepare(const Vec3 &toSun, ShadowCasterFn staticCasters, ShadowCasterFn dynamicCasters,
+                      bool dynamicMoved);
+// Shadows what is drawn next under this view. Shades are the colour factors
+// in full shadow of each map, 1 for none.
+void shadowMapBind(const Mat4 &view, float staticShade, float dynamicShade);
+void shadowMapUnbind();
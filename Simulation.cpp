@@ -0,0 +1,213 @@
+#include "Simulation.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+const double SIM_STEP = 0.016;
+float simTimeScale = 1.0f;
+
+// Never try to catch up more than this much real time in one batch, so a long
+// stall (suspend, breakpoint) does not turn into a burst of ticks
+static const double MAX_FRAME_TIME = 0.25;
+// Upper bound on ticks per batch even when running faster than real time
+static const int MAX_TICKS_PER_ADVANCE = 1000;
+
+// Rates per simulated second, matching the old per-tick increments at 16 ms
+static const float SUN_SPEED_DAY = 0.08f / 0.016f;
+static const float SUN_SPEED_NIGHT = 0.04f / 0.016f;
+static const float CLOUD_SPEED = 0.1f / 0.016f;
+
+typedef std::chrono::steady_clock SimClock;
+
+enum SimEventType
+{
+    SIM_EVENT_TOGGLE_NIGHT,
+    SIM_EVENT_SET_TIME_SCALE
+};
+
+struct SimEvent
+{
+    SimEventType type;
+    float value;
+};
+
+// Input callbacks -> simulation thread
+static SpscQueue<SimEvent, 256> eventQueue;
+// Simulation thread -> campusDisplay
+static TripleBuffer<SimSnapshot> snapshots;
+
+static std::thread simThread;
+static std::atomic<bool> simRunning(false);
+static SimClock::time_point clockStart;
+
+static double secondsSinceStart(SimClock::time_point t)
+{
+    return std::chrono::duration<double>(t - clockStart).count();
+}
+
+static void stepState(SimState &s, float dt)
+{
+    // Day/Night cycle
+    if (!s.nightMode)
+    {
+        s.sunAngle += SUN_SPEED_DAY * dt; // Slower sun movement for longer day
+        if (s.sunAngle > 180.0f)
+            s.sunAngle = 0.0f;
+    }
+    else
+    {
+        s.sunAngle += SUN_SPEED_NIGHT * dt; // Moon moves slower at night
+        if (s.sunAngle > 360.0f)
+            s.sunAngle = 180.0f;
+    }
+
+    s.cloudOffset += CLOUD_SPEED * dt;
+    if (s.cloudOffset > 800.0f)
+        s.cloudOffset = -800.0f;
+}
+
+// Blends a and b unless they are on opposite sides of a wrap-around, where
+// blending would sweep the whole range in one frame
+static float blendWrapped(float a, float b, float t, float maxJump)
+{
+    if (std::fabs(b - a) > maxJump)
+        return b;
+    return a + (b - a) * t;
+}
+
+static void simulationLoop(SimState state)
+{
+    SimState previous = state;
+    double accumulator = 0.0;
+    float timeScale = 1.0f;
+    unsigned long tick = 0;
+    SimClock::time_point lastTime = SimClock::now();
+
+    while (simRunning.load(std::memory_order_relaxed))
+    {
+        // Apply queued input first; discrete changes never blend
+        SimEvent ev;
+        bool snapped = false;
+        while (eventQueue.pop(ev))
+        {
+            if (ev.type == SIM_EVENT_TOGGLE_NIGHT)
+            {
+                state.nightMode = !state.nightMode;
+                if (!state.nightMode)
+                    state.sunAngle = 0;
+                snapped = true;
+            }
+            else if (ev.type == SIM_EVENT_SET_TIME_SCALE)
+            {
+                timeScale = ev.value;
+            }
+        }
+        if (snapped)
+            previous = state;
+
+        SimClock::time_point now = SimClock::now();
+        double frameTime = std::chrono::duration<double>(now - lastTime).count();
+        lastTime = now;
+        if (frameTime > MAX_FRAME_TIME)
+            frameTime = MAX_FRAME_TIME;
+        accumulator += frameTime * timeScale;
+
+        int steps = 0;
+        while (accumulator >= SIM_STEP && steps < MAX_TICKS_PER_ADVANCE)
+        {
+            previous = state;
+            stepState(state, static_cast<float>(SIM_STEP));
+            accumulator -= SIM_STEP;
+            ++tick;
+            ++steps;
+        }
+        if (steps == MAX_TICKS_PER_ADVANCE)
+            accumulator = 0.0; // Drop the backlog rather than spiral
+
+        if (steps > 0 || snapped)
+        {
+            SimSnapshot &out = snapshots.writeSlot();
+            out.previous = previous;
+            out.current = state;
+            // When current was due, in real time: now minus the unspent remainder
+            out.tickTime = secondsSinceStart(now) - accumulator / timeScale;
+            out.timeScale = timeScale;
+            out.tick = tick;
+            snapshots.publish();
+        }
+
+        // Sleep until the next tick is due, but wake at least once per real
+        // tick so queued input is not held back at slow time scales
+        double untilNext = std::fmin((SIM_STEP - accumulator) / timeScale, SIM_STEP);
+        std::this_thread::sleep_for(std::chrono::duration<double>(untilNext));
+    }
+}
+
+void simInit(const SimState &initial)
+{
+    simShutdown();
+
+    clockStart = SimClock::now();
+    SimSnapshot &first = snapshots.writeSlot();
+    first.previous = initial;
+    first.current = initial;
+    first.tickTime = 0.0;
+    first.timeScale = simTimeScale;
+    first.tick = 0;
+    snapshots.publish();
+    snapshots.update();
+
+    static bool exitHookInstalled = false;
+    if (!exitHookInstalled)
+    {
+        std::atexit(simShutdown); // exit(0) on ESC must not leave the thread joinable
+        exitHookInstalled = true;
+    }
+
+    simSetTimeScale(simTimeScale);
+    simRunning = true;
+    simThread = std::thread(simulationLoop, initial);
+}
+
+void simShutdown()
+{
+    simRunning = false;
+    if (simThread.joinable())
+        simThread.join();
+}
+
+SimState simInterpolated()
+{
+    snapshots.update();
+    const SimSnapshot &snap = snapshots.readSlot();
+
+    double sinceTick = secondsSinceStart(SimClock::now()) - snap.tickTime;
+    float alpha = static_cast<float>(sinceTick * snap.timeScale / SIM_STEP);
+    alpha = std::fmax(0.0f, std::fmin(1.0f, alpha));
+
+    SimState s = snap.current;
+    s.sunAngle = blendWrapped(snap.previous.sunAngle, snap.current.sunAngle, alpha, 90.0f);
+    s.cloudOffset = blendWrapped(snap.previous.cloudOffset, snap.current.cloudOffset, alpha, 800.0f);
+    return s;
+}
+
+const SimSnapshot &simLatestSnapshot()
+{
+    return snapshots.readSlot();
+}
+
+void simToggleNightMode()
+{
+    SimEvent ev = {SIM_EVENT_TOGGLE_NIGHT, 0.0f};
+    eventQueue.push(ev);
+}
+
+void simSetTimeScale(float scale)
+{
+    SimEvent ev = {SIM_EVENT_SET_TIME_SCALE, scale};
+    eventQueue.push(ev);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Animated scene state. Advanced only by the fixed-timestep simulation, which
+// runs on its own thread, so motion is independent of how often campusDisplay
+// runs.
+struct SimState
+{
+    float sunAngle;    // Sun/moon angle in degrees
+    float cloudOffset; // Drives cloud drift and bird motion
+    bool nightMode;
+};
+
+// Immutable snapshot published by the simulation thread after each batch of
+// ticks. The renderer blends previous -> current by how long ago current was
+// produced.
+struct SimSnapshot
+{
+    SimState previous;
+    SimState current;
+    double tickTime;  // Real time (seconds on the sim clock) when current was reached
+    float timeScale;  // Time scale in effect when the snapshot was taken
+    unsigned long tick;
+};
+
+// Simulated seconds per tick (the old 16 ms glutTimerFunc period)
+extern const double SIM_STEP;
+
+// Simulated seconds per real second as last requested from the UI; raise it
+// to run faster than real time. Changes reach the simulation through
+// simSetTimeScale.
+extern float simTimeScale;
+
+// Publishes the initial state and starts the simulation thread
+void simInit(const SimState &initial);
+
+// Stops and joins the simulation thread (also run at exit)
+void simShutdown();
+
+// Picks up the newest snapshot without blocking and returns the render state
+// blended between its two ticks
+SimState simInterpolated();
+
+// Newest snapshot picked up by simInterpolated
+const SimSnapshot &simLatestSnapshot();
+
+// Input-side requests, queued for the simulation thread to apply on its next
+// tick. Never block; a request is dropped only if the queue is full.
+void simToggleNightMode();
+void simSetTimeScale(float scale);
@@ -0,0 +1,273 @@
+#include "SphereMesh.h"
+#include "GLExt.h"
+#include "Math3D.h"
+#include "MatrixStack.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "ShaderPipeline.h"
+#include <GL/glut.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+static const int lodSegments[] = {6, 8, 12, 16, 20, 24, 32};
+const int SPHERE_LOD_COUNT = sizeof(lodSegments) / sizeof(lodSegments[0]);
+
+// Largest silhouette error (pixels) a level may show at its projected size
+static const float SILHOUETTE_TOLERANCE_PX = 0.5f;
+
+struct SphereLod
+{
+    GLuint vertexBuffer; // 0 when drawing from client memory
+    GLuint indexBuffer;
+    std::vector<GLfloat> vertices; // Unit positions, which are also the normals
+    std::vector<GLushort> indices;
+    GLsizei indexCount;
+    GLuint vertexArray; // Shader pipeline only
+};
+
+static SphereLod lods[sizeof(lodSegments) / sizeof(lodSegments[0])];
+static bool useBuffers = false;
+static float pixelsPerUnitAtOne = 1.0f; // Projected size of 1 unit at distance 1
+static int lodBias = 0;
+
+// Shader pipeline: instances of the bound level wait here and go out as one
+// instanced draw when the level is unbound
+static GLuint instanceBuffer = 0;
+static std::vector<ShaderInstance> pendingInstances;
+
+static void buildLod(SphereLod &lod, int segments)
+{
+    // Poles on the z axis like glutSolidSphere; the seam column is duplicated
+    for (int stack = 0; stack <= segments; ++stack)
+    {
+        float phi = PI * stack / segments;
+        for (int slice = 0; slice <= segments; ++slice)
+        {
+            float theta = 2.0f * PI * slice / segments;
+            lod.vertices.push_back(std::sin(phi) * std::cos(theta));
+            lod.vertices.push_back(std::sin(phi) * std::sin(theta));
+            lod.vertices.push_back(std::cos(phi));
+        }
+    }
+    int row = segments + 1;
+    for (int stack = 0; stack < segments; ++stack)
+    {
+        for (int slice = 0; slice < segments; ++slice)
+        {
+            GLushort a = static_cast<GLushort>(stack * row + slice);
+            GLushort b = static_cast<GLushort>(a + row);
+            // Counter-clockwise seen from outside
+            lod.indices.push_back(a);
+            lod.indices.push_back(b);
+            lod.indices.push_back(static_cast<GLushort>(a + 1));
+            lod.indices.push_back(static_cast<GLushort>(a + 1));
+            lod.indices.push_back(b);
+            lod.indices.push_back(static_cast<GLushort>(b + 1));
+        }
+    }
+    lod.indexCount = static_cast<GLsizei>(lod.indices.size());
+}
+
+void sphereMeshInit()
+{
+    useBuffers = glHasVertexBufferObject;
+    size_t bytes = 0;
+    for (int i = 0; i < SPHERE_LOD_COUNT; ++i)
+    {
+        SphereLod &lod = lods[i];
+        buildLod(lod, lodSegments[i]);
+        bytes += lod.vertices.size() * sizeof(GLfloat) + lod.indices.size() * sizeof(GLushort);
+        if (!useBuffers)
+            continue;
+
+        pglGenBuffers(1, &lod.vertexBuffer);
+        pglBindBuffer(GL_ARRAY_BUFFER, lod.vertexBuffer);
+        pglBufferData(GL_ARRAY_BUFFER, lod.vertices.size() * sizeof(GLfloat), lod.vertices.data(), GL_STATIC_DRAW);
+        pglGenBuffers(1, &lod.indexBuffer);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod.indexBuffer);
+        pglBufferData(GL_ELEMENT_ARRAY_BUFFER, lod.indices.size() * sizeof(GLushort), lod.indices.data(), GL_STATIC_DRAW);
+        // The GPU copy is all that is needed from here on
+        std::vector<GLfloat>().swap(lod.vertices);
+        std::vector<GLushort>().swap(lod.indices);
+    }
+    if (useBuffers && shaderPipelineAvailable())
+    {
+        pglGenBuffers(1, &instanceBuffer);
+        for (SphereLod &lod : lods)
+        {
+            pglGenVertexArrays(1, &lod.vertexArray);
+            pglBindVertexArray(lod.vertexArray);
+            pglBindBuffer(GL_ARRAY_BUFFER, lod.vertexBuffer);
+            pglEnableVertexAttribArray(SHADER_ATTRIB_POSITION);
+            pglVertexAttribPointer(SHADER_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            pglEnableVertexAttribArray(SHADER_ATTRIB_NORMAL);
+            pglVertexAttribPointer(SHADER_ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod.indexBuffer);
+            shaderPipelineInstanceAttribs(instanceBuffer);
+        }
+        pglBindVertexArray(0);
+    }
+    if (useBuffers)
+    {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    std::cout << "Sphere meshes: " << SPHERE_LOD_COUNT << " levels, " << bytes / 1024 << " KiB"
+              << (useBuffers ? " in buffer objects" : " in client memory") << std::endl;
+}
+
+void sphereMeshSetProjection(float fovYDegrees, int viewportHeight)
+{
+    float halfFov = fovYDegrees * PI / 360.0f;
+    pixelsPerUnitAtOne = viewportHeight / (2.0f * std::tan(halfFov));
+}
+
+void sphereMeshSetLodBias(int bias)
+{
+    lodBias = bias;
+}
+
+int sphereLodSegments(int lod)
+{
+    return lodSegments[lod];
+}
+
+// Largest scale the modelview applies along any of its axes
+static float maxAxisScale(const float *m)
+{
+    return std::max(std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]),
+                    std::max(std::sqrt(m[4] * m[4] + m[5] * m[5] + m[6] * m[6]),
+                             std::sqrt(m[8] * m[8] + m[9] * m[9] + m[10] * m[10])));
+}
+
+int sphereLodForRadius(float radius)
+{
+    const float *m = rcModelview().m;
+    // Eye-space centre, and the largest axis scale of the current transform
+    float distance = std::sqrt(m[12] * m[12] + m[13] * m[13] + m[14] * m[14]);
+    float scale = maxAxisScale(m);
+    float eyeRadius = radius * scale;
+
+    int wanted = SPHERE_LOD_COUNT - 1;
+    if (distance > eyeRadius)
+    {
+        // A polygon of n sides strays r * (1 - cos(pi / n)) from its circle
+        float radiusPx = eyeRadius * pixelsPerUnitAtOne / distance;
+        float segments = 3.0f;
+        if (radiusPx > SILHOUETTE_TOLERANCE_PX)
+            segments = PI / std::acos(1.0f - SILHOUETTE_TOLERANCE_PX / radiusPx);
+        wanted = 0;
+        while (wanted < SPHERE_LOD_COUNT - 1 && lodSegments[wanted] < segments)
+            ++wanted;
+    }
+    return std::max(0, std::min(SPHERE_LOD_COUNT - 1, wanted + lodBias));
+}
+
+static int boundLod = -1;
+
+void sphereMeshBind(int lod)
+{
+    boundLod = lod;
+    if (shaderPipelineActive())
+        return; // Nothing to set up until the instances are drawn
+    const SphereLod &mesh = lods[lod];
+    const GLvoid *base = nullptr;
+    if (useBuffers)
+    {
+        pglBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    }
+    else
+    {
+        base = mesh.vertices.data();
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, base);
+    glNormalPointer(GL_FLOAT, 0, base);
+}
+
+static void drawPendingInstances()
+{
+    if (pendingInstances.empty())
+        return;
+    const SphereLod &mesh = lods[boundLod];
+    // Re-specifying the whole store each draw lets the driver orphan the old one
+    pglBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    pglBufferData(GL_ARRAY_BUFFER, pendingInstances.size() * sizeof(ShaderInstance), pendingInstances.data(), GL_STREAM_DRAW);
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    shaderPipelineUse();
+    pglBindVertexArray(mesh.vertexArray);
+    pglDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, nullptr,
+                             static_cast<GLsizei>(pendingInstances.size()));
+    pglBindVertexArray(0);
+    shaderPipelineRelease();
+    profilerCount(PROFILE_DRAW_CALLS);
+    pendingInstances.clear();
+}
+
+void sphereMeshUnbind()
+{
+    if (shaderPipelineActive())
+    {
+        drawPendingInstances();
+        boundLod = -1;
+        return;
+    }
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (useBuffers)
+    {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    boundLod = -1;
+}
+
+void sphereMeshDrawBound(const Mat4 &modelview, const GLubyte color[4])
+{
+    if (boundLod < 0)
+        return;
+    if (shaderPipelineActive())
+    {
+        ShaderInstance instance = {modelview, {color[0], color[1], color[2], color[3]}};
+        pendingInstances.push_back(instance);
+        return;
+    }
+    const SphereLod &mesh = lods[boundLod];
+    glColor4ubv(color);
+    glLoadMatrixf(modelview.m);
+    glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, useBuffers ? nullptr : mesh.indices.data());
+    profilerCount(PROFILE_DRAW_CALLS);
+}
+
+void drawSphere(float radius)
+{
+    drawSphereLod(radius, sphereLodForRadius(radius));
+}
+
+void drawSphereLod(float radius, int lod)
+{
+    renderQueueSphere(lod, radius); // GL_NORMALIZE keeps the lighting right
+}
+
+void drawSphereInstances(const SphereInstance *instances, int count)
+{
+    if (count <= 0)
+        return;
+    float largest = 0.0f;
+    for (int i = 0; i < count; ++i)
+        largest = std::max(largest, instances[i].radius);
+    int lod = sphereLodForRadius(largest);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const SphereInstance &s = instances[i];
+        rcPushMatrix();
+        rcTranslatef(s.x, s.y, s.z);
+        renderQueueSphere(lod, s.radius);
+        rcPopMatrix();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Math3D.h"
+#include <GL/glut.h>
+
+// Shared unit-sphere meshes, tessellated once at several levels of detail and
+// kept in buffer objects (client arrays if VBOs are unsupported). Replaces
+// glutSolidSphere, which rebuilds its geometry in immediate mode every call.
+
+// Number of detail levels; level 0 is the coarsest
+extern const int SPHERE_LOD_COUNT;
+
+// Builds and uploads every level. Call once with a current GL context, after
+// shaderPipelineInit.
+void sphereMeshInit();
+
+// Viewport the LOD selection projects into: vertical field of view in degrees
+// and the height in pixels of the target being rendered
+void sphereMeshSetProjection(float fovYDegrees, int viewportHeight);
+
+// Shifts the selected level, negative = coarser (set from the quality level)
+void sphereMeshSetLodBias(int bias);
+
+// Slices (= stacks) of a level
+int sphereLodSegments(int lod);
+
+// Level for a sphere of this radius centred at the current modelview origin,
+// chosen by its projected diameter in pixels and the LOD bias
+int sphereLodForRadius(float radius);
+
+// Draws a sphere at the current modelview origin (MatrixStack.h) like
+// glutSolidSphere. The draw goes through the render queue, which skips
+// spheres outside the view frustum and groups them by level.
+void drawSphere(float radius);
+void drawSphereLod(float radius, int lod);
+
+// Several spheres relative to the current modelview, sharing one LOD. The
+// level is picked from the largest instance.
+struct SphereInstance
+{
+    float x, y, z;
+    float radius;
+};
+void drawSphereInstances(const SphereInstance *instances, int count);
+
+// Submission, used by the render queue: bind a level once, then draw it with
+// each instance's transform (scale included) and colour. On the shader
+// pipeline the instances are collected and drawn in one instanced call at
+// unbind.
+void sphereMeshBind(int lod);
+void sphereMeshDrawBound(const Mat4 &modelview, const GLubyte color[4]);
+void sphereMeshUnbind();
@@ -0,0 +1,196 @@
+#include "StaticBuildings.h"
+#include "CampusLayout.h"
+#include "DefaultLayout.h"
+#include "StaticMesh.h"
+#include <array>
+#include <cstring>
+#include <utility>
+
+// The stock campus's distinct buildings, read by the compiler from the
+// building lines of DEFAULT_LAYOUT so the two cannot drift apart. Buildings
+// of any other kind or shape are baked at runtime as before.
+const int STOCK_SHAPE_MAX = 16;
+
+struct StockShape
+{
+    int kind; // LayoutBuildingKind
+    BuildingShape shape;
+};
+
+struct StockShapes
+{
+    StockShape shapes[STOCK_SHAPE_MAX];
+    int count;
+};
+
+struct StockField
+{
+    const char *begin;
+    int length;
+};
+
+constexpr bool stockSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Next field of the line at, moving at past it
+constexpr StockField stockField(const char *&at)
+{
+    while (stockSpace(*at))
+        ++at;
+    StockField field{at, 0};
+    while (*at != '\0' && *at != '\n' && !stockSpace(*at))
+    {
+        ++at;
+        ++field.length;
+    }
+    return field;
+}
+
+constexpr bool stockFieldIs(const StockField &field, const char *word)
+{
+    for (int i = 0; i < field.length; ++i)
+    {
+        if (word[i] != field.begin[i])
+            return false;
+    }
+    return word[field.length] == '\0';
+}
+
+// The plain decimals layouts use, rounded as strtof rounds them
+constexpr float stockFloat(const StockField &field)
+{
+    bool negative = field.length > 0 && field.begin[0] == '-';
+    double digits = 0.0, scale = 1.0;
+    bool fraction = false;
+    for (int i = negative ? 1 : 0; i < field.length; ++i)
+    {
+        if (field.begin[i] == '.')
+        {
+            fraction = true;
+            continue;
+        }
+        digits = digits * 10.0 + (field.begin[i] - '0');
+        if (fraction)
+            scale *= 10.0;
+    }
+    return static_cast<float>((negative ? -digits : digits) / scale);
+}
+
+constexpr bool stockSameShape(const StockShape &a, const StockShape &b)
+{
+    const BuildingShape &s = a.shape, &t = b.shape;
+    return a.kind == b.kind && s.width == t.width && s.height == t.height && s.depth == t.depth && s.r == t.r &&
+           s.g == t.g && s.b == t.b && s.windowsX == t.windowsX && s.windowsZ_front == t.windowsZ_front &&
+           s.windowsZ_side == t.windowsZ_side && s.floors == t.floors;
+}
+
+// building KIND X Y Z  WIDTH HEIGHT DEPTH  R G B  WINDOWS_X WINDOWS_FRONT WINDOWS_SIDE FLOORS ...
+constexpr StockShapes stockShapes(const char *text)
+{
+    StockShapes result{};
+    for (const char *at = text; *at != '\0';)
+    {
+        if (stockFieldIs(stockField(at), "building"))
+        {
+            StockField f[14]{};
+            for (StockField &field : f)
+                field = stockField(at);
+            StockShape stock{-1, {}};
+            for (int kind = 0; kind < LAYOUT_BUILDING_KIND_COUNT; ++kind)
+            {
+                if (stockFieldIs(f[0], LAYOUT_BUILDING_KIND_NAMES[kind]))
+                    stock.kind = kind;
+            }
+            stock.shape = {stockFloat(f[4]),
+                           stockFloat(f[5]),
+                           stockFloat(f[6]),
+                           stockFloat(f[7]),
+                           stockFloat(f[8]),
+                           stockFloat(f[9]),
+                           static_cast<int>(stockFloat(f[10])),
+                           static_cast<int>(stockFloat(f[11])),
+                           static_cast<int>(stockFloat(f[12])),
+                           static_cast<int>(stockFloat(f[13]))};
+            bool seen = false;
+            for (int i = 0; i < result.count; ++i)
+                seen = seen || stockSameShape(result.shapes[i], stock);
+            if (!seen)
+                result.shapes[result.count++] = stock; // Overflowing STOCK_SHAPE_MAX fails compilation
+        }
+        while (*at != '\0' && *at != '\n')
+            ++at;
+        if (*at == '\n')
+            ++at;
+    }
+    return result;
+}
+
+constexpr StockShapes STOCK_SHAPES = stockShapes(DEFAULT_LAYOUT);
+static_assert(STOCK_SHAPES.count > 0, "DEFAULT_LAYOUT has no buildings to precompile");
+
+template <int I>
+struct StockBuilding
+{
+    static_assert(STOCK_SHAPES.shapes[I].kind >= 0, "DEFAULT_LAYOUT has a building of unknown kind");
+    static constexpr BuildingShape shape = STOCK_SHAPES.shapes[I].shape;
+};
+
+struct StaticEntry
+{
+    const char *geometry;
+    const BuildingShape *shape;
+    const PackedVertex *vertices;
+    int vertexCount;
+    const GLushort *indices;
+    int indexCount;
+    const GLubyte *palette;
+    int paletteSize;
+    const float *boundsMin, *boundsMax;
+};
+
+template <int I>
+static StaticEntry staticEntry()
+{
+    typedef StaticBuilding<StockBuilding<I>::shape> Building;
+    const auto &mesh = Building::mesh;
+    return {LAYOUT_BUILDING_KIND_NAMES[STOCK_SHAPES.shapes[I].kind],
+            &StockBuilding<I>::shape,
+            mesh.vertices,
+            Building::faces.count * 4,
+            mesh.indices,
+            Building::faces.count * 6,
+            mesh.palette,
+            mesh.paletteSize,
+            mesh.boundsMin,
+            mesh.boundsMax};
+}
+
+template <int... I>
+static std::array<StaticEntry, sizeof...(I)> staticTable(std::integer_sequence<int, I...>)
+{
+    return {{staticEntry<I>()...}};
+}
+
+static const auto table = staticTable(std::make_integer_sequence<int, STOCK_SHAPES.count>());
+
+bool staticBuildingMesh(const BuildingShape &shape, const char *geometry, BakedMesh &mesh)
+{
+    for (const StaticEntry &entry : table)
+    {
+        if (std::strcmp(entry.geometry, geometry) != 0 || !sameBuildingShape(*entry.shape, shape))
+            continue;
+        mesh = BakedMesh();
+        mesh.id = meshBakeNewId();
+        mesh.packedView = entry.vertices;
+        mesh.packedViewCount = entry.vertexCount;
+        mesh.indexView = entry.indices;
+        mesh.palette.assign(entry.palette, entry.palette + entry.paletteSize * 4);
+        mesh.indexCount = entry.indexCount;
+        mesh.boundsMin = Vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+        mesh.boundsMax = Vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+        return true;
+    }
+    return false;
+}
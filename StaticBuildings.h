@@ -0,0 +1,9 @@
+#pragma once
+#include "BuildingMesh.h"
+#include "MeshBaker.h"
+
+// Meshes of the campus's own buildings, generated at compile time
+// (StaticMesh.h) from the shapes in DEFAULT_LAYOUT so they need no baking at
+// startup. Points mesh at the table's read-only data and returns true when
+// geometry (a BuildingGeometry name) and shape are one of them.
+bool staticBuildingMesh(const BuildingShape &shape, const char *geometry, BakedMesh &mesh);
@@ -0,0 +1,243 @@
+#pragma once
+#include "BakeGeometry.h"
+#include "BuildingMesh.h"
+#include "MeshBaker.h"
+
+// Compile-time building meshes. StaticBuilding<SHAPE>::mesh is the packed
+// mesh (PackedVertex, 16-bit indices, palette) for a constexpr BuildingShape,
+// evaluated by the compiler and emitted as read-only data. The boxes mirror
+// the geometry functions of the building files and go through the same face
+// rules as the runtime baker (BakeGeometry.h). Vertices are not welded or
+// reordered for the vertex cache: after merging, no two faces share a vertex
+// with the same normal and colour, so the runtime bakes weld nothing either
+// and both come out at 4 vertices per quad and an ACMR of 2.00 (academic
+// block: 406 triangles, 812 vertices), which no triangle order improves.
+// tests/StaticBuildingsTest.cpp checks the two against each other.
+
+const int STATIC_PALETTE_SIZE = 8;
+
+struct StaticBox
+{
+    BakeBox bounds;
+    GLubyte color[4];
+};
+
+constexpr GLubyte staticColorByte(float c)
+{
+    return c <= 0.0f ? 0 : c >= 1.0f ? 255 : static_cast<GLubyte>(c * 255.0f + 0.5f);
+}
+
+// Boxes the building files issue for a shape
+constexpr int staticBuildingBoxCount(const BuildingShape &s)
+{
+    int perFloor = 4 * ((s.windowsZ_front > 0 ? s.windowsZ_front : 0) + (s.windowsX > 0 ? s.windowsX : 0));
+    return 2 + s.floors * perFloor + (s.floors > 0 ? 1 : 0);
+}
+
+template <int N>
+struct StaticBoxSet
+{
+    StaticBox boxes[N];
+    int count;
+};
+
+template <int N>
+constexpr void staticAddBox(StaticBoxSet<N> &set, float x, float y, float z, float w, float h, float d, float r,
+                            float g, float b)
+{
+    StaticBox &box = set.boxes[set.count++];
+    const float center[3] = {x, y, z};
+    const float size[3] = {w, h, d};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        box.bounds.lo[axis] = center[axis] - 0.5f * size[axis];
+        box.bounds.hi[axis] = center[axis] + 0.5f * size[axis];
+    }
+    box.color[0] = staticColorByte(r);
+    box.color[1] = staticColorByte(g);
+    box.color[2] = staticColorByte(b);
+    box.color[3] = 255;
+}
+
+// Same boxes, sizes and colours as the building files' geometry functions
+template <int N>
+constexpr StaticBoxSet<N> staticBuildingBoxes(const BuildingShape &s)
+{
+    StaticBoxSet<N> set{};
+    float w = s.width, h = s.height, d = s.depth;
+    float r = s.r, g = s.g, b = s.b;
+    float cy = h / 2.0f;
+    staticAddBox(set, 0, cy, 0, w, h, d, r, g, b);
+    staticAddBox(set, 0, cy + h / 2.0f + 0.15f, 0, w + 0.5f, 0.3f, d + 0.5f, r * 0.6f, g * 0.6f, b * 0.6f);
+
+    float floorHeight = h / s.floors;
+    float windowWidth = w / (s.windowsX + 1) * 0.6f;
+    float windowHeight = floorHeight * 0.5f;
+    float windowDepth = 0.2f;
+    float doorWidth = windowWidth * 1.5f;
+    float doorHeight = floorHeight * 0.8f;
+    float fr = r * 0.5f, fg = g * 0.5f, fb = b * 0.5f;
+
+    for (int f = 0; f < s.floors; ++f)
+    {
+        float currentFloorY = -h / 2.0f + f * floorHeight + floorHeight * 0.2f;
+        float y = cy + (currentFloorY + windowHeight / 2.0f);
+        if (s.windowsZ_front > 0)
+        {
+            float spacing = d / (s.windowsZ_front + 1);
+            for (int i = 0; i < s.windowsZ_front; ++i)
+            {
+                float winZ = -d / 2.0f + (i + 1) * spacing - spacing / 2.0f;
+                for (int side = 1; side >= -1; side -= 2)
+                {
+                    float x = side * (w / 2.0f + windowDepth / 2.0f);
+                    staticAddBox(set, x, y, winZ, windowDepth, windowHeight, windowWidth * 0.8f, 0.5f, 0.7f, 0.8f);
+                    staticAddBox(set, x, y, winZ, windowDepth * 1.2f, windowHeight + 0.2f, windowWidth * 0.8f + 0.2f,
+                                 fr, fg, fb);
+                }
+            }
+        }
+        if (s.windowsX > 0)
+        {
+            float spacing = w / (s.windowsX + 1);
+            for (int i = 0; i < s.windowsX; ++i)
+            {
+                float winX = -w / 2.0f + (i + 1) * spacing - spacing / 2.0f;
+                for (int side = 1; side >= -1; side -= 2)
+                {
+                    float z = side * (d / 2.0f + windowDepth / 2.0f);
+                    staticAddBox(set, winX, y, z, windowWidth, windowHeight, windowDepth, 0.5f, 0.7f, 0.8f);
+                    staticAddBox(set, winX, y, z, windowWidth + 0.2f, windowHeight + 0.2f, windowDepth * 1.2f, fr,
+                                 fg, fb);
+                }
+            }
+        }
+        if (f == 0)
+        {
+            staticAddBox(set, w / 2.0f + windowDepth / 2.0f, cy + (-h / 2.0f + doorHeight / 2.0f), 0,
+                         windowDepth * 1.5f, doorHeight, doorWidth, r * 0.4f, g * 0.4f, b * 0.35f);
+        }
+    }
+    return set;
+}
+
+template <int N>
+struct StaticFaceSet
+{
+    BakeFace faces[N * 6];
+    int count;
+};
+
+template <int N>
+constexpr StaticFaceSet<N> staticOptimizedFaces(const StaticBoxSet<N> &set)
+{
+    BakeBox bounds[N]{};
+    for (int i = 0; i < set.count; ++i)
+        bounds[i] = set.boxes[i].bounds;
+
+    StaticFaceSet<N> result{};
+    for (int i = 0; i < set.count; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int sign = -1; sign <= 1; sign += 2)
+            {
+                BakeFace f = bakeBoxFace(bounds[i], axis, sign, set.boxes[i].color);
+                if (!bakeHideFace(f, bounds, set.count) && !bakeFaceEmpty(f))
+                    result.faces[result.count++] = f;
+            }
+        }
+    }
+    int merges = 0;
+    result.count = bakeMergeFaces(result.faces, result.count, merges);
+    return result;
+}
+
+template <int F>
+struct StaticMeshData
+{
+    PackedVertex vertices[F * 4];
+    GLushort indices[F * 6];
+    GLubyte palette[STATIC_PALETTE_SIZE * 4];
+    int paletteSize;
+    float boundsMin[3], boundsMax[3];
+};
+
+constexpr GLushort staticQuantize(float v, float lo, float hi)
+{
+    return hi > lo ? static_cast<GLushort>((v - lo) / (hi - lo) * 65535.0f + 0.5f) : 0;
+}
+
+// Octahedral encoding of an axis normal, as octahedralEncode does it
+constexpr void staticEncodeNormal(const float n[3], GLbyte out[2])
+{
+    float x = n[0], y = n[1];
+    if (n[2] < 0.0f)
+    {
+        float foldedX = (1.0f - bakeAbs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - bakeAbs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = static_cast<GLbyte>(x * 127.0f);
+    out[1] = static_cast<GLbyte>(y * 127.0f);
+}
+
+template <int F, int N>
+constexpr StaticMeshData<F> staticPackMesh(const StaticFaceSet<N> &set)
+{
+    StaticMeshData<F> mesh{};
+    float corners[F][4][3]{};
+    float normals[F][3]{};
+    for (int i = 0; i < F; ++i)
+        bakeFaceCorners(set.faces[i], corners[i], normals[i]);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        mesh.boundsMin[axis] = mesh.boundsMax[axis] = corners[0][0][axis];
+        for (int i = 0; i < F; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                mesh.boundsMin[axis] = bakeMin(mesh.boundsMin[axis], corners[i][c][axis]);
+                mesh.boundsMax[axis] = bakeMax(mesh.boundsMax[axis], corners[i][c][axis]);
+            }
+        }
+    }
+
+    for (int i = 0; i < F; ++i)
+    {
+        const GLubyte *color = set.faces[i].color;
+        int entry = 0;
+        while (entry < mesh.paletteSize &&
+               !(mesh.palette[entry * 4] == color[0] && mesh.palette[entry * 4 + 1] == color[1] &&
+                 mesh.palette[entry * 4 + 2] == color[2] && mesh.palette[entry * 4 + 3] == color[3]))
+            ++entry;
+        if (entry == mesh.paletteSize)
+        {
+            for (int k = 0; k < 4; ++k)
+                mesh.palette[entry * 4 + k] = color[k];
+            ++mesh.paletteSize; // Overflowing STATIC_PALETTE_SIZE fails compilation
+        }
+
+        for (int c = 0; c < 4; ++c)
+        {
+            PackedVertex &vertex = mesh.vertices[i * 4 + c];
+            for (int axis = 0; axis < 3; ++axis)
+                vertex.position[axis] = staticQuantize(corners[i][c][axis], mesh.boundsMin[axis], mesh.boundsMax[axis]);
+            staticEncodeNormal(normals[i], vertex.normal);
+            vertex.color = static_cast<GLubyte>(entry);
+        }
+        const int quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int k = 0; k < 6; ++k)
+            mesh.indices[i * 6 + k] = static_cast<GLushort>(i * 4 + quad[k]);
+    }
+    return mesh;
+}
+
+template <const BuildingShape &S>
+struct StaticBuilding
+{
+    static constexpr int boxCount = staticBuildingBoxCount(S);
+    static constexpr StaticFaceSet<boxCount> faces = staticOptimizedFaces(staticBuildingBoxes<boxCount>(S));
+    static constexpr StaticMeshData<faces.count> mesh = staticPackMesh<faces.count>(faces);
+};
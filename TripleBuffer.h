@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+
+// Lock-free single-producer/single-consumer triple buffer. The producer always
+// has a private slot to write into and the consumer always has a private slot
+// to read from; the third slot is handed between them with one atomic
+// exchange, so neither side ever waits on the other.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // Producer: slot to fill before calling publish()
+    T &writeSlot() { return slots[back]; }
+
+    // Producer: hands the filled slot to the consumer
+    void publish()
+    {
+        unsigned char old = middle.exchange(static_cast<unsigned char>(back | FRESH_BIT), std::memory_order_acq_rel);
+        back = old & INDEX_MASK;
+    }
+
+    // Consumer: picks up the newest published slot if there is one and
+    // returns the consumer's slot. Returns true when the slot changed.
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+        unsigned char old = middle.exchange(static_cast<unsigned char>(front), std::memory_order_acq_rel);
+        front = old & INDEX_MASK;
+        return true;
+    }
+
+    // Consumer: the most recent slot picked up by update()
+    const T &readSlot() const { return slots[front]; }
+
+private:
+    static const unsigned char INDEX_MASK = 0x3;
+    static const unsigned char FRESH_BIT = 0x4;
+
+    T slots[3];
+    std::atomic<unsigned char> middle; // Shared slot index plus the fresh flag
+    unsigned char back;                // Owned by the producer
+    unsigned char front;               // Owned by the consumer
+};
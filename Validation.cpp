@@ -0,0 +1,103 @@
+#include "Validation.h"
+#include "RenderBackend.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const ValidationShot shots[] = {
+    {"overview_day", {20.0f, -45.0f, 150.0f, {0.0f, 10.0f, 0.0f}}, 50.0f, 0.0f, false, 1},
+    {"overview_night", {20.0f, -45.0f, 150.0f, {0.0f, 10.0f, 0.0f}}, 130.0f, 0.0f, true, 1},
+    {"street_day", {8.0f, 230.0f, 60.0f, {-30.0f, 8.0f, 30.0f}}, 80.0f, 40.0f, false, 2},
+    {"street_night", {8.0f, 230.0f, 60.0f, {-30.0f, 8.0f, 30.0f}}, 160.0f, 40.0f, true, 2},
+    {"courts_day", {35.0f, 70.0f, 90.0f, {100.0f, 2.0f, -40.0f}}, 30.0f, 120.0f, false, 3},
+    {"courts_night", {35.0f, 70.0f, 90.0f, {100.0f, 2.0f, -40.0f}}, 150.0f, 120.0f, true, 3},
+};
+static const int SHOT_COUNT = sizeof(shots) / sizeof(shots[0]);
+
+bool validationCapture(const std::string &dir, ShotRenderer render)
+{
+    bool ok = true;
+    for (const ValidationShot &shot : shots)
+    {
+        Image image;
+        render(shot, image);
+        std::string path = dir + "/" + shot.name + ".ppm";
+        if (!writePpm(path, image))
+        {
+            std::cout << "Cannot write " << path << std::endl;
+            ok = false;
+        }
+    }
+    if (ok)
+        std::cout << "Captured " << SHOT_COUNT << " reference frames with the "
+                  << renderBackendInfo(renderBackendCurrent()).name << " backend into " << dir << std::endl;
+    return ok;
+}
+
+static void printResult(const ValidationShot &shot, const DiffResult &result)
+{
+    std::cout << "  " << std::left << std::setw(16) << shot.name << std::right;
+    if (!result.sizesMatch)
+    {
+        std::cout << "FAIL (size differs)" << std::endl;
+        return;
+    }
+    std::ostringstream line;
+    line << (result.passed ? "ok  " : "FAIL") << std::fixed << std::setprecision(3) << " failing "
+         << result.failFraction * 100.0 << "%" << std::setprecision(1) << ", max dE " << result.maxDeltaE;
+    std::cout << line.str() << std::endl;
+}
+
+bool validationCompareReference(const std::string &dir, ShotRenderer render, const DiffTolerance &tolerance)
+{
+    std::cout << "Validating the " << renderBackendInfo(renderBackendCurrent()).name << " backend against "
+              << dir << std::endl;
+    bool allPassed = true;
+    for (const ValidationShot &shot : shots)
+    {
+        Image reference, test, heatmap;
+        std::string base = dir + "/" + shot.name;
+        if (!readPpm(base + ".ppm", reference))
+        {
+            std::cout << "  " << shot.name << ": cannot read " << base << ".ppm" << std::endl;
+            allPassed = false;
+            continue;
+        }
+        render(shot, test);
+        DiffResult result = compareImages(reference, test, tolerance, &heatmap);
+        printResult(shot, result);
+        if (!result.passed)
+        {
+            allPassed = false;
+            writePpm(base + "_test.ppm", test);
+            if (result.sizesMatch)
+                writePpm(base + "_diff.ppm", heatmap);
+        }
+    }
+    return allPassed;
+}
+
+bool validationCompareBackends(int backendA, int backendB, ShotRenderer render, const DiffTolerance &tolerance)
+{
+    std::cout << "Validating " << renderBackendInfo(backendB).name << " against "
+              << renderBackendInfo(backendA).name << std::endl;
+    int previous = renderBackendCurrent();
+    bool allPassed = true;
+    for (const ValidationShot &shot : shots)
+    {
+        Image a, b, heatmap;
+        renderBackendSelect(backendA);
+        render(shot, a);
+        renderBackendSelect(backendB);
+        render(shot, b);
+        DiffResult result = compareImages(a, b, tolerance, &heatmap);
+        printResult(shot, result);
+        if (!result.passed)
+        {
+            allPassed = false;
+            writePpm(std::string("ab_") + shot.name + "_diff.ppm", heatmap);
+        }
+    }
+    renderBackendSelect(previous);
+    return allPassed;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Benchmark.h"
+#include "ImageDiff.h"
+#include <string>
+
+// Fixed shots of the scene (camera pose, time of day, cloud position, random
+// seed) rendered offscreen at full resolution and ultra quality, for
+// reference captures and pixel comparisons between render paths.
+
+struct ValidationShot
+{
+    const char *name;
+    CameraPose pose;
+    float sunAngle;
+    float cloudOffset;
+    bool night;
+    unsigned seed; // srand value before the clouds are generated and the scene drawn
+};
+
+// Renders one shot and reads back the 3D pass; supplied by the scene code
+typedef void (*ShotRenderer)(const ValidationShot &shot, Image &out);
+
+// Writes <dir>/<shot>.ppm for every shot with the current backend
+bool validationCapture(const std::string &dir, ShotRenderer render);
+
+// Renders every shot with the current backend and compares it with the
+// reference in dir; failures leave <shot>_test.ppm and <shot>_diff.ppm
+// (heatmap) next to it. True if all shots pass.
+bool validationCompareReference(const std::string &dir, ShotRenderer render, const DiffTolerance &tolerance);
+
+// Compares backend b against backend a on every shot, writing heatmaps of
+// failures to the working directory as ab_<shot>_diff.ppm. The current
+// backend is kept. True if all shots pass.
+bool validationCompareBackends(int backendA, int backendB, ShotRenderer render, const DiffTolerance &tolerance);
@@ -0,0 +1,349 @@
+#include "WorldPartition.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+enum ChunkState
+{
+    CHUNK_UNLOADED,
+    CHUNK_LOADING, // Meshes requested, not all uploaded
+    CHUNK_RESIDENT
+};
+
+struct WorldChunk
+{
+    std::vector<uint32_t> objects;          // AABB indices
+    std::vector<BuildingMeshHandle> meshes; // One per building while loading or resident
+    ChunkState state;
+    bool inRange;
+    unsigned lastInRange; // Update it was last in range at
+};
+
+const int CHUNK_LOADS_PER_FRAME = 4;          // Requesting meshes records new shapes on this thread
+const size_t UPLOAD_BYTES_PER_FRAME = 1 << 20;
+const int MAX_CHUNKS_PER_AXIS = 256;          // Wider layouts get larger chunks
+
+static const CampusLayout *layout = nullptr;
+static const BuildingGeometry *kindGeometry[LAYOUT_BUILDING_KIND_COUNT];
+static std::vector<WorldChunk> chunks;
+static std::vector<uint32_t> objectChunk; // Per AABB index
+static float originX = 0.0f, originZ = 0.0f, chunkSize = WORLD_CHUNK_SIZE;
+static int columns = 0, rows = 0;
+static std::vector<uint32_t> inRange;
+static std::vector<uint32_t> loaded; // Loading or resident, in load order
+static unsigned updates = 0;
+static unsigned generation = 0;
+static bool loadingInRange = false;
+static int dropped = 0; // Chunks evicted since the last report
+static bool overBudgetReported = false;
+static bool focused = false; // Updated at least once; a rebuild streams around the last focus
+static float lastFocus[2], lastRadius;
+
+BuildingShape layoutBuildingShape(const LayoutBuilding &b)
+{
+    return {b.size[0], b.size[1], b.size[2], b.color[0], b.color[1], b.color[2], b.windowsX, b.windowsZFront,
+            b.windowsZSide, b.floors};
+}
+
+static int cellOf(float v, float origin, int cells)
+{
+    int cell = static_cast<int>(std::floor((v - origin) / chunkSize));
+    return std::max(0, std::min(cells - 1, cell));
+}
+
+static void loadChunk(WorldChunk &chunk)
+{
+    for (uint32_t i : chunk.objects)
+    {
+        const LayoutAabb &box = layout->aabbs[i];
+        if (box.section != LAYOUT_BUILDINGS || box.index >= layout->buildingCount)
+            continue;
+        const LayoutBuilding &b = layout->buildings[box.index];
+        if (b.kind < LAYOUT_BUILDING_KIND_COUNT)
+            chunk.meshes.push_back(buildingMeshAcquire(layoutBuildingShape(b), *kindGeometry[b.kind]));
+    }
+    chunk.state = CHUNK_LOADING;
+}
+
+static void releaseChunk(WorldChunk &chunk)
+{
+    for (BuildingMeshHandle mesh : chunk.meshes)
+        buildingMeshRelease(mesh);
+    chunk.meshes.clear();
+    chunk.state = CHUNK_UNLOADED;
+}
+
+static float distanceSquared(uint32_t c, float x, float z)
+{
+    float minX = originX + static_cast<float>(c % columns) * chunkSize;
+    float minZ = originZ + static_cast<float>(c / columns) * chunkSize;
+    float dx = std::max(0.0f, std::max(minX - x, x - (minX + chunkSize)));
+    float dz = std::max(0.0f, std::max(minZ - z, z - (minZ + chunkSize)));
+    return dx * dx + dz * dz;
+}
+
+static void findInRange(float x, float z, float radius)
+{
+    std::vector<uint32_t> previous;
+    previous.swap(inRange);
+    ++updates;
+    int column0 = 0, column1 = columns - 1, row0 = 0, row1 = rows - 1;
+    if (radius > 0.0f)
+    {
+        column0 = cellOf(x - radius, originX, columns);
+        column1 = cellOf(x + radius, originX, columns);
+        row0 = cellOf(z - radius, originZ, rows);
+        row1 = cellOf(z + radius, originZ, rows);
+    }
+    for (int row = row0; row <= row1; ++row)
+    {
+        for (int column = column0; column <= column1; ++column)
+        {
+            uint32_t c = static_cast<uint32_t>(row * columns + column);
+            if (radius <= 0.0f || distanceSquared(c, x, z) <= radius * radius)
+            {
+                inRange.push_back(c);
+                chunks[c].lastInRange = updates;
+            }
+        }
+    }
+
+    // A resident chunk entering or leaving range switches between detail and proxies
+    for (uint32_t c : previous)
+    {
+        if (chunks[c].lastInRange == updates)
+            continue;
+        chunks[c].inRange = false;
+        if (chunks[c].state == CHUNK_RESIDENT)
+            ++generation;
+    }
+    for (uint32_t c : inRange)
+    {
+        if (chunks[c].inRange)
+            continue;
+        chunks[c].inRange = true;
+        if (chunks[c].state == CHUNK_RESIDENT)
+            ++generation;
+    }
+}
+
+static void evict(size_t budgetBytes)
+{
+    size_t bytes = buildingMeshBytes();
+    while (bytes > budgetBytes)
+    {
+        int victim = -1;
+        for (size_t i = 0; i < loaded.size(); ++i)
+        {
+            const WorldChunk &chunk = chunks[loaded[i]];
+            if (!chunk.inRange && (victim < 0 || chunk.lastInRange < chunks[loaded[victim]].lastInRange))
+                victim = static_cast<int>(i);
+        }
+        if (victim < 0)
+        {
+            if (!overBudgetReported)
+                std::cout << "Streaming: the chunks in range need " << bytes / 1048576.0 << " MB of building meshes, over the "
+                          << budgetBytes / 1048576.0 << " MB budget" << std::endl;
+            overBudgetReported = true;
+            break;
+        }
+        releaseChunk(chunks[loaded[victim]]);
+        loaded.erase(loaded.begin() + victim);
+        ++dropped;
+        bytes = buildingMeshBytes();
+    }
+    if (bytes <= budgetBytes)
+        overBudgetReported = false;
+}
+
+// Once the chunks in range have all come in
+static void report(size_t budgetBytes)
+{
+    int resident = 0;
+    for (uint32_t c : loaded)
+        resident += chunks[c].state == CHUNK_RESIDENT;
+    std::cout << "Streaming: " << inRange.size() << " chunks in range, " << resident << " resident, "
+              << buildingMeshCount() << " building meshes in " << buildingMeshBytes() / 1048576.0 << " of "
+              << budgetBytes / 1048576.0 << " MB; " << dropped << " chunks dropped to stay within it" << std::endl;
+    dropped = 0;
+}
+
+static void streamAround(float x, float z, float radius, size_t budgetBytes, int maxLoads, bool wait)
+{
+    focused = true;
+    lastFocus[0] = x;
+    lastFocus[1] = z;
+    lastRadius = radius;
+    findInRange(x, z, radius);
+
+    std::vector<std::pair<float, uint32_t>> wanted; // Nearest first
+    for (uint32_t c : inRange)
+    {
+        if (chunks[c].state == CHUNK_UNLOADED)
+            wanted.push_back({distanceSquared(c, x, z), c});
+    }
+    std::sort(wanted.begin(), wanted.end());
+    for (size_t i = 0; i < wanted.size() && static_cast<int>(i) < maxLoads; ++i)
+    {
+        loadChunk(chunks[wanted[i].second]);
+        loaded.push_back(wanted[i].second);
+    }
+
+    buildingMeshStream(wait ? SIZE_MAX : UPLOAD_BYTES_PER_FRAME, wait);
+    for (uint32_t c : loaded)
+    {
+        WorldChunk &chunk = chunks[c];
+        if (chunk.state != CHUNK_LOADING || !std::all_of(chunk.meshes.begin(), chunk.meshes.end(), buildingMeshReady))
+            continue;
+        chunk.state = CHUNK_RESIDENT;
+        if (chunk.inRange)
+            ++generation;
+    }
+    bool wasLoading = loadingInRange;
+    loadingInRange = std::any_of(inRange.begin(), inRange.end(),
+                                 [](uint32_t c) { return chunks[c].state != CHUNK_RESIDENT; });
+    evict(budgetBytes);
+    if (wasLoading && !loadingInRange && !wait)
+        report(budgetBytes);
+}
+
+void worldPartitionBuild(const CampusLayout &newLayout,
+                         const BuildingGeometry *const geometries[LAYOUT_BUILDING_KIND_COUNT])
+{
+    std::vector<WorldChunk> previous;
+    previous.swap(chunks);
+    layout = &newLayout;
+    std::copy(geometries, geometries + LAYOUT_BUILDING_KIND_COUNT, kindGeometry);
+
+    float lo[2] = {FLT_MAX, FLT_MAX}, hi[2] = {-FLT_MAX, -FLT_MAX};
+    for (uint32_t i = 0; i < layout->aabbCount; ++i)
+    {
+        const LayoutAabb &box = layout->aabbs[i];
+        float center[2] = {0.5f * (box.min[0] + box.max[0]), 0.5f * (box.min[2] + box.max[2])};
+        for (int k = 0; k < 2; ++k)
+        {
+            lo[k] = std::min(lo[k], center[k]);
+            hi[k] = std::max(hi[k], center[k]);
+        }
+    }
+    if (layout->aabbCount == 0)
+        lo[0] = lo[1] = hi[0] = hi[1] = 0.0f;
+    chunkSize = WORLD_CHUNK_SIZE;
+    while (std::max(hi[0] - lo[0], hi[1] - lo[1]) / chunkSize >= MAX_CHUNKS_PER_AXIS)
+        chunkSize *= 2.0f;
+    originX = lo[0];
+    originZ = lo[1];
+    columns = static_cast<int>((hi[0] - lo[0]) / chunkSize) + 1;
+    rows = static_cast<int>((hi[1] - lo[1]) / chunkSize) + 1;
+
+    WorldChunk empty = {};
+    chunks.assign(static_cast<size_t>(columns) * rows, empty);
+    objectChunk.resize(layout->aabbCount);
+    for (uint32_t i = 0; i < layout->aabbCount; ++i)
+    {
+        const LayoutAabb &box = layout->aabbs[i];
+        int column = cellOf(0.5f * (box.min[0] + box.max[0]), originX, columns);
+        int row = cellOf(0.5f * (box.min[2] + box.max[2]), originZ, rows);
+        objectChunk[i] = static_cast<uint32_t>(row * columns + column);
+        chunks[objectChunk[i]].objects.push_back(i);
+    }
+    inRange.clear();
+    loaded.clear();
+    ++generation;
+
+    // Hold on to the old chunks' meshes until the new ones have asked for theirs
+    if (focused)
+        streamAround(lastFocus[0], lastFocus[1], lastRadius, SIZE_MAX, static_cast<int>(chunks.size()), false);
+    for (WorldChunk &chunk : previous)
+        releaseChunk(chunk);
+    std::cout << "World partition: " << columns << "x" << rows << " chunks of " << static_cast<int>(chunkSize) << std::endl;
+}
+
+void worldPartitionApply(const CampusLayout &newLayout, const LayoutDiff &diff)
+{
+    layout = &newLayout;
+    uint32_t count = layout->aabbCount;
+    if (diff.aabbs.remap.size() != objectChunk.size())
+    {
+        worldPartitionBuild(newLayout, kindGeometry);
+        return;
+    }
+    std::vector<uint32_t> newChunk(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const LayoutAabb &box = layout->aabbs[i];
+        float x = 0.5f * (box.min[0] + box.max[0]), z = 0.5f * (box.min[2] + box.max[2]);
+        if (x < originX || x >= originX + columns * chunkSize || z < originZ || z >= originZ + rows * chunkSize)
+        {
+            worldPartitionBuild(newLayout, kindGeometry); // Past the grid's edge
+            return;
+        }
+        newChunk[i] = static_cast<uint32_t>(cellOf(z, originZ, rows) * columns + cellOf(x, originX, columns));
+    }
+
+    // Chunks an object changed in, on either side of the reload
+    std::vector<bool> changed(count, false), dirty(chunks.size(), false);
+    for (const std::vector<uint32_t> *list : {&diff.aabbs.added, &diff.aabbs.modified})
+    {
+        for (uint32_t i : *list)
+        {
+            changed[i] = true;
+            dirty[newChunk[i]] = true;
+        }
+    }
+    for (uint32_t i = 0; i < diff.aabbs.remap.size(); ++i)
+    {
+        uint32_t to = diff.aabbs.remap[i];
+        if (to == LAYOUT_NO_INDEX || changed[to])
+            dirty[objectChunk[i]] = true;
+    }
+
+    objectChunk.swap(newChunk);
+    for (WorldChunk &chunk : chunks)
+        chunk.objects.clear();
+    for (uint32_t i = 0; i < count; ++i)
+        chunks[objectChunk[i]].objects.push_back(i);
+    int reloaded = 0;
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        WorldChunk &chunk = chunks[c];
+        if (!dirty[c] || chunk.state == CHUNK_UNLOADED)
+            continue;
+        // Requested before the old meshes let go, so shapes that stayed are kept
+        std::vector<BuildingMeshHandle> previous;
+        previous.swap(chunk.meshes);
+        loadChunk(chunk);
+        for (BuildingMeshHandle mesh : previous)
+            buildingMeshRelease(mesh);
+        ++reloaded;
+    }
+    ++generation;
+    std::cout << "World partition: " << reloaded << " of " << loaded.size() << " loaded chunks reloaded" << std::endl;
+}
+
+void worldPartitionUpdate(float focusX, float focusZ, float radius, size_t budgetBytes, bool wait)
+{
+    streamAround(focusX, focusZ, radius, budgetBytes, wait ? static_cast<int>(chunks.size()) : CHUNK_LOADS_PER_FRAME,
+                 wait);
+}
+
+bool worldPartitionDetailed(uint32_t aabbIndex)
+{
+    if (aabbIndex >= objectChunk.size())
+        return false;
+    const WorldChunk &chunk = chunks[objectChunk[aabbIndex]];
+    return chunk.inRange && chunk.state == CHUNK_RESIDENT;
+}
+
+unsigned worldPartitionGeneration()
+{
+    return generation;
+}
+
+bool worldPartitionLoading()
+{
+    return loadingInRange;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "BuildingMesh.h"
+#include "CampusLayout.h"
+#include "LayoutDiff.h"
+#include <cstddef>
+#include <cstdint>
+
+// Streams the layout in square chunks around a focus point, the camera's
+// look-at. Each chunk owns the objects whose AABB centre lies in it. Chunks
+// within the stream radius are loaded, nearest first: their building meshes
+// are requested from BuildingMesh.h, which bakes missing shapes on worker
+// threads and uploads a few per frame. A chunk is resident once all of its
+// meshes are. Objects of chunks that are out of range or still loading are
+// drawn as coarse proxies.
+//
+// Resident chunks out of range stay cached for when the focus comes back,
+// until the building meshes outgrow the memory budget; then the chunks wanted
+// least recently are dropped, and with them meshes no other chunk uses. Only
+// the chunks in range are ever kept over budget, so memory follows the radius
+// and not the size of the estate.
+
+const float WORLD_CHUNK_SIZE = 128.0f;
+
+// Shape a layout building is baked as
+BuildingShape layoutBuildingShape(const LayoutBuilding &building);
+
+// Partitions a newly loaded or reloaded layout. After a reload the chunks in
+// range are requested again before the old ones let go, so meshes for shapes
+// that stayed are kept rather than baked again.
+void worldPartitionBuild(const CampusLayout &layout,
+                         const BuildingGeometry *const geometries[LAYOUT_BUILDING_KIND_COUNT]);
+// Applies a reload in place: objects are renumbered, and only the loaded
+// chunks that gained, lost or changed an object request their meshes again.
+// A layout that no longer fits the chunk grid is partitioned anew.
+void worldPartitionApply(const CampusLayout &layout, const LayoutDiff &diff);
+// Once per frame before drawing; radius 0 keeps the whole layout in range.
+// With wait set the chunks in range are resident when it returns, as pixel
+// validation and benchmark frames need.
+void worldPartitionUpdate(float focusX, float focusZ, float radius, size_t budgetBytes, bool wait);
+
+// True if the object with this AABB index draws in full detail this frame
+bool worldPartitionDetailed(uint32_t aabbIndex);
+// Changes whenever the set of objects drawn in detail does
+unsigned worldPartitionGeneration();
+bool worldPartitionLoading(); // Chunks in range are not all resident yet
@@ -1,10 +1,13 @@
 #include <GL/glut.h>
 #include <iostream>
 #include "Campus.h"
+#include "Options.h"
 
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_ALPHA);
+    if (!parseCampusOptions(argc, argv))
+        return 1;
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL | GLUT_ALPHA);
     glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
     glutInitWindowPosition(50, 50);
     glutCreateWindow("3D Smart Campus Simulation - Enhanced Realism");
@@ -28,6 +31,14 @@ int main(int argc, char** argv) {
     std::cout << "  Mouse Right Drag: Pan Camera" << std::endl;
     std::cout << "  Mouse Wheel: Zoom Camera" << std::endl;
     std::cout << "  Arrow Keys: Pan Camera" << std::endl;
+    std::cout << "  +/-: Faster/Slower Simulation" << std::endl;
+    std::cout << "  F: Cycle Render Rate (60/30/144 Hz/On Demand)" << std::endl;
+    std::cout << "  R: Toggle Dynamic Resolution" << std::endl;
+    std::cout << "  P: Toggle Profiler Report" << std::endl;
+    std::cout << "  O: Toggle Overdraw Heatmap" << std::endl;
+    std::cout << "  Q: Cycle Quality (Auto/Low/Medium/High/Ultra)" << std::endl;
+    std::cout << "  B: Cycle Render Backend (Legacy/Shader)" << std::endl;
+    std::cout << "  A: A/B Benchmark (Current vs Next Backend)" << std::endl;
     std::cout << "  ESC: Exit" << std::endl;
 
     glutMainLoop();
@@ -0,0 +1,132 @@
+// Checks that a layout reload that only reorders records still renumbers the
+// objects: the diff reports no changes but new AABB indices, and the BVH
+// updated from it finds every object under its new index and box.
+//
+//   g++ -std=c++17 -I.. LayoutReloadTest.cpp ../LayoutCompiler.cpp ../CampusLayout.cpp ../LayoutDiff.cpp ../LayoutBvh.cpp ../MappedFile.cpp ../Math3D.cpp -o layoutreloadtest
+
+#include "CampusLayout.h"
+#include "LayoutBvh.h"
+#include "LayoutCompiler.h"
+#include "LayoutDiff.h"
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char *name)
+{
+    std::cout << (passed ? "ok   " : "FAIL ") << name << std::endl;
+    if (!passed)
+        ++failures;
+}
+
+static bool compile(const std::string &text, std::vector<unsigned char> &image, CampusLayout &layout)
+{
+    std::string error;
+    if (layoutCompileText(text, image, error) && campusLayoutView(image.data(), image.size(), layout, error))
+        return true;
+    std::cout << "Cannot compile the layout: " << error << std::endl;
+    return false;
+}
+
+// The default layout with the first and last lines of each object kind swapped
+static std::string permuted(const std::string &text)
+{
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    for (std::string line; std::getline(in, line);)
+        lines.push_back(line);
+    for (const char *kind : {"building ", "tree ", "road "})
+    {
+        int first = -1, last = -1;
+        for (int i = 0; i < static_cast<int>(lines.size()); ++i)
+        {
+            if (lines[i].compare(0, std::string(kind).size(), kind) != 0)
+                continue;
+            if (first < 0)
+                first = i;
+            last = i;
+        }
+        if (first >= 0 && last > first)
+            std::swap(lines[first], lines[last]);
+    }
+    std::string out;
+    for (const std::string &line : lines)
+        out += line + "\n";
+    return out;
+}
+
+static bool sameBox(const LayoutAabb &a, const LayoutAabb &b)
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        if (a.min[k] != b.min[k] || a.max[k] != b.max[k])
+            return false;
+    }
+    return true;
+}
+
+// A ray straight down through the middle of each box must hit it under its
+// index, and every hit must be a box the ray really enters
+static bool bvhFindsEveryObject(const CampusLayout &layout)
+{
+    std::vector<uint32_t> hits;
+    for (uint32_t i = 0; i < layout.aabbCount; ++i)
+    {
+        const LayoutAabb &box = layout.aabbs[i];
+        Vec3 origin(0.5f * (box.min[0] + box.max[0]), box.max[1] + 100.0f, 0.5f * (box.min[2] + box.max[2]));
+        layoutBvhRay(origin, Vec3(0.0f, -1.0f, 0.0f), hits);
+        bool found = false;
+        for (uint32_t hit : hits)
+        {
+            const LayoutAabb &other = layout.aabbs[hit];
+            if (origin.x < other.min[0] || origin.x > other.max[0] || origin.z < other.min[2] ||
+                origin.z > other.max[2])
+                return false;
+            found = found || hit == i;
+        }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    std::vector<unsigned char> oldImage, newImage;
+    CampusLayout from, to;
+    if (!compile(campusLayoutDefaultText(), oldImage, from) || !compile(permuted(campusLayoutDefaultText()), newImage, to))
+        return 1;
+
+    LayoutDiff same;
+    layoutDiff(from, from, same);
+    check(layoutDiffChanges(same) == 0 && layoutDiffKeepsIndices(same, from.aabbCount),
+          "an unedited layout keeps every index");
+
+    LayoutDiff diff;
+    layoutDiff(from, to, diff);
+    check(layoutDiffChanges(diff) == 0 && !diff.routeChanged, "reordered records count as unchanged");
+    check(!layoutDiffKeepsIndices(diff, to.aabbCount), "reordered records are renumbered");
+    bool remapped = diff.aabbs.remap.size() == from.aabbCount;
+    for (uint32_t i = 0; remapped && i < from.aabbCount; ++i)
+    {
+        uint32_t j = diff.aabbs.remap[i];
+        remapped = j < to.aabbCount && sameBox(from.aabbs[i], to.aabbs[j]);
+    }
+    check(remapped, "each old index maps to the same box in the new layout");
+
+    layoutBvhBuild(from);
+    check(bvhFindsEveryObject(from), "the BVH finds every object before the reload");
+    layoutBvhUpdate(to, diff);
+    check(bvhFindsEveryObject(to), "the updated BVH finds every object under its new index");
+
+    if (failures > 0)
+    {
+        std::cout << failures << " failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All passed" << std::endl;
+    return 0;
+}
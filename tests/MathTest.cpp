@@ -0,0 +1,166 @@
+// Checks the CPU matrix code against GL's own: Mat4 multiply and inverse,
+// the rc* modelview stack and rcSyncModelview. Needs a window for a GL
+// context; exits non-zero if anything fails.
+//
+//   g++ -std=c++17 -I.. MathTest.cpp ../Math3D.cpp ../MatrixStack.cpp -o mathtest -lglut -lGLU -lGL
+
+#include "Math3D.h"
+#include "MatrixStack.h"
+#include <GL/glut.h>
+#include <cmath>
+#include <iostream>
+
+const float TOLERANCE = 1e-4f; // Relative to the largest element
+
+static int failures = 0;
+
+static void check(bool passed, const char *name)
+{
+    std::cout << (passed ? "ok   " : "FAIL ") << name << std::endl;
+    if (!passed)
+        ++failures;
+}
+
+static bool near(const Mat4 &a, const Mat4 &b)
+{
+    float scale = 1.0f;
+    for (int i = 0; i < 16; ++i)
+        scale = std::fmax(scale, std::fmax(std::fabs(a.m[i]), std::fabs(b.m[i])));
+    for (int i = 0; i < 16; ++i)
+    {
+        if (std::fabs(a.m[i] - b.m[i]) > TOLERANCE * scale)
+            return false;
+    }
+    return true;
+}
+
+static Mat4 glModelview()
+{
+    Mat4 m;
+    glGetFloatv(GL_MODELVIEW_MATRIX, m.m);
+    return m;
+}
+
+// Row by column, as written out
+static Mat4 reference(const Mat4 &a, const Mat4 &b)
+{
+    Mat4 product;
+    for (int r = 0; r < 4; ++r)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k)
+                sum += a.at(r, k) * b.at(k, c);
+            product.m[c * 4 + r] = sum;
+        }
+    }
+    return product;
+}
+
+static void testMultiply()
+{
+    Mat4 a = mat4Translation(3.0f, -2.0f, 7.5f) * mat4Rotation(37.0f, Vec3(1.0f, 2.0f, -0.5f));
+    Mat4 b = mat4Perspective(60.0f, 1.5f, 0.5f, 800.0f) * mat4Scale(2.0f, 0.5f, -1.25f);
+    check(near(a * b, reference(a, b)), "Mat4 multiply matches the written-out product");
+
+    glLoadMatrixf(a.m);
+    glMultMatrixf(b.m);
+    check(near(a * b, glModelview()), "Mat4 multiply matches glMultMatrixf");
+
+    Vec4 v(1.0f, -4.0f, 2.5f, 1.0f);
+    Vec4 viaRows(dot(a.row(0), v), dot(a.row(1), v), dot(a.row(2), v), dot(a.row(3), v));
+    Vec4 product = a * v;
+    check(std::fabs(product.x - viaRows.x) < TOLERANCE && std::fabs(product.y - viaRows.y) < TOLERANCE &&
+              std::fabs(product.z - viaRows.z) < TOLERANCE && std::fabs(product.w - viaRows.w) < TOLERANCE,
+          "Mat4 times Vec4 matches the row dot products");
+}
+
+static void testInverse()
+{
+    Mat4 view = mat4LookAt(Vec3(40.0f, 25.0f, -60.0f), Vec3(0.0f, 5.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+    check(near(view * inverse(view), Mat4()), "inverse of a view matrix");
+    Mat4 model = mat4Translation(-12.0f, 0.0f, 4.0f) * mat4Rotation(-75.0f, Vec3(0.0f, 1.0f, 0.0f)) *
+                 mat4Scale(3.0f, 0.25f, 8.0f);
+    check(near(inverse(model) * model, Mat4()), "inverse of a scaled model matrix");
+    Mat4 projection = mat4Perspective(45.0f, 4.0f / 3.0f, 1.0f, 500.0f);
+    check(near(projection * inverse(projection), Mat4()), "inverse of a perspective projection");
+    check(near(inverse(mat4Scale(1.0f, 0.0f, 1.0f)), Mat4()), "inverse of a singular matrix is the identity");
+}
+
+// The same transforms through the rc* stack and through GL's must agree
+static void testStack()
+{
+    glMatrixMode(GL_MODELVIEW);
+    Mat4 view = mat4LookAt(Vec3(0.0f, 30.0f, 90.0f), Vec3(), Vec3(0.0f, 1.0f, 0.0f));
+    rcLoadMatrix(view);
+    glLoadMatrixf(view.m);
+
+    rcPushMatrix();
+    glPushMatrix();
+    rcTranslatef(10.0f, 0.0f, -5.0f);
+    glTranslatef(10.0f, 0.0f, -5.0f);
+    rcRotatef(30.0f, 0.0f, 1.0f, 0.0f);
+    glRotatef(30.0f, 0.0f, 1.0f, 0.0f);
+    rcScalef(2.0f, 3.0f, 0.5f);
+    glScalef(2.0f, 3.0f, 0.5f);
+    check(near(rcModelview(), glModelview()), "rcTranslatef, rcRotatef and rcScalef match GL");
+
+    rcPushMatrix();
+    glPushMatrix();
+    rcRotatef(-110.0f, 1.0f, 1.0f, 0.0f);
+    glRotatef(-110.0f, 1.0f, 1.0f, 0.0f);
+    check(near(rcModelview(), glModelview()), "rcRotatef about a diagonal axis matches GL");
+    rcPopMatrix();
+    glPopMatrix();
+    check(near(rcModelview(), glModelview()), "rcPopMatrix restores the pushed matrix");
+    rcPopMatrix();
+    glPopMatrix();
+    check(near(rcModelview(), view), "rcPopMatrix returns to the bottom of the stack");
+    rcPopMatrix(); // Never pops the bottom
+    check(near(rcModelview(), view), "rcPopMatrix keeps the bottom matrix");
+}
+
+static void testSync()
+{
+    glMatrixMode(GL_MODELVIEW);
+    Mat4 m = mat4Translation(1.0f, 2.0f, 3.0f) * mat4Rotation(45.0f, Vec3(0.0f, 0.0f, 1.0f));
+    rcLoadMatrix(m);
+    rcSyncModelview();
+    check(near(glModelview(), m), "rcSyncModelview loads the top of the stack");
+
+    rcPushMatrix();
+    rcTranslatef(0.0f, -8.0f, 0.0f);
+    rcSyncModelview();
+    check(near(glModelview(), rcModelview()), "rcSyncModelview after a push and translate");
+    rcPopMatrix();
+    rcSyncModelview();
+    check(near(glModelview(), m), "rcSyncModelview after a pop");
+
+    glLoadIdentity();
+    rcSyncModelview();
+    check(near(glModelview(), Mat4()), "rcSyncModelview skips the load while nothing changed");
+    rcModelviewChanged();
+    rcSyncModelview();
+    check(near(glModelview(), m), "rcSyncModelview reloads after rcModelviewChanged");
+}
+
+int main(int argc, char **argv)
+{
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(64, 64);
+    glutCreateWindow("Math test");
+
+    testMultiply();
+    testInverse();
+    testStack();
+    testSync();
+    if (failures > 0)
+    {
+        std::cout << failures << " failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All passed" << std::endl;
+    return 0;
+}
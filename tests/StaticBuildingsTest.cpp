@@ -0,0 +1,110 @@
+// Checks the compile-time building meshes against runtime bakes: every
+// building of the default layout must find its precompiled mesh under its own
+// geometry and no other, with the triangles, vertices and bounds that baking
+// its geometry at runtime gives.
+//
+//   g++ -std=c++17 -I.. StaticBuildingsTest.cpp ../StaticBuildings.cpp ../MeshBaker.cpp ../MeshOptimizer.cpp ../AcademicBlock.cpp ../AdminBlock.cpp ../Cafe.cpp ../Dormitory.cpp ../Library.cpp ../CampusLayout.cpp ../LayoutCompiler.cpp ../LayoutDiff.cpp ../MappedFile.cpp ../Math3D.cpp ../MatrixStack.cpp ../CubeBatch.cpp ../RenderQueue.cpp ../GLState.cpp ../GLExt.cpp ../ShaderPipeline.cpp ../ImmediateMode.cpp ../SphereMesh.cpp ../Quality.cpp ../BuildingMesh.cpp ../MeshCache.cpp ../WorldPartition.cpp ../Options.cpp ../Profiler.cpp ../RenderBackend.cpp -o staticbuildingstest -lglut -lGLU -lGL
+
+#include "AcademicBlock.h"
+#include "AdminBlock.h"
+#include "Cafe.h"
+#include "CampusLayout.h"
+#include "Dormitory.h"
+#include "LayoutCompiler.h"
+#include "Library.h"
+#include "MatrixStack.h"
+#include "MeshBaker.h"
+#include "MeshOptimizer.h"
+#include "StaticBuildings.h"
+#include "WorldPartition.h"
+#include <GL/glut.h>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const float TOLERANCE = 1e-3f; // World units
+
+static const BuildingGeometry *const geometries[LAYOUT_BUILDING_KIND_COUNT] = {
+    &ACADEMIC_BLOCK_GEOMETRY, &LIBRARY_GEOMETRY, &DORMITORY_GEOMETRY, &ADMIN_BLOCK_GEOMETRY, &CAFE_GEOMETRY};
+
+static int failures = 0;
+
+static void check(bool passed, const std::string &name)
+{
+    std::cout << (passed ? "ok   " : "FAIL ") << name << std::endl;
+    if (!passed)
+        ++failures;
+}
+
+static bool near(const Vec3 &a, const Vec3 &b)
+{
+    return std::fabs(a.x - b.x) < TOLERANCE && std::fabs(a.y - b.y) < TOLERANCE && std::fabs(a.z - b.z) < TOLERANCE;
+}
+
+static void bake(const BuildingShape &shape, const BuildingGeometry &geometry, BakedMesh &mesh)
+{
+    rcPushMatrix();
+    rcLoadMatrix(Mat4());
+    meshBakeBegin();
+    geometry.build(shape);
+    MeshBakeStats stats;
+    meshBakeEnd(mesh, stats);
+    rcPopMatrix();
+    MeshOptimizeStats optimized;
+    meshOptimize(mesh, optimized);
+}
+
+int main(int argc, char **argv)
+{
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(64, 64);
+    glutCreateWindow("Static buildings test");
+
+    std::vector<unsigned char> image;
+    CampusLayout layout;
+    std::string error;
+    if (!layoutCompileText(campusLayoutDefaultText(), image, error) ||
+        !campusLayoutView(image.data(), image.size(), layout, error))
+    {
+        std::cout << "Cannot compile the default layout: " << error << std::endl;
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < layout.buildingCount; ++i)
+    {
+        const LayoutBuilding &b = layout.buildings[i];
+        const BuildingGeometry &geometry = *geometries[b.kind];
+        BuildingShape shape = layoutBuildingShape(b);
+        std::string name = std::string(layoutString(layout, b.name)) + ": ";
+
+        BakedMesh precompiled;
+        bool found = staticBuildingMesh(shape, geometry.name, precompiled);
+        check(found, name + "precompiled");
+        if (!found)
+            continue;
+        bool otherGeometry = false;
+        for (const BuildingGeometry *other : geometries)
+        {
+            BakedMesh unused;
+            otherGeometry = otherGeometry || (other != &geometry && staticBuildingMesh(shape, other->name, unused));
+        }
+        check(!otherGeometry, name + "not precompiled under another geometry");
+
+        BakedMesh baked;
+        bake(shape, geometry, baked);
+        check(precompiled.indexCount == baked.indexCount, name + "same triangles as the runtime bake");
+        check(bakedMeshPackedCount(precompiled) == bakedMeshPackedCount(baked), name + "same vertices as the runtime bake");
+        check(near(precompiled.boundsMin, baked.boundsMin) && near(precompiled.boundsMax, baked.boundsMax),
+              name + "same bounds as the runtime bake");
+    }
+
+    if (failures > 0)
+    {
+        std::cout << failures << " failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All passed" << std::endl;
+    return 0;
+}
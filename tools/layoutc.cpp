@@ -0,0 +1,86 @@
+// Compiles a text campus layout into the binary file the campus maps at
+// startup (--layout=FILE).
+//
+//   g++ -std=c++17 -I.. layoutc.cpp ../LayoutCompiler.cpp ../CampusLayout.cpp ../LayoutDiff.cpp ../MappedFile.cpp -o layoutc
+//
+//   layoutc INPUT.txt OUTPUT.layout   Compile a layout
+//   layoutc --default OUTPUT.layout   Compile the built-in campus
+//   layoutc --print-default           Print the built-in campus as text, to start a layout from
+
+#include "CampusLayout.h"
+#include "LayoutCompiler.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " INPUT.txt OUTPUT.layout" << std::endl;
+    std::cout << "       " << program << " --default OUTPUT.layout" << std::endl;
+    std::cout << "       " << program << " --print-default" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && std::strcmp(argv[1], "--print-default") == 0)
+    {
+        std::cout << campusLayoutDefaultText();
+        return 0;
+    }
+    if (argc != 3)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string text;
+    if (std::strcmp(argv[1], "--default") == 0)
+    {
+        text = campusLayoutDefaultText();
+    }
+    else
+    {
+        std::ifstream in(argv[1], std::ios::binary);
+        if (!in)
+        {
+            std::cout << "Cannot read " << argv[1] << std::endl;
+            return 1;
+        }
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        text = contents.str();
+    }
+
+    std::vector<unsigned char> image;
+    std::string error;
+    CampusLayout layout;
+    if (!layoutCompileText(text, image, error) || !campusLayoutView(image.data(), image.size(), layout, error))
+    {
+        std::cout << argv[1] << ": " << error << std::endl;
+        return 1;
+    }
+    // Written beside the output and moved over it: a running campus may have
+    // the old file mapped, and truncating it under the mapping would fault
+    std::string temporary = std::string(argv[2]) + ".tmp";
+    bool ok = false;
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+        ok = static_cast<bool>(out);
+    }
+    ok = ok && replaceFile(temporary.c_str(), argv[2]);
+    if (!ok)
+    {
+        std::remove(temporary.c_str());
+        std::cout << "Cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << argv[2] << " (" << image.size() << " bytes): " << layout.buildingCount
+              << " buildings, " << layout.roadCount << " roads, " << layout.parkingLotCount << " parking lots, "
+              << layout.courtCount << " courts, " << layout.treeCount << " trees, " << layout.pathCount
+              << " paths, " << layout.routeCount << " route points" << std::endl;
+    return 0;
+}